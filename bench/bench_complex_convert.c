@@ -0,0 +1,134 @@
+/*
+ * bench/bench_complex_convert.c
+ *
+ * Описание:
+ * Бенчмарк ядер преобразования комплексных отсчетов (protocol/complex_convert.c).
+ * Для каждой доступной реализации (scalar, sse2, avx2) проверяет совпадение
+ * результата со скалярной и измеряет пропускную способность на массиве
+ * TIME_REF_RANGE (400 элементов) и на строке данных произвольной длины.
+ * Запуск: make bench && ./bench/bench_complex_convert [элементов_в_строке]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "../protocol/complex_convert.h"
+
+#define BENCH_MIN_NS 200000000ull // Минимальное время замера одного ядра (0.2 с)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+    complex_int8_t *i8;
+    complex_fixed16_t *i16;
+    float *re, *im, *mag;
+    int32_t *re32, *im32;
+    size_t count;
+} BenchBuffers;
+
+typedef enum { K_I8_F32, K_I8_I32, K_I8_MAG, K_I16_F32, K_I16_I32, K_I16_MAG, K_COUNT } KernelId;
+static const char *kernel_names[K_COUNT] = { "i8->f32", "i8->i32", "i8 |z|", "i16->f32", "i16->i32", "i16 |z|" };
+static const size_t kernel_src_bytes[K_COUNT] = { 2, 2, 2, 4, 4, 4 };
+
+static void run_kernel(KernelId k, BenchBuffers *b) {
+    switch (k) {
+        case K_I8_F32: complex_i8_to_planes_f32(b->i8, b->count, b->re, b->im); break;
+        case K_I8_I32: complex_i8_to_planes_i32(b->i8, b->count, b->re32, b->im32); break;
+        case K_I8_MAG: complex_i8_magnitude_f32(b->i8, b->count, b->mag); break;
+        case K_I16_F32: complex_i16_to_planes_f32(b->i16, b->count, b->re, b->im); break;
+        case K_I16_I32: complex_i16_to_planes_i32(b->i16, b->count, b->re32, b->im32); break;
+        case K_I16_MAG: complex_i16_magnitude_f32(b->i16, b->count, b->mag); break;
+        default: break;
+    }
+}
+
+// Сверка с эталоном (скалярная формула) на смещенном на 1 элемент массиве (невыровненный вход и хвост)
+static int verify(BenchBuffers *b) {
+    size_t n = b->count - 1;
+    BenchBuffers v = *b;
+    v.i8 = b->i8 + 1; v.i16 = b->i16 + 1; v.count = n;
+    int errors = 0;
+    for (int k = 0; k < K_COUNT; ++k) {
+        memset(b->re, 0, b->count * sizeof(float)); memset(b->im, 0, b->count * sizeof(float));
+        memset(b->re32, 0, b->count * sizeof(int32_t)); memset(b->im32, 0, b->count * sizeof(int32_t));
+        run_kernel((KernelId)k, &v);
+        for (size_t i = 0; i < n; ++i) {
+            int32_t r = (k < K_I16_F32) ? v.i8[i].real : v.i16[i].real;
+            int32_t m = (k < K_I16_F32) ? v.i8[i].imag : v.i16[i].imag;
+            float mag = sqrtf((float)r * (float)r + (float)m * (float)m);
+            int bad = 0;
+            switch ((KernelId)k) {
+                case K_I8_F32: case K_I16_F32: bad = (b->re[i] != (float)r || b->im[i] != (float)m); break;
+                case K_I8_I32: case K_I16_I32: bad = (b->re32[i] != r || b->im32[i] != m); break;
+                default: bad = fabsf(b->mag[i] - mag) > 1e-3f * (mag + 1.0f); break;
+            }
+            if (bad) { errors++; break; }
+        }
+        if (errors) { fprintf(stderr, "  MISMATCH in kernel %s\n", kernel_names[k]); return -1; }
+    }
+    return 0;
+}
+
+static void bench_size(size_t count) {
+    BenchBuffers b;
+    b.count = count;
+    b.i8 = malloc(count * sizeof(complex_int8_t));
+    b.i16 = malloc(count * sizeof(complex_fixed16_t));
+    b.re = malloc(count * sizeof(float)); b.im = malloc(count * sizeof(float)); b.mag = malloc(count * sizeof(float));
+    b.re32 = malloc(count * sizeof(int32_t)); b.im32 = malloc(count * sizeof(int32_t));
+    if (!b.i8 || !b.i16 || !b.re || !b.im || !b.mag || !b.re32 || !b.im32) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(12345);
+    for (size_t i = 0; i < count; ++i) {
+        b.i8[i].real = (int8_t)(rand() & 0xFF); b.i8[i].imag = (int8_t)(rand() & 0xFF);
+        b.i16[i].real = (int16_t)(rand() & 0xFFFF); b.i16[i].imag = (int16_t)(rand() & 0xFFFF);
+    }
+
+    printf("\n=== %zu elements ===\n", count);
+    printf("%-8s", "impl");
+    for (int k = 0; k < K_COUNT; ++k) printf(" %14s", kernel_names[k]);
+    printf("   (MB/s входных данных)\n");
+
+    const char *impls[] = { "scalar", "sse2", "avx2" };
+    for (size_t ii = 0; ii < sizeof(impls) / sizeof(impls[0]); ++ii) {
+        if (complex_convert_force_impl(impls[ii]) != 0) {
+            printf("%-8s (недоступно на этом процессоре)\n", impls[ii]);
+            continue;
+        }
+        if (verify(&b) != 0) continue;
+        printf("%-8s", impls[ii]);
+        for (int k = 0; k < K_COUNT; ++k) {
+            uint64_t iterations = 0;
+            uint64_t start = now_ns(), elapsed;
+            do {
+                for (int r = 0; r < 64; ++r) run_kernel((KernelId)k, &b);
+                iterations += 64;
+                elapsed = now_ns() - start;
+            } while (elapsed < BENCH_MIN_NS);
+            double mb_s = (double)iterations * (double)count * (double)kernel_src_bytes[k] / ((double)elapsed / 1e9) / 1e6;
+            printf(" %14.1f", mb_s);
+        }
+        printf("\n");
+    }
+
+    free(b.i8); free(b.i16); free(b.re); free(b.im); free(b.mag); free(b.re32); free(b.im32);
+}
+
+int main(int argc, char *argv[]) {
+    size_t line_elements = 8191; // Некратно ширине вектора - проверяется хвост
+    if (argc > 1) line_elements = (size_t)strtoul(argv[1], NULL, 10);
+    if (line_elements < 2) line_elements = 2;
+
+    printf("Auto-selected implementation: %s\n", complex_convert_impl_name());
+    bench_size(TIME_REF_RANGE_ELEMENTS);
+    bench_size(line_elements);
+    return 0;
+}
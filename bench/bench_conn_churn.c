@@ -0,0 +1,537 @@
+/*
+ * bench/bench_conn_churn.c
+ *
+ * Описание:
+ * Бенчмарк «дребезга» соединений УВМ <-> СВ-М. Запускает svm_app (из текущего каталога,
+ * с его config.ini) и в каждом цикле параллельно, по потоку на СВ-М, выполняет тот же путь,
+ * что и uvm_app: подключение через IOInterface, «Инициализация канала», ожидание
+ * «Подтверждения инициализации», отключение. Измеряются:
+ *  - connect: время установления соединения (до accept на стороне СВ-М);
+ *  - init:    «Инициализация канала» -> «Подтверждение инициализации»;
+ *  - teardown: закрытие передачи УВМ -> закрытие сокета со стороны СВ-М (экземпляр свободен).
+ * После каждого цикла сравниваются число открытых дескрипторов и потоков svm_app
+ * с исходными (утечки на цикл). Адрес каждого СВ-М - host из [settings_svmN] (или target_ip).
+ * Вторая часть - путь подключения/переподключения самого uvm_app: он запускается с
+ * --wait-for-gui, бенчмарк подключается к нему как GUI и в каждом цикле аварийно
+ * завершает (SIGKILL) и перезапускает svm_app, ожидая события LinkRecovered от всех СВ-М:
+ *  - recover: время восстановления линка по данным УВМ (обрыв -> подготовка завершена);
+ *  - outage:  SIGKILL svm_app -> восстановлены все линки;
+ *  - число попыток подключения и утечки дескрипторов/потоков uvm_app на цикл.
+ * Вторая часть требует uvm_reconnect_initial_ms > 0 и свободного порта GUI 12345.
+ * Запуск: make bench && ./bench/bench_conn_churn [циклов] [путь_к_svm_app] [циклов_УВМ] [путь_к_uvm_app]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "../config/config.h"
+#include "../io/io_interface.h"
+#include "../io/io_common.h"
+#include "../protocol/protocol_defs.h"
+#include "../protocol/message_builder.h"
+
+#define BENCH_DEFAULT_CYCLES 50
+#define BENCH_STARTUP_TIMEOUT_MS 5000
+#define BENCH_REPLY_TIMEOUT_MS 5000
+#define BENCH_DEFAULT_UVM_CYCLES 5
+#define BENCH_GUI_PORT 12345           // Порт GUI сервера uvm_app
+#define BENCH_RECOVER_TIMEOUT_MS 60000 // Срок восстановления всех линков УВМ в одном цикле
+#define BENCH_STOP_TIMEOUT_MS 5000
+
+typedef struct {
+    int svm_id;
+    LogicalAddress lak;
+    EthernetConfig ethernet;
+    // Результаты цикла
+    bool ok;
+    uint64_t connect_ns;
+    uint64_t init_ns;
+    uint64_t teardown_ns;
+    // Результаты цикла УВМ
+    bool recovered;
+    uint64_t recover_ms;
+    unsigned attempts;
+} ChurnTarget;
+
+typedef struct {
+    uint64_t *samples;
+    size_t count;
+} SampleSet;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Один цикл подключения к одному СВ-М (поток на СВ-М)
+static void* churn_one(void *arg) {
+    ChurnTarget *t = (ChurnTarget*)arg;
+    t->ok = false;
+    IOInterface *io = create_ethernet_interface(&t->ethernet);
+    if (!io) return NULL;
+
+    uint64_t t0 = now_ns();
+    int handle = io->connect(io);
+    if (handle < 0) goto cleanup;
+    t->connect_ns = now_ns() - t0;
+
+    struct timeval tv = { BENCH_REPLY_TIMEOUT_MS / 1000, (BENCH_REPLY_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    Message request = create_init_channel_message(LOGICAL_ADDRESS_UVM_VAL, t->lak, 0);
+    Message *reply = (Message*)malloc(sizeof(Message));
+    if (!reply) goto cleanup;
+    uint64_t t1 = now_ns();
+    if (send_protocol_message(io, handle, &request) != 0) { free(reply); goto cleanup; }
+    bool confirmed = false;
+    while (!confirmed) {
+        if (receive_protocol_message(io, handle, reply) != 0) break;
+        confirmed = (reply->header.message_type == MESSAGE_TYPE_CONFIRM_INIT);
+    }
+    free(reply);
+    if (!confirmed) goto cleanup;
+    t->init_ns = now_ns() - t1;
+
+    // СВ-М закрывает сокет, когда экземпляр вернулся в резерв; до этого дочитываем его сообщения
+    char drain[4096];
+    uint64_t t2 = now_ns();
+    shutdown(handle, SHUT_WR);
+    ssize_t n;
+    while ((n = recv(handle, drain, sizeof(drain), 0)) > 0) { }
+    if (n < 0) goto cleanup;
+    t->teardown_ns = now_ns() - t2;
+    t->ok = true;
+
+cleanup:
+    io->destroy(io); // Закрывает и сокет соединения
+    return NULL;
+}
+
+// Число открытых дескрипторов процесса
+static int count_fds(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/fd", (int)pid);
+    DIR *dir = opendir(path);
+    if (!dir) return -1;
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+// Число потоков процесса
+static int count_threads(pid_t pid) {
+    char path[64], line[256];
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int threads = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "Threads: %d", &threads) == 1) break;
+    }
+    fclose(f);
+    return threads;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_stats(const char *name, SampleSet *set) {
+    if (set->count == 0) {
+        printf("  %-9s no samples\n", name);
+        return;
+    }
+    qsort(set->samples, set->count, sizeof(uint64_t), compare_u64);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < set->count; ++i) sum += set->samples[i];
+    printf("  %-9s min %8.3f  avg %8.3f  p50 %8.3f  p99 %8.3f  max %8.3f ms  (%zu samples)\n", name,
+           set->samples[0] / 1e6, (double)sum / set->count / 1e6,
+           set->samples[set->count / 2] / 1e6, set->samples[(set->count * 99) / 100] / 1e6,
+           set->samples[set->count - 1] / 1e6, set->count);
+}
+
+// Вывод svm_app и подробный вывод слоя IO/конфигурации не нужны: печатаются только итоги
+static int saved_stdout = -1, saved_stderr = -1;
+
+static void output_quiet(void) {
+    fflush(stdout);
+    fflush(stderr);
+    saved_stdout = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0); // svm_app не должен их унаследовать
+    saved_stderr = fcntl(STDERR_FILENO, F_DUPFD_CLOEXEC, 0);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        close(devnull);
+    }
+}
+
+static void output_restore(void) {
+    fflush(stdout);
+    fflush(stderr);
+    if (saved_stdout >= 0) { dup2(saved_stdout, STDOUT_FILENO); close(saved_stdout); saved_stdout = -1; }
+    if (saved_stderr >= 0) { dup2(saved_stderr, STDERR_FILENO); close(saved_stderr); saved_stderr = -1; }
+}
+
+static pid_t spawn_svm(const char *path) {
+    pid_t pid = fork();
+    if (pid < 0) { perror("bench_conn_churn: fork failed"); return -1; }
+    if (pid == 0) {
+        execl(path, path, (char*)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+static pid_t spawn_uvm(const char *path) {
+    pid_t pid = fork();
+    if (pid < 0) { perror("bench_conn_churn: fork failed"); return -1; }
+    if (pid == 0) {
+        execl(path, path, "--wait-for-gui", (char*)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+// Остановка сигналом; не завершившийся за BENCH_STOP_TIMEOUT_MS процесс снимается SIGKILL
+static void stop_process(pid_t pid, int sig) {
+    if (pid <= 0) return;
+    kill(pid, sig);
+    uint64_t deadline = now_ns() + (uint64_t)BENCH_STOP_TIMEOUT_MS * 1000000ull;
+    while (waitpid(pid, NULL, WNOHANG) == 0) {
+        if (now_ns() > deadline) {
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+            return;
+        }
+        usleep(10000);
+    }
+}
+
+// Поток событий GUI сервера uvm_app (строки "EVENT;SVM_ID:...;Type:...;Details:...")
+typedef struct {
+    int fd;
+    char buf[4096];
+    size_t len;
+} GuiEvents;
+
+// Подключение к GUI серверу uvm_app (он начинает слушать после старта); -1 по сроку
+static int gui_connect(GuiEvents *gui, pid_t uvm_pid, uint64_t deadline) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(BENCH_GUI_PORT);
+    gui->len = 0;
+    while (now_ns() < deadline && waitpid(uvm_pid, NULL, WNOHANG) == 0) {
+        gui->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (gui->fd < 0) return -1;
+        if (connect(gui->fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) return 0;
+        close(gui->fd);
+        gui->fd = -1;
+        usleep(100000);
+    }
+    return -1;
+}
+
+// Очередная строка события: 1 - прочитана, 0 - истек срок, -1 - uvm_app закрыл соединение
+static int gui_read_line(GuiEvents *gui, char *line, size_t size, uint64_t deadline) {
+    for (;;) {
+        char *nl = memchr(gui->buf, '\n', gui->len);
+        if (nl) {
+            size_t n = (size_t)(nl - gui->buf);
+            snprintf(line, size, "%.*s", (int)n, gui->buf);
+            gui->len -= n + 1;
+            memmove(gui->buf, nl + 1, gui->len);
+            return 1;
+        }
+        if (gui->len == sizeof(gui->buf)) gui->len = 0; // Слишком длинная строка - отбрасываем
+        uint64_t now = now_ns();
+        if (now >= deadline) return 0;
+        struct pollfd pfd = { gui->fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, (int)((deadline - now) / 1000000ull) + 1);
+        if (ready < 0 && errno != EINTR) return -1;
+        if (ready <= 0) continue;
+        ssize_t n = recv(gui->fd, gui->buf + gui->len, sizeof(gui->buf) - gui->len, 0);
+        if (n <= 0) return -1;
+        gui->len += (size_t)n;
+    }
+}
+
+static ChurnTarget* find_target(ChurnTarget *targets, int num_targets, int svm_id) {
+    for (int i = 0; i < num_targets; ++i) {
+        if (targets[i].svm_id == svm_id) return &targets[i];
+    }
+    return NULL;
+}
+
+// Ожидание события от всех СВ-М: линк подключен (LinkStatus = ACTIVE) или восстановлен (LinkRecovered)
+static bool gui_wait_all(GuiEvents *gui, ChurnTarget *targets, int num_targets, bool recovered, uint64_t deadline) {
+    for (int i = 0; i < num_targets; ++i) targets[i].recovered = false;
+    int remaining = num_targets;
+    char line[512];
+    while (remaining > 0 && gui_read_line(gui, line, sizeof(line), deadline) == 1) {
+        int svm_id, status;
+        unsigned long long recover_ms;
+        unsigned attempts;
+        ChurnTarget *t = NULL;
+        if (recovered) {
+            if (sscanf(line, "EVENT;SVM_ID:%d;Type:LinkRecovered;Details:RecoverMs=%llu,Attempts=%u",
+                       &svm_id, &recover_ms, &attempts) != 3) continue;
+            t = find_target(targets, num_targets, svm_id);
+            if (!t) continue;
+            t->recover_ms = recover_ms;
+            t->attempts = attempts;
+        } else {
+            if (sscanf(line, "EVENT;SVM_ID:%d;Type:LinkStatus;Details:NewStatus=%d", &svm_id, &status) != 2 ||
+                status != 2) continue; // 2 - UVM_LINK_ACTIVE
+            t = find_target(targets, num_targets, svm_id);
+            if (!t) continue;
+        }
+        if (!t->recovered) {
+            t->recovered = true;
+            remaining--;
+        }
+    }
+    return remaining == 0;
+}
+
+// Один цикл по всем СВ-М; возвращает число успешных подключений
+static int run_cycle(ChurnTarget *targets, int num_targets) {
+    pthread_t tids[MAX_SVM_INSTANCES];
+    for (int i = 0; i < num_targets; ++i) {
+        if (pthread_create(&tids[i], NULL, churn_one, &targets[i]) != 0) {
+            tids[i] = 0;
+            targets[i].ok = false;
+        }
+    }
+    int ok = 0;
+    for (int i = 0; i < num_targets; ++i) {
+        if (tids[i] != 0) pthread_join(tids[i], NULL);
+        if (targets[i].ok) ok++;
+    }
+    return ok;
+}
+
+// Вторая часть: переподключения uvm_app после аварийного перезапуска svm_app
+static int run_uvm_reconnect(ChurnTarget *targets, int num_targets, int uvm_cycles,
+                             pid_t *svm_pid, const char *svm_path, const char *uvm_path) {
+    size_t max_samples = (size_t)uvm_cycles * num_targets;
+    SampleSet recover_set = { calloc(max_samples, sizeof(uint64_t)), 0 };
+    SampleSet outage_set = { calloc(uvm_cycles, sizeof(uint64_t)), 0 };
+    int *fd_delta = calloc(uvm_cycles, sizeof(int));
+    int *thread_delta = calloc(uvm_cycles, sizeof(int));
+    GuiEvents *gui = calloc(1, sizeof(GuiEvents));
+    if (!recover_set.samples || !outage_set.samples || !fd_delta || !thread_delta || !gui) {
+        fprintf(stderr, "bench_conn_churn: Failed to allocate samples.\n");
+        free(recover_set.samples); free(outage_set.samples); free(fd_delta); free(thread_delta); free(gui);
+        return EXIT_FAILURE;
+    }
+    gui->fd = -1;
+
+    output_quiet();
+    int status = EXIT_FAILURE;
+    const char *error = NULL;
+    pid_t uvm_pid = spawn_uvm(uvm_path);
+    uint64_t deadline = now_ns() + (uint64_t)BENCH_STARTUP_TIMEOUT_MS * 1000000ull;
+    if (uvm_pid < 0) {
+        error = "failed to start uvm_app";
+    } else if (gui_connect(gui, uvm_pid, deadline) != 0) {
+        error = "no GUI connection to uvm_app (port 12345 busy or uvm_app exited)";
+    } else if (!gui_wait_all(gui, targets, num_targets, false, deadline)) {
+        error = "uvm_app did not connect to all SVM instances";
+    }
+
+    int failures = 0;
+    unsigned long total_attempts = 0;
+    int base_fds = count_fds(uvm_pid);
+    int base_threads = count_threads(uvm_pid);
+    // Цикл 0 прогревает путь переподключения (обрыв может прийтись на первую подготовку); в статистику не входит
+    for (int c = -1; c < uvm_cycles && !error; ++c) {
+        uint64_t t_kill = now_ns();
+        stop_process(*svm_pid, SIGKILL);
+        *svm_pid = spawn_svm(svm_path);
+        if (*svm_pid < 0) { error = "failed to restart svm_app"; break; }
+        deadline = now_ns() + (uint64_t)BENCH_RECOVER_TIMEOUT_MS * 1000000ull;
+        bool all = gui_wait_all(gui, targets, num_targets, true, deadline);
+        uint64_t outage = now_ns() - t_kill;
+        if (waitpid(uvm_pid, NULL, WNOHANG) == uvm_pid) { uvm_pid = -1; error = "uvm_app exited"; break; }
+        if (c < 0) {
+            if (!all) error = "uvm_app did not recover all links after the warm-up restart";
+            base_fds = count_fds(uvm_pid);
+            base_threads = count_threads(uvm_pid);
+            continue;
+        }
+        for (int i = 0; i < num_targets; ++i) {
+            if (!targets[i].recovered) { failures++; continue; }
+            recover_set.samples[recover_set.count++] = targets[i].recover_ms * 1000000ull;
+            total_attempts += targets[i].attempts;
+        }
+        if (all) outage_set.samples[outage_set.count++] = outage;
+        fd_delta[c] = count_fds(uvm_pid) - base_fds;
+        thread_delta[c] = count_threads(uvm_pid) - base_threads;
+    }
+    if (gui->fd >= 0) close(gui->fd);
+    stop_process(uvm_pid, SIGINT);
+    output_restore();
+
+    if (error) {
+        fprintf(stderr, "bench_conn_churn: UVM reconnect: %s.\n", error);
+    } else {
+        printf("UVM reconnect: %d SVM instances x %d svm_app restarts, %d links not recovered, %.2f attempts/recovery\n",
+               num_targets, uvm_cycles, failures,
+               recover_set.count ? (double)total_attempts / recover_set.count : 0.0);
+        print_stats("recover", &recover_set);
+        print_stats("outage", &outage_set);
+        printf("  uvm_app baseline: %d fds, %d threads\n", base_fds, base_threads);
+        int max_fd_delta = 0, max_thread_delta = 0;
+        for (int c = 0; c < uvm_cycles; ++c) {
+            if (fd_delta[c] > max_fd_delta) max_fd_delta = fd_delta[c];
+            if (thread_delta[c] > max_thread_delta) max_thread_delta = thread_delta[c];
+        }
+        printf("  leaks: fds %+d after last cycle (max %+d), threads %+d after last cycle (max %+d)\n",
+               fd_delta[uvm_cycles - 1], max_fd_delta, thread_delta[uvm_cycles - 1], max_thread_delta);
+        status = EXIT_SUCCESS;
+    }
+    free(recover_set.samples);
+    free(outage_set.samples);
+    free(fd_delta);
+    free(thread_delta);
+    free(gui);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    int cycles = BENCH_DEFAULT_CYCLES;
+    int uvm_cycles = BENCH_DEFAULT_UVM_CYCLES;
+    const char *svm_path = "./svm_app";
+    const char *uvm_path = "./uvm_app";
+    if (argc > 1) cycles = atoi(argv[1]);
+    if (cycles <= 0) cycles = BENCH_DEFAULT_CYCLES;
+    if (argc > 2) svm_path = argv[2];
+    if (argc > 3) uvm_cycles = atoi(argv[3]); // 0 - без второй части
+    if (uvm_cycles < 0) uvm_cycles = BENCH_DEFAULT_UVM_CYCLES;
+    if (argc > 4) uvm_path = argv[4];
+
+    static AppConfig cfg;
+    output_quiet();
+    int config_status = load_config("config.ini", &cfg);
+    output_restore();
+    if (config_status != 0) {
+        fprintf(stderr, "bench_conn_churn: Failed to load config.ini from current directory.\n");
+        return EXIT_FAILURE;
+    }
+    ChurnTarget targets[MAX_SVM_INSTANCES];
+    int num_targets = 0;
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        if (!cfg.svm_config_loaded[i]) continue;
+        ChurnTarget *t = &targets[num_targets++];
+        memset(t, 0, sizeof(*t));
+        t->svm_id = i;
+        t->lak = cfg.svm_settings[i].lak;
+        // host из [settings_svmN]; без него load_config подставляет target_ip из [ethernet_uvm_target]
+        snprintf(t->ethernet.target_ip, sizeof(t->ethernet.target_ip), "%s", cfg.svm_ethernet[i].target_ip);
+        t->ethernet.port = cfg.svm_ethernet[i].port;
+    }
+    if (num_targets == 0) {
+        fprintf(stderr, "bench_conn_churn: No SVM instances in config.ini.\n");
+        return EXIT_FAILURE;
+    }
+
+    output_quiet();
+    pid_t svm_pid = spawn_svm(svm_path);
+    if (svm_pid < 0) { output_restore(); return EXIT_FAILURE; }
+
+    // Ожидание готовности всех портов (этот же цикл прогревает экземпляры; в статистику не входит)
+    uint64_t deadline = now_ns() + (uint64_t)BENCH_STARTUP_TIMEOUT_MS * 1000000ull;
+    while (run_cycle(targets, num_targets) != num_targets) {
+        if (now_ns() > deadline || waitpid(svm_pid, NULL, WNOHANG) == svm_pid) {
+            output_restore();
+            fprintf(stderr, "bench_conn_churn: %s did not come up on all %d ports.\n", svm_path, num_targets);
+            stop_process(svm_pid, SIGKILL);
+            return EXIT_FAILURE;
+        }
+        usleep(100000);
+    }
+    int base_fds = count_fds(svm_pid);
+    int base_threads = count_threads(svm_pid);
+
+    size_t max_samples = (size_t)cycles * num_targets;
+    SampleSet connect_set = { calloc(max_samples, sizeof(uint64_t)), 0 };
+    SampleSet init_set = { calloc(max_samples, sizeof(uint64_t)), 0 };
+    SampleSet teardown_set = { calloc(max_samples, sizeof(uint64_t)), 0 };
+    int *fd_delta = calloc(cycles, sizeof(int));
+    int *thread_delta = calloc(cycles, sizeof(int));
+    if (!connect_set.samples || !init_set.samples || !teardown_set.samples || !fd_delta || !thread_delta) {
+        output_restore();
+        fprintf(stderr, "bench_conn_churn: Failed to allocate samples.\n");
+        stop_process(svm_pid, SIGKILL);
+        return EXIT_FAILURE;
+    }
+
+    int failures = 0;
+    uint64_t t_start = now_ns();
+    for (int c = 0; c < cycles; ++c) {
+        failures += num_targets - run_cycle(targets, num_targets);
+        for (int i = 0; i < num_targets; ++i) {
+            if (!targets[i].ok) continue;
+            connect_set.samples[connect_set.count++] = targets[i].connect_ns;
+            init_set.samples[init_set.count++] = targets[i].init_ns;
+            teardown_set.samples[teardown_set.count++] = targets[i].teardown_ns;
+        }
+        fd_delta[c] = count_fds(svm_pid) - base_fds;
+        thread_delta[c] = count_threads(svm_pid) - base_threads;
+    }
+    uint64_t elapsed = now_ns() - t_start;
+
+    output_restore();
+
+    printf("Connection churn: %d SVM instances x %d cycles, %.1f cycles/s, %d failed connections\n",
+           num_targets, cycles, cycles / (elapsed / 1e9), failures);
+    print_stats("connect", &connect_set);
+    print_stats("init", &init_set);
+    print_stats("teardown", &teardown_set);
+    printf("  svm_app baseline: %d fds, %d threads\n", base_fds, base_threads);
+    int max_fd_delta = 0, max_thread_delta = 0;
+    for (int c = 0; c < cycles; ++c) {
+        if (fd_delta[c] > max_fd_delta) max_fd_delta = fd_delta[c];
+        if (thread_delta[c] > max_thread_delta) max_thread_delta = thread_delta[c];
+    }
+    printf("  leaks: fds %+d after last cycle (max %+d), threads %+d after last cycle (max %+d), "
+           "%.3f fds/cycle\n", fd_delta[cycles - 1], max_fd_delta, thread_delta[cycles - 1], max_thread_delta,
+           (double)fd_delta[cycles - 1] / cycles);
+
+    free(connect_set.samples);
+    free(init_set.samples);
+    free(teardown_set.samples);
+    free(fd_delta);
+    free(thread_delta);
+
+    int status = EXIT_SUCCESS;
+    if (uvm_cycles > 0 && cfg.uvm_reconnect_initial_ms <= 0) {
+        printf("UVM reconnect: skipped (uvm_reconnect_initial_ms = 0 in config.ini)\n");
+    } else if (uvm_cycles > 0) {
+        status = run_uvm_reconnect(targets, num_targets, uvm_cycles, &svm_pid, svm_path, uvm_path);
+    }
+
+    stop_process(svm_pid, SIGINT);
+    return status;
+}
@@ -0,0 +1,176 @@
+/*
+ * bench/bench_false_sharing.c
+ *
+ * Описание:
+ * Бенчмарк ложного разделения строк кэша между соседними экземплярами svm_instances[].
+ * Сравнивает прежнюю раскладку SvmInstance (поля подряд, без выравнивания) с текущей
+ * (горячие группы с новой строки кэша, структура выровнена). Каждый поток эмулирует
+ * горячий путь своего экземпляра: захват instance_mutex, message_counter++,
+ * messages_sent_count++. Счетчики промахов кэша берутся из perf_event_open
+ * (если ядро/права не позволяют - выводится только время).
+ * Запуск: make bench && ./bench/bench_false_sharing [итераций_на_поток]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "../svm/svm_types.h"
+
+#define BENCH_DEFAULT_ITERATIONS 2000000ul
+#define BENCH_INSTANCES 4 // Соседние экземпляры (как в стандартном config.ini)
+
+// Прежняя раскладка SvmInstance (до разделения на горячие и холодные части)
+typedef struct {
+    int id;
+    pthread_t receiver_tid;
+    pthread_t processor_tid;
+    IOInterface *io_handle;
+    int client_handle;
+    bool is_active;
+    LogicalAddress assigned_lak;
+    struct ThreadSafeQueuedMsgQueue *incoming_queue;
+    SVMState current_state;
+    uint32_t session_id;
+    uint16_t message_counter;
+    uint64_t bcb_epoch_ns;
+    uint32_t line_status_seq;
+    uint16_t link_up_changes_counter;
+    uint32_t link_up_low_time_us100;
+    uint16_t sign_det_changes_counter;
+    uint64_t rng_seed;
+    uint64_t rng_state[2];
+    pthread_mutex_t instance_mutex;
+    SvmParamStore params;
+    struct SvmTimer *link_status_timer;
+    struct SvmTimer *cycle_timer;
+    bool user_flag1;
+    bool simulate_control_failure;
+    int disconnect_after_messages;
+    int messages_sent_count;
+    bool simulate_response_timeout;
+    bool send_warning_on_confirm;
+    uint8_t warning_tks;
+} OldSvmInstance;
+
+typedef struct {
+    pthread_mutex_t *mutex;
+    uint16_t *message_counter;
+    int *messages_sent_count;
+    unsigned long iterations;
+} WorkerArgs;
+
+static void* worker(void *arg) {
+    WorkerArgs *w = (WorkerArgs*)arg;
+    for (unsigned long i = 0; i < w->iterations; ++i) {
+        pthread_mutex_lock(w->mutex);
+        (*w->message_counter)++;
+        (*w->messages_sent_count)++;
+        pthread_mutex_unlock(w->mutex);
+    }
+    return NULL;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Счетчик производительности для процесса и всех создаваемых им потоков (inherit)
+static int perf_open(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void run_case(const char *name, pthread_mutex_t **mutexes, uint16_t **counters, int **sent,
+                     int threads, unsigned long iterations) {
+    int fd_llc = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    int fd_l1d = perf_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                           (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    pthread_t tids[MAX_SVM_INSTANCES];
+    WorkerArgs args[MAX_SVM_INSTANCES];
+
+    if (fd_llc >= 0) ioctl(fd_llc, PERF_EVENT_IOC_ENABLE, 0);
+    if (fd_l1d >= 0) ioctl(fd_l1d, PERF_EVENT_IOC_ENABLE, 0);
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < threads; ++i) {
+        args[i].mutex = mutexes[i];
+        args[i].message_counter = counters[i];
+        args[i].messages_sent_count = sent[i];
+        args[i].iterations = iterations;
+        pthread_create(&tids[i], NULL, worker, &args[i]);
+    }
+    for (int i = 0; i < threads; ++i) pthread_join(tids[i], NULL);
+    uint64_t elapsed = now_ns() - t0;
+
+    uint64_t llc = 0, l1d = 0;
+    if (fd_llc >= 0) { ioctl(fd_llc, PERF_EVENT_IOC_DISABLE, 0); if (read(fd_llc, &llc, sizeof(llc)) != sizeof(llc)) llc = 0; close(fd_llc); }
+    if (fd_l1d >= 0) { ioctl(fd_l1d, PERF_EVENT_IOC_DISABLE, 0); if (read(fd_l1d, &l1d, sizeof(l1d)) != sizeof(l1d)) l1d = 0; close(fd_l1d); }
+
+    double ns_per_op = (double)elapsed / ((double)iterations * threads);
+    printf("  %-8s %8.2f ns/op", name, ns_per_op);
+    if (fd_llc >= 0) printf("  cache-misses %12llu", (unsigned long long)llc);
+    else printf("  cache-misses          n/a");
+    if (fd_l1d >= 0) printf("  L1D-read-misses %12llu", (unsigned long long)l1d);
+    else printf("  L1D-read-misses          n/a");
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long iterations = BENCH_DEFAULT_ITERATIONS;
+    if (argc > 1) iterations = strtoul(argv[1], NULL, 10);
+    if (iterations == 0) iterations = BENCH_DEFAULT_ITERATIONS;
+    int threads = BENCH_INSTANCES;
+
+    static OldSvmInstance old_instances[MAX_SVM_INSTANCES];
+    static SvmInstance new_instances[MAX_SVM_INSTANCES];
+    pthread_mutex_t *mutexes[MAX_SVM_INSTANCES];
+    uint16_t *counters[MAX_SVM_INSTANCES];
+    int *sent[MAX_SVM_INSTANCES];
+
+    printf("False sharing between adjacent instances: %d threads x %lu iterations, %ld CPUs\n",
+           threads, iterations, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("  old layout: sizeof=%zu, mutex@%zu, message_counter@%zu, messages_sent_count@%zu\n",
+           sizeof(OldSvmInstance), offsetof(OldSvmInstance, instance_mutex),
+           offsetof(OldSvmInstance, message_counter), offsetof(OldSvmInstance, messages_sent_count));
+    printf("  new layout: sizeof=%zu, mutex@%zu, message_counter@%zu, messages_sent_count@%zu\n",
+           sizeof(SvmInstance), offsetof(SvmInstance, instance_mutex),
+           offsetof(SvmInstance, message_counter), offsetof(SvmInstance, messages_sent_count));
+
+    for (int i = 0; i < threads; ++i) {
+        pthread_mutex_init(&old_instances[i].instance_mutex, NULL);
+        mutexes[i] = &old_instances[i].instance_mutex;
+        counters[i] = &old_instances[i].message_counter;
+        sent[i] = &old_instances[i].messages_sent_count;
+    }
+    run_case("old", mutexes, counters, sent, threads, iterations);
+
+    for (int i = 0; i < threads; ++i) {
+        pthread_mutex_init(&new_instances[i].instance_mutex, NULL);
+        mutexes[i] = &new_instances[i].instance_mutex;
+        counters[i] = &new_instances[i].message_counter;
+        sent[i] = &new_instances[i].messages_sent_count;
+    }
+    run_case("new", mutexes, counters, sent, threads, iterations);
+
+    for (int i = 0; i < threads; ++i) {
+        pthread_mutex_destroy(&old_instances[i].instance_mutex);
+        pthread_mutex_destroy(&new_instances[i].instance_mutex);
+    }
+    return 0;
+}
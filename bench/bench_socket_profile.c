@@ -0,0 +1,254 @@
+/*
+ * bench/bench_socket_profile.c
+ *
+ * Описание:
+ * Влияние профиля сокета (socket_profile в config.ini) на обмен командами и ответами
+ * по Ethernet через 127.0.0.1. Для каждого профиля (default, latency, throughput)
+ * сервер-поток и клиент создаются через IOInterface с этим профилем:
+ *  - single: «пинг-понг» - кадр команды, кадр ответа; время круга p50/p99;
+ *  - pair:   две команды подряд отдельными send, ответ после обеих (как команда
+ *            с последующим запросом состояния) - здесь Nagle ждет ACK первой команды,
+ *            а получатель откладывает ACK: без TCP_NODELAY/TCP_QUICKACK круг ~40 мс;
+ *  - stream: поток кадров по 64 КБ в одну сторону, МБ/с до подтверждения приема.
+ * Запуск: make bench && ./bench/bench_socket_profile [кругов] [размер_тела] [МБ_потока]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include "../io/io_interface.h"
+#include "../protocol/protocol_defs.h"
+
+#define BENCH_DEFAULT_ROUNDS 5000
+#define BENCH_DEFAULT_BODY_BYTES 16
+#define BENCH_DEFAULT_STREAM_MB 256
+#define BENCH_PAIR_ROUNDS_MAX 200   // Круг pair без профиля latency длится десятки мс
+#define BENCH_STREAM_CHUNK (64 * 1024)
+#define BENCH_TCP_PORT 18098
+
+typedef struct {
+    IOInterface *listener;
+    size_t frame_bytes;
+    bool ok;
+} BenchServer;
+
+typedef struct {
+    uint64_t *samples;
+    size_t count;
+} SampleSet;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool read_full(IOInterface *io, int handle, void *buffer, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = io->receive_data(handle, (char*)buffer + done, length - done);
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// Сервер: три подключения - single (1 кадр на ответ), pair (2 кадра на ответ), stream (прием до EOF).
+// Число кадров на ответ клиент передает первым байтом подключения (0 - поток)
+static void* server_thread(void *arg) {
+    BenchServer *server = (BenchServer*)arg;
+    IOInterface *io = server->listener;
+    char *buffer = malloc(BENCH_STREAM_CHUNK);
+    server->ok = false;
+    if (!buffer) return NULL;
+
+    for (int connection = 0; connection < 3; ++connection) {
+        int handle = io->accept(io, NULL, 0, NULL);
+        if (handle < 0) goto cleanup;
+        uint8_t frames_per_reply = 0;
+        if (!read_full(io, handle, &frames_per_reply, 1)) {
+            io->disconnect(io, handle);
+            goto cleanup;
+        }
+        if (frames_per_reply > 0) {
+            bool alive = true;
+            while (alive) {
+                for (uint8_t f = 0; f < frames_per_reply && alive; ++f) {
+                    alive = read_full(io, handle, buffer, server->frame_bytes);
+                }
+                if (alive) alive = io->send_data(handle, buffer, server->frame_bytes) == (ssize_t)server->frame_bytes;
+            }
+        } else {
+            uint64_t total = 0;
+            ssize_t n;
+            while ((n = io->receive_data(handle, buffer, BENCH_STREAM_CHUNK)) > 0) total += (uint64_t)n;
+            io->send_data(handle, &total, sizeof(total));
+        }
+        io->disconnect(io, handle);
+    }
+    server->ok = true;
+
+cleanup:
+    free(buffer);
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_rtt(const char *profile, const char *mode, SampleSet *set) {
+    qsort(set->samples, set->count, sizeof(uint64_t), compare_u64);
+    printf("  %-10s %-6s RTT: p50 %9.2f  p99 %9.2f  max %9.2f us  (%zu rounds)\n", profile, mode,
+           set->samples[set->count / 2] / 1e3, set->samples[(set->count * 99) / 100] / 1e3,
+           set->samples[set->count - 1] / 1e3, set->count);
+}
+
+// Вывод слоя IO (подключения, закрытия) не нужен: печатаются только итоги
+static int saved_stdout = -1, saved_stderr = -1;
+
+static void output_quiet(void) {
+    fflush(stdout);
+    fflush(stderr);
+    saved_stdout = dup(STDOUT_FILENO);
+    saved_stderr = dup(STDERR_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        close(devnull);
+    }
+}
+
+static void output_restore(void) {
+    fflush(stdout);
+    fflush(stderr);
+    if (saved_stdout >= 0) { dup2(saved_stdout, STDOUT_FILENO); close(saved_stdout); saved_stdout = -1; }
+    if (saved_stderr >= 0) { dup2(saved_stderr, STDERR_FILENO); close(saved_stderr); saved_stderr = -1; }
+}
+
+// Круги запрос-ответ: frames_per_reply кадров команд отдельными send, затем один кадр ответа
+static bool run_rounds(IOInterface *client, char *frame, size_t frame_bytes, uint8_t frames_per_reply,
+                       int rounds, SampleSet *set) {
+    int handle = client->connect(client);
+    if (handle < 0) return false;
+    bool ok = client->send_data(handle, &frames_per_reply, 1) == 1;
+    for (int r = 0; ok && r < rounds; ++r) {
+        uint64_t t0 = now_ns();
+        for (uint8_t f = 0; ok && f < frames_per_reply; ++f) {
+            ok = client->send_data(handle, frame, frame_bytes) == (ssize_t)frame_bytes;
+        }
+        if (ok) ok = read_full(client, handle, frame, frame_bytes);
+        if (ok) set->samples[set->count++] = now_ns() - t0;
+    }
+    client->disconnect(client, handle);
+    return ok;
+}
+
+static bool run_stream(IOInterface *client, uint64_t stream_bytes, double *mb_per_s) {
+    char *chunk = calloc(1, BENCH_STREAM_CHUNK);
+    if (!chunk) return false;
+    int handle = client->connect(client);
+    bool ok = handle >= 0;
+    uint8_t mode = 0;
+    if (ok) ok = client->send_data(handle, &mode, 1) == 1;
+    uint64_t t0 = now_ns();
+    for (uint64_t sent = 0; ok && sent < stream_bytes; sent += BENCH_STREAM_CHUNK) {
+        ok = client->send_data(handle, chunk, BENCH_STREAM_CHUNK) == BENCH_STREAM_CHUNK;
+    }
+    if (ok) {
+        shutdown(handle, SHUT_WR);
+        uint64_t received = 0;
+        ok = read_full(client, handle, &received, sizeof(received)) && received == stream_bytes;
+        *mb_per_s = (stream_bytes / (1024.0 * 1024.0)) / ((now_ns() - t0) / 1e9);
+    }
+    if (handle >= 0) client->disconnect(client, handle);
+    free(chunk);
+    return ok;
+}
+
+// Прогон одного профиля: сервер и клиент с одинаковыми опциями сокетов
+static bool run_profile(SocketProfile profile, int rounds, size_t frame_bytes, uint64_t stream_bytes) {
+    const char *name = socket_profile_name(profile);
+    int pair_rounds = rounds < BENCH_PAIR_ROUNDS_MAX ? rounds : BENCH_PAIR_ROUNDS_MAX;
+    SampleSet single = { calloc((size_t)rounds, sizeof(uint64_t)), 0 };
+    SampleSet pair = { calloc((size_t)pair_rounds, sizeof(uint64_t)), 0 };
+    char *frame = calloc(1, frame_bytes);
+    EthernetConfig tcp_config = {0};
+    strncpy(tcp_config.target_ip, "127.0.0.1", sizeof(tcp_config.target_ip) - 1);
+    tcp_config.port = BENCH_TCP_PORT;
+    tcp_config.profile = profile;
+    IOInterface *listener = create_ethernet_interface(&tcp_config);
+    IOInterface *client = create_ethernet_interface(&tcp_config);
+    BenchServer server = { listener, frame_bytes, false };
+    pthread_t tid = 0;
+    bool result = false;
+    double mb_per_s = 0.0;
+
+    output_quiet();
+    if (!single.samples || !pair.samples || !frame || !listener || !client) goto cleanup;
+    if (listener->listen(listener) < 0) goto cleanup;
+    if (pthread_create(&tid, NULL, server_thread, &server) != 0) { tid = 0; goto cleanup; }
+
+    MessageHeader *header = (MessageHeader*)frame;
+    header->address = LOGICAL_ADDRESS_UVM_VAL;
+    header->message_type = MESSAGE_TYPE_INIT_CHANNEL;
+    header->body_length = htons((uint16_t)(frame_bytes - sizeof(MessageHeader)));
+
+    if (!run_rounds(client, frame, frame_bytes, 1, rounds, &single)) goto cleanup;
+    if (!run_rounds(client, frame, frame_bytes, 2, pair_rounds, &pair)) goto cleanup;
+    if (!run_stream(client, stream_bytes, &mb_per_s)) goto cleanup;
+    result = true;
+
+cleanup:
+    if (tid) {
+        if (!result) shutdown(listener->io_handle, SHUT_RDWR); // Снимаем сервер с accept
+        pthread_join(tid, NULL);
+    }
+    if (listener) listener->destroy(listener);
+    if (client) client->destroy(client);
+    output_restore();
+    if (result && server.ok) {
+        print_rtt(name, "single", &single);
+        print_rtt(name, "pair", &pair);
+        printf("  %-10s stream: %9.1f MB/s  (%llu MB in %d KB writes)\n", name, mb_per_s,
+               (unsigned long long)(stream_bytes >> 20), BENCH_STREAM_CHUNK / 1024);
+    } else {
+        fprintf(stderr, "bench_socket_profile: %s run failed.\n", name);
+    }
+    free(single.samples);
+    free(pair.samples);
+    free(frame);
+    return result && server.ok;
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = BENCH_DEFAULT_ROUNDS;
+    int body_bytes = BENCH_DEFAULT_BODY_BYTES;
+    int stream_mb = BENCH_DEFAULT_STREAM_MB;
+    if (argc > 1) rounds = atoi(argv[1]);
+    if (argc > 2) body_bytes = atoi(argv[2]);
+    if (argc > 3) stream_mb = atoi(argv[3]);
+    if (rounds <= 0) rounds = BENCH_DEFAULT_ROUNDS;
+    if (body_bytes < 0 || body_bytes > MAX_MESSAGE_BODY_SIZE) body_bytes = BENCH_DEFAULT_BODY_BYTES;
+    if (stream_mb <= 0) stream_mb = BENCH_DEFAULT_STREAM_MB;
+    size_t frame_bytes = sizeof(MessageHeader) + (size_t)body_bytes;
+    uint64_t stream_bytes = (uint64_t)stream_mb << 20;
+
+    printf("Socket profiles over 127.0.0.1: %d rounds of %zu-byte frames, %d MB stream\n",
+           rounds, frame_bytes, stream_mb);
+    bool ok = true;
+    SocketProfile profiles[] = { SOCKET_PROFILE_DEFAULT, SOCKET_PROFILE_LATENCY, SOCKET_PROFILE_THROUGHPUT };
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); ++i) {
+        ok = run_profile(profiles[i], rounds, frame_bytes, stream_bytes) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,339 @@
+/*
+ * bench/bench_unix_loopback.c
+ *
+ * Описание:
+ * Сравнение транспортов для svm_app и uvm_app на одной машине: Ethernet (TCP через
+ * 127.0.0.1), TCP на io_uring (uring), локальный сокет Unix и кольца в общей памяти
+ * (shm; без системных вызовов на пути данных - остаются накладные расходы самого приложения).
+ * Для каждого транспорта через IOInterface
+ * поднимается сервер-поток (listen/accept, как у СВ-М) и клиент (connect, как у УВМ):
+ *  - latency:    «пинг-понг» кадрами протокольного размера (заголовок + тело),
+ *                время круга запрос -> эхо-ответ;
+ *  - throughput: поток кадров по 64 КБ в одну сторону, МБ/с до подтверждения приема;
+ *  - burst (ethernet и uring): кадры протокольного размера пачками по BENCH_BURST,
+ *                у uring - одной подачей uring_send_batch, у ethernet - send по одному;
+ *                сообщений в секунду и процессорное время (обе стороны) на сообщение.
+ * Запуск: make bench && ./bench/bench_unix_loopback [кругов] [размер_тела] [МБ_потока]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <arpa/inet.h>
+
+#include "../io/io_interface.h"
+#include "../protocol/protocol_defs.h"
+
+#define BENCH_DEFAULT_ROUNDS 20000
+#define BENCH_DEFAULT_BODY_BYTES 64
+#define BENCH_DEFAULT_STREAM_MB 256
+#define BENCH_STREAM_CHUNK (64 * 1024)
+#define BENCH_TCP_PORT 18095
+#define BENCH_URING_PORT 18096
+#define BENCH_BURST 16
+#define BENCH_BURST_ROUNDS_FACTOR 10 // Сообщений в прогоне пачек: кругов latency * 10
+#define BENCH_UNIX_PATH "/tmp/bench_unix_loopback.sock"
+#define BENCH_SHM_PATH "/tmp/bench_shm_loopback.sock"
+
+typedef struct {
+    const char *name;
+    IOInterface *listener;
+    size_t frame_bytes;
+    bool sink_only;     // Только прием потока (прогон пачек)
+    bool ok;
+} BenchServer;
+
+typedef struct {
+    uint64_t *samples;
+    size_t count;
+} SampleSet;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Чтение ровно length байт (как receive_protocol_message, но без разбора и журнала)
+static bool read_full(IOInterface *io, int handle, void *buffer, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = io->receive_data(handle, (char*)buffer + done, length - done);
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// Сервер: первое подключение - эхо кадров, второе - прием потока до EOF и подтверждение
+static void* server_thread(void *arg) {
+    BenchServer *server = (BenchServer*)arg;
+    IOInterface *io = server->listener;
+    char *buffer = malloc(BENCH_STREAM_CHUNK);
+    server->ok = false;
+    if (!buffer) return NULL;
+
+    int handle;
+    if (!server->sink_only) {
+        handle = io->accept(io, NULL, 0, NULL);
+        if (handle < 0) goto cleanup;
+        while (read_full(io, handle, buffer, server->frame_bytes)) {
+            if (io->send_data(handle, buffer, server->frame_bytes) != (ssize_t)server->frame_bytes) break;
+        }
+        io->disconnect(io, handle);
+    }
+
+    handle = io->accept(io, NULL, 0, NULL);
+    if (handle < 0) goto cleanup;
+    uint64_t total = 0;
+    ssize_t n;
+    while ((n = io->receive_data(handle, buffer, BENCH_STREAM_CHUNK)) > 0) total += (uint64_t)n;
+    io->send_data(handle, &total, sizeof(total));
+    io->disconnect(io, handle);
+    server->ok = true;
+
+cleanup:
+    free(buffer);
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_latency(const char *name, SampleSet *set) {
+    if (set->count == 0) {
+        printf("  %-9s latency: no samples\n", name);
+        return;
+    }
+    qsort(set->samples, set->count, sizeof(uint64_t), compare_u64);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < set->count; ++i) sum += set->samples[i];
+    printf("  %-9s latency: min %7.2f  avg %7.2f  p50 %7.2f  p99 %7.2f  max %8.2f us  (%zu rounds)\n", name,
+           set->samples[0] / 1e3, (double)sum / set->count / 1e3,
+           set->samples[set->count / 2] / 1e3, set->samples[(set->count * 99) / 100] / 1e3,
+           set->samples[set->count - 1] / 1e3, set->count);
+}
+
+// Вывод слоя IO (подключения, закрытия) не нужен: печатаются только итоги
+static int saved_stdout = -1, saved_stderr = -1;
+
+static void output_quiet(void) {
+    fflush(stdout);
+    fflush(stderr);
+    saved_stdout = dup(STDOUT_FILENO);
+    saved_stderr = dup(STDERR_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        close(devnull);
+    }
+}
+
+static void output_restore(void) {
+    fflush(stdout);
+    fflush(stderr);
+    if (saved_stdout >= 0) { dup2(saved_stdout, STDOUT_FILENO); close(saved_stdout); saved_stdout = -1; }
+    if (saved_stderr >= 0) { dup2(saved_stderr, STDERR_FILENO); close(saved_stderr); saved_stderr = -1; }
+}
+
+// Прогон одного транспорта: listener и client - интерфейсы одного типа
+static bool run_transport(const char *name, IOInterface *listener, IOInterface *client,
+                          int rounds, size_t frame_bytes, uint64_t stream_bytes) {
+    bool result = false;
+    SampleSet latency = { calloc((size_t)rounds, sizeof(uint64_t)), 0 };
+    char *frame = calloc(1, frame_bytes);
+    char *chunk = calloc(1, BENCH_STREAM_CHUNK);
+    pthread_t tid = 0;
+    BenchServer server = { name, listener, frame_bytes, false, false };
+    int handle = -1;
+    double mb_per_s = 0.0;
+
+    output_quiet();
+    if (!latency.samples || !frame || !chunk) goto cleanup;
+    if (listener->listen(listener) < 0) goto cleanup;
+    if (pthread_create(&tid, NULL, server_thread, &server) != 0) { tid = 0; goto cleanup; }
+
+    // Кадр: заголовок протокола + тело заданной длины
+    MessageHeader *header = (MessageHeader*)frame;
+    header->address = LOGICAL_ADDRESS_UVM_VAL;
+    header->message_type = MESSAGE_TYPE_INIT_CHANNEL;
+    header->body_length = htons((uint16_t)(frame_bytes - sizeof(MessageHeader)));
+
+    handle = client->connect(client);
+    if (handle < 0) goto cleanup;
+    for (int r = 0; r < rounds; ++r) {
+        uint64_t t0 = now_ns();
+        if (client->send_data(handle, frame, frame_bytes) != (ssize_t)frame_bytes) goto cleanup;
+        if (!read_full(client, handle, frame, frame_bytes)) goto cleanup;
+        latency.samples[latency.count++] = now_ns() - t0;
+    }
+    client->disconnect(client, handle);
+
+    handle = client->connect(client);
+    if (handle < 0) goto cleanup;
+    uint64_t t1 = now_ns();
+    for (uint64_t sent = 0; sent < stream_bytes; sent += BENCH_STREAM_CHUNK) {
+        if (client->send_data(handle, chunk, BENCH_STREAM_CHUNK) != BENCH_STREAM_CHUNK) goto cleanup;
+    }
+    shutdown(handle, SHUT_WR);
+    uint64_t received = 0;
+    if (!read_full(client, handle, &received, sizeof(received)) || received != stream_bytes) goto cleanup;
+    mb_per_s = (stream_bytes / (1024.0 * 1024.0)) / ((now_ns() - t1) / 1e9);
+    result = true;
+
+cleanup:
+    if (handle >= 0) client->disconnect(client, handle);
+    if (tid) {
+        if (!result) shutdown(listener->io_handle, SHUT_RDWR); // Снимаем сервер с accept
+        pthread_join(tid, NULL);
+    }
+    output_restore();
+    if (result && server.ok) {
+        print_latency(name, &latency);
+        printf("  %-9s throughput: %8.1f MB/s  (%llu MB in %d KB writes)\n", name, mb_per_s,
+               (unsigned long long)(stream_bytes >> 20), BENCH_STREAM_CHUNK / 1024);
+    } else {
+        fprintf(stderr, "bench_unix_loopback: %s run failed.\n", name);
+    }
+    free(latency.samples);
+    free(frame);
+    free(chunk);
+    return result && server.ok;
+}
+
+static uint64_t cpu_time_ns(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * 1000000000ull +
+           ((uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec) * 1000ull;
+}
+
+// Прогон пачек: messages кадров по BENCH_BURST за отправку, сервер принимает поток до EOF
+static bool run_burst(const char *name, IOInterface *listener, IOInterface *client, int messages, size_t frame_bytes) {
+    bool result = false;
+    char *frame = calloc(1, frame_bytes);
+    pthread_t tid = 0;
+    BenchServer server = { name, listener, frame_bytes, true, false };
+    int handle = -1;
+    double seconds = 0.0, cpu_ns = 0.0;
+    IOSendRequest requests[BENCH_BURST];
+    uint64_t expected = (uint64_t)messages * frame_bytes;
+
+    output_quiet();
+    if (!frame) goto cleanup;
+    if (listener->listen(listener) < 0) goto cleanup;
+    if (pthread_create(&tid, NULL, server_thread, &server) != 0) { tid = 0; goto cleanup; }
+
+    handle = client->connect(client);
+    if (handle < 0) goto cleanup;
+    uint64_t t0 = now_ns(), c0 = cpu_time_ns();
+    for (int sent = 0; sent < messages; sent += BENCH_BURST) {
+        int n = messages - sent < BENCH_BURST ? messages - sent : BENCH_BURST;
+        if (client->type == IO_TYPE_URING) {
+            for (int i = 0; i < n; ++i) {
+                requests[i].handle = handle;
+                requests[i].buffer = frame;
+                requests[i].length = frame_bytes;
+                requests[i].result = -1;
+            }
+            if (uring_send_batch(requests, (size_t)n) != 0) goto cleanup;
+        } else {
+            for (int i = 0; i < n; ++i) {
+                if (client->send_data(handle, frame, frame_bytes) != (ssize_t)frame_bytes) goto cleanup;
+            }
+        }
+    }
+    shutdown(handle, SHUT_WR);
+    uint64_t received = 0;
+    if (!read_full(client, handle, &received, sizeof(received)) || received != expected) goto cleanup;
+    seconds = (now_ns() - t0) / 1e9;
+    cpu_ns = (double)(cpu_time_ns() - c0);
+    result = true;
+
+cleanup:
+    if (handle >= 0) client->disconnect(client, handle);
+    if (tid) {
+        if (!result) shutdown(listener->io_handle, SHUT_RDWR);
+        pthread_join(tid, NULL);
+    }
+    output_restore();
+    if (result && server.ok) {
+        printf("  %-9s burst: %10.0f msg/s  %6.3f us CPU/msg  (%d messages, %d per send)\n", name,
+               messages / seconds, cpu_ns / messages / 1e3, messages, BENCH_BURST);
+    } else {
+        fprintf(stderr, "bench_unix_loopback: %s burst run failed.\n", name);
+    }
+    free(frame);
+    return result && server.ok;
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = BENCH_DEFAULT_ROUNDS;
+    int body_bytes = BENCH_DEFAULT_BODY_BYTES;
+    int stream_mb = BENCH_DEFAULT_STREAM_MB;
+    if (argc > 1) rounds = atoi(argv[1]);
+    if (argc > 2) body_bytes = atoi(argv[2]);
+    if (argc > 3) stream_mb = atoi(argv[3]);
+    if (rounds <= 0) rounds = BENCH_DEFAULT_ROUNDS;
+    if (body_bytes < 0 || body_bytes > MAX_MESSAGE_BODY_SIZE) body_bytes = BENCH_DEFAULT_BODY_BYTES;
+    if (stream_mb <= 0) stream_mb = BENCH_DEFAULT_STREAM_MB;
+    size_t frame_bytes = sizeof(MessageHeader) + (size_t)body_bytes;
+    uint64_t stream_bytes = (uint64_t)stream_mb << 20;
+
+    printf("Loopback transports: %d rounds of %zu-byte frames, %d MB stream\n", rounds, frame_bytes, stream_mb);
+
+    EthernetConfig tcp_config = {0};
+    strncpy(tcp_config.target_ip, "127.0.0.1", sizeof(tcp_config.target_ip) - 1);
+    tcp_config.port = BENCH_TCP_PORT;
+    UnixConfig unix_config = {0};
+    strncpy(unix_config.path, BENCH_UNIX_PATH, sizeof(unix_config.path) - 1);
+
+    IOInterface *tcp_listener = create_ethernet_interface(&tcp_config);
+    IOInterface *tcp_client = create_ethernet_interface(&tcp_config);
+    EthernetConfig uring_config = tcp_config;
+    uring_config.port = BENCH_URING_PORT;
+    output_quiet();
+    IOInterface *uring_listener = create_uring_interface(&uring_config); // Без io_uring - Ethernet
+    IOInterface *uring_client = create_uring_interface(&uring_config);
+    output_restore();
+    IOInterface *unix_listener = create_unix_interface(&unix_config);
+    IOInterface *unix_client = create_unix_interface(&unix_config);
+    UnixConfig shm_config = {0};
+    strncpy(shm_config.path, BENCH_SHM_PATH, sizeof(shm_config.path) - 1);
+    IOInterface *shm_listener = create_shm_interface(&shm_config);
+    IOInterface *shm_client = create_shm_interface(&shm_config);
+    int status = EXIT_FAILURE;
+    if (tcp_listener && tcp_client && uring_listener && uring_client && unix_listener && unix_client &&
+        shm_listener && shm_client) {
+        const char *uring_name = uring_client->type == IO_TYPE_URING ? "uring" : "uring(off)";
+        bool ok = run_transport("ethernet", tcp_listener, tcp_client, rounds, frame_bytes, stream_bytes);
+        ok = run_transport(uring_name, uring_listener, uring_client, rounds, frame_bytes, stream_bytes) && ok;
+        ok = run_transport("unix", unix_listener, unix_client, rounds, frame_bytes, stream_bytes) && ok;
+        ok = run_transport("shm", shm_listener, shm_client, rounds, frame_bytes, stream_bytes) && ok;
+        int burst_messages = rounds * BENCH_BURST_ROUNDS_FACTOR;
+        ok = run_burst("ethernet", tcp_listener, tcp_client, burst_messages, frame_bytes) && ok;
+        ok = run_burst(uring_name, uring_listener, uring_client, burst_messages, frame_bytes) && ok;
+        if (ok) status = EXIT_SUCCESS;
+    }
+
+    output_quiet();
+    if (tcp_listener) tcp_listener->destroy(tcp_listener);
+    if (tcp_client) tcp_client->destroy(tcp_client);
+    if (uring_listener) uring_listener->destroy(uring_listener);
+    if (uring_client) uring_client->destroy(uring_client);
+    if (unix_listener) unix_listener->destroy(unix_listener);
+    if (unix_client) unix_client->destroy(unix_client);
+    if (shm_listener) shm_listener->destroy(shm_listener);
+    if (shm_client) shm_client->destroy(shm_client);
+    output_restore();
+    return status;
+}
@@ -0,0 +1,263 @@
+/*
+ * bench/bench_zerocopy.c
+ *
+ * Описание:
+ * Процессорное время отправителя на крупный кадр (по умолчанию тело 32 КБ, как у REF_AZIMUTH)
+ * при обычной отправке Ethernet (копирование в ядро) и при MSG_ZEROCOPY с пулом буферов,
+ * как у отправителя УВМ: буфер занимается снова только после уведомления ядра.
+ * Сервер-поток принимает поток кадров до EOF и подтверждает число байт; время процессора
+ * считается только для потока-отправителя (RUSAGE_THREAD).
+ * На петле (127.0.0.1) ядро все равно копирует данные при доставке получателю и помечает
+ * такие отправки как скопированные - выигрыш виден при отправке на другой узел:
+ * тогда укажите адрес и порт запущенного там приемника, принимающего два подключения
+ * подряд (подтверждение приема от внешнего приемника не ждется).
+ * Запуск: make bench && ./bench/bench_zerocopy [кадров] [размер_тела] [адрес порт]
+ */
+#define _GNU_SOURCE // Для RUSAGE_THREAD
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <arpa/inet.h>
+
+#include "../io/io_interface.h"
+#include "../protocol/protocol_defs.h"
+
+#define BENCH_DEFAULT_FRAMES 20000
+#define BENCH_DEFAULT_BODY_BYTES 32768
+#define BENCH_TCP_PORT 18097
+#define BENCH_POOL_SIZE 16          // Как UVM_ZC_POOL_SIZE отправителя УВМ
+#define BENCH_WAIT_MS 10
+#define BENCH_SINK_CHUNK (64 * 1024)
+
+typedef struct {
+    IOInterface *listener;
+    int connections;    // Сколько подключений принять (по одному на прогон)
+    bool ok;
+} BenchSink;
+
+// Итоги прогона (печатаются после остановки приемника, чтобы не смешиваться с выводом слоя IO)
+typedef struct {
+    const char *name;
+    bool zerocopy;
+    bool ok;
+    double mb_per_s;
+    double cpu_us_per_frame;
+    EthernetZcStats zc;     // Прирост счетчиков zero-copy за прогон
+} BenchResult;
+
+typedef struct {
+    char *buffer;
+    EthernetZcTicket ticket;
+    bool busy;
+} BenchBuffer;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t thread_cpu_ns(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return ((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * 1000000000ull +
+           ((uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec) * 1000ull;
+}
+
+// Приемник: поток до EOF, затем подтверждение числа принятых байт
+static void* sink_thread(void *arg) {
+    BenchSink *sink = (BenchSink*)arg;
+    IOInterface *io = sink->listener;
+    char *buffer = malloc(BENCH_SINK_CHUNK);
+    sink->ok = false;
+    if (!buffer) return NULL;
+    for (int c = 0; c < sink->connections; ++c) {
+        int handle = io->accept(io, NULL, 0, NULL);
+        if (handle < 0) goto cleanup;
+        uint64_t total = 0;
+        ssize_t n;
+        while ((n = io->receive_data(handle, buffer, BENCH_SINK_CHUNK)) > 0) total += (uint64_t)n;
+        io->send_data(handle, &total, sizeof(total));
+        io->disconnect(io, handle);
+    }
+    sink->ok = true;
+
+cleanup:
+    free(buffer);
+    return NULL;
+}
+
+// Вывод слоя IO (подключения, закрытия) не нужен: печатаются только итоги
+static int saved_stdout = -1, saved_stderr = -1;
+
+static void output_quiet(void) {
+    fflush(stdout);
+    fflush(stderr);
+    saved_stdout = dup(STDOUT_FILENO);
+    saved_stderr = dup(STDERR_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        close(devnull);
+    }
+}
+
+static void output_restore(void) {
+    fflush(stdout);
+    fflush(stderr);
+    if (saved_stdout >= 0) { dup2(saved_stdout, STDOUT_FILENO); close(saved_stdout); saved_stdout = -1; }
+    if (saved_stderr >= 0) { dup2(saved_stderr, STDERR_FILENO); close(saved_stderr); saved_stderr = -1; }
+}
+
+// Свободный буфер пула; при занятом пуле - ожидание уведомлений ядра
+static BenchBuffer* pool_acquire(BenchBuffer *pool, int handle) {
+    while (true) {
+        for (int i = 0; i < BENCH_POOL_SIZE; ++i) {
+            if (pool[i].busy && ethernet_zerocopy_released(handle, &pool[i].ticket)) pool[i].busy = false;
+            if (!pool[i].busy) return &pool[i];
+        }
+        ethernet_zerocopy_wait(handle, BENCH_WAIT_MS);
+    }
+}
+
+// Прогон: frames кадров по одному соединению; confirm - ждать подтверждения приемника
+static void run_send(BenchResult *result, IOInterface *client, BenchBuffer *pool,
+                     int frames, size_t frame_bytes, bool confirm) {
+    bool zerocopy = result->zerocopy;
+    EthernetZcStats before, after;
+    ethernet_zerocopy_stats(&before);
+    result->ok = false;
+
+    int handle = client->connect(client);
+    if (handle < 0) return;
+    uint64_t t0 = now_ns(), c0 = thread_cpu_ns();
+    for (int i = 0; i < frames; ++i) {
+        BenchBuffer *buffer = zerocopy ? pool_acquire(pool, handle) : &pool[i % BENCH_POOL_SIZE];
+        ssize_t sent;
+        if (zerocopy) {
+            sent = ethernet_send_zerocopy(handle, buffer->buffer, frame_bytes, &buffer->ticket);
+            buffer->busy = buffer->ticket.pending;
+        } else {
+            sent = client->send_data(handle, buffer->buffer, frame_bytes);
+        }
+        if (sent != (ssize_t)frame_bytes) goto cleanup;
+    }
+    for (int i = 0; zerocopy && i < BENCH_POOL_SIZE; ++i) { // Все буферы возвращены ядром
+        while (pool[i].busy && !ethernet_zerocopy_released(handle, &pool[i].ticket)) {
+            ethernet_zerocopy_wait(handle, BENCH_WAIT_MS);
+        }
+        pool[i].busy = false;
+    }
+    double cpu_ns = (double)(thread_cpu_ns() - c0);
+    shutdown(handle, SHUT_WR);
+    if (confirm) {
+        uint64_t received = 0;
+        size_t done = 0;
+        while (done < sizeof(received)) {
+            ssize_t n = client->receive_data(handle, (char*)&received + done, sizeof(received) - done);
+            if (n <= 0) goto cleanup;
+            done += (size_t)n;
+        }
+        if (received != (uint64_t)frames * frame_bytes) goto cleanup;
+    }
+    double seconds = (now_ns() - t0) / 1e9;
+    result->mb_per_s = ((double)frames * frame_bytes / (1024.0 * 1024.0)) / seconds;
+    result->cpu_us_per_frame = cpu_ns / frames / 1e3;
+    result->ok = true;
+
+cleanup:
+    client->disconnect(client, handle);
+    ethernet_zerocopy_stats(&after);
+    result->zc.zerocopy_sends = after.zerocopy_sends - before.zerocopy_sends;
+    result->zc.zerocopy_bytes = after.zerocopy_bytes - before.zerocopy_bytes;
+    result->zc.kernel_copied = after.kernel_copied - before.kernel_copied;
+    result->zc.fallback_bytes = after.fallback_bytes - before.fallback_bytes;
+}
+
+static void print_result(const BenchResult *result) {
+    if (!result->ok) {
+        fprintf(stderr, "bench_zerocopy: %s run failed.\n", result->name);
+        return;
+    }
+    printf("  %-8s %8.1f MB/s  %7.2f us CPU/frame (sender)", result->name, result->mb_per_s, result->cpu_us_per_frame);
+    if (result->zerocopy) {
+        printf("  zero-copy %llu sends/%llu MB, kernel-copied %llu, fallback %llu KB",
+               (unsigned long long)result->zc.zerocopy_sends, (unsigned long long)(result->zc.zerocopy_bytes >> 20),
+               (unsigned long long)result->zc.kernel_copied, (unsigned long long)(result->zc.fallback_bytes >> 10));
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    int frames = BENCH_DEFAULT_FRAMES;
+    int body_bytes = BENCH_DEFAULT_BODY_BYTES;
+    if (argc > 1) frames = atoi(argv[1]);
+    if (argc > 2) body_bytes = atoi(argv[2]);
+    if (frames <= 0) frames = BENCH_DEFAULT_FRAMES;
+    if (body_bytes <= 0 || body_bytes > MAX_MESSAGE_BODY_SIZE) body_bytes = BENCH_DEFAULT_BODY_BYTES;
+    size_t frame_bytes = sizeof(MessageHeader) + (size_t)body_bytes;
+    bool remote = argc > 4;
+
+    EthernetConfig tcp_config = {0};
+    strncpy(tcp_config.target_ip, remote ? argv[3] : "127.0.0.1", sizeof(tcp_config.target_ip) - 1);
+    tcp_config.port = remote ? (uint16_t)atoi(argv[4]) : BENCH_TCP_PORT;
+    EthernetConfig zc_config = tcp_config;
+    zc_config.zerocopy_threshold = (uint32_t)frame_bytes;
+
+    printf("Zero-copy sends: %d frames of %zu bytes to %s:%u\n", frames, frame_bytes,
+           tcp_config.target_ip, tcp_config.port);
+
+    BenchBuffer pool[BENCH_POOL_SIZE] = {0};
+    for (int i = 0; i < BENCH_POOL_SIZE; ++i) {
+        pool[i].buffer = calloc(1, frame_bytes);
+        if (!pool[i].buffer) {
+            fprintf(stderr, "bench_zerocopy: Out of memory\n");
+            return EXIT_FAILURE;
+        }
+        MessageHeader *header = (MessageHeader*)pool[i].buffer;
+        header->address = LOGICAL_ADDRESS_UVM_VAL;
+        header->message_type = MESSAGE_TYPE_INIT_CHANNEL;
+        header->body_length = htons((uint16_t)body_bytes);
+    }
+
+    IOInterface *listener = remote ? NULL : create_ethernet_interface(&tcp_config);
+    IOInterface *copy_client = create_ethernet_interface(&tcp_config);
+    IOInterface *zc_client = create_ethernet_interface(&zc_config);
+    BenchSink sink = { listener, 2, false };
+    BenchResult results[2] = { { "copy", false, false, 0.0, 0.0, {0} }, { "zerocopy", true, false, 0.0, 0.0, {0} } };
+    pthread_t tid = 0;
+    int status = EXIT_FAILURE;
+
+    output_quiet();
+    if (copy_client && zc_client && (remote || listener)) {
+        bool listening = remote || listener->listen(listener) >= 0;
+        if (listening && (remote || pthread_create(&tid, NULL, sink_thread, &sink) == 0)) {
+            run_send(&results[0], copy_client, pool, frames, frame_bytes, !remote);
+            run_send(&results[1], zc_client, pool, frames, frame_bytes, !remote);
+            bool ok = results[0].ok && results[1].ok;
+            if (tid) {
+                if (!ok) shutdown(listener->io_handle, SHUT_RDWR); // Снимаем приемник с accept
+                pthread_join(tid, NULL);
+                ok = ok && sink.ok;
+            }
+            if (ok) status = EXIT_SUCCESS;
+        }
+    }
+    if (listener) listener->destroy(listener);
+    if (copy_client) copy_client->destroy(copy_client);
+    if (zc_client) zc_client->destroy(zc_client);
+    output_restore();
+
+    print_result(&results[0]);
+    print_result(&results[1]);
+    for (int i = 0; i < BENCH_POOL_SIZE; ++i) free(pool[i].buffer);
+    return status;
+}
@@ -9,6 +9,7 @@
 #include <string.h> // Для strcpy, strcasecmp
 #include <strings.h> // Для strcasecmp в некоторых системах (хотя string.h обычно достаточно)
 #include <stdbool.h>
+#include <arpa/inet.h> // inet_pton для проверки host
 #include "ini.h"
 // #include "../protocol/protocol_defs.h" // LogicalAddress уже в config.h через AppConfig -> SvmInstanceSettings
 
@@ -21,6 +22,78 @@ static bool parse_ini_boolean(const char* value) {
             strcmp(value, "1") == 0);
 }
 
+// Разбор распределения задержки: none | fixed:<мс> | uniform:<мин>:<макс> | lognormal:<медиана>:<sigma>
+static bool parse_latency(const char *value, SvmFaultProfileSettings *profile) {
+    char kind[16] = {0};
+    double a = 0.0, b = 0.0;
+    int n = sscanf(value, "%15[a-z]:%lf:%lf", kind, &a, &b);
+    if (n >= 1 && strcasecmp(kind, "none") == 0) {
+        profile->latency_dist = LATENCY_NONE;
+    } else if (n >= 2 && strcasecmp(kind, "fixed") == 0 && a >= 0.0) {
+        profile->latency_dist = LATENCY_FIXED;
+    } else if (n == 3 && strcasecmp(kind, "uniform") == 0 && a >= 0.0 && b >= a) {
+        profile->latency_dist = LATENCY_UNIFORM;
+    } else if (n == 3 && strcasecmp(kind, "lognormal") == 0 && a > 0.0 && b >= 0.0) {
+        profile->latency_dist = LATENCY_LOGNORMAL;
+    } else {
+        return false;
+    }
+    profile->latency_a_ms = a;
+    profile->latency_b_ms = b;
+    return true;
+}
+
+// Разбор вероятности "<p>" для всех типов (name == base) или для одного типа (name == base_<тип>)
+static bool parse_type_probability(const char *name, const char *base, const char *value, float table[256]) {
+    size_t base_len = strlen(base);
+    if (strncasecmp(name, base, base_len) != 0) return false;
+    double p = atof(value);
+    if (p < 0.0 || p > 1.0) {
+        fprintf(stderr, "Warning: Invalid %s value '%s' (expected 0..1). Ignored.\n", name, value);
+        return true;
+    }
+    if (name[base_len] == '\0') {
+        for (int t = 0; t < 256; ++t) table[t] = (float)p;
+        return true;
+    }
+    int type = -1;
+    if (name[base_len] == '_' && sscanf(name + base_len + 1, "%d", &type) == 1 && type >= 0 && type < 256) {
+        table[type] = (float)p;
+    } else {
+        fprintf(stderr, "Warning: Invalid message type in '%s'. Ignored.\n", name);
+    }
+    return true;
+}
+
+// Разбор номера порта TCP (1..65535)
+static bool parse_port(const char *text, uint16_t *port) {
+    char *end = NULL;
+    long p = strtol(text, &end, 10);
+    if (end == text || p < 1 || p > 65535) return false;
+    while (*end == ' ' || *end == '\t') end++;
+    if (*end != '\0') return false;
+    *port = (uint16_t)p;
+    return true;
+}
+
+// Разбор узла СВ-М: "адрес" или "адрес:порт"; адрес - IPv4, как его ожидает ethernet_connect
+static bool parse_svm_host(const char *value, SvmEthernetConfig *eth) {
+    char address[sizeof(eth->target_ip)];
+    uint16_t port = eth->port;
+    if (strlen(value) >= sizeof(address)) return false;
+    strcpy(address, value);
+    char *colon = strchr(address, ':');
+    if (colon) {
+        *colon = '\0';
+        if (!parse_port(colon + 1, &port)) return false;
+    }
+    struct in_addr parsed;
+    if (inet_pton(AF_INET, address, &parsed) != 1) return false;
+    strcpy(eth->target_ip, address);
+    eth->port = port;
+    return true;
+}
+
 // Обработчик для библиотеки inih
 static int config_handler(void* user, const char* section, const char* name,
                           const char* value) {
@@ -41,6 +114,69 @@ static int config_handler(void* user, const char* section, const char* name,
                 fprintf(stderr, "Warning: Invalid uvm_keepalive_timeout_sec value '%s'. Using default.\n", value);
                 pconfig->uvm_keepalive_timeout_sec = 15; // Восстанавливаем дефолт, если он был изменен
             }
+        } else if (MATCH_PARAM("uvm_connect_timeout_ms")) {
+            pconfig->uvm_connect_timeout_ms = atoi(value);
+            if (pconfig->uvm_connect_timeout_ms <= 0) { // Валидация
+                fprintf(stderr, "Warning: Invalid uvm_connect_timeout_ms value '%s'. Using default.\n", value);
+                pconfig->uvm_connect_timeout_ms = 3000;
+            }
+        } else if (MATCH_PARAM("uvm_reconnect_initial_ms")) {
+            pconfig->uvm_reconnect_initial_ms = atoi(value);
+            if (pconfig->uvm_reconnect_initial_ms < 0) { // Валидация
+                fprintf(stderr, "Warning: Invalid uvm_reconnect_initial_ms value '%s'. Using default.\n", value);
+                pconfig->uvm_reconnect_initial_ms = 500;
+            }
+        } else if (MATCH_PARAM("uvm_reconnect_max_ms")) {
+            pconfig->uvm_reconnect_max_ms = atoi(value);
+            if (pconfig->uvm_reconnect_max_ms <= 0) { // Валидация
+                fprintf(stderr, "Warning: Invalid uvm_reconnect_max_ms value '%s'. Using default.\n", value);
+                pconfig->uvm_reconnect_max_ms = 30000;
+            }
+        } else if (MATCH_PARAM("mux_port")) {
+            pconfig->mux_port = atoi(value);
+            if (pconfig->mux_port < 0 || pconfig->mux_port > 65535) { // Валидация
+                fprintf(stderr, "Warning: Invalid mux_port value '%s'. Multiplexing disabled.\n", value);
+                pconfig->mux_port = 0;
+            }
+        } else if (MATCH_PARAM("unix_socket_dir")) {
+            snprintf(pconfig->unix_socket_dir, sizeof(pconfig->unix_socket_dir), "%s", value);
+        } else if (MATCH_PARAM("svm_instances")) {
+            if (parse_instance_slice(value, &pconfig->svm_instance_first, &pconfig->svm_instance_count) != 0) {
+                fprintf(stderr, "Warning: Invalid svm_instances value '%s'. Running all instances.\n", value);
+                pconfig->svm_instance_first = 0;
+                pconfig->svm_instance_count = 0;
+            }
+        } else if (MATCH_PARAM("uvm_node_stats_interval_sec")) {
+            pconfig->uvm_node_stats_interval_sec = atoi(value);
+            if (pconfig->uvm_node_stats_interval_sec < 0) { // Валидация
+                fprintf(stderr, "Warning: Invalid uvm_node_stats_interval_sec value '%s'. Using default.\n", value);
+                pconfig->uvm_node_stats_interval_sec = 0;
+            }
+        } else if (MATCH_PARAM("socket_profile")) {
+            if (socket_profile_parse(value, &pconfig->socket_profile) != 0) {
+                fprintf(stderr, "Warning: Unknown socket_profile '%s'. Using default.\n", value);
+                pconfig->socket_profile = SOCKET_PROFILE_DEFAULT;
+            }
+        } else if (MATCH_PARAM("tcp_info_interval_ms")) {
+            pconfig->tcp_info_interval_ms = atoi(value);
+            if (pconfig->tcp_info_interval_ms < 0) { // Валидация
+                fprintf(stderr, "Warning: Invalid tcp_info_interval_ms value '%s'. Sampling disabled.\n", value);
+                pconfig->tcp_info_interval_ms = 0;
+            }
+        } else if (MATCH_PARAM("confirm_init_signature")) {
+            pconfig->confirm_init_signature = parse_ini_boolean(value);
+        } else if (MATCH_PARAM("zerocopy_threshold")) {
+            pconfig->zerocopy_threshold = atoi(value);
+            if (pconfig->zerocopy_threshold < 0) { // Валидация
+                fprintf(stderr, "Warning: Invalid zerocopy_threshold value '%s'. Zero-copy disabled.\n", value);
+                pconfig->zerocopy_threshold = 0;
+            }
+        } else if (MATCH_PARAM("svm_worker_threads")) {
+            pconfig->svm_worker_threads = atoi(value);
+            if (pconfig->svm_worker_threads < 0) { // Валидация
+                fprintf(stderr, "Warning: Invalid svm_worker_threads value '%s'. Using default.\n", value);
+                pconfig->svm_worker_threads = 0;
+            }
         }
         return 1; // Секция обработана
     } else if (MATCH_SECTION("ethernet_uvm_target")) {
@@ -67,6 +203,39 @@ static int config_handler(void* user, const char* section, const char* name,
             pconfig->serial.stop_bits = atoi(value);
         }
         return 1; // Секция обработана
+    } else if (MATCH_SECTION("data_sink")) {
+        if (MATCH_PARAM("enabled")) {
+            pconfig->data_sink_enabled = parse_ini_boolean(value);
+        } else if (MATCH_PARAM("output_dir")) {
+            snprintf(pconfig->data_sink_output_dir, sizeof(pconfig->data_sink_output_dir), "%s", value);
+        } else if (MATCH_PARAM("extent_mb")) {
+            pconfig->data_sink_extent_mb = atoi(value);
+            if (pconfig->data_sink_extent_mb <= 0) { // Валидация
+                fprintf(stderr, "Warning: Invalid data_sink extent_mb value '%s'. Using default.\n", value);
+                pconfig->data_sink_extent_mb = 64;
+            }
+        } else if (MATCH_PARAM("queue_capacity")) {
+            pconfig->data_sink_queue_capacity = atoi(value);
+            if (pconfig->data_sink_queue_capacity <= 0 || pconfig->data_sink_queue_capacity > 4096) {
+                fprintf(stderr, "Warning: Invalid data_sink queue_capacity value '%s'. Using default.\n", value);
+                pconfig->data_sink_queue_capacity = 32;
+            }
+        } else if (MATCH_PARAM("assemble_frames")) {
+            pconfig->frame_assembler_enabled = parse_ini_boolean(value);
+        } else if (MATCH_PARAM("frame_max_lines")) {
+            pconfig->frame_max_lines = atoi(value);
+            if (pconfig->frame_max_lines <= 0 || pconfig->frame_max_lines > 65535) {
+                fprintf(stderr, "Warning: Invalid frame_max_lines value '%s'. Using default.\n", value);
+                pconfig->frame_max_lines = 1024;
+            }
+        } else if (MATCH_PARAM("frame_line_bytes")) {
+            pconfig->frame_line_bytes = atoi(value);
+            if (pconfig->frame_line_bytes <= 0 || pconfig->frame_line_bytes > MAX_MESSAGE_BODY_SIZE) {
+                fprintf(stderr, "Warning: Invalid frame_line_bytes value '%s'. Using default.\n", value);
+                pconfig->frame_line_bytes = 4096;
+            }
+        }
+        return 1; // Секция обработана
     }
 
     // Затем пытаемся распознать секцию [settings_svmN]
@@ -78,7 +247,16 @@ static int config_handler(void* user, const char* section, const char* name,
             pconfig->svm_config_loaded[svm_id_set] = true;
 
             if (MATCH_PARAM("port")) {
-                pconfig->svm_ethernet[svm_id_set].port = (uint16_t)atoi(value);
+                if (!parse_port(value, &pconfig->svm_ethernet[svm_id_set].port)) {
+                    fprintf(stderr, "Warning: Invalid port '%s' for SVM %d. Using default %d.\n",
+                            value, svm_id_set, 8080 + svm_id_set);
+                    pconfig->svm_ethernet[svm_id_set].port = (uint16_t)(8080 + svm_id_set);
+                }
+            } else if (MATCH_PARAM("host")) { // "адрес" или "адрес:порт"
+                if (!parse_svm_host(value, &pconfig->svm_ethernet[svm_id_set])) {
+                    fprintf(stderr, "Warning: Invalid host '%s' for SVM %d (expected IPv4 address[:port]). Using target_ip.\n",
+                            value, svm_id_set);
+                }
             } else if (MATCH_PARAM("lak")) {
                 pconfig->svm_settings[svm_id_set].lak = (LogicalAddress)strtol(value, NULL, 0); // strtol для hex 0x...
             } else if (MATCH_PARAM("simulate_control_failure")) {
@@ -91,13 +269,33 @@ static int config_handler(void* user, const char* section, const char* name,
                 pconfig->svm_settings[svm_id_set].send_warning_on_confirm = parse_ini_boolean(value);
             } else if (MATCH_PARAM("warning_tks")) {
                 pconfig->svm_settings[svm_id_set].warning_tks = (uint8_t)atoi(value);
+            } else if (MATCH_PARAM("rng_seed")) {
+                pconfig->svm_settings[svm_id_set].rng_seed = strtoull(value, NULL, 0);
+            } else if (MATCH_PARAM("response_latency")) {
+                if (!parse_latency(value, &pconfig->svm_settings[svm_id_set].profile)) {
+                    fprintf(stderr, "Warning: Invalid response_latency '%s' for SVM %d. Ignored.\n", value, svm_id_set);
+                }
+            } else if (parse_type_probability(name, "drop_probability", value,
+                                              pconfig->svm_settings[svm_id_set].profile.drop_probability)) {
+                // Разобрано
+            } else if (parse_type_probability(name, "duplicate_probability", value,
+                                              pconfig->svm_settings[svm_id_set].profile.duplicate_probability)) {
+                // Разобрано
+            } else if (MATCH_PARAM("bandwidth_limit_kbps")) {
+                pconfig->svm_settings[svm_id_set].profile.bandwidth_limit_kbps = (uint32_t)strtoul(value, NULL, 0);
+            } else if (MATCH_PARAM("bandwidth_burst_bytes")) {
+                pconfig->svm_settings[svm_id_set].profile.bandwidth_burst_bytes = (uint32_t)strtoul(value, NULL, 0);
+            } else if (MATCH_PARAM("warning_period_ms")) {
+                pconfig->svm_settings[svm_id_set].profile.warning_period_ms = (uint32_t)strtoul(value, NULL, 0);
+            } else if (MATCH_PARAM("disconnect_after_ms")) {
+                pconfig->svm_settings[svm_id_set].profile.disconnect_after_ms = (uint32_t)strtoul(value, NULL, 0);
             }
             // else {
             //     printf("Config_handler: Unknown parameter '%s' in section [%s]\n", name, section);
             // }
             return 1; // Секция settings_svmN обработана (или параметр в ней)
         } else {
-            // Невалидный svm_id_set (например, settings_svm5, если MAX_SVM_INSTANCES=4)
+            // Невалидный svm_id_set (например, settings_svm16, если MAX_SVM_INSTANCES=16)
             fprintf(stderr, "Config_handler: Invalid SVM ID %d in section [%s]\n", svm_id_set, section);
             return 0; // Ошибка, остановить парсинг для этой строки
         }
@@ -130,9 +328,33 @@ int load_config(const char *filename, AppConfig *config) {
     config->serial.stop_bits = 1;
 
     config->uvm_keepalive_timeout_sec = 15; // Значение по умолчанию
+    config->uvm_connect_timeout_ms = 3000;
+    config->uvm_reconnect_initial_ms = 500;
+    config->uvm_reconnect_max_ms = 30000;
+    config->svm_worker_threads = 0; // По числу процессоров
+    config->mux_port = 0; // Без мультиплексирования
+    strncpy(config->unix_socket_dir, "/tmp", sizeof(config->unix_socket_dir)-1);
+    config->unix_socket_dir[sizeof(config->unix_socket_dir)-1] = '\0';
+    config->svm_instance_first = 0;
+    config->svm_instance_count = 0; // Все экземпляры
+    config->uvm_node_stats_interval_sec = 0;
+    config->zerocopy_threshold = 0; // Без zero-copy
+    config->socket_profile = SOCKET_PROFILE_DEFAULT; // Опции ядра
+    config->tcp_info_interval_ms = 0; // Без снимков TCP_INFO
+    config->confirm_init_signature = false; // Тело «Подтверждения инициализации» строго по Таблице 4.7
+
+    config->data_sink_enabled = true;
+    strncpy(config->data_sink_output_dir, "data", sizeof(config->data_sink_output_dir)-1);
+    config->data_sink_output_dir[sizeof(config->data_sink_output_dir)-1] = '\0';
+    config->data_sink_extent_mb = 64;
+    config->data_sink_queue_capacity = 32;
+    config->frame_assembler_enabled = true;
+    config->frame_max_lines = 1024;
+    config->frame_line_bytes = 4096;
 
     // Устанавливаем дефолты для всех слотов SVM
     for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        config->svm_ethernet[i].target_ip[0] = '\0'; // Пусто - адрес из [ethernet_uvm_target]
         config->svm_ethernet[i].port = 0; // Будет перезаписан из config.ini или установлен дефолт ниже
         config->svm_settings[i].lak = 0;  // Аналогично
         config->svm_settings[i].simulate_control_failure = false;
@@ -140,6 +362,8 @@ int load_config(const char *filename, AppConfig *config) {
         config->svm_settings[i].simulate_response_timeout = false;
         config->svm_settings[i].send_warning_on_confirm = false;
         config->svm_settings[i].warning_tks = 1; // TKS по умолчанию, если send_warning_on_confirm=true
+        config->svm_settings[i].rng_seed = 0;
+        memset(&config->svm_settings[i].profile, 0, sizeof(config->svm_settings[i].profile));
         config->svm_config_loaded[i] = false; // Сбрасываем флаг перед парсингом
     }
 
@@ -162,6 +386,13 @@ int load_config(const char *filename, AppConfig *config) {
         printf("Configuration parsed successfully from '%s'.\n", filename);
     }
 
+    if (strcasecmp(config->interface_type, "ethernet") != 0 && strcasecmp(config->interface_type, "serial") != 0 &&
+        strcasecmp(config->interface_type, "unix") != 0 && strcasecmp(config->interface_type, "shm") != 0 &&
+        strcasecmp(config->interface_type, "uring") != 0) {
+        fprintf(stderr, "Warning: Unknown interface_type '%s'. Using ethernet.\n", config->interface_type);
+        snprintf(config->interface_type, sizeof(config->interface_type), "%s", "ethernet");
+    }
+
     // 4. Финализация настроек SVM: подсчет найденных и установка дефолтов для недостающих/невалидных
     config->num_svm_configs_found = 0;
     for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
@@ -184,6 +415,10 @@ int load_config(const char *filename, AppConfig *config) {
         }
 
         // Общая валидация для всех слотов (загруженных и дефолтных)
+        if (config->svm_ethernet[i].target_ip[0] == '\0') { // Узел не задан - общий адрес УВМ-цели
+            snprintf(config->svm_ethernet[i].target_ip, sizeof(config->svm_ethernet[i].target_ip), "%s",
+                     config->uvm_ethernet_target.target_ip);
+        }
         if (config->svm_ethernet[i].port == 0 || config->svm_ethernet[i].port > 65535) {
              fprintf(stderr, "Warning: Invalid port %d for SVM %d after parsing/defaults. Resetting to default %d.\n", config->svm_ethernet[i].port, i, 8080 + i);
              config->svm_ethernet[i].port = 8080 + i;
@@ -208,13 +443,63 @@ int load_config(const char *filename, AppConfig *config) {
     printf("--- Effective Configuration ---\n");
     printf("  interface_type = %s\n", config->interface_type);
     printf("  uvm_keepalive_timeout_sec = %d\n", config->uvm_keepalive_timeout_sec);
+    printf("  uvm_connect_timeout_ms = %d\n", config->uvm_connect_timeout_ms);
+    printf("  uvm_reconnect: initial %d ms, max %d ms%s\n", config->uvm_reconnect_initial_ms,
+           config->uvm_reconnect_max_ms, config->uvm_reconnect_initial_ms ? "" : " (disabled)");
+    printf("  svm_worker_threads = %d%s\n", config->svm_worker_threads,
+           config->svm_worker_threads ? "" : " (CPU count)");
+    bool shm_transport = strcasecmp(config->interface_type, "shm") == 0;
+    bool unix_transport = shm_transport || strcasecmp(config->interface_type, "unix") == 0;
+    const char *transport_name = shm_transport ? "shared memory" : (unix_transport ? "Unix socket" :
+                                 (strcasecmp(config->interface_type, "uring") == 0 ? "TCP (io_uring)" : "TCP"));
+    if (strcasecmp(config->interface_type, "serial") == 0) {
+        printf("  transport: all SVMs multiplexed over serial port %s\n", config->serial.device);
+    } else if (config->mux_port > 0) {
+        printf("  transport: SVMs of each node multiplexed over %s %d (by LAK)\n",
+               unix_transport ? transport_name : "port", config->mux_port);
+    } else {
+        printf("  transport: one %s connection per SVM\n", transport_name);
+    }
+    if (!unix_transport && strcasecmp(config->interface_type, "serial") != 0) {
+        printf("  socket_profile = %s\n", socket_profile_name(config->socket_profile));
+        printf("  tcp_info_interval_ms = %d%s\n", config->tcp_info_interval_ms,
+               config->tcp_info_interval_ms ? "" : " (disabled)");
+    }
+    printf("  confirm_init_signature = %s\n", config->confirm_init_signature ? "true (parameter re-upload skipped when unchanged)" : "false");
+    if (unix_transport) {
+        printf("  unix_socket_dir = %s (socket svm_<port>.sock)\n", config->unix_socket_dir);
+    }
+    if (config->svm_instance_first >= MAX_SVM_INSTANCES) {
+        fprintf(stderr, "Warning: svm_instances starts beyond the last instance %d. Running all instances.\n", MAX_SVM_INSTANCES - 1);
+        config->svm_instance_first = 0;
+        config->svm_instance_count = 0;
+    }
+    if (config->svm_instance_count > 0) {
+        printf("  svm_instances = %d-%d\n", config->svm_instance_first,
+               config->svm_instance_first + config->svm_instance_count - 1);
+    } else {
+        printf("  svm_instances = %d-%d (all)\n", config->svm_instance_first, MAX_SVM_INSTANCES - 1);
+    }
+    printf("  uvm_node_stats_interval_sec = %d%s\n", config->uvm_node_stats_interval_sec,
+           config->uvm_node_stats_interval_sec ? "" : " (at exit only)");
+    if (config->zerocopy_threshold > 0) {
+        printf("  zerocopy_threshold = %d bytes (UVM sends over TCP)\n", config->zerocopy_threshold);
+    } else {
+        printf("  zerocopy_threshold = 0 (disabled)\n");
+    }
+    printf("  data_sink: %s, dir='%s', extent=%d MB, queue=%d lines\n", config->data_sink_enabled ? "enabled" : "disabled",
+           config->data_sink_output_dir, config->data_sink_extent_mb, config->data_sink_queue_capacity);
+    printf("  frame assembler: %s, max_lines=%d, line_bytes=%d\n", config->frame_assembler_enabled ? "enabled" : "disabled",
+           config->frame_max_lines, config->frame_line_bytes);
     printf("  UVM Target IP (for SVMs to connect to, if UVM were server): %s\n", config->uvm_ethernet_target.target_ip);
     // UVM является клиентом, поэтому target_ip из uvm_ethernet_target используется как IP машины с SVM
     // А порт для UVM-клиента берется из svm_ethernet[i].port
 
-    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) { // Показываем все слоты, даже если они дефолтные
-         printf("  SVM %d: Port=%u, LAK=0x%02X (Config loaded: %s)\n",
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) { // Ненастроенные слоты (не запускаются) - одной строкой ниже
+         if (!config->svm_config_loaded[i]) continue;
+         printf("  SVM %d: Host=%s, Port=%u, LAK=0x%02X (Config loaded: %s)\n",
                 i,
+                config->svm_ethernet[i].target_ip,
                 config->svm_ethernet[i].port,
                 config->svm_settings[i].lak,
                 config->svm_config_loaded[i] ? "Yes" : "No");
@@ -223,8 +508,43 @@ int load_config(const char *filename, AppConfig *config) {
          printf("    Disconnect After: %d messages\n", config->svm_settings[i].disconnect_after_messages);
          printf("    Simulate Response Timeout: %s\n", config->svm_settings[i].simulate_response_timeout ? "Yes" : "No");
          printf("    Send Warning on Confirm: %s (TKS: %u)\n", config->svm_settings[i].send_warning_on_confirm ? "Yes" : "No", config->svm_settings[i].warning_tks);
+         printf("    RNG Seed: %llu%s\n", (unsigned long long)config->svm_settings[i].rng_seed,
+                config->svm_settings[i].rng_seed ? "" : " (from time)");
+         const SvmFaultProfileSettings *profile = &config->svm_settings[i].profile;
+         static const char *latency_names[] = { "none", "fixed", "uniform", "lognormal" };
+         printf("    Profile: latency=%s(%.2f, %.2f), bandwidth=%u kbps (burst %u B), warning every %u ms, disconnect after %u ms\n",
+                latency_names[profile->latency_dist], profile->latency_a_ms, profile->latency_b_ms,
+                profile->bandwidth_limit_kbps, profile->bandwidth_burst_bytes,
+                profile->warning_period_ms, profile->disconnect_after_ms);
+    }
+    if (config->num_svm_configs_found < MAX_SVM_INSTANCES) {
+        printf("  Other %d SVM slots: not configured\n", MAX_SVM_INSTANCES - config->num_svm_configs_found);
     }
     printf("-----------------------------\n");
 
     return 0; // Успех, даже если файл не найден (используются дефолты)
-}
\ No newline at end of file
+}
+
+int parse_instance_slice(const char *text, int *first, int *count) {
+    char *end = NULL;
+    long a = strtol(text, &end, 10);
+    long b = a;
+    if (end == text || a < 0) return -1;
+    while (*end == ' ') end++;
+    if (*end == '-') {
+        const char *second = end + 1;
+        b = strtol(second, &end, 10);
+        if (end == second || b < a) return -1;
+    }
+    while (*end == ' ' || *end == '\t') end++;
+    if (*end != '\0' && *end != ';') return -1;
+    *first = (int)a;
+    *count = (int)(b - a + 1);
+    return 0;
+}
+
+bool config_instance_in_slice(const AppConfig *config, int svm_id) {
+    if (svm_id < config->svm_instance_first) return false;
+    return config->svm_instance_count <= 0 ||
+           svm_id < config->svm_instance_first + config->svm_instance_count;
+}
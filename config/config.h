@@ -11,7 +11,29 @@
 #include <stdbool.h> // <-- Добавляем для bool
 
 // Максимальное количество SVM, чьи настройки можно хранить и эмулировать
-#define MAX_SVM_INSTANCES 4
+// (с запасом для раздачи срезов --instances A-B нескольким узлам эмуляции)
+#define MAX_SVM_INSTANCES 16
+
+// Распределение задержки ответов СВ-М
+typedef enum {
+    LATENCY_NONE = 0,
+    LATENCY_FIXED,     // a = задержка
+    LATENCY_UNIFORM,   // [a, b]
+    LATENCY_LOGNORMAL  // a = медиана, b = sigma логарифма
+} LatencyDistribution;
+
+// Профиль нагрузки/сбоев экземпляра СВ-М (все по умолчанию выключено)
+typedef struct {
+    LatencyDistribution latency_dist;
+    double latency_a_ms;
+    double latency_b_ms;
+    float drop_probability[256];      // Вероятность потери исходящего сообщения по типу
+    float duplicate_probability[256]; // Вероятность повтора исходящего сообщения по типу
+    uint32_t bandwidth_limit_kbps;    // Ограничение полосы исходящих (кбит/с), 0 = нет
+    uint32_t bandwidth_burst_bytes;   // Емкость корзины токенов (байт), 0 = по умолчанию
+    uint32_t warning_period_ms;       // Период внеочередных «Предупреждений», 0 = выкл
+    uint32_t disconnect_after_ms;     // Отключение через N мс после подключения, 0 = выкл
+} SvmFaultProfileSettings;
 
 // Настройки, специфичные для одного SVM
 typedef struct {
@@ -22,11 +44,14 @@ typedef struct {
     bool simulate_response_timeout; // Имитировать задержку ответа (для таймаута UVM)?
     bool send_warning_on_confirm;   // Отправить Предупреждение вместо ConfirmInit?
     uint8_t warning_tks;            // Тип TKS для отправки в Предупреждении
+    uint64_t rng_seed;              // Зерно генератора эмуляции (0 = от времени запуска)
+    SvmFaultProfileSettings profile; // Профиль нагрузки/сбоев
     // Можно добавить другие: потеря пакетов, неверный номер сообщения и т.д.
 } SvmInstanceSettings;
 
 // Настройки Ethernet для одного SVM
 typedef struct {
+    char target_ip[40]; // Адрес узла, где запущен этот СВ-М (по умолчанию - из [ethernet_uvm_target])
     uint16_t port;
 } SvmEthernetConfig;
 
@@ -46,6 +71,28 @@ typedef struct {
     EthernetConfig uvm_ethernet_target; // Параметры цели для UVM
     SerialConfig serial;                // Параметры Serial
 	int uvm_keepalive_timeout_sec;
+    int uvm_connect_timeout_ms;         // Срок установления соединения УВМ с каждым СВ-М (мс)
+    int uvm_reconnect_initial_ms;       // Начальная задержка переподключения (мс; 0 - не переподключаться)
+    int uvm_reconnect_max_ms;           // Предельная задержка переподключения (мс)
+    int svm_worker_threads;             // Потоков в пуле обработчиков СВ-М (0 = по числу процессоров)
+    int mux_port;                       // Порт общего соединения для всех СВ-М узла (0 = у каждого СВ-М свое)
+    char unix_socket_dir[96];           // Каталог сокетов svm_<port>.sock при interface_type = unix/shm
+    int svm_instance_first;             // Срез экземпляров, запускаемых этим svm_app: первый ID
+    int svm_instance_count;             // ... и их число (0 = до конца диапазона)
+    int uvm_node_stats_interval_sec;    // Период вывода статистики по узлам СВ-М (0 = только при завершении)
+    int zerocopy_threshold;             // Кадры УВМ от этого размера (байт) - без копирования в ядро (0 = выкл)
+    SocketProfile socket_profile;       // Опции TCP-сокетов обеих сторон (ethernet/uring)
+    int tcp_info_interval_ms;           // Период снятия TCP_INFO соединений обеих сторон (0 = выкл)
+    bool confirm_init_signature;        // «Подтверждение инициализации» с подписью набора параметров (вне протокола)
+
+    // --- Приемник потоковых данных UVM ---
+    bool data_sink_enabled;          // Записывать строки данных в файлы?
+    char data_sink_output_dir[256];  // Каталог для файлов сеансов
+    int data_sink_extent_mb;         // Размер экстента предразмещения (МБ)
+    int data_sink_queue_capacity;    // Емкость очереди строк к потоку приемника (строк)
+    bool frame_assembler_enabled;    // Собирать строки К3/К4 в кадры?
+    int frame_max_lines;             // Максимальное число строк в кадре
+    int frame_line_bytes;            // Максимальный размер отсчетов одной строки (байт)
 
 } AppConfig;
 
@@ -54,4 +101,15 @@ typedef struct {
  */
 int load_config(const char *filename, AppConfig *config);
 
+/**
+ * @brief Разбирает срез экземпляров вида "A-B" или "A" (например, из командной строки svm_app).
+ * @return 0 при успехе (first/count заполнены), -1 при ошибке формата.
+ */
+int parse_instance_slice(const char *text, int *first, int *count);
+
+/**
+ * @brief Входит ли экземпляр СВ-М в срез, запускаемый этим svm_app.
+ */
+bool config_instance_in_slice(const AppConfig *config, int svm_id);
+
 #endif // CONFIG_H
\ No newline at end of file
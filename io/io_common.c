@@ -15,13 +15,22 @@
 #include <errno.h>
 #include <arpa/inet.h>  // <-- ДОБАВЛЕНО для ntohs
 
-// Отправить протокольное сообщение через интерфейс
-int send_protocol_message(IOInterface *io, int handle, Message *message) {
-    if (!io || !io->send_data || handle < 0 || !message) {
-        fprintf(stderr, "send_protocol_message: Invalid arguments\n");
-        return -1;
+#define IO_SEND_BURST_MAX 64 // Сообщений в одной подаче send_protocol_messages
+
+// Имя транспорта для журнала
+const char* io_type_name(IOInterfaceType type) {
+    switch (type) {
+        case IO_TYPE_ETHERNET: return "Ethernet";
+        case IO_TYPE_SERIAL:   return "Serial";
+        case IO_TYPE_UNIX:     return "Unix";
+        case IO_TYPE_SHM:      return "Shm";
+        case IO_TYPE_URING:    return "Uring";
+        default:               return "Unknown";
     }
+}
 
+// Перевод сообщения в сетевой порядок байт и журнал отправки; возвращает размер кадра
+static size_t prepare_outgoing(IOInterface *io, int handle, Message *message) {
 	message_to_network_byte_order(message);
 
 	uint16_t body_length_net = message->header.body_length;
@@ -30,17 +39,27 @@ int send_protocol_message(IOInterface *io, int handle, Message *message) {
     size_t total_message_size = sizeof(MessageHeader) + body_length_host;
 
     printf("Отправка сообщения через %s: Тип=%u, Номер=%u, Длина тела=%u, Общий размер=%zu, Handle=%d\n",
-           (io->type == IO_TYPE_ETHERNET) ? "Ethernet" : ((io->type == IO_TYPE_SERIAL) ? "Serial" : "Unknown"),
+           io_type_name(io->type),
            message->header.message_type,
            get_full_message_number(&message->header),
            body_length_host,
            total_message_size,
            handle);
+    return total_message_size;
+}
+
+// Отправить протокольное сообщение через интерфейс
+int send_protocol_message(IOInterface *io, int handle, Message *message) {
+    if (!io || !io->send_data || handle < 0 || !message) {
+        fprintf(stderr, "send_protocol_message: Invalid arguments\n");
+        return -1;
+    }
+
+    size_t total_message_size = prepare_outgoing(io, handle, message);
 
     ssize_t bytes_sent = io->send_data(handle, message, total_message_size);
 
-    message->header.body_length = body_length_net;
-    message_to_host_byte_order(message);
+    message_to_host_byte_order(message); // body_length еще в сетевом порядке, как ждет функция
 
     if (bytes_sent < 0) {
         fprintf(stderr, "send_protocol_message: io->send_data failed\n");
@@ -53,6 +72,83 @@ int send_protocol_message(IOInterface *io, int handle, Message *message) {
 	return 0;
 }
 
+// Отправка без копирования: кадр уходит из буфера сообщения, пока ядро его не освободит.
+// Поэтому при ticket->pending обратного перевода в хостовый порядок нет - буфер трогать нельзя
+int send_protocol_message_zerocopy(IOInterface *io, int handle, Message *message, EthernetZcTicket *ticket) {
+    if (!io || handle < 0 || !message || !ticket) {
+        fprintf(stderr, "send_protocol_message_zerocopy: Invalid arguments\n");
+        return -1;
+    }
+    ticket->pending = false;
+    if (io->type != IO_TYPE_ETHERNET && io->type != IO_TYPE_URING) {
+        return send_protocol_message(io, handle, message);
+    }
+
+    size_t total_message_size = prepare_outgoing(io, handle, message);
+
+    ssize_t bytes_sent = ethernet_send_zerocopy(handle, message, total_message_size, ticket);
+
+    if (!ticket->pending) {
+        message_to_host_byte_order(message);
+    }
+
+    if (bytes_sent < 0) {
+        fprintf(stderr, "send_protocol_message_zerocopy: send failed\n");
+        return -1;
+    } else if ((size_t)bytes_sent != total_message_size) {
+        fprintf(stderr, "send_protocol_message_zerocopy: Ошибка отправки: отправлено %zd байт вместо %zu\n", bytes_sent, total_message_size);
+        return -1;
+    }
+    return 0;
+}
+
+// Пачка сообщений: io_uring - одной подачей на всю пачку, остальные транспорты - по одному
+int send_protocol_messages(IOSendItem *items, size_t count) {
+    if (!items) {
+        fprintf(stderr, "send_protocol_messages: Invalid arguments\n");
+        return (int)count;
+    }
+    int failed = 0;
+    for (size_t start = 0; start < count; start += IO_SEND_BURST_MAX) {
+        size_t n = count - start < IO_SEND_BURST_MAX ? count - start : IO_SEND_BURST_MAX;
+        IOSendRequest requests[IO_SEND_BURST_MAX];
+        int request_index[IO_SEND_BURST_MAX];
+        size_t request_count = 0;
+
+        for (size_t i = 0; i < n; ++i) {
+            IOSendItem *item = &items[start + i];
+            request_index[i] = -1;
+            if (!item->io || item->io->type != IO_TYPE_URING || item->handle < 0 || !item->message) {
+                item->result = send_protocol_message(item->io, item->handle, item->message);
+                continue;
+            }
+            requests[request_count].handle = item->handle;
+            requests[request_count].buffer = item->message;
+            requests[request_count].length = prepare_outgoing(item->io, item->handle, item->message);
+            requests[request_count].result = -1;
+            request_index[i] = (int)request_count++;
+        }
+        if (request_count > 0) {
+            uring_send_batch(requests, request_count);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            IOSendItem *item = &items[start + i];
+            if (request_index[i] >= 0) {
+                IOSendRequest *request = &requests[request_index[i]];
+                message_to_host_byte_order(item->message);
+                item->result = 0;
+                if (request->result != (ssize_t)request->length) {
+                    fprintf(stderr, "send_protocol_messages: Ошибка отправки: отправлено %zd байт вместо %zu, Handle=%d\n",
+                            request->result, request->length, item->handle);
+                    item->result = -1;
+                }
+            }
+            if (item->result != 0) failed++;
+        }
+    }
+    return failed;
+}
+
 
 // Получает полное протокольное сообщение из интерфейса
 int receive_protocol_message(IOInterface *io, int handle, Message *message) {
@@ -73,6 +169,7 @@ int receive_protocol_message(IOInterface *io, int handle, Message *message) {
              // Проверяем на EINTR, который может вернуть serial_receive при таймауте poll
              if (errno == EINTR || bytesRead == -2) { // -2 - наш условный код для таймаута/нет данных
                  errno = 0; // Сбрасываем errno
+                 if (totalBytesRead == 0) return -2; // Сообщение еще не началось: даем проверить флаг остановки
                  usleep(10000); // Небольшая пауза перед повторной попыткой
                  continue;
              }
@@ -125,11 +222,18 @@ int receive_protocol_message(IOInterface *io, int handle, Message *message) {
 	printf("DEBUG RECV: message.header.body_length после message_to_host_byte_order (должен быть хост) = %u\n", message->header.body_length);
 
     printf("Получено сообщение через %s: Тип=%u, Номер=%u, Длина тела=%u, Handle=%d\n",
-           (io->type == IO_TYPE_ETHERNET) ? "Ethernet" : ((io->type == IO_TYPE_SERIAL) ? "Serial" : "Unknown"),
+           io_type_name(io->type),
            message->header.message_type,
            get_full_message_number(&message->header),
            message->header.body_length,
            handle);
 
     return 0;
-}
\ No newline at end of file
+}
+
+// Состояние TCP в ядре есть только у сокетов Ethernet/io_uring
+int io_tcp_info(IOInterface *io, int handle, EthernetTcpInfo *info) {
+    if (!io || handle < 0 || !info) return -1;
+    if (io->type != IO_TYPE_ETHERNET && io->type != IO_TYPE_URING) return -1;
+    return ethernet_tcp_info(handle, info);
+}
@@ -14,6 +14,11 @@
 #include <stddef.h>
 #include <sys/types.h>
 
+/**
+ * @brief Возвращает имя транспорта ("Ethernet", "Serial", "Unix", "Shm", "Uring") для журнала.
+ */
+const char* io_type_name(IOInterfaceType type);
+
 /**
  * @brief Отправляет полное *протокольное сообщение* (заголовок + тело)
  *        через указанный интерфейс и дескриптор.
@@ -27,6 +32,40 @@
  */
 int send_protocol_message(IOInterface *io, int handle, Message *message); // Переименовали для ясности
 
+/**
+ * @brief Отправляет протокольное сообщение без копирования в ядро (MSG_ZEROCOPY),
+ *        если на соединении включен zero-copy и кадр не меньше порога.
+ * Для транспортов, кроме Ethernet/io_uring, и мелких кадров - обычная отправка.
+ * Если ticket->pending, сообщение остается в сетевом порядке байт, а буфер нельзя
+ * изменять или освобождать, пока ethernet_zerocopy_released() не вернет true.
+ *
+ * @param io Указатель на инициализированный IOInterface.
+ * @param handle Дескриптор соединения.
+ * @param message Сообщение для отправки (буфер из пула вызывающего).
+ * @param ticket Билет освобождения буфера (заполняется).
+ * @return 0 в случае успеха, -1 в случае ошибки.
+ */
+int send_protocol_message_zerocopy(IOInterface *io, int handle, Message *message, EthernetZcTicket *ticket);
+
+// Элемент пачки для send_protocol_messages()
+typedef struct {
+    IOInterface *io;
+    int handle;
+    Message *message;
+    int result;         // Заполняется: 0 - отправлено, -1 - ошибка
+} IOSendItem;
+
+/**
+ * @brief Отправляет пачку протокольных сообщений (возможно, по разным соединениям).
+ * Сообщения интерфейсов IO_TYPE_URING уходят одной подачей io_uring (uring_send_batch),
+ * остальные - по одному, как send_protocol_message. Сообщения одного соединения
+ * отправляются в порядке массива.
+ * @param items Элементы пачки; результат каждого - в items[i].result.
+ * @param count Количество элементов.
+ * @return Количество неотправленных сообщений (0 - все отправлены).
+ */
+int send_protocol_messages(IOSendItem *items, size_t count);
+
 /**
  * @brief Получает полное *протокольное сообщение* (заголовок + тело)
  *        из указанного интерфейса и дескриптора.
@@ -38,8 +77,19 @@ int send_protocol_message(IOInterface *io, int handle, Message *message); // П
  * @param message Указатель на структуру Message, куда будет записано полученное сообщение.
  * @return 0 в случае успеха,
  *         -1 в случае ошибки чтения/формата,
- *         1 если соединение было закрыто удаленной стороной.
+ *         1 если соединение было закрыто удаленной стороной,
+ *         -2 если данных нет (таймаут ожидания последовательного порта) до начала сообщения:
+ *            вызывающий может проверить флаг остановки и повторить прием.
  */
 int receive_protocol_message(IOInterface *io, int handle, Message *message); // Переименовали для ясности
 
+/**
+ * @brief Снимает состояние TCP-соединения в ядре (srtt, rttvar, повторы, cwnd, очереди).
+ * @param io Интерфейс соединения (Ethernet или io_uring).
+ * @param handle Дескриптор соединения.
+ * @param info Результат.
+ * @return 0 при успехе, -1 для транспортов без TCP (serial, unix, shm) и при ошибке.
+ */
+int io_tcp_info(IOInterface *io, int handle, EthernetTcpInfo *info);
+
 #endif // IO_COMMON_H
\ No newline at end of file
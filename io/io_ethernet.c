@@ -3,17 +3,77 @@
  *
  * Описание:
  * Реализация функций интерфейса ввода-вывода (IOInterface) для Ethernet (TCP/IP).
+ * Для крупных сообщений есть отправка без копирования в ядро (SO_ZEROCOPY/MSG_ZEROCOPY):
+ * страницы буфера передаются ядру, а о их освобождении оно сообщает через очередь
+ * ошибок сокета. Номера отправок ведутся по дескриптору соединения.
+ * Профиль сокета (EthernetConfig.profile) задает согласованный набор опций TCP
+ * для слушающего, принятых и клиентских сокетов.
  */
 
 #include "io_interface.h" // Определения интерфейса и структур конфигурации
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h> // strcasecmp
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h> // SIOCOUTQ
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+// Очередь ожидания подключений: при массовом переподключении УВМ новые соединения
+// ждут в ней, пока экземпляр освобождает прежнее, а не теряют SYN
+#define ETHERNET_LISTEN_BACKLOG 16
+#define ETHERNET_MAX_HANDLES 1024 // Дескрипторы, для которых ведется состояние (zero-copy, TCP_QUICKACK)
+#define ETHERNET_ZC_DRAIN_MS 1000 // Ожидание уведомлений zero-copy при закрытии соединения
+#define ETHERNET_ZC_DRAIN_STEP_MS 10
+
+// Опции профиля сокета; 0 - не трогать (значение ядра)
+typedef struct {
+    const char *name;
+    int nodelay;            // TCP_NODELAY: 1 - выкл. Nagle, -1 - явно вкл.
+    bool quickack;          // TCP_QUICKACK, возобновляется после каждого recv (ядро сбрасывает его само)
+    int buffer_bytes;       // SO_SNDBUF/SO_RCVBUF (без CAP_NET_ADMIN ограничено net.core.[rw]mem_max)
+    int busy_poll_us;       // SO_BUSY_POLL: опрос очереди драйвера вместо сна в recv (только при >1 CPU)
+    unsigned user_timeout_ms; // TCP_USER_TIMEOUT: разрыв, если данные не подтверждены за это время
+} EthernetProfileSettings;
+
+static const EthernetProfileSettings ethernet_profiles[] = {
+    [SOCKET_PROFILE_DEFAULT]    = { "default",    0,  false, 0,               0,  0     },
+    [SOCKET_PROFILE_LATENCY]    = { "latency",    1,  true,  256 * 1024,      50, 5000  },
+    [SOCKET_PROFILE_THROUGHPUT] = { "throughput", -1, false, 1024 * 1024,     0,  30000 },
+};
+#define ETHERNET_PROFILE_COUNT (sizeof(ethernet_profiles) / sizeof(ethernet_profiles[0]))
+
+static bool ethernet_quickack[ETHERNET_MAX_HANDLES]; // Соединения профиля latency
+
+// Состояние zero-copy соединения. Номера отправок - счетчик ядра для сокета (с 0)
+typedef struct {
+    bool enabled;
+    uint32_t threshold;
+    uint32_t epoch;         // Меняется при включении и закрытии дескриптора: билеты прежнего соединения освобождены
+    uint32_t next_id;       // Номер следующей отправки с MSG_ZEROCOPY
+    uint32_t completed;     // Ядро освободило все отправки с номером < completed
+} EthernetZeroCopy;
+
+static pthread_mutex_t ethernet_zc_mutex = PTHREAD_MUTEX_INITIALIZER;
+static EthernetZeroCopy ethernet_zc[ETHERNET_MAX_HANDLES];
+static EthernetZcStats ethernet_zc_counters;
 
 // --- Прототипы статических функций реализации ---
 static int ethernet_connect(IOInterface *self);
@@ -89,6 +149,7 @@ static int ethernet_connect(IOInterface *self) {
         self->io_handle = -1;
         return -1;
     }
+    ethernet_apply_profile(self->io_handle, config->profile); // Буферы - до подключения (масштаб окна)
 
     // Готовим адрес сервера
     memset(&server_addr, 0, sizeof(server_addr));
@@ -116,9 +177,77 @@ static int ethernet_connect(IOInterface *self) {
     }
 
     printf("Ethernet: Connected to %s:%d (handle: %d)\n", config->target_ip, config->port, self->io_handle);
+    if (config->zerocopy_threshold > 0) {
+        ethernet_zerocopy_enable(self->io_handle, config->zerocopy_threshold);
+    }
     return self->io_handle; // Возвращаем дескриптор соединения
 }
 
+// Неблокирующее подключение: запуск. Завершение - ethernet_connect_finish после готовности на запись
+int ethernet_connect_start(IOInterface *self) {
+    if (!self || self->type != IO_TYPE_ETHERNET || !self->config) {
+        fprintf(stderr, "ethernet_connect_start: Invalid interface or config\n");
+        return -1;
+    }
+    if (self->io_handle != -1) {
+        ethernet_disconnect(self, self->io_handle);
+        self->io_handle = -1;
+    }
+
+    EthernetConfig *config = (EthernetConfig*)self->config;
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config->port);
+    if (inet_pton(AF_INET, config->target_ip, &server_addr.sin_addr) != 1) {
+        fprintf(stderr, "ethernet_connect_start: Invalid server address format: %s\n", config->target_ip);
+        return -1;
+    }
+
+    self->io_handle = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (self->io_handle < 0) {
+        perror("ethernet_connect_start: Failed to create socket");
+        self->io_handle = -1;
+        return -1;
+    }
+    ethernet_apply_profile(self->io_handle, config->profile); // Буферы - до подключения (масштаб окна)
+    if (connect(self->io_handle, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0 && errno != EINPROGRESS) {
+        perror("ethernet_connect_start: Connection failed");
+        close(self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+    return self->io_handle;
+}
+
+// Неблокирующее подключение: проверка результата и возврат сокета в блокирующий режим
+int ethernet_connect_finish(IOInterface *self) {
+    if (!self || self->io_handle < 0) return -1;
+    EthernetConfig *config = (EthernetConfig*)self->config;
+    int so_error = 0;
+    socklen_t len = sizeof(so_error);
+    if (getsockopt(self->io_handle, SOL_SOCKET, SO_ERROR, &so_error, &len) < 0) so_error = errno;
+    if (so_error != 0) {
+        fprintf(stderr, "ethernet_connect_finish: Connection to %s:%d failed: %s\n",
+                config->target_ip, config->port, strerror(so_error));
+        close(self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+    int flags = fcntl(self->io_handle, F_GETFL, 0);
+    if (flags < 0 || fcntl(self->io_handle, F_SETFL, flags & ~O_NONBLOCK) < 0) {
+        perror("ethernet_connect_finish: Failed to restore blocking mode");
+        close(self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+    printf("Ethernet: Connected to %s:%d (handle: %d)\n", config->target_ip, config->port, self->io_handle);
+    if (config->zerocopy_threshold > 0) {
+        ethernet_zerocopy_enable(self->io_handle, config->zerocopy_threshold);
+    }
+    return self->io_handle;
+}
+
 static int ethernet_listen(IOInterface *self) {
      if (!self || self->type != IO_TYPE_ETHERNET || !self->config) {
         fprintf(stderr, "ethernet_listen: Invalid interface or config\n");
@@ -145,6 +274,8 @@ static int ethernet_listen(IOInterface *self) {
         perror("ethernet_listen: setsockopt(SO_REUSEADDR) failed");
         // Не фатально, но может мешать быстрому перезапуску
     }
+    // Буферы слушающего сокета наследуют принятые соединения (окно объявляется уже в SYN-ACK)
+    ethernet_apply_profile(self->io_handle, config->profile);
 
     // Готовим адрес для прослушивания
     memset(&server_addr, 0, sizeof(server_addr));
@@ -161,7 +292,7 @@ static int ethernet_listen(IOInterface *self) {
     }
 
     // Начинаем слушать
-    if (listen(self->io_handle, 1) < 0) { // Очередь ожидания = 1
+    if (listen(self->io_handle, ETHERNET_LISTEN_BACKLOG) < 0) {
         perror("ethernet_listen: Listen failed");
         close(self->io_handle);
         self->io_handle = -1;
@@ -200,6 +331,7 @@ static int ethernet_accept(IOInterface *self, char *client_ip_buffer, size_t buf
     if (client_port) {
         *client_port = ntohs(client_addr.sin_port);
     }
+    ethernet_apply_profile(client_handle, ((EthernetConfig*)self->config)->profile);
 
     return client_handle; // Возвращаем дескриптор клиента
 }
@@ -212,7 +344,9 @@ static int ethernet_disconnect(IOInterface *self, int handle) {
         return -1; // Нечего закрывать
     }
     printf("Ethernet: Closing handle %d\n", handle);
-    if (close(handle) < 0) {
+    ethernet_zerocopy_disable(handle);
+    if (handle < ETHERNET_MAX_HANDLES) __atomic_store_n(&ethernet_quickack[handle], false, __ATOMIC_RELAXED);
+    if (ethernet_zerocopy_close(handle) < 0) {
         perror("ethernet_disconnect: close failed");
         return -1;
     }
@@ -229,7 +363,8 @@ static ssize_t ethernet_send(int handle, const void *buffer, size_t length) {
     }
     ssize_t total_sent = 0;
     while(total_sent < (ssize_t)length) {
-        ssize_t sent_now = send(handle, (const char*)buffer + total_sent, length - total_sent, 0);
+        // MSG_NOSIGNAL: закрытое другой стороной соединение - ошибка EPIPE, а не SIGPIPE для всего процесса
+        ssize_t sent_now = send(handle, (const char*)buffer + total_sent, length - total_sent, MSG_NOSIGNAL);
         if (sent_now < 0) {
             if (errno == EINTR) continue; // Повторить при прерывании
             perror("ethernet_send: send failed");
@@ -256,18 +391,293 @@ static ssize_t ethernet_receive(int handle, void *buffer, size_t length) {
 
     if (bytes_received < 0) {
         perror("ethernet_receive: recv failed");
+    } else if (bytes_received > 0 && handle < ETHERNET_MAX_HANDLES &&
+               __atomic_load_n(&ethernet_quickack[handle], __ATOMIC_RELAXED)) {
+        int one = 1; // Ядро выходит из режима быстрых ACK само: возобновляем после каждого приема
+        setsockopt(handle, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
     }
     // bytes_received == 0 означает, что соединение закрыто удаленно
     // bytes_received > 0 означает успешное чтение
     return bytes_received;
 }
 
+// --- Состояние соединения в ядре ---
+
+int ethernet_tcp_info(int handle, EthernetTcpInfo *info) {
+    if (handle < 0 || !info) return -1;
+    struct tcp_info tcpi;
+    socklen_t len = sizeof(tcpi);
+    memset(&tcpi, 0, sizeof(tcpi));
+    if (getsockopt(handle, IPPROTO_TCP, TCP_INFO, &tcpi, &len) < 0) return -1;
+    int sendq = 0;
+    if (ioctl(handle, SIOCOUTQ, &sendq) < 0) sendq = 0;
+    info->srtt_us = tcpi.tcpi_rtt;
+    info->rttvar_us = tcpi.tcpi_rttvar;
+    info->retransmits = tcpi.tcpi_total_retrans;
+    info->cwnd = tcpi.tcpi_snd_cwnd;
+    info->unacked_bytes = tcpi.tcpi_unacked * tcpi.tcpi_snd_mss;
+    info->sendq_bytes = sendq > 0 ? (uint32_t)sendq : 0;
+    return 0;
+}
+
+// --- Профили сокета ---
+
+const char* socket_profile_name(SocketProfile profile) {
+    if ((unsigned)profile >= ETHERNET_PROFILE_COUNT) return "unknown";
+    return ethernet_profiles[profile].name;
+}
+
+int socket_profile_parse(const char *text, SocketProfile *profile) {
+    if (!text || !profile) return -1;
+    for (size_t i = 0; i < ETHERNET_PROFILE_COUNT; ++i) {
+        if (strcasecmp(text, ethernet_profiles[i].name) == 0) {
+            *profile = (SocketProfile)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Опция, которую ядро не приняло, - предупреждение: остальные опции профиля все равно действуют
+static int ethernet_set_option(int handle, int level, int name, int value, const char *option) {
+    if (setsockopt(handle, level, name, &value, sizeof(value)) < 0) {
+        fprintf(stderr, "Ethernet: setsockopt(%s = %d) failed on handle %d: %s\n", option, value, handle, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int ethernet_apply_profile(int handle, SocketProfile profile) {
+    if (handle < 0 || (unsigned)profile >= ETHERNET_PROFILE_COUNT) return -1;
+    const EthernetProfileSettings *settings = &ethernet_profiles[profile];
+    int result = 0;
+    if (settings->nodelay != 0) {
+        result |= ethernet_set_option(handle, IPPROTO_TCP, TCP_NODELAY, settings->nodelay > 0, "TCP_NODELAY");
+    }
+    if (settings->quickack) {
+        result |= ethernet_set_option(handle, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+        if (handle < ETHERNET_MAX_HANDLES) __atomic_store_n(&ethernet_quickack[handle], true, __ATOMIC_RELAXED);
+    }
+    if (settings->buffer_bytes > 0) {
+        // С CAP_NET_ADMIN - без ограничения net.core.[rw]mem_max, иначе - в его пределах
+        if (setsockopt(handle, SOL_SOCKET, SO_SNDBUFFORCE, &settings->buffer_bytes, sizeof(int)) < 0) {
+            result |= ethernet_set_option(handle, SOL_SOCKET, SO_SNDBUF, settings->buffer_bytes, "SO_SNDBUF");
+        }
+        if (setsockopt(handle, SOL_SOCKET, SO_RCVBUFFORCE, &settings->buffer_bytes, sizeof(int)) < 0) {
+            result |= ethernet_set_option(handle, SOL_SOCKET, SO_RCVBUF, settings->buffer_bytes, "SO_RCVBUF");
+        }
+    }
+    // На одном процессоре опрос отнимает время у стороны, от которой ждем данные
+    if (settings->busy_poll_us > 0 && sysconf(_SC_NPROCESSORS_ONLN) > 1) {
+        result |= ethernet_set_option(handle, SOL_SOCKET, SO_BUSY_POLL, settings->busy_poll_us, "SO_BUSY_POLL");
+    }
+    if (settings->user_timeout_ms > 0) {
+        result |= ethernet_set_option(handle, IPPROTO_TCP, TCP_USER_TIMEOUT, (int)settings->user_timeout_ms, "TCP_USER_TIMEOUT");
+    }
+    return result ? -1 : 0;
+}
+
+// --- Отправка без копирования (MSG_ZEROCOPY) ---
+
+int ethernet_zerocopy_enable(int handle, uint32_t threshold) {
+    if (handle < 0 || handle >= ETHERNET_MAX_HANDLES || threshold == 0) return -1;
+    int one = 1;
+    if (setsockopt(handle, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0) {
+        fprintf(stderr, "Ethernet: SO_ZEROCOPY unavailable on handle %d (%s), sending with copies\n", handle, strerror(errno));
+        return -1;
+    }
+    pthread_mutex_lock(&ethernet_zc_mutex);
+    EthernetZeroCopy *zc = &ethernet_zc[handle];
+    zc->enabled = true;
+    zc->threshold = threshold;
+    zc->epoch++;
+    zc->next_id = 0;
+    zc->completed = 0;
+    pthread_mutex_unlock(&ethernet_zc_mutex);
+    printf("Ethernet: Zero-copy sends from %u bytes enabled (handle: %d)\n", threshold, handle);
+    return 0;
+}
+
+// Пока ядро не освободило все отправки соединения, его буферы нельзя изменять
+static bool ethernet_zerocopy_drained(int handle, uint32_t epoch) {
+    pthread_mutex_lock(&ethernet_zc_mutex);
+    EthernetZeroCopy *zc = &ethernet_zc[handle];
+    bool drained = zc->epoch != epoch || zc->completed == zc->next_id;
+    pthread_mutex_unlock(&ethernet_zc_mutex);
+    return drained;
+}
+
+static void ethernet_zerocopy_reap(int handle, uint32_t epoch);
+
+void ethernet_zerocopy_disable(int handle) {
+    if (handle < 0 || handle >= ETHERNET_MAX_HANDLES) return;
+    pthread_mutex_lock(&ethernet_zc_mutex);
+    bool enabled = ethernet_zc[handle].enabled;
+    uint32_t epoch = ethernet_zc[handle].epoch;
+    ethernet_zc[handle].enabled = false; // Новые отправки - с копированием
+    pthread_mutex_unlock(&ethernet_zc_mutex);
+    if (!enabled) return;
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (true) {
+        ethernet_zerocopy_reap(handle, epoch);
+        if (ethernet_zerocopy_drained(handle, epoch)) return;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long waited_ms = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (waited_ms >= ETHERNET_ZC_DRAIN_MS) break;
+        ethernet_zerocopy_wait(handle, ETHERNET_ZC_DRAIN_STEP_MS);
+    }
+    // Получатель не принимает данные: закрытие со сбросом (SO_LINGER 0) удаляет очередь
+    // отправки вместе со ссылками ядра на буферы, билеты освобождаются в ethernet_zerocopy_close
+    struct linger abort_close = { 1, 0 };
+    if (setsockopt(handle, SOL_SOCKET, SO_LINGER, &abort_close, sizeof(abort_close)) < 0) {
+        perror("ethernet_zerocopy_disable: setsockopt(SO_LINGER) failed");
+    }
+    fprintf(stderr, "Ethernet: Zero-copy sends on handle %d not completed in %d ms, connection will be reset\n",
+            handle, ETHERNET_ZC_DRAIN_MS);
+}
+
+int ethernet_zerocopy_close(int handle) {
+    if (handle < 0 || handle >= ETHERNET_MAX_HANDLES) return close(handle);
+    // Под мьютексом: номер дескриптора не займет новое соединение, пока билеты прежнего не освобождены
+    pthread_mutex_lock(&ethernet_zc_mutex);
+    int result = close(handle);
+    ethernet_zc[handle].enabled = false;
+    ethernet_zc[handle].epoch++;
+    pthread_mutex_unlock(&ethernet_zc_mutex);
+    return result;
+}
+
+ssize_t ethernet_send_zerocopy(int handle, const void *buffer, size_t length, EthernetZcTicket *ticket) {
+    if (handle < 0 || buffer == NULL || length == 0 || ticket == NULL) {
+        return -1;
+    }
+    ticket->pending = false;
+    bool enabled = false;
+    uint32_t epoch = 0;
+    if (handle < ETHERNET_MAX_HANDLES) {
+        pthread_mutex_lock(&ethernet_zc_mutex);
+        enabled = ethernet_zc[handle].enabled && length >= ethernet_zc[handle].threshold;
+        epoch = ethernet_zc[handle].epoch;
+        pthread_mutex_unlock(&ethernet_zc_mutex);
+    }
+    if (!enabled) {
+        return ethernet_send(handle, buffer, length);
+    }
+
+    size_t total_sent = 0;
+    uint32_t sends = 0;
+    ssize_t result = 0;
+    while (total_sent < length) {
+        ssize_t sent_now = send(handle, (const char*)buffer + total_sent, length - total_sent, MSG_NOSIGNAL | MSG_ZEROCOPY);
+        if (sent_now < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) { // Исчерпан предел optmem сокета: остаток - обычной отправкой
+                ssize_t rest = ethernet_send(handle, (const char*)buffer + total_sent, length - total_sent);
+                if (rest > 0) {
+                    __atomic_add_fetch(&ethernet_zc_counters.fallback_bytes, (uint64_t)rest, __ATOMIC_RELAXED);
+                    total_sent += (size_t)rest;
+                }
+                if (rest < 0) result = -1;
+                break;
+            }
+            perror("ethernet_send_zerocopy: send failed");
+            result = -1;
+            break;
+        }
+        sends++;
+        total_sent += (size_t)sent_now;
+        __atomic_add_fetch(&ethernet_zc_counters.zerocopy_bytes, (uint64_t)sent_now, __ATOMIC_RELAXED);
+    }
+
+    if (sends > 0) {
+        __atomic_add_fetch(&ethernet_zc_counters.zerocopy_sends, sends, __ATOMIC_RELAXED);
+        pthread_mutex_lock(&ethernet_zc_mutex);
+        EthernetZeroCopy *zc = &ethernet_zc[handle];
+        if (zc->enabled && zc->epoch == epoch) {
+            zc->next_id += sends;
+            ticket->epoch = epoch;
+            ticket->release_id = zc->next_id;
+            ticket->pending = true;
+        }
+        pthread_mutex_unlock(&ethernet_zc_mutex);
+    }
+    return result < 0 ? -1 : (ssize_t)total_sent;
+}
+
+// Разбор уведомлений: ядро сообщает диапазоны [ee_info, ee_data] освобожденных отправок.
+// Для TCP они приходят по порядку, поэтому достаточно границы completed
+static void ethernet_zerocopy_reap(int handle, uint32_t epoch) {
+    while (true) {
+        union {
+            char buf[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+            struct cmsghdr align;
+        } control;
+        struct msghdr msg = {0};
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        if (recvmsg(handle, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN: уведомлений больше нет
+        }
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                  (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) continue;
+            struct sock_extended_err serr;
+            memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+            if (serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr.ee_errno != 0) continue;
+            if (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                __atomic_add_fetch(&ethernet_zc_counters.kernel_copied, (uint64_t)(serr.ee_data - serr.ee_info + 1), __ATOMIC_RELAXED);
+            }
+            pthread_mutex_lock(&ethernet_zc_mutex);
+            EthernetZeroCopy *zc = &ethernet_zc[handle];
+            if (zc->epoch == epoch && (int32_t)(serr.ee_data + 1 - zc->completed) > 0) {
+                zc->completed = serr.ee_data + 1;
+            }
+            pthread_mutex_unlock(&ethernet_zc_mutex);
+        }
+    }
+}
+
+bool ethernet_zerocopy_released(int handle, const EthernetZcTicket *ticket) {
+    if (!ticket || !ticket->pending) return true;
+    if (handle < 0 || handle >= ETHERNET_MAX_HANDLES) return true;
+    pthread_mutex_lock(&ethernet_zc_mutex);
+    bool same_connection = ethernet_zc[handle].epoch == ticket->epoch;
+    pthread_mutex_unlock(&ethernet_zc_mutex);
+    if (!same_connection) return true; // Дескриптор закрыт после ethernet_zerocopy_disable: ядро буфер не держит
+
+    ethernet_zerocopy_reap(handle, ticket->epoch);
+    pthread_mutex_lock(&ethernet_zc_mutex);
+    EthernetZeroCopy *zc = &ethernet_zc[handle];
+    bool released = zc->epoch != ticket->epoch || (int32_t)(zc->completed - ticket->release_id) >= 0;
+    pthread_mutex_unlock(&ethernet_zc_mutex);
+    return released;
+}
+
+void ethernet_zerocopy_wait(int handle, int timeout_ms) {
+    if (handle < 0) return;
+    struct pollfd pfd = { handle, 0, 0 }; // Очередь ошибок не пуста - POLLERR (его не нужно запрашивать)
+    if (poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & (POLLHUP | POLLNVAL))) {
+        usleep((useconds_t)timeout_ms * 1000); // Соединение закрывается: poll не ждет, не крутимся впустую
+    }
+}
+
+void ethernet_zerocopy_stats(EthernetZcStats *stats) {
+    if (!stats) return;
+    stats->zerocopy_sends = __atomic_load_n(&ethernet_zc_counters.zerocopy_sends, __ATOMIC_RELAXED);
+    stats->zerocopy_bytes = __atomic_load_n(&ethernet_zc_counters.zerocopy_bytes, __ATOMIC_RELAXED);
+    stats->kernel_copied = __atomic_load_n(&ethernet_zc_counters.kernel_copied, __ATOMIC_RELAXED);
+    stats->fallback_bytes = __atomic_load_n(&ethernet_zc_counters.fallback_bytes, __ATOMIC_RELAXED);
+}
+
 static void ethernet_destroy(IOInterface *self) {
     if (!self) return;
 
     // Закрываем основной дескриптор, если он еще открыт
     if (self->io_handle >= 0) {
-        close(self->io_handle);
+        ethernet_zerocopy_close(self->io_handle);
         self->io_handle = -1;
     }
     // Освобождаем память, выделенную для конфигурации
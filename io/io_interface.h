@@ -3,7 +3,8 @@
  *
  * Описание:
  * Определяет абстрактный интерфейс для операций ввода-вывода (I/O),
- * позволяя использовать различные транспортные механизмы (Ethernet, Serial).
+ * позволяя использовать различные транспортные механизмы (Ethernet, Serial, Unix, общая память,
+ * Ethernet на io_uring).
  */
 
 #ifndef IO_INTERFACE_H
@@ -12,12 +13,16 @@
 #include <stddef.h>    // для size_t
 #include <sys/types.h> // для ssize_t
 #include <stdint.h>    // для uint16_t и т.д.
+#include <stdbool.h>
 
 // --- Перечисление типов интерфейса ---
 typedef enum {
     IO_TYPE_NONE,
     IO_TYPE_ETHERNET,
-    IO_TYPE_SERIAL
+    IO_TYPE_SERIAL,
+    IO_TYPE_UNIX,
+    IO_TYPE_SHM,
+    IO_TYPE_URING
 } IOInterfaceType;
 
 // --- Базовая структура конфигурации ---
@@ -25,12 +30,21 @@ typedef struct {
     IOInterfaceType type;
 } IOConfigBase;
 
+// --- Профиль опций TCP-сокета (interface_type = ethernet/uring) ---
+typedef enum {
+    SOCKET_PROFILE_DEFAULT,     // Значения ядра (Nagle, автоподстройка буферов)
+    SOCKET_PROFILE_LATENCY,     // Команды/ответы: без Nagle, быстрые ACK, busy-poll
+    SOCKET_PROFILE_THROUGHPUT   // Потоки данных: Nagle, большие буферы
+} SocketProfile;
+
 // --- Конфигурация для Ethernet ---
 typedef struct {
     IOConfigBase base;
     char target_ip[40];
     uint16_t port;
 	int base_port;
+    uint32_t zerocopy_threshold; // Подключение клиента: SO_ZEROCOPY для отправок от этого размера (0 - выключено)
+    SocketProfile profile;       // Опции слушающего, принятых и клиентских сокетов
 } EthernetConfig;
 
 // --- Конфигурация для Serial ---
@@ -43,6 +57,46 @@ typedef struct {
     int stop_bits;
 } SerialConfig;
 
+// --- Конфигурация для локального сокета Unix ---
+typedef struct {
+    IOConfigBase base;
+    char path[108];     // Путь к файлу сокета (размер sun_path)
+} UnixConfig;
+
+// --- Запрос пачечной отправки (uring_send_batch) ---
+typedef struct {
+    int handle;
+    const void *buffer;
+    size_t length;
+    ssize_t result;     // Заполняется: байт отправлено или -1
+} IOSendRequest;
+
+// --- Отправка без копирования (MSG_ZEROCOPY, только Ethernet/io_uring) ---
+// Билет отправки: буфер нельзя изменять, пока ethernet_zerocopy_released() не вернет true
+typedef struct {
+    uint32_t epoch;     // Соединение (меняется при каждом подключении/закрытии дескриптора)
+    uint32_t release_id; // Буфер свободен, когда ядро завершит все отправки с номером < release_id
+    bool pending;       // false - данные скопированы в ядро, буфер свободен сразу
+} EthernetZcTicket;
+
+// Счетчики отправок без копирования (по всем соединениям процесса)
+typedef struct {
+    uint64_t zerocopy_sends;    // Вызовов send с MSG_ZEROCOPY
+    uint64_t zerocopy_bytes;    // Байт, отправленных с MSG_ZEROCOPY
+    uint64_t kernel_copied;     // Из них ядро все же скопировало (уведомления SO_EE_CODE_ZEROCOPY_COPIED, отправок)
+    uint64_t fallback_bytes;    // Байт крупных сообщений, ушедших с копированием (ENOBUFS - предел optmem)
+} EthernetZcStats;
+
+// Снимок состояния TCP-соединения в ядре (TCP_INFO и очередь отправки)
+typedef struct {
+    uint32_t srtt_us;           // Сглаженное RTT
+    uint32_t rttvar_us;         // Разброс RTT
+    uint32_t retransmits;       // Повторных передач сегментов за время соединения
+    uint32_t cwnd;              // Окно перегрузки (сегментов)
+    uint32_t unacked_bytes;     // Отправлено, но не подтверждено (сегменты * MSS)
+    uint32_t sendq_bytes;       // Всего в очереди отправки сокета (не отправлено + не подтверждено)
+} EthernetTcpInfo;
+
 // --- Структура самого интерфейса ---
 // !!!!! ПОЛНОЕ ОПРЕДЕЛЕНИЕ СТРУКТУРЫ ПЕРЕМЕЩЕНО СЮДА !!!!!
 typedef struct IOInterface {
@@ -81,6 +135,170 @@ IOInterface* create_ethernet_interface(const EthernetConfig *config);
  */
 IOInterface* create_serial_interface(const SerialConfig *config);
 
+/**
+ * @brief Создает и инициализирует экземпляр интерфейса локального сокета Unix (stream).
+ * Копирует конфигурацию. Слушающий интерфейс удаляет файл сокета при уничтожении.
+ * @param config Указатель на конфигурацию Unix.
+ * @return Указатель на созданный IOInterface или NULL в случае ошибки.
+ */
+IOInterface* create_unix_interface(const UnixConfig *config);
+
+/**
+ * @brief Создает интерфейс на кольцевых буферах в общей памяти (memfd) для процессов
+ * одной машины. Подключение и передача области идут через управляющий сокет Unix
+ * по пути из config; данные - только через общую память, с eventfd для пробуждения.
+ * Дескриптор соединения - управляющий сокет: shutdown() на нем будит ожидающих
+ * и закрывает соединение, как у сокетов.
+ * @param config Путь управляющего сокета.
+ * @return Указатель на созданный IOInterface или NULL в случае ошибки.
+ */
+IOInterface* create_shm_interface(const UnixConfig *config);
+
+/**
+ * @brief Создает интерфейс Ethernet (TCP) на io_uring: прием - многократный recv в
+ * кольцо предоставленных буферов, пачки отправляются цепочками SEND (uring_send_batch).
+ * Если io_uring недоступен, возвращает обычный интерфейс Ethernet (тип IO_TYPE_ETHERNET).
+ * @param config Указатель на конфигурацию Ethernet.
+ * @return Указатель на созданный IOInterface или NULL в случае ошибки.
+ */
+IOInterface* create_uring_interface(const EthernetConfig *config);
+
+/**
+ * @brief Отправляет пачку запросов по соединениям интерфейсов IO_TYPE_URING одной подачей
+ * io_uring_enter. Запросы одного соединения связаны (IOSQE_IO_LINK) и уходят в порядке
+ * массива; недоотправленное досылается обычным send(). Результат - в requests[i].result.
+ * @return Количество запросов, отправленных не полностью (0 - все отправлены), -1 при ошибке аргументов.
+ */
+int uring_send_batch(IOSendRequest *requests, size_t count);
+
+/**
+ * @brief Формирует путь сокета Unix для СВ-М с заданным портом: "<dir>/svm_<port>.sock".
+ * Порт из конфигурации служит номером сокета, поэтому сопоставление СВ-М не меняется.
+ * @return 0 при успехе, -1 если путь не помещается в sun_path.
+ */
+int unix_socket_path(char *buffer, size_t buffer_len, const char *dir, uint16_t port);
+
+/**
+ * @brief Начинает неблокирующее подключение Ethernet интерфейса к цели из конфигурации.
+ * Готовность сокета на запись (poll/epoll) означает завершение попытки.
+ * @return Дескриптор сокета (подключение может быть еще в процессе) или -1 при ошибке.
+ */
+int ethernet_connect_start(IOInterface *self);
+
+/**
+ * @brief Завершает подключение, начатое ethernet_connect_start: проверяет результат
+ * и переводит сокет в блокирующий режим. При ошибке сокет закрывается.
+ * @return Дескриптор соединения или -1 при ошибке.
+ */
+int ethernet_connect_finish(IOInterface *self);
+
+/**
+ * @brief Снимает состояние TCP-соединения: getsockopt(TCP_INFO) и ioctl(SIOCOUTQ).
+ * Годится для сокетов Ethernet и io_uring (обычные TCP-сокеты).
+ * @return 0 при успехе, -1 при ошибке (не TCP-сокет, дескриптор закрыт).
+ */
+int ethernet_tcp_info(int handle, EthernetTcpInfo *info);
+
+/**
+ * @brief Применяет к TCP-сокету опции профиля: TCP_NODELAY, TCP_QUICKACK, SO_SNDBUF/SO_RCVBUF,
+ * SO_BUSY_POLL, TCP_USER_TIMEOUT. Вызывается слоем Ethernet для каждого создаваемого сокета.
+ * @return 0 при успехе, -1 если ядро не приняло часть опций (остальные применены).
+ */
+int ethernet_apply_profile(int handle, SocketProfile profile);
+
+/**
+ * @brief Имя профиля ("default", "latency", "throughput").
+ */
+const char* socket_profile_name(SocketProfile profile);
+
+/**
+ * @brief Разбирает имя профиля (без учета регистра).
+ * @return 0 при успехе, -1 для неизвестного имени.
+ */
+int socket_profile_parse(const char *text, SocketProfile *profile);
+
+/**
+ * @brief Включает SO_ZEROCOPY на TCP-соединении: ethernet_send_zerocopy отправляет данные
+ * от threshold байт без копирования в ядро. Вызывается при подключении, если в
+ * EthernetConfig задан zerocopy_threshold; выключается при закрытии соединения.
+ * @return 0 при успехе, -1 если ядро не поддерживает SO_ZEROCOPY.
+ */
+int ethernet_zerocopy_enable(int handle, uint32_t threshold);
+
+/**
+ * @brief Выключает zero-copy перед закрытием соединения: ждет (до 1 с), пока ядро
+ * освободит отправленные буферы, иначе включает закрытие со сбросом (SO_LINGER 0).
+ * Билеты соединения остаются занятыми до ethernet_zerocopy_close().
+ */
+void ethernet_zerocopy_disable(int handle);
+
+/**
+ * @brief Закрывает дескриптор соединения; его билеты после этого считаются освобожденными.
+ * @return Результат close().
+ */
+int ethernet_zerocopy_close(int handle);
+
+/**
+ * @brief Отправляет буфер целиком; при включенном zero-copy и length >= порога - с MSG_ZEROCOPY.
+ * Билет заполняется и при ошибке: часть данных могла уйти без копирования.
+ * @return Отправлено байт или -1 при ошибке (как send_data).
+ */
+ssize_t ethernet_send_zerocopy(int handle, const void *buffer, size_t length, EthernetZcTicket *ticket);
+
+/**
+ * @brief Разбирает уведомления о завершении из очереди ошибок сокета (без ожидания)
+ * и проверяет, освободило ли ядро буфер отправки с этим билетом.
+ * @return true, если буфер можно изменять (в том числе если дескриптор соединения уже закрыт).
+ */
+bool ethernet_zerocopy_released(int handle, const EthernetZcTicket *ticket);
+
+/**
+ * @brief Ждет уведомления в очереди ошибок сокета не дольше timeout_ms.
+ */
+void ethernet_zerocopy_wait(int handle, int timeout_ms);
+
+/**
+ * @brief Возвращает счетчики отправок без копирования.
+ */
+void ethernet_zerocopy_stats(EthernetZcStats *stats);
+
+/**
+ * @brief Начинает неблокирующее подключение интерфейса Unix (аналог ethernet_connect_start).
+ * @return Дескриптор сокета или -1 при ошибке (нет сервера, переполнена очередь ожидания).
+ */
+int unix_connect_start(IOInterface *self);
+
+/**
+ * @brief Завершает подключение, начатое unix_connect_start (аналог ethernet_connect_finish).
+ * @return Дескриптор соединения или -1 при ошибке.
+ */
+int unix_connect_finish(IOInterface *self);
+
+/**
+ * @brief Начинает подключение интерфейса общей памяти: подключает управляющий сокет
+ * и сразу передает серверу область колец (аналог ethernet_connect_start).
+ * @return Дескриптор соединения или -1 при ошибке.
+ */
+int shm_connect_start(IOInterface *self);
+
+/**
+ * @brief Завершает подключение, начатое shm_connect_start (аналог ethernet_connect_finish).
+ * @return Дескриптор соединения или -1 при ошибке.
+ */
+int shm_connect_finish(IOInterface *self);
+
+/**
+ * @brief Начинает неблокирующее подключение интерфейса io_uring (аналог ethernet_connect_start).
+ * @return Дескриптор сокета или -1 при ошибке.
+ */
+int uring_connect_start(IOInterface *self);
+
+/**
+ * @brief Завершает подключение, начатое uring_connect_start, и создает кольцо приема соединения.
+ * @return Дескриптор соединения или -1 при ошибке.
+ */
+int uring_connect_finish(IOInterface *self);
+
 // Функция destroy вызывается через указатель в структуре.
 
 #endif // IO_INTERFACE_H
\ No newline at end of file
@@ -0,0 +1,593 @@
+/*
+ * io/io_shm.c
+ *
+ * Описание:
+ * Реализация интерфейса ввода-вывода (IOInterface) на кольцевых буферах в общей
+ * памяти для svm_app и uvm_app на одной машине. Подключение устанавливается через
+ * управляющий сокет Unix (та же реализация, что у IO_TYPE_UNIX, с проверкой
+ * SO_PEERCRED); клиент создает memfd с парой колец (клиент -> сервер, сервер -> клиент)
+ * и четыре eventfd и передает их серверу через SCM_RIGHTS. Размер memfd запечатан
+ * (F_SEAL_SHRINK | F_SEAL_GROW): сервер проверяет печати до mmap, поэтому клиент не может
+ * уменьшить область под отображением сервера (SIGBUS при доступе). Дальше данные идут только
+ * через общую память: без системных вызовов сокетов и копирования в ядре.
+ * Кольцо - байтовый поток с одним писателем и одним читателем (семантика как у
+ * потокового сокета). Eventfd-«звонок» пишется, только если другая сторона уснула
+ * в ожидании данных или места, поэтому при потоковом обмене системных вызовов нет.
+ * Управляющий сокет остается в poll ожидающих: его закрытие другой стороной или
+ * shutdown(handle) этой стороной будит их и означает конец соединения.
+ */
+
+#define _GNU_SOURCE // Для memfd_create и F_ADD_SEALS
+#include "io_interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+
+#define SHM_MAGIC 0x524D5653u          // "SVMR"
+#define SHM_VERSION 1u
+#define SHM_CACHE_LINE 64
+#define SHM_MAX_HANDLES 1024            // Дескрипторы управляющих сокетов, для которых ведется таблица
+#define SHM_HANDSHAKE_TIMEOUT_MS 2000   // Ожидание дескрипторов от клиента после accept
+#define SHM_SPIN_ITERATIONS 4000        // Опрос кольца перед сном (только при нескольких процессорах)
+#define SHM_NUM_FDS 5                   // memfd + 4 eventfd
+#define SHM_RING_BYTES (1u << 20)       // Емкость каждого из двух колец (степень двойки)
+#define SHM_REQUIRED_SEALS (F_SEAL_SHRINK | F_SEAL_GROW) // Размер области неизменен на все соединение
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SHM_CPU_RELAX() __builtin_ia32_pause()
+#else
+#define SHM_CPU_RELAX() __asm__ __volatile__("" ::: "memory")
+#endif
+
+// Управление одним кольцом в общей памяти. Строка писателя и строка читателя разделены
+typedef struct {
+    uint64_t head __attribute__((aligned(SHM_CACHE_LINE))); // Пишет писатель: байт записано всего
+    uint32_t producer_waiting;                               // Писатель спит: ждет места
+    uint64_t tail __attribute__((aligned(SHM_CACHE_LINE))); // Пишет читатель: байт прочитано всего
+    uint32_t consumer_waiting;                               // Читатель спит: ждет данных
+} ShmRingControl;
+
+// Начало области общей памяти; за ним - данные колец [0] и [1]
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ring_bytes;
+    ShmRingControl ring[2] __attribute__((aligned(SHM_CACHE_LINE))); // [0]: клиент -> сервер, [1]: сервер -> клиент
+} ShmRegion;
+
+// Eventfd в порядке передачи: данные/место кольца [0], данные/место кольца [1]
+enum { SHM_EFD_DATA0, SHM_EFD_SPACE0, SHM_EFD_DATA1, SHM_EFD_SPACE1, SHM_NUM_EFDS };
+
+// Соединение (сторона клиента или сервера). Живет, пока на него есть ссылки
+typedef struct {
+    int handle;                // Управляющий сокет; он же дескриптор соединения для IOInterface
+    ShmRegion *region;
+    size_t map_bytes;
+    uint32_t mask;
+    ShmRingControl *tx, *rx;
+    uint8_t *tx_data, *rx_data;
+    int efds[SHM_NUM_EFDS];
+    int tx_data_efd, tx_space_efd, rx_data_efd, rx_space_efd;
+    pthread_mutex_t send_mutex; // Писатель кольца должен быть один
+    int refs;
+} ShmLink;
+
+// Внутренние данные интерфейса: управляющий интерфейс Unix
+typedef struct {
+    IOInterface *control;
+} ShmInternalData;
+
+static pthread_mutex_t shm_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ShmLink *shm_table[SHM_MAX_HANDLES];
+static int shm_spin_limit = -1;
+
+// --- Прототипы статических функций реализации ---
+static int shm_connect(IOInterface *self);
+static int shm_listen(IOInterface *self);
+static int shm_accept(IOInterface *self, char *client_ip_buffer, size_t buffer_len, uint16_t *client_port);
+static int shm_disconnect(IOInterface *self, int handle);
+static ssize_t shm_send(int handle, const void *buffer, size_t length);
+static ssize_t shm_receive(int handle, void *buffer, size_t length);
+static void shm_destroy(IOInterface *self);
+
+// --- Функция-фабрика ---
+IOInterface* create_shm_interface(const UnixConfig *config) {
+    if (!config || config->path[0] == '\0') {
+        fprintf(stderr, "create_shm_interface: NULL config or empty socket path provided\n");
+        return NULL;
+    }
+    IOInterface *interface = (IOInterface*)malloc(sizeof(IOInterface));
+    ShmInternalData *internal = (ShmInternalData*)calloc(1, sizeof(ShmInternalData));
+    UnixConfig *config_copy = (UnixConfig*)malloc(sizeof(UnixConfig));
+    if (!interface || !internal || !config_copy) {
+        perror("create_shm_interface: Failed to allocate memory for interface");
+        free(interface);
+        free(internal);
+        free(config_copy);
+        return NULL;
+    }
+    internal->control = create_unix_interface(config);
+    if (!internal->control) {
+        free(interface);
+        free(internal);
+        free(config_copy);
+        return NULL;
+    }
+    memcpy(config_copy, config, sizeof(UnixConfig));
+    config_copy->base.type = IO_TYPE_SHM;
+
+    interface->type = IO_TYPE_SHM;
+    interface->config = config_copy;
+    interface->io_handle = -1;
+    interface->internal_data = internal;
+
+    interface->connect = shm_connect;
+    interface->listen = shm_listen;
+    interface->accept = shm_accept;
+    interface->disconnect = shm_disconnect;
+    interface->send_data = shm_send;
+    interface->receive_data = shm_receive;
+    interface->destroy = shm_destroy;
+
+    if (shm_spin_limit < 0) {
+        shm_spin_limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHM_SPIN_ITERATIONS : 0;
+    }
+    return interface;
+}
+
+// --- Таблица соединений (по дескриптору управляющего сокета) ---
+
+static void shm_link_free(ShmLink *link) {
+    if (link->region) munmap(link->region, link->map_bytes);
+    for (int i = 0; i < SHM_NUM_EFDS; ++i) {
+        if (link->efds[i] >= 0) close(link->efds[i]);
+    }
+    if (link->handle >= 0) close(link->handle); // Номер дескриптора освобождается последним
+    pthread_mutex_destroy(&link->send_mutex);
+    free(link);
+}
+
+static ShmLink* shm_get(int handle) {
+    if (handle < 0 || handle >= SHM_MAX_HANDLES) return NULL;
+    pthread_mutex_lock(&shm_table_mutex);
+    ShmLink *link = shm_table[handle];
+    if (link) link->refs++;
+    pthread_mutex_unlock(&shm_table_mutex);
+    return link;
+}
+
+static void shm_put(ShmLink *link) {
+    pthread_mutex_lock(&shm_table_mutex);
+    bool last = (--link->refs == 0);
+    pthread_mutex_unlock(&shm_table_mutex);
+    if (last) shm_link_free(link);
+}
+
+// Отображает область и раскладывает кольца по стороне соединения. Владение memfd не берет.
+// Сервер отображает только область с запечатанным размером (память клиента)
+static ShmLink* shm_link_create(int handle, int memfd, const int efds[SHM_NUM_EFDS], bool is_server) {
+    if (handle >= SHM_MAX_HANDLES) {
+        fprintf(stderr, "shm_link_create: Handle %d exceeds the table size %d\n", handle, SHM_MAX_HANDLES);
+        return NULL;
+    }
+    if (is_server) {
+        int seals = fcntl(memfd, F_GET_SEALS);
+        if (seals < 0 || (seals & SHM_REQUIRED_SEALS) != SHM_REQUIRED_SEALS) {
+            fprintf(stderr, "shm_link_create: Shared memory size is not sealed (seals 0x%X)\n", seals < 0 ? 0 : seals);
+            return NULL;
+        }
+    }
+    struct stat st;
+    if (fstat(memfd, &st) < 0 || (size_t)st.st_size < sizeof(ShmRegion)) {
+        fprintf(stderr, "shm_link_create: Invalid shared memory object\n");
+        return NULL;
+    }
+    ShmLink *link = (ShmLink*)calloc(1, sizeof(ShmLink));
+    if (!link) {
+        perror("shm_link_create: Failed to allocate link");
+        return NULL;
+    }
+    link->handle = -1;
+    for (int i = 0; i < SHM_NUM_EFDS; ++i) link->efds[i] = -1;
+    link->map_bytes = (size_t)st.st_size;
+    link->region = mmap(NULL, link->map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (link->region == MAP_FAILED) {
+        perror("shm_link_create: mmap failed");
+        link->region = NULL;
+        free(link);
+        return NULL;
+    }
+    ShmRegion *region = link->region;
+    uint32_t ring_bytes = region->ring_bytes;
+    if (region->magic != SHM_MAGIC || region->version != SHM_VERSION || ring_bytes == 0 ||
+        (ring_bytes & (ring_bytes - 1)) != 0 || link->map_bytes < sizeof(ShmRegion) + 2 * (size_t)ring_bytes) {
+        fprintf(stderr, "shm_link_create: Shared memory header mismatch (magic 0x%08X, version %u, ring %u)\n",
+                region->magic, region->version, ring_bytes);
+        munmap(link->region, link->map_bytes);
+        free(link);
+        return NULL;
+    }
+    uint8_t *data0 = (uint8_t*)region + sizeof(ShmRegion);
+    uint8_t *data1 = data0 + ring_bytes;
+    link->mask = ring_bytes - 1;
+    if (is_server) {
+        link->rx = &region->ring[0]; link->rx_data = data0;
+        link->tx = &region->ring[1]; link->tx_data = data1;
+        link->rx_data_efd = efds[SHM_EFD_DATA0]; link->rx_space_efd = efds[SHM_EFD_SPACE0];
+        link->tx_data_efd = efds[SHM_EFD_DATA1]; link->tx_space_efd = efds[SHM_EFD_SPACE1];
+    } else {
+        link->tx = &region->ring[0]; link->tx_data = data0;
+        link->rx = &region->ring[1]; link->rx_data = data1;
+        link->tx_data_efd = efds[SHM_EFD_DATA0]; link->tx_space_efd = efds[SHM_EFD_SPACE0];
+        link->rx_data_efd = efds[SHM_EFD_DATA1]; link->rx_space_efd = efds[SHM_EFD_SPACE1];
+    }
+    memcpy(link->efds, efds, sizeof(link->efds));
+    pthread_mutex_init(&link->send_mutex, NULL);
+    link->handle = handle;
+    link->refs = 1; // Ссылка таблицы
+    return link;
+}
+
+static void shm_register(ShmLink *link) {
+    pthread_mutex_lock(&shm_table_mutex);
+    shm_table[link->handle] = link;
+    pthread_mutex_unlock(&shm_table_mutex);
+}
+
+// --- Ожидание и сигнализация ---
+
+static void shm_ring_bell(uint32_t *waiting, int efd) {
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST) && __atomic_exchange_n(waiting, 0, __ATOMIC_SEQ_CST)) {
+        eventfd_write(efd, 1);
+    }
+}
+
+// Сон до звонка или до события на управляющем сокете. -1: соединение закрыто
+// (другой стороной или shutdown этой стороной), 0: проверить кольцо снова
+static int shm_wait(ShmLink *link, int efd) {
+    struct pollfd pfd[2] = { { efd, POLLIN, 0 }, { link->handle, POLLIN, 0 } };
+    if (poll(pfd, 2, -1) < 0) return errno == EINTR ? 0 : -1;
+    if (pfd[0].revents & POLLIN) {
+        eventfd_t value;
+        eventfd_read(efd, &value);
+    }
+    if (pfd[1].revents) {
+        char byte;
+        ssize_t n = recv(link->handle, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) return -1;
+    }
+    return 0;
+}
+
+// Ожидание условия cond_expr: опрос кольца, затем сон с выставленным флагом waiting_flag.
+// Если соединение закрыто, а условие так и не выполнилось - переход на closed_label
+#define SHM_WAIT_FOR(link, cond_expr, waiting_flag, efd, closed_label) \
+    do { \
+        for (int spin_ = 0; !(cond_expr) && spin_ < shm_spin_limit; ++spin_) SHM_CPU_RELAX(); \
+        while (!(cond_expr)) { \
+            __atomic_store_n((waiting_flag), 1, __ATOMIC_SEQ_CST); \
+            if (cond_expr) { __atomic_store_n((waiting_flag), 0, __ATOMIC_SEQ_CST); break; } \
+            if (shm_wait((link), (efd)) < 0) { \
+                __atomic_store_n((waiting_flag), 0, __ATOMIC_SEQ_CST); \
+                if (!(cond_expr)) goto closed_label; \
+            } \
+        } \
+    } while (0)
+
+// --- Реализации функций интерфейса ---
+
+static ssize_t shm_send(int handle, const void *buffer, size_t length) {
+    if (handle < 0 || buffer == NULL || length == 0) {
+        return -1;
+    }
+    ShmLink *link = shm_get(handle);
+    if (!link) {
+        errno = EBADF;
+        return -1;
+    }
+    pthread_mutex_lock(&link->send_mutex);
+    size_t ring_bytes = (size_t)link->mask + 1;
+    uint64_t head = __atomic_load_n(&link->tx->head, __ATOMIC_RELAXED);
+    size_t total_sent = 0;
+    while (total_sent < length) {
+        SHM_WAIT_FOR(link, head - __atomic_load_n(&link->tx->tail, __ATOMIC_SEQ_CST) < ring_bytes,
+                     &link->tx->producer_waiting, link->tx_space_efd, closed);
+        size_t space = ring_bytes - (size_t)(head - __atomic_load_n(&link->tx->tail, __ATOMIC_ACQUIRE));
+        size_t chunk = length - total_sent < space ? length - total_sent : space;
+        size_t offset = (size_t)head & link->mask;
+        size_t first = chunk < ring_bytes - offset ? chunk : ring_bytes - offset;
+        memcpy(link->tx_data + offset, (const char*)buffer + total_sent, first);
+        memcpy(link->tx_data, (const char*)buffer + total_sent + first, chunk - first);
+        head += chunk;
+        total_sent += chunk;
+        __atomic_store_n(&link->tx->head, head, __ATOMIC_SEQ_CST);
+        shm_ring_bell(&link->tx->consumer_waiting, link->tx_data_efd);
+    }
+    pthread_mutex_unlock(&link->send_mutex);
+    shm_put(link);
+    return (ssize_t)total_sent;
+
+closed:
+    pthread_mutex_unlock(&link->send_mutex);
+    shm_put(link);
+    fprintf(stderr, "shm_send: Connection %d closed\n", handle);
+    errno = EPIPE;
+    return -1;
+}
+
+static ssize_t shm_receive(int handle, void *buffer, size_t length) {
+    if (handle < 0 || buffer == NULL || length == 0) {
+        return -1;
+    }
+    ShmLink *link = shm_get(handle);
+    if (!link) {
+        errno = EBADF;
+        return -1;
+    }
+    size_t ring_bytes = (size_t)link->mask + 1;
+    uint64_t tail = __atomic_load_n(&link->rx->tail, __ATOMIC_RELAXED);
+    SHM_WAIT_FOR(link, __atomic_load_n(&link->rx->head, __ATOMIC_SEQ_CST) != tail,
+                 &link->rx->consumer_waiting, link->rx_data_efd, closed);
+
+    size_t available = (size_t)(__atomic_load_n(&link->rx->head, __ATOMIC_ACQUIRE) - tail);
+    size_t chunk = length < available ? length : available;
+    size_t offset = (size_t)tail & link->mask;
+    size_t first = chunk < ring_bytes - offset ? chunk : ring_bytes - offset;
+    memcpy(buffer, link->rx_data + offset, first);
+    memcpy((char*)buffer + first, link->rx_data, chunk - first);
+    __atomic_store_n(&link->rx->tail, tail + chunk, __ATOMIC_SEQ_CST);
+    shm_ring_bell(&link->rx->producer_waiting, link->rx_space_efd);
+    shm_put(link);
+    return (ssize_t)chunk;
+
+closed:
+    shm_put(link);
+    return 0; // Как у сокета: соединение закрыто, данных больше не будет
+}
+
+// Клиент: управляющий сокет уже подключен; создается область и передается серверу
+static int shm_client_handshake(int handle) {
+    size_t map_bytes = sizeof(ShmRegion) + 2 * (size_t)SHM_RING_BYTES;
+    int fds[SHM_NUM_FDS];
+    for (int i = 0; i < SHM_NUM_FDS; ++i) fds[i] = -1;
+    ShmLink *link = NULL;
+    int result = -1;
+
+    fds[0] = memfd_create("svm_shm_ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fds[0] < 0 || ftruncate(fds[0], (off_t)map_bytes) < 0) {
+        perror("shm_connect: Failed to create shared memory");
+        goto cleanup;
+    }
+    if (fcntl(fds[0], F_ADD_SEALS, SHM_REQUIRED_SEALS | F_SEAL_SEAL) < 0) {
+        perror("shm_connect: Failed to seal shared memory");
+        goto cleanup;
+    }
+    ShmRegion *region = mmap(NULL, sizeof(ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    if (region == MAP_FAILED) {
+        perror("shm_connect: mmap failed");
+        goto cleanup;
+    }
+    region->magic = SHM_MAGIC;
+    region->version = SHM_VERSION;
+    region->ring_bytes = SHM_RING_BYTES;
+    munmap(region, sizeof(ShmRegion));
+    for (int i = 1; i < SHM_NUM_FDS; ++i) {
+        fds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fds[i] < 0) {
+            perror("shm_connect: eventfd failed");
+            goto cleanup;
+        }
+    }
+    link = shm_link_create(handle, fds[0], &fds[1], false);
+    if (!link) goto cleanup;
+
+    char byte = 'S';
+    struct iovec iov = { &byte, 1 };
+    union {
+        char buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    if (sendmsg(handle, &msg, MSG_NOSIGNAL) != 1) {
+        perror("shm_connect: Failed to pass shared memory to server");
+        goto cleanup;
+    }
+    shm_register(link);
+    for (int i = 1; i < SHM_NUM_FDS; ++i) fds[i] = -1; // Теперь принадлежат соединению
+    link = NULL;
+    result = 0;
+
+cleanup:
+    if (link) {
+        link->handle = -1; // Управляющий сокет закрывает вызывающий
+        for (int i = 0; i < SHM_NUM_EFDS; ++i) link->efds[i] = -1;
+        shm_link_free(link);
+    }
+    for (int i = 0; i < SHM_NUM_FDS; ++i) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    return result;
+}
+
+int shm_connect_start(IOInterface *self) {
+    if (!self || self->type != IO_TYPE_SHM || !self->internal_data) {
+        fprintf(stderr, "shm_connect_start: Invalid interface\n");
+        return -1;
+    }
+    IOInterface *control = ((ShmInternalData*)self->internal_data)->control;
+    if (self->io_handle != -1) {
+        shm_disconnect(self, self->io_handle);
+    }
+    self->io_handle = unix_connect_start(control);
+    if (self->io_handle < 0) return -1;
+    // Подключение к локальному серверу уже в его очереди ожидания: область передается сразу,
+    // сервер заберет ее при accept (как данные, отправленные до accept по TCP)
+    if (shm_client_handshake(self->io_handle) != 0) {
+        control->disconnect(control, self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+    return self->io_handle;
+}
+
+int shm_connect_finish(IOInterface *self) {
+    if (!self || self->io_handle < 0) return -1;
+    IOInterface *control = ((ShmInternalData*)self->internal_data)->control;
+    int handle = self->io_handle;
+    // Проверка результата подключения; при ошибке сокет закрыт, соединение снимается с таблицы
+    if (unix_connect_finish(control) < 0) {
+        pthread_mutex_lock(&shm_table_mutex);
+        ShmLink *link = handle < SHM_MAX_HANDLES ? shm_table[handle] : NULL;
+        if (link) shm_table[handle] = NULL;
+        pthread_mutex_unlock(&shm_table_mutex);
+        if (link) {
+            link->handle = -1; // Уже закрыт
+            shm_put(link);
+        }
+        self->io_handle = -1;
+        return -1;
+    }
+    UnixConfig *config = (UnixConfig*)self->config;
+    printf("Shm: Connected to %s, %u KB rings (handle: %d)\n", config->path, SHM_RING_BYTES / 1024, handle);
+    return handle;
+}
+
+static int shm_connect(IOInterface *self) {
+    if (shm_connect_start(self) < 0) return -1;
+    return shm_connect_finish(self);
+}
+
+static int shm_listen(IOInterface *self) {
+    if (!self || self->type != IO_TYPE_SHM || !self->internal_data) {
+        fprintf(stderr, "shm_listen: Invalid interface\n");
+        return -1;
+    }
+    IOInterface *control = ((ShmInternalData*)self->internal_data)->control;
+    self->io_handle = control->listen(control);
+    return self->io_handle;
+}
+
+// Сервер: прием дескрипторов области от клиента
+static ShmLink* shm_server_handshake(int handle) {
+    struct pollfd pfd = { handle, POLLIN, 0 };
+    if (poll(&pfd, 1, SHM_HANDSHAKE_TIMEOUT_MS) <= 0) {
+        fprintf(stderr, "shm_accept: Client did not pass shared memory in %d ms\n", SHM_HANDSHAKE_TIMEOUT_MS);
+        return NULL;
+    }
+    int fds[SHM_NUM_FDS];
+    char byte;
+    struct iovec iov = { &byte, 1 };
+    union {
+        char buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    ssize_t n;
+    do {
+        n = recvmsg(handle, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    struct cmsghdr *cmsg = n == 1 ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        fprintf(stderr, "shm_accept: Client did not pass shared memory descriptors\n");
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) { // Чужие дескрипторы
+            int count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            int *received = (int*)CMSG_DATA(cmsg);
+            for (int i = 0; i < count; ++i) close(received[i]);
+        }
+        return NULL;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    ShmLink *link = shm_link_create(handle, fds[0], &fds[1], true);
+    close(fds[0]); // Отображение держит область
+    if (!link) {
+        for (int i = 1; i < SHM_NUM_FDS; ++i) close(fds[i]);
+    }
+    return link;
+}
+
+static int shm_accept(IOInterface *self, char *client_ip_buffer, size_t buffer_len, uint16_t *client_port) {
+    if (!self || self->type != IO_TYPE_SHM || !self->internal_data) {
+        fprintf(stderr, "shm_accept: Invalid interface\n");
+        return -1;
+    }
+    IOInterface *control = ((ShmInternalData*)self->internal_data)->control;
+    while (true) {
+        int handle = control->accept(control, client_ip_buffer, buffer_len, client_port); // С проверкой SO_PEERCRED
+        if (handle < 0) return -1;
+        ShmLink *link = shm_server_handshake(handle);
+        if (!link) {
+            close(handle);
+            continue;
+        }
+        shm_register(link);
+        printf("Shm: Accepted shared memory connection, %u KB rings (handle: %d)\n", (link->mask + 1) / 1024, handle);
+        return handle;
+    }
+}
+
+static int shm_disconnect(IOInterface *self, int handle) {
+    if (handle < 0) {
+        return -1;
+    }
+    ShmLink *link = NULL;
+    if (handle < SHM_MAX_HANDLES) {
+        pthread_mutex_lock(&shm_table_mutex);
+        link = shm_table[handle];
+        shm_table[handle] = NULL;
+        pthread_mutex_unlock(&shm_table_mutex);
+    }
+    printf("Shm: Closing handle %d\n", handle);
+    if (self && self->io_handle == handle) {
+        self->io_handle = -1;
+        ShmInternalData *internal = (ShmInternalData*)self->internal_data;
+        if (internal && internal->control->io_handle == handle) internal->control->io_handle = -1;
+    }
+    if (!link) {
+        return close(handle);
+    }
+    shutdown(handle, SHUT_RDWR); // Будит ожидающих в shm_wait; сокет закроется с последней ссылкой
+    shm_put(link);
+    return 0;
+}
+
+static void shm_destroy(IOInterface *self) {
+    if (!self) return;
+    ShmInternalData *internal = (ShmInternalData*)self->internal_data;
+    if (self->io_handle >= 0) {
+        shm_disconnect(self, self->io_handle); // Подключенный клиент или слушающий сокет
+    }
+    if (internal && internal->control) {
+        internal->control->destroy(internal->control); // Слушающий сокет и его файл
+    }
+    free(self->config);
+    self->config = NULL;
+    free(self->internal_data);
+    self->internal_data = NULL;
+    free(self);
+    printf("Shm Interface destroyed.\n");
+}
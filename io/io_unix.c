@@ -0,0 +1,326 @@
+/*
+ * io/io_unix.c
+ *
+ * Описание:
+ * Реализация функций интерфейса ввода-вывода (IOInterface) для локальных
+ * сокетов Unix (AF_UNIX, SOCK_STREAM). Используется, когда svm_app и uvm_app
+ * работают на одной машине: обмен идет в обход стека TCP/IP.
+ * При приеме подключения проверяются учетные данные клиента (SO_PEERCRED):
+ * допускаются процессы того же пользователя и root.
+ */
+
+#define _GNU_SOURCE // Для struct ucred (SO_PEERCRED)
+#include "io_interface.h" // Определения интерфейса и структур конфигурации
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// Очередь ожидания подключений (как у Ethernet)
+#define UNIX_LISTEN_BACKLOG 16
+
+// Внутренние данные: слушающий интерфейс владеет файлом сокета и удаляет его при уничтожении
+typedef struct {
+    bool owns_path;
+} UnixInternalData;
+
+// --- Прототипы статических функций реализации ---
+static int unix_connect(IOInterface *self);
+static int unix_listen(IOInterface *self);
+static int unix_accept(IOInterface *self, char *client_ip_buffer, size_t buffer_len, uint16_t *client_port);
+static int unix_disconnect(IOInterface *self, int handle);
+static ssize_t unix_send(int handle, const void *buffer, size_t length);
+static ssize_t unix_receive(int handle, void *buffer, size_t length);
+static void unix_destroy(IOInterface *self);
+
+// --- Функция-фабрика ---
+IOInterface* create_unix_interface(const UnixConfig *config) {
+    if (!config || config->path[0] == '\0') {
+        fprintf(stderr, "create_unix_interface: NULL config or empty socket path provided\n");
+        return NULL;
+    }
+
+    IOInterface *interface = (IOInterface*)malloc(sizeof(IOInterface));
+    if (!interface) {
+        perror("create_unix_interface: Failed to allocate memory for interface");
+        return NULL;
+    }
+    UnixConfig *config_copy = (UnixConfig*)malloc(sizeof(UnixConfig));
+    UnixInternalData *internal = (UnixInternalData*)calloc(1, sizeof(UnixInternalData));
+    if (!config_copy || !internal) {
+        perror("create_unix_interface: Failed to allocate memory for config copy");
+        free(config_copy);
+        free(internal);
+        free(interface);
+        return NULL;
+    }
+    memcpy(config_copy, config, sizeof(UnixConfig));
+    config_copy->base.type = IO_TYPE_UNIX;
+
+    interface->type = IO_TYPE_UNIX;
+    interface->config = config_copy;
+    interface->io_handle = -1;
+    interface->internal_data = internal;
+
+    interface->connect = unix_connect;
+    interface->listen = unix_listen;
+    interface->accept = unix_accept;
+    interface->disconnect = unix_disconnect;
+    interface->send_data = unix_send;
+    interface->receive_data = unix_receive;
+    interface->destroy = unix_destroy;
+
+    return interface;
+}
+
+int unix_socket_path(char *buffer, size_t buffer_len, const char *dir, uint16_t port) {
+    if (!buffer || !dir) return -1;
+    struct sockaddr_un addr;
+    int len = snprintf(buffer, buffer_len, "%s/svm_%u.sock", dir, port);
+    if (len < 0 || (size_t)len >= buffer_len || (size_t)len >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "unix_socket_path: Socket path for port %u in '%s' is too long\n", port, dir);
+        return -1;
+    }
+    return 0;
+}
+
+// --- Реализации функций интерфейса ---
+
+static void unix_fill_address(const UnixConfig *config, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strncpy(addr->sun_path, config->path, sizeof(addr->sun_path) - 1);
+}
+
+static int unix_connect(IOInterface *self) {
+    if (unix_connect_start(self) < 0) return -1;
+    return unix_connect_finish(self); // Локальное подключение завершается сразу
+}
+
+// Неблокирующее подключение: запуск. Сервер локальный, поэтому подключение
+// либо завершается сразу, либо отвергается (нет сервера, полна очередь ожидания)
+int unix_connect_start(IOInterface *self) {
+    if (!self || self->type != IO_TYPE_UNIX || !self->config) {
+        fprintf(stderr, "unix_connect_start: Invalid interface or config\n");
+        return -1;
+    }
+    if (self->io_handle != -1) {
+        unix_disconnect(self, self->io_handle);
+        self->io_handle = -1;
+    }
+
+    UnixConfig *config = (UnixConfig*)self->config;
+    struct sockaddr_un server_addr;
+    unix_fill_address(config, &server_addr);
+
+    self->io_handle = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (self->io_handle < 0) {
+        perror("unix_connect_start: Failed to create socket");
+        self->io_handle = -1;
+        return -1;
+    }
+    if (connect(self->io_handle, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0 && errno != EINPROGRESS) {
+        fprintf(stderr, "unix_connect_start: Connection to %s failed: %s\n", config->path, strerror(errno));
+        close(self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+    return self->io_handle;
+}
+
+// Неблокирующее подключение: проверка результата и возврат сокета в блокирующий режим
+int unix_connect_finish(IOInterface *self) {
+    if (!self || self->io_handle < 0) return -1;
+    UnixConfig *config = (UnixConfig*)self->config;
+    int so_error = 0;
+    socklen_t len = sizeof(so_error);
+    if (getsockopt(self->io_handle, SOL_SOCKET, SO_ERROR, &so_error, &len) < 0) so_error = errno;
+    if (so_error != 0) {
+        fprintf(stderr, "unix_connect_finish: Connection to %s failed: %s\n", config->path, strerror(so_error));
+        close(self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+    int flags = fcntl(self->io_handle, F_GETFL, 0);
+    if (flags < 0 || fcntl(self->io_handle, F_SETFL, flags & ~O_NONBLOCK) < 0) {
+        perror("unix_connect_finish: Failed to restore blocking mode");
+        close(self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+    printf("Unix: Connected to %s (handle: %d)\n", config->path, self->io_handle);
+    return self->io_handle;
+}
+
+static int unix_listen(IOInterface *self) {
+    if (!self || self->type != IO_TYPE_UNIX || !self->config) {
+        fprintf(stderr, "unix_listen: Invalid interface or config\n");
+        return -1;
+    }
+    if (self->io_handle != -1) {
+        unix_disconnect(self, self->io_handle);
+    }
+
+    UnixConfig *config = (UnixConfig*)self->config;
+    UnixInternalData *internal = (UnixInternalData*)self->internal_data;
+    struct sockaddr_un server_addr;
+    unix_fill_address(config, &server_addr);
+
+    self->io_handle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (self->io_handle < 0) {
+        perror("unix_listen: Failed to create socket");
+        self->io_handle = -1;
+        return -1;
+    }
+
+    // Файл сокета от прежнего запуска мешает bind (аналог SO_REUSEADDR); удаляем только сокеты
+    struct stat st;
+    if (lstat(config->path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "unix_listen: %s exists and is not a socket\n", config->path);
+            close(self->io_handle);
+            self->io_handle = -1;
+            return -1;
+        }
+        unlink(config->path);
+    }
+
+    if (bind(self->io_handle, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        fprintf(stderr, "unix_listen: Bind to %s failed: %s\n", config->path, strerror(errno));
+        close(self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+    internal->owns_path = true;
+
+    if (listen(self->io_handle, UNIX_LISTEN_BACKLOG) < 0) {
+        perror("unix_listen: Listen failed");
+        close(self->io_handle);
+        self->io_handle = -1;
+        return -1;
+    }
+
+    printf("Unix: Listening on %s (handle: %d)\n", config->path, self->io_handle);
+    return self->io_handle;
+}
+
+// Прием подключения. Вместо IP клиента возвращается "pid N", порт - 0.
+// Подключения процессов другого пользователя (кроме root) отклоняются.
+static int unix_accept(IOInterface *self, char *client_ip_buffer, size_t buffer_len, uint16_t *client_port) {
+    if (!self || self->type != IO_TYPE_UNIX || self->io_handle < 0) {
+        fprintf(stderr, "unix_accept: Invalid interface or not listening\n");
+        return -1;
+    }
+
+    int client_handle = -1;
+    while (true) {
+        do {
+            client_handle = accept(self->io_handle, NULL, NULL);
+        } while (client_handle < 0 && errno == EINTR);
+
+        if (client_handle < 0) {
+            perror("unix_accept: Accept failed");
+            return -1;
+        }
+
+        struct ucred cred;
+        socklen_t cred_len = sizeof(cred);
+        if (getsockopt(client_handle, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) < 0) {
+            perror("unix_accept: getsockopt(SO_PEERCRED) failed");
+            close(client_handle);
+            continue;
+        }
+        if (cred.uid != geteuid() && cred.uid != 0) {
+            fprintf(stderr, "unix_accept: Rejected connection from pid %d (uid %u): foreign user\n",
+                    (int)cred.pid, (unsigned)cred.uid);
+            close(client_handle);
+            continue;
+        }
+        printf("Unix: Peer credentials pid %d, uid %u, gid %u\n", (int)cred.pid, (unsigned)cred.uid, (unsigned)cred.gid);
+        if (client_ip_buffer && buffer_len > 0) {
+            snprintf(client_ip_buffer, buffer_len, "pid %d", (int)cred.pid);
+        }
+        if (client_port) {
+            *client_port = 0;
+        }
+        return client_handle;
+    }
+}
+
+static int unix_disconnect(IOInterface *self, int handle) {
+    if (handle < 0) {
+        return -1;
+    }
+    printf("Unix: Closing handle %d\n", handle);
+    if (close(handle) < 0) {
+        perror("unix_disconnect: close failed");
+        return -1;
+    }
+    if (self && self->io_handle == handle) {
+        self->io_handle = -1;
+    }
+    return 0;
+}
+
+static ssize_t unix_send(int handle, const void *buffer, size_t length) {
+    if (handle < 0 || buffer == NULL || length == 0) {
+        return -1;
+    }
+    ssize_t total_sent = 0;
+    while (total_sent < (ssize_t)length) {
+        // MSG_NOSIGNAL: закрытый другой стороной сокет - ошибка EPIPE, а не SIGPIPE
+        ssize_t sent_now = send(handle, (const char*)buffer + total_sent, length - total_sent, MSG_NOSIGNAL);
+        if (sent_now < 0) {
+            if (errno == EINTR) continue;
+            perror("unix_send: send failed");
+            return -1;
+        }
+        if (sent_now == 0) {
+            fprintf(stderr, "unix_send: send returned 0\n");
+            return total_sent;
+        }
+        total_sent += sent_now;
+    }
+    return total_sent;
+}
+
+static ssize_t unix_receive(int handle, void *buffer, size_t length) {
+    if (handle < 0 || buffer == NULL || length == 0) {
+        return -1;
+    }
+    ssize_t bytes_received;
+    do {
+        bytes_received = recv(handle, buffer, length, 0);
+    } while (bytes_received < 0 && errno == EINTR);
+
+    if (bytes_received < 0) {
+        perror("unix_receive: recv failed");
+    }
+    return bytes_received;
+}
+
+static void unix_destroy(IOInterface *self) {
+    if (!self) return;
+
+    if (self->io_handle >= 0) {
+        close(self->io_handle);
+        self->io_handle = -1;
+    }
+    UnixInternalData *internal = (UnixInternalData*)self->internal_data;
+    UnixConfig *config = (UnixConfig*)self->config;
+    if (internal && internal->owns_path && config) {
+        unlink(config->path); // Файл сокета больше никто не слушает
+    }
+    free(self->config);
+    self->config = NULL;
+    free(self->internal_data);
+    self->internal_data = NULL;
+    free(self);
+    printf("Unix Interface destroyed.\n");
+}
@@ -0,0 +1,699 @@
+/*
+ * io/io_uring.c
+ *
+ * Описание:
+ * Реализация интерфейса ввода-вывода (IOInterface) для Ethernet (TCP) на io_uring
+ * (прямые системные вызовы io_uring_setup/io_uring_enter/io_uring_register, без liburing).
+ * Подключение, прослушивание и прием соединений выполняет обычный интерфейс Ethernet.
+ *  - Прием: у каждого соединения свое кольцо с одной многократной операцией recv
+ *    (IORING_RECV_MULTISHOT), которая складывает данные в зарегистрированные буферы из
+ *    кольца предоставленных буферов (IORING_REGISTER_PBUF_RING). Пока в очереди
+ *    завершений есть данные, receive_data забирает их без системных вызовов;
+ *    io_uring_enter вызывается, только когда очередь пуста. Прочитанный буфер сразу
+ *    возвращается в кольцо.
+ *  - Отправка: одиночное сообщение - обычный send(); пачка (uring_send_batch) - для
+ *    каждого соединения цепочка SENDMSG (до URING_SEND_IOV_MAX кадров в операции),
+ *    связанная IOSQE_IO_LINK, чтобы сохранить порядок; цепочки всех соединений
+ *    пачки подаются одним io_uring_enter.
+ * Если io_uring недоступен (старое ядро, запрет io_uring_disabled, seccomp), фабрика
+ * возвращает обычный интерфейс Ethernet; если кольцо не удалось создать для отдельного
+ * соединения, оно работает через send()/recv().
+ */
+
+#include "io_interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#define URING_MAX_HANDLES 1024          // Дескрипторы соединений, для которых ведется таблица
+#define URING_RX_SQ_ENTRIES 4           // Приему нужна одна операция (и ее перезапуск)
+#define URING_RX_CQ_ENTRIES 256         // Больше числа буферов: очередь завершений не переполняется
+#define URING_RX_BUFFERS 64             // Буферов приема на соединение (степень двойки)
+#define URING_RX_BUFFER_BYTES 4096
+#define URING_RX_BGID 0                 // Группа буферов (своя в каждом кольце)
+#define URING_TX_ENTRIES 64             // Предельный размер пачки за одну подачу
+#define URING_SEND_IOV_MAX 16           // Кадров в одной операции SENDMSG
+
+// Кольцо io_uring: отображенные очереди подачи (SQ) и завершений (CQ)
+typedef struct {
+    int fd;
+    void *sq_map, *cq_map;
+    size_t sq_map_bytes, cq_map_bytes;
+    struct io_uring_sqe *sqes;
+    size_t sqes_bytes;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned sq_entries;
+    unsigned sqe_tail;                  // Заполненные, но еще не опубликованные SQE
+} UringRing;
+
+// Соединение с кольцом приема. Живет, пока на него есть ссылки
+typedef struct {
+    int handle;
+    UringRing ring;
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_bytes;
+    uint8_t *buffers;
+    uint16_t buf_tail;
+    bool recv_armed;                    // Многократный recv активен
+    bool recv_pending;                  // SQE recv подготовлен, но не подан
+    bool eof;
+    bool plain;                         // Ядро не поддерживает multishot recv: обычный recv()
+    int cur_bid;                        // Частично прочитанный буфер
+    uint32_t cur_offset, cur_length;
+    int refs;
+} UringLink;
+
+// Внутренние данные интерфейса: обычный интерфейс Ethernet для подключений
+typedef struct {
+    IOInterface *control;
+} UringInternalData;
+
+static pthread_mutex_t uring_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+static UringLink *uring_table[URING_MAX_HANDLES];
+static pthread_mutex_t uring_tx_mutex = PTHREAD_MUTEX_INITIALIZER;
+static UringRing uring_tx;              // Общее кольцо отправки пачек
+static bool uring_tx_ready = false;
+static int uring_supported = -1;        // -1: не проверено
+
+// --- Прототипы статических функций реализации ---
+static int uring_connect(IOInterface *self);
+static int uring_listen(IOInterface *self);
+static int uring_accept(IOInterface *self, char *client_ip_buffer, size_t buffer_len, uint16_t *client_port);
+static int uring_disconnect(IOInterface *self, int handle);
+static ssize_t uring_send(int handle, const void *buffer, size_t length);
+static ssize_t uring_receive(int handle, void *buffer, size_t length);
+static void uring_destroy(IOInterface *self);
+static bool uring_probe(void);
+
+// --- Функция-фабрика ---
+IOInterface* create_uring_interface(const EthernetConfig *config) {
+    if (!config) {
+        fprintf(stderr, "create_uring_interface: NULL config provided\n");
+        return NULL;
+    }
+    if (!uring_probe()) {
+        return create_ethernet_interface(config); // Прозрачная замена: тот же TCP без io_uring
+    }
+    IOInterface *interface = (IOInterface*)malloc(sizeof(IOInterface));
+    UringInternalData *internal = (UringInternalData*)calloc(1, sizeof(UringInternalData));
+    EthernetConfig *config_copy = (EthernetConfig*)malloc(sizeof(EthernetConfig));
+    if (!interface || !internal || !config_copy) {
+        perror("create_uring_interface: Failed to allocate memory for interface");
+        free(interface);
+        free(internal);
+        free(config_copy);
+        return NULL;
+    }
+    internal->control = create_ethernet_interface(config);
+    if (!internal->control) {
+        free(interface);
+        free(internal);
+        free(config_copy);
+        return NULL;
+    }
+    memcpy(config_copy, config, sizeof(EthernetConfig));
+    config_copy->base.type = IO_TYPE_URING;
+
+    interface->type = IO_TYPE_URING;
+    interface->config = config_copy;
+    interface->io_handle = -1;
+    interface->internal_data = internal;
+
+    interface->connect = uring_connect;
+    interface->listen = uring_listen;
+    interface->accept = uring_accept;
+    interface->disconnect = uring_disconnect;
+    interface->send_data = uring_send;
+    interface->receive_data = uring_receive;
+    interface->destroy = uring_destroy;
+
+    return interface;
+}
+
+// --- Кольцо io_uring ---
+
+static int uring_sys_setup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_sys_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void uring_ring_free(UringRing *ring) {
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_bytes);
+    if (ring->cq_map && ring->cq_map != ring->sq_map) munmap(ring->cq_map, ring->cq_map_bytes);
+    if (ring->sq_map) munmap(ring->sq_map, ring->sq_map_bytes);
+    if (ring->fd >= 0) close(ring->fd);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+// Создание кольца и отображение очередей. -1 с errno при ошибке
+static int uring_ring_init(UringRing *ring, unsigned entries, unsigned cq_entries) {
+    memset(ring, 0, sizeof(*ring));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = cq_entries;
+    ring->fd = uring_sys_setup(entries, &params);
+    if (ring->fd < 0) return -1;
+
+    ring->sq_map_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_bytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_map_bytes > ring->sq_map_bytes) ring->sq_map_bytes = ring->cq_map_bytes;
+        ring->cq_map_bytes = ring->sq_map_bytes;
+    }
+    ring->sq_map = mmap(NULL, ring->sq_map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) goto fail;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_map = ring->sq_map;
+    } else {
+        ring->cq_map = mmap(NULL, ring->cq_map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) goto fail;
+    }
+    ring->sqes_bytes = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) goto fail;
+
+    uint8_t *sq = (uint8_t*)ring->sq_map, *cq = (uint8_t*)ring->cq_map;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring->sq_entries = params.sq_entries;
+    ring->sqe_tail = *ring->sq_tail;
+    return 0;
+
+fail:;
+    int saved_errno = errno;
+    if (ring->sq_map == MAP_FAILED) ring->sq_map = NULL;
+    if (ring->cq_map == MAP_FAILED) ring->cq_map = NULL;
+    if (ring->sqes == MAP_FAILED) ring->sqes = NULL;
+    uring_ring_free(ring);
+    errno = saved_errno;
+    return -1;
+}
+
+// Свободный SQE (обнуленный) или NULL, если очередь подачи полна
+static struct io_uring_sqe* uring_get_sqe(UringRing *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sqe_tail - head >= ring->sq_entries) return NULL;
+    unsigned index = ring->sqe_tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->sqe_tail++;
+    return sqe;
+}
+
+// Публикует подготовленные SQE; возвращает, сколько их ждет подачи ядру
+static unsigned uring_flush_sq(UringRing *ring) {
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+    return ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+}
+
+// Забирает одно завершение без системного вызова. false: очередь завершений пуста
+static bool uring_pop_cqe(UringRing *ring, struct io_uring_cqe *out) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) return false;
+    *out = ring->cqes[head & *ring->cq_mask];
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Однократная проверка: кольцо создается и принимает кольцо предоставленных буферов
+static bool uring_probe(void) {
+    pthread_mutex_lock(&uring_table_mutex);
+    if (uring_supported < 0) {
+        UringRing ring;
+        uring_supported = 0;
+        if (uring_ring_init(&ring, URING_RX_SQ_ENTRIES, URING_RX_CQ_ENTRIES) < 0) {
+            fprintf(stderr, "create_uring_interface: io_uring unavailable (%s). Falling back to Ethernet.\n", strerror(errno));
+        } else {
+            long page = sysconf(_SC_PAGESIZE);
+            void *buf_ring = mmap(NULL, (size_t)page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            struct io_uring_buf_reg reg;
+            memset(&reg, 0, sizeof(reg));
+            reg.ring_addr = (uint64_t)(uintptr_t)buf_ring;
+            reg.ring_entries = 1;
+            reg.bgid = URING_RX_BGID;
+            if (buf_ring != MAP_FAILED && uring_sys_register(ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0) {
+                uring_supported = 1;
+                printf("io_uring: multishot receive with provided buffers available.\n");
+            } else {
+                fprintf(stderr, "create_uring_interface: Provided buffer rings unsupported (%s). Falling back to Ethernet.\n",
+                        strerror(errno));
+            }
+            if (buf_ring != MAP_FAILED) munmap(buf_ring, (size_t)page);
+            uring_ring_free(&ring);
+        }
+    }
+    bool supported = uring_supported == 1;
+    pthread_mutex_unlock(&uring_table_mutex);
+    return supported;
+}
+
+// --- Таблица соединений (по дескриптору сокета) ---
+
+static void uring_link_free(UringLink *link) {
+    uring_ring_free(&link->ring); // Вместе с кольцом снимается и регистрация буферов
+    if (link->buf_ring) munmap(link->buf_ring, link->buf_ring_bytes);
+    if (link->buffers) munmap(link->buffers, (size_t)URING_RX_BUFFERS * URING_RX_BUFFER_BYTES);
+    if (link->handle >= 0) ethernet_zerocopy_close(link->handle); // Номер дескриптора освобождается последним
+    free(link);
+}
+
+static UringLink* uring_get(int handle) {
+    if (handle < 0 || handle >= URING_MAX_HANDLES) return NULL;
+    pthread_mutex_lock(&uring_table_mutex);
+    UringLink *link = uring_table[handle];
+    if (link) link->refs++;
+    pthread_mutex_unlock(&uring_table_mutex);
+    return link;
+}
+
+static void uring_put(UringLink *link) {
+    pthread_mutex_lock(&uring_table_mutex);
+    bool last = (--link->refs == 0);
+    pthread_mutex_unlock(&uring_table_mutex);
+    if (last) uring_link_free(link);
+}
+
+// Возврат буфера в кольцо предоставленных буферов
+static void uring_recycle_buffer(UringLink *link, int bid) {
+    struct io_uring_buf *buf = &link->buf_ring->bufs[link->buf_tail & (URING_RX_BUFFERS - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(link->buffers + (size_t)bid * URING_RX_BUFFER_BYTES);
+    buf->len = URING_RX_BUFFER_BYTES;
+    buf->bid = (uint16_t)bid;
+    link->buf_tail++;
+    __atomic_store_n(&link->buf_ring->tail, link->buf_tail, __ATOMIC_RELEASE);
+}
+
+// Кольцо приема для соединения. При ошибке соединение остается без кольца (обычный recv)
+static void uring_link_register(int handle) {
+    if (handle >= URING_MAX_HANDLES) {
+        fprintf(stderr, "uring: Handle %d exceeds the table size %d, using plain send/recv\n", handle, URING_MAX_HANDLES);
+        return;
+    }
+    UringLink *link = (UringLink*)calloc(1, sizeof(UringLink));
+    if (!link) {
+        perror("uring: Failed to allocate link");
+        return;
+    }
+    link->handle = -1;
+    link->cur_bid = -1;
+    if (uring_ring_init(&link->ring, URING_RX_SQ_ENTRIES, URING_RX_CQ_ENTRIES) < 0) {
+        fprintf(stderr, "uring: Failed to create receive ring for handle %d (%s), using plain recv\n", handle, strerror(errno));
+        free(link);
+        return;
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    link->buf_ring_bytes = (URING_RX_BUFFERS * sizeof(struct io_uring_buf) + (size_t)page - 1) & ~((size_t)page - 1);
+    link->buf_ring = mmap(NULL, link->buf_ring_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    link->buffers = mmap(NULL, (size_t)URING_RX_BUFFERS * URING_RX_BUFFER_BYTES, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (link->buf_ring == MAP_FAILED || link->buffers == MAP_FAILED) {
+        perror("uring: Failed to allocate receive buffers");
+        goto fail;
+    }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)link->buf_ring;
+    reg.ring_entries = URING_RX_BUFFERS;
+    reg.bgid = URING_RX_BGID;
+    if (uring_sys_register(link->ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        perror("uring: Failed to register provided buffer ring");
+        goto fail;
+    }
+    for (int bid = 0; bid < URING_RX_BUFFERS; ++bid) uring_recycle_buffer(link, bid);
+    link->handle = handle;
+    link->refs = 1; // Ссылка таблицы
+
+    pthread_mutex_lock(&uring_table_mutex);
+    uring_table[handle] = link;
+    pthread_mutex_unlock(&uring_table_mutex);
+    return;
+
+fail:
+    if (link->buf_ring == MAP_FAILED) link->buf_ring = NULL;
+    if (link->buffers == MAP_FAILED) link->buffers = NULL;
+    uring_link_free(link);
+}
+
+// --- Прием ---
+
+static ssize_t uring_plain_receive(int handle, void *buffer, size_t length) {
+    ssize_t bytes_received;
+    do {
+        bytes_received = recv(handle, buffer, length, 0);
+    } while (bytes_received < 0 && errno == EINTR);
+    if (bytes_received < 0) {
+        perror("uring_receive: recv failed");
+    }
+    return bytes_received;
+}
+
+// Подготовка многократного recv; подается вместе с ожиданием в io_uring_enter
+static void uring_arm_recv(UringLink *link) {
+    struct io_uring_sqe *sqe = uring_get_sqe(&link->ring);
+    if (!sqe) return; // Очередь подачи приема не бывает полной: recv в ней один
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = link->handle;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_RX_BGID;
+    link->recv_armed = true;
+    link->recv_pending = true;
+}
+
+static ssize_t uring_link_receive(UringLink *link, void *buffer, size_t length) {
+    while (link->cur_length == 0) {
+        if (link->eof) return 0;
+        if (link->plain) return uring_plain_receive(link->handle, buffer, length);
+        if (!link->recv_armed) uring_arm_recv(link);
+
+        struct io_uring_cqe cqe;
+        if (!uring_pop_cqe(&link->ring, &cqe)) {
+            unsigned to_submit = link->recv_pending ? uring_flush_sq(&link->ring) : 0;
+            if (uring_sys_enter(link->ring.fd, to_submit, 1, IORING_ENTER_GETEVENTS) < 0) {
+                if (errno == EINTR) continue;
+                perror("uring_receive: io_uring_enter failed");
+                return -1;
+            }
+            link->recv_pending = false;
+            continue;
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE)) link->recv_armed = false; // recv завершился, нужен перезапуск
+        if (cqe.res > 0) {
+            link->cur_bid = (int)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            link->cur_offset = 0;
+            link->cur_length = (uint32_t)cqe.res;
+        } else if (cqe.res == 0) {
+            link->eof = true; // Соединение закрыто другой стороной или shutdown() этой стороной
+        } else if (cqe.res == -ENOBUFS) {
+            continue; // Все буферы были заняты; они уже возвращены - перезапуск recv
+        } else if (cqe.res == -EINVAL && (cqe.flags & IORING_CQE_F_BUFFER) == 0 && !link->recv_armed) {
+            fprintf(stderr, "uring_receive: Multishot recv unsupported by kernel, using plain recv for handle %d\n", link->handle);
+            link->plain = true;
+        } else {
+            errno = -cqe.res;
+            perror("uring_receive: recv failed");
+            return -1;
+        }
+    }
+
+    size_t chunk = length < link->cur_length ? length : link->cur_length;
+    memcpy(buffer, link->buffers + (size_t)link->cur_bid * URING_RX_BUFFER_BYTES + link->cur_offset, chunk);
+    link->cur_offset += (uint32_t)chunk;
+    link->cur_length -= (uint32_t)chunk;
+    if (link->cur_length == 0) {
+        uring_recycle_buffer(link, link->cur_bid);
+        link->cur_bid = -1;
+    }
+    return (ssize_t)chunk;
+}
+
+static ssize_t uring_receive(int handle, void *buffer, size_t length) {
+    if (handle < 0 || buffer == NULL || length == 0) {
+        return -1;
+    }
+    UringLink *link = uring_get(handle);
+    if (!link) {
+        return uring_plain_receive(handle, buffer, length);
+    }
+    ssize_t result = uring_link_receive(link, buffer, length);
+    uring_put(link);
+    return result;
+}
+
+// --- Отправка ---
+
+static ssize_t uring_send(int handle, const void *buffer, size_t length) {
+    if (handle < 0 || buffer == NULL || length == 0) {
+        return -1;
+    }
+    ssize_t total_sent = 0;
+    while (total_sent < (ssize_t)length) {
+        // MSG_NOSIGNAL: закрытое другой стороной соединение - ошибка EPIPE, а не SIGPIPE
+        ssize_t sent_now = send(handle, (const char*)buffer + total_sent, length - total_sent, MSG_NOSIGNAL);
+        if (sent_now < 0) {
+            if (errno == EINTR) continue;
+            perror("uring_send: send failed");
+            return -1;
+        }
+        if (sent_now == 0) {
+            fprintf(stderr, "uring_send: send returned 0\n");
+            return total_sent;
+        }
+        total_sent += sent_now;
+    }
+    return total_sent;
+}
+
+// Подача до URING_TX_ENTRIES запросов одной подачей. Запросы соединения собираются в
+// SENDMSG по URING_SEND_IOV_MAX кадров; операции одного соединения связаны в цепочку
+static int uring_send_chunk(IOSendRequest *requests, size_t count) {
+    struct iovec iovs[URING_TX_ENTRIES];
+    size_t iov_request[URING_TX_ENTRIES];    // Запрос каждого элемента iovs
+    struct msghdr msgs[URING_TX_ENTRIES];
+    size_t op_first[URING_TX_ENTRIES], op_count[URING_TX_ENTRIES];
+    int op_result[URING_TX_ENTRIES];
+    bool queued[URING_TX_ENTRIES] = { false };
+    size_t done[URING_TX_ENTRIES];
+    int error[URING_TX_ENTRIES];
+    size_t iov_count = 0;
+    unsigned ops = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (queued[i]) continue;
+        struct io_uring_sqe *previous = NULL;
+        for (size_t j = i; j < count; ) {
+            // Следующая операция соединения: до URING_SEND_IOV_MAX его запросов по порядку
+            op_first[ops] = iov_count;
+            op_count[ops] = 0;
+            for (; j < count && op_count[ops] < URING_SEND_IOV_MAX; ++j) {
+                if (queued[j] || requests[j].handle != requests[i].handle) continue;
+                iovs[iov_count].iov_base = (void*)requests[j].buffer;
+                iovs[iov_count].iov_len = requests[j].length;
+                iov_request[iov_count++] = j;
+                op_count[ops]++;
+                queued[j] = true;
+            }
+            if (op_count[ops] == 0) break;
+            memset(&msgs[ops], 0, sizeof(msgs[ops]));
+            msgs[ops].msg_iov = &iovs[op_first[ops]];
+            msgs[ops].msg_iovlen = op_count[ops];
+            struct io_uring_sqe *sqe = uring_get_sqe(&uring_tx);
+            if (!sqe) return -1; // Не бывает: операций не больше запросов, а очередь подачи пуста
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = requests[i].handle;
+            sqe->addr = (uint64_t)(uintptr_t)&msgs[ops];
+            sqe->len = 1;
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+            sqe->user_data = ops;
+            // Следующая операция соединения начнется только после полной отправки этой
+            if (previous) previous->flags |= IOSQE_IO_LINK;
+            previous = sqe;
+            op_result[ops++] = -ECANCELED;
+        }
+    }
+
+    unsigned completed = 0;
+    while (completed < ops) {
+        unsigned to_submit = uring_flush_sq(&uring_tx);
+        if (uring_sys_enter(uring_tx.fd, to_submit, ops - completed, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            // Часть пачки могла уйти: незавершенные не повторяются (иначе возможны дубли),
+            // а считаются ошибкой. Кольцо закрывается, дальше - обычный send()
+            perror("uring_send_batch: io_uring_enter failed");
+            for (unsigned op = 0; op < ops; ++op) {
+                if (op_result[op] == -ECANCELED) op_result[op] = -EIO;
+            }
+            uring_ring_free(&uring_tx);
+            uring_tx_ready = false;
+            break;
+        }
+        struct io_uring_cqe cqe;
+        while (uring_pop_cqe(&uring_tx, &cqe)) {
+            if (cqe.user_data < ops) op_result[cqe.user_data] = cqe.res;
+            completed++;
+        }
+    }
+
+    // Байты операции раскладываются по ее запросам; разорванная цепочка (ECANCELED) - не ошибка
+    for (unsigned op = 0; op < ops; ++op) {
+        size_t remaining = op_result[op] > 0 ? (size_t)op_result[op] : 0;
+        for (size_t k = op_first[op]; k < op_first[op] + op_count[op]; ++k) {
+            size_t r = iov_request[k];
+            done[r] = remaining < requests[r].length ? remaining : requests[r].length;
+            remaining -= done[r];
+            error[r] = (op_result[op] < 0 && op_result[op] != -ECANCELED) ? -op_result[op] : 0;
+        }
+    }
+
+    // Разбор по порядку: недоотправленное досылается обычным send()
+    for (size_t i = 0; i < count; ++i) {
+        IOSendRequest *request = &requests[i];
+        bool failed_before = false;
+        for (size_t j = 0; j < i; ++j) {
+            if (requests[j].handle == request->handle && requests[j].result < 0) failed_before = true;
+        }
+        if (failed_before) {
+            request->result = -1; // Соединение уже неисправно, порядок не нарушаем
+        } else if (error[i] != 0) {
+            errno = error[i];
+            perror("uring_send_batch: sendmsg failed");
+            request->result = -1;
+        } else if (done[i] == request->length) {
+            request->result = (ssize_t)done[i];
+        } else {
+            ssize_t rest = uring_send(request->handle, (const char*)request->buffer + done[i], request->length - done[i]);
+            request->result = rest < 0 ? -1 : (ssize_t)done[i] + rest;
+        }
+    }
+    return 0;
+}
+
+int uring_send_batch(IOSendRequest *requests, size_t count) {
+    if (!requests) return -1;
+    pthread_mutex_lock(&uring_tx_mutex);
+    if (!uring_tx_ready && count > 1) {
+        if (uring_ring_init(&uring_tx, URING_TX_ENTRIES, URING_TX_ENTRIES * 2) == 0) {
+            uring_tx_ready = true;
+        } else {
+            fprintf(stderr, "uring_send_batch: Failed to create send ring (%s), using plain send\n", strerror(errno));
+        }
+    }
+    for (size_t start = 0; start < count; start += URING_TX_ENTRIES) {
+        size_t n = count - start < URING_TX_ENTRIES ? count - start : URING_TX_ENTRIES;
+        if (n > 1 && uring_tx_ready && uring_send_chunk(requests + start, n) == 0) continue;
+        for (size_t i = start; i < start + n; ++i) { // Одиночный запрос или кольцо недоступно
+            requests[i].result = uring_send(requests[i].handle, requests[i].buffer, requests[i].length);
+        }
+    }
+    pthread_mutex_unlock(&uring_tx_mutex);
+    int failed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (requests[i].result != (ssize_t)requests[i].length) failed++;
+    }
+    return failed;
+}
+
+// --- Подключение и прием соединений ---
+
+int uring_connect_start(IOInterface *self) {
+    if (!self || self->type != IO_TYPE_URING || !self->internal_data) {
+        fprintf(stderr, "uring_connect_start: Invalid interface\n");
+        return -1;
+    }
+    IOInterface *control = ((UringInternalData*)self->internal_data)->control;
+    if (self->io_handle != -1) {
+        uring_disconnect(self, self->io_handle);
+    }
+    self->io_handle = ethernet_connect_start(control);
+    return self->io_handle;
+}
+
+int uring_connect_finish(IOInterface *self) {
+    if (!self || self->io_handle < 0) return -1;
+    IOInterface *control = ((UringInternalData*)self->internal_data)->control;
+    self->io_handle = ethernet_connect_finish(control); // При ошибке сокет закрыт
+    if (self->io_handle >= 0) {
+        uring_link_register(self->io_handle);
+    }
+    return self->io_handle;
+}
+
+static int uring_connect(IOInterface *self) {
+    if (uring_connect_start(self) < 0) return -1;
+    return uring_connect_finish(self);
+}
+
+static int uring_listen(IOInterface *self) {
+    if (!self || self->type != IO_TYPE_URING || !self->internal_data) {
+        fprintf(stderr, "uring_listen: Invalid interface\n");
+        return -1;
+    }
+    IOInterface *control = ((UringInternalData*)self->internal_data)->control;
+    self->io_handle = control->listen(control);
+    return self->io_handle;
+}
+
+static int uring_accept(IOInterface *self, char *client_ip_buffer, size_t buffer_len, uint16_t *client_port) {
+    if (!self || self->type != IO_TYPE_URING || !self->internal_data) {
+        fprintf(stderr, "uring_accept: Invalid interface\n");
+        return -1;
+    }
+    IOInterface *control = ((UringInternalData*)self->internal_data)->control;
+    int handle = control->accept(control, client_ip_buffer, buffer_len, client_port);
+    if (handle >= 0) {
+        uring_link_register(handle);
+    }
+    return handle;
+}
+
+static int uring_disconnect(IOInterface *self, int handle) {
+    if (handle < 0) {
+        return -1;
+    }
+    UringLink *link = NULL;
+    if (handle < URING_MAX_HANDLES) {
+        pthread_mutex_lock(&uring_table_mutex);
+        link = uring_table[handle];
+        uring_table[handle] = NULL;
+        pthread_mutex_unlock(&uring_table_mutex);
+    }
+    printf("Uring: Closing handle %d\n", handle);
+    ethernet_zerocopy_disable(handle); // Подключение шло через Ethernet, zero-copy включался там
+    if (self && self->io_handle == handle) {
+        self->io_handle = -1;
+        UringInternalData *internal = (UringInternalData*)self->internal_data;
+        if (internal && internal->control->io_handle == handle) internal->control->io_handle = -1;
+    }
+    if (!link) {
+        return ethernet_zerocopy_close(handle);
+    }
+    shutdown(handle, SHUT_RDWR); // Завершает многократный recv и будит прием; сокет закроется с последней ссылкой
+    uring_put(link);
+    return 0;
+}
+
+static void uring_destroy(IOInterface *self) {
+    if (!self) return;
+    UringInternalData *internal = (UringInternalData*)self->internal_data;
+    if (self->io_handle >= 0) {
+        uring_disconnect(self, self->io_handle); // Подключенный клиент или слушающий сокет
+    }
+    if (internal && internal->control) {
+        internal->control->destroy(internal->control);
+    }
+    free(self->config);
+    self->config = NULL;
+    free(self->internal_data);
+    self->internal_data = NULL;
+    free(self);
+    printf("Uring Interface destroyed.\n");
+}
@@ -0,0 +1,344 @@
+/*
+ * protocol/complex_convert.c
+ *
+ * Описание:
+ * Реализация преобразования комплексных отсчетов.
+ * В памяти complex_int8_t - это пара байт {imag, real}, complex_fixed16_t - пара
+ * int16 {imag, real}. Векторные ядра загружают блок пар целиком и разделяют
+ * части сдвигами внутри 16/32-битных полей (знаковое расширение получается
+ * арифметическим сдвигом), поэтому перестановки байт не нужны.
+ * Хвост массива, не кратный ширине вектора, обрабатывается скалярным кодом.
+ */
+#include "complex_convert.h"
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CC_HAVE_X86 1
+#else
+#define CC_HAVE_X86 0
+#endif
+
+// Таблица функций одной реализации
+typedef struct {
+    const char *name;
+    void (*i8_f32)(const complex_int8_t*, size_t, float*, float*);
+    void (*i8_i32)(const complex_int8_t*, size_t, int32_t*, int32_t*);
+    void (*i16_f32)(const complex_fixed16_t*, size_t, float*, float*);
+    void (*i16_i32)(const complex_fixed16_t*, size_t, int32_t*, int32_t*);
+    void (*i8_mag)(const complex_int8_t*, size_t, float*);
+    void (*i16_mag)(const complex_fixed16_t*, size_t, float*);
+} ComplexConvertOps;
+
+// --- Скалярная реализация (также используется для хвостов) ---
+
+static void scalar_i8_f32(const complex_int8_t *src, size_t count, float *re, float *im) {
+    for (size_t i = 0; i < count; ++i) {
+        re[i] = (float)src[i].real;
+        im[i] = (float)src[i].imag;
+    }
+}
+
+static void scalar_i8_i32(const complex_int8_t *src, size_t count, int32_t *re, int32_t *im) {
+    for (size_t i = 0; i < count; ++i) {
+        re[i] = src[i].real;
+        im[i] = src[i].imag;
+    }
+}
+
+static void scalar_i16_f32(const complex_fixed16_t *src, size_t count, float *re, float *im) {
+    for (size_t i = 0; i < count; ++i) {
+        re[i] = (float)src[i].real;
+        im[i] = (float)src[i].imag;
+    }
+}
+
+static void scalar_i16_i32(const complex_fixed16_t *src, size_t count, int32_t *re, int32_t *im) {
+    for (size_t i = 0; i < count; ++i) {
+        re[i] = src[i].real;
+        im[i] = src[i].imag;
+    }
+}
+
+static void scalar_i8_mag(const complex_int8_t *src, size_t count, float *mag) {
+    for (size_t i = 0; i < count; ++i) {
+        float r = (float)src[i].real;
+        float m = (float)src[i].imag;
+        mag[i] = sqrtf(r * r + m * m);
+    }
+}
+
+static void scalar_i16_mag(const complex_fixed16_t *src, size_t count, float *mag) {
+    for (size_t i = 0; i < count; ++i) {
+        float r = (float)src[i].real;
+        float m = (float)src[i].imag;
+        mag[i] = sqrtf(r * r + m * m);
+    }
+}
+
+static const ComplexConvertOps cc_scalar_ops = {
+    "scalar", scalar_i8_f32, scalar_i8_i32, scalar_i16_f32, scalar_i16_i32, scalar_i8_mag, scalar_i16_mag
+};
+
+#if CC_HAVE_X86
+// --- SSE2 (базовый набор для x86_64) ---
+
+// 8 пар complex_int8_t -> два вектора int16 (re, im)
+static inline void sse2_split_i8(const complex_int8_t *p, __m128i *re16, __m128i *im16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    *im16 = _mm_srai_epi16(_mm_slli_epi16(v, 8), 8); // Младший байт каждой пары
+    *re16 = _mm_srai_epi16(v, 8);                    // Старший байт каждой пары
+}
+
+static inline __m128i sse2_lo_i16_to_i32(__m128i x) { return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16); }
+static inline __m128i sse2_hi_i16_to_i32(__m128i x) { return _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16); }
+
+static void sse2_i8_i32(const complex_int8_t *src, size_t count, int32_t *re, int32_t *im) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i r, m;
+        sse2_split_i8(src + i, &r, &m);
+        _mm_storeu_si128((__m128i*)(re + i), sse2_lo_i16_to_i32(r));
+        _mm_storeu_si128((__m128i*)(re + i + 4), sse2_hi_i16_to_i32(r));
+        _mm_storeu_si128((__m128i*)(im + i), sse2_lo_i16_to_i32(m));
+        _mm_storeu_si128((__m128i*)(im + i + 4), sse2_hi_i16_to_i32(m));
+    }
+    scalar_i8_i32(src + i, count - i, re + i, im + i);
+}
+
+static void sse2_i8_f32(const complex_int8_t *src, size_t count, float *re, float *im) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i r, m;
+        sse2_split_i8(src + i, &r, &m);
+        _mm_storeu_ps(re + i, _mm_cvtepi32_ps(sse2_lo_i16_to_i32(r)));
+        _mm_storeu_ps(re + i + 4, _mm_cvtepi32_ps(sse2_hi_i16_to_i32(r)));
+        _mm_storeu_ps(im + i, _mm_cvtepi32_ps(sse2_lo_i16_to_i32(m)));
+        _mm_storeu_ps(im + i + 4, _mm_cvtepi32_ps(sse2_hi_i16_to_i32(m)));
+    }
+    scalar_i8_f32(src + i, count - i, re + i, im + i);
+}
+
+static void sse2_i8_mag(const complex_int8_t *src, size_t count, float *mag) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i r, m;
+        sse2_split_i8(src + i, &r, &m);
+        __m128 rl = _mm_cvtepi32_ps(sse2_lo_i16_to_i32(r));
+        __m128 rh = _mm_cvtepi32_ps(sse2_hi_i16_to_i32(r));
+        __m128 ml = _mm_cvtepi32_ps(sse2_lo_i16_to_i32(m));
+        __m128 mh = _mm_cvtepi32_ps(sse2_hi_i16_to_i32(m));
+        _mm_storeu_ps(mag + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(rl, rl), _mm_mul_ps(ml, ml))));
+        _mm_storeu_ps(mag + i + 4, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(rh, rh), _mm_mul_ps(mh, mh))));
+    }
+    scalar_i8_mag(src + i, count - i, mag + i);
+}
+
+// 4 пары complex_fixed16_t -> два вектора int32 (re, im)
+static inline void sse2_split_i16(const complex_fixed16_t *p, __m128i *re32, __m128i *im32) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    *im32 = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+    *re32 = _mm_srai_epi32(v, 16);
+}
+
+static void sse2_i16_i32(const complex_fixed16_t *src, size_t count, int32_t *re, int32_t *im) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i r, m;
+        sse2_split_i16(src + i, &r, &m);
+        _mm_storeu_si128((__m128i*)(re + i), r);
+        _mm_storeu_si128((__m128i*)(im + i), m);
+    }
+    scalar_i16_i32(src + i, count - i, re + i, im + i);
+}
+
+static void sse2_i16_f32(const complex_fixed16_t *src, size_t count, float *re, float *im) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i r, m;
+        sse2_split_i16(src + i, &r, &m);
+        _mm_storeu_ps(re + i, _mm_cvtepi32_ps(r));
+        _mm_storeu_ps(im + i, _mm_cvtepi32_ps(m));
+    }
+    scalar_i16_f32(src + i, count - i, re + i, im + i);
+}
+
+static void sse2_i16_mag(const complex_fixed16_t *src, size_t count, float *mag) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i r, m;
+        sse2_split_i16(src + i, &r, &m);
+        __m128 rf = _mm_cvtepi32_ps(r);
+        __m128 mf = _mm_cvtepi32_ps(m);
+        _mm_storeu_ps(mag + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(rf, rf), _mm_mul_ps(mf, mf))));
+    }
+    scalar_i16_mag(src + i, count - i, mag + i);
+}
+
+static const ComplexConvertOps cc_sse2_ops = {
+    "sse2", sse2_i8_f32, sse2_i8_i32, sse2_i16_f32, sse2_i16_i32, sse2_i8_mag, sse2_i16_mag
+};
+
+// --- AVX2 (выбирается только если процессор поддерживает) ---
+#define CC_AVX2 __attribute__((target("avx2")))
+
+// 16 пар complex_int8_t -> два вектора по 16 int16 (re, im)
+CC_AVX2 static inline void avx2_split_i8(const complex_int8_t *p, __m256i *re16, __m256i *im16) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    *im16 = _mm256_srai_epi16(_mm256_slli_epi16(v, 8), 8);
+    *re16 = _mm256_srai_epi16(v, 8);
+}
+
+CC_AVX2 static inline __m256i avx2_lo_i16_to_i32(__m256i x) { return _mm256_cvtepi16_epi32(_mm256_castsi256_si128(x)); }
+CC_AVX2 static inline __m256i avx2_hi_i16_to_i32(__m256i x) { return _mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1)); }
+
+CC_AVX2 static void avx2_i8_i32(const complex_int8_t *src, size_t count, int32_t *re, int32_t *im) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i r, m;
+        avx2_split_i8(src + i, &r, &m);
+        _mm256_storeu_si256((__m256i*)(re + i), avx2_lo_i16_to_i32(r));
+        _mm256_storeu_si256((__m256i*)(re + i + 8), avx2_hi_i16_to_i32(r));
+        _mm256_storeu_si256((__m256i*)(im + i), avx2_lo_i16_to_i32(m));
+        _mm256_storeu_si256((__m256i*)(im + i + 8), avx2_hi_i16_to_i32(m));
+    }
+    sse2_i8_i32(src + i, count - i, re + i, im + i);
+}
+
+CC_AVX2 static void avx2_i8_f32(const complex_int8_t *src, size_t count, float *re, float *im) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i r, m;
+        avx2_split_i8(src + i, &r, &m);
+        _mm256_storeu_ps(re + i, _mm256_cvtepi32_ps(avx2_lo_i16_to_i32(r)));
+        _mm256_storeu_ps(re + i + 8, _mm256_cvtepi32_ps(avx2_hi_i16_to_i32(r)));
+        _mm256_storeu_ps(im + i, _mm256_cvtepi32_ps(avx2_lo_i16_to_i32(m)));
+        _mm256_storeu_ps(im + i + 8, _mm256_cvtepi32_ps(avx2_hi_i16_to_i32(m)));
+    }
+    sse2_i8_f32(src + i, count - i, re + i, im + i);
+}
+
+CC_AVX2 static void avx2_i8_mag(const complex_int8_t *src, size_t count, float *mag) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i r, m;
+        avx2_split_i8(src + i, &r, &m);
+        __m256 rl = _mm256_cvtepi32_ps(avx2_lo_i16_to_i32(r));
+        __m256 rh = _mm256_cvtepi32_ps(avx2_hi_i16_to_i32(r));
+        __m256 ml = _mm256_cvtepi32_ps(avx2_lo_i16_to_i32(m));
+        __m256 mh = _mm256_cvtepi32_ps(avx2_hi_i16_to_i32(m));
+        _mm256_storeu_ps(mag + i, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(rl, rl), _mm256_mul_ps(ml, ml))));
+        _mm256_storeu_ps(mag + i + 8, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(rh, rh), _mm256_mul_ps(mh, mh))));
+    }
+    sse2_i8_mag(src + i, count - i, mag + i);
+}
+
+// 8 пар complex_fixed16_t -> два вектора по 8 int32 (re, im)
+CC_AVX2 static inline void avx2_split_i16(const complex_fixed16_t *p, __m256i *re32, __m256i *im32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    *im32 = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+    *re32 = _mm256_srai_epi32(v, 16);
+}
+
+CC_AVX2 static void avx2_i16_i32(const complex_fixed16_t *src, size_t count, int32_t *re, int32_t *im) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i r, m;
+        avx2_split_i16(src + i, &r, &m);
+        _mm256_storeu_si256((__m256i*)(re + i), r);
+        _mm256_storeu_si256((__m256i*)(im + i), m);
+    }
+    sse2_i16_i32(src + i, count - i, re + i, im + i);
+}
+
+CC_AVX2 static void avx2_i16_f32(const complex_fixed16_t *src, size_t count, float *re, float *im) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i r, m;
+        avx2_split_i16(src + i, &r, &m);
+        _mm256_storeu_ps(re + i, _mm256_cvtepi32_ps(r));
+        _mm256_storeu_ps(im + i, _mm256_cvtepi32_ps(m));
+    }
+    sse2_i16_f32(src + i, count - i, re + i, im + i);
+}
+
+CC_AVX2 static void avx2_i16_mag(const complex_fixed16_t *src, size_t count, float *mag) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i r, m;
+        avx2_split_i16(src + i, &r, &m);
+        __m256 rf = _mm256_cvtepi32_ps(r);
+        __m256 mf = _mm256_cvtepi32_ps(m);
+        _mm256_storeu_ps(mag + i, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(rf, rf), _mm256_mul_ps(mf, mf))));
+    }
+    sse2_i16_mag(src + i, count - i, mag + i);
+}
+
+static const ComplexConvertOps cc_avx2_ops = {
+    "avx2", avx2_i8_f32, avx2_i8_i32, avx2_i16_f32, avx2_i16_i32, avx2_i8_mag, avx2_i16_mag
+};
+#endif // CC_HAVE_X86
+
+// --- Выбор реализации ---
+static const ComplexConvertOps *cc_ops = &cc_scalar_ops;
+static pthread_once_t cc_once = PTHREAD_ONCE_INIT;
+
+static void cc_select_impl(void) {
+#if CC_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        cc_ops = &cc_avx2_ops;
+    } else {
+        cc_ops = &cc_sse2_ops;
+    }
+#endif
+}
+
+static inline const ComplexConvertOps* cc_get_ops(void) {
+    pthread_once(&cc_once, cc_select_impl);
+    return cc_ops;
+}
+
+void complex_i8_to_planes_f32(const complex_int8_t *src, size_t count, float *re, float *im) {
+    cc_get_ops()->i8_f32(src, count, re, im);
+}
+
+void complex_i8_to_planes_i32(const complex_int8_t *src, size_t count, int32_t *re, int32_t *im) {
+    cc_get_ops()->i8_i32(src, count, re, im);
+}
+
+void complex_i16_to_planes_f32(const complex_fixed16_t *src, size_t count, float *re, float *im) {
+    cc_get_ops()->i16_f32(src, count, re, im);
+}
+
+void complex_i16_to_planes_i32(const complex_fixed16_t *src, size_t count, int32_t *re, int32_t *im) {
+    cc_get_ops()->i16_i32(src, count, re, im);
+}
+
+void complex_i8_magnitude_f32(const complex_int8_t *src, size_t count, float *mag) {
+    cc_get_ops()->i8_mag(src, count, mag);
+}
+
+void complex_i16_magnitude_f32(const complex_fixed16_t *src, size_t count, float *mag) {
+    cc_get_ops()->i16_mag(src, count, mag);
+}
+
+const char* complex_convert_impl_name(void) {
+    return cc_get_ops()->name;
+}
+
+int complex_convert_force_impl(const char *name) {
+    cc_get_ops(); // Гарантируем, что автоматический выбор уже выполнен и не перезапишет результат
+    if (strcmp(name, "scalar") == 0) { cc_ops = &cc_scalar_ops; return 0; }
+#if CC_HAVE_X86
+    if (strcmp(name, "sse2") == 0) { cc_ops = &cc_sse2_ops; return 0; }
+    if (strcmp(name, "avx2") == 0) {
+        if (!__builtin_cpu_supports("avx2")) return -1;
+        cc_ops = &cc_avx2_ops;
+        return 0;
+    }
+#endif
+    return -1;
+}
@@ -0,0 +1,60 @@
+/*
+ * protocol/complex_convert.h
+ *
+ * Описание:
+ * Преобразование массивов комплексных отсчетов протокола (complex_int8_t, complex_fixed16_t)
+ * в раздельные плоскости (действительная / мнимая часть) типа float или int32,
+ * а также вычисление модуля.
+ * Реализация выбирается во время выполнения по возможностям процессора
+ * (скалярная, SSE2, AVX2). Массивы могут иметь произвольную длину и выравнивание.
+ * Массивы complex_fixed16_t должны быть в порядке байт хоста.
+ */
+#ifndef COMPLEX_CONVERT_H
+#define COMPLEX_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol_defs.h"
+
+/**
+ * @brief Разделяет complex_int8_t на плоскости float.
+ */
+void complex_i8_to_planes_f32(const complex_int8_t *src, size_t count, float *re, float *im);
+
+/**
+ * @brief Разделяет complex_int8_t на плоскости int32.
+ */
+void complex_i8_to_planes_i32(const complex_int8_t *src, size_t count, int32_t *re, int32_t *im);
+
+/**
+ * @brief Разделяет complex_fixed16_t на плоскости float.
+ */
+void complex_i16_to_planes_f32(const complex_fixed16_t *src, size_t count, float *re, float *im);
+
+/**
+ * @brief Разделяет complex_fixed16_t на плоскости int32.
+ */
+void complex_i16_to_planes_i32(const complex_fixed16_t *src, size_t count, int32_t *re, int32_t *im);
+
+/**
+ * @brief Вычисляет модуль |re + j*im| для массива complex_int8_t.
+ */
+void complex_i8_magnitude_f32(const complex_int8_t *src, size_t count, float *mag);
+
+/**
+ * @brief Вычисляет модуль |re + j*im| для массива complex_fixed16_t.
+ */
+void complex_i16_magnitude_f32(const complex_fixed16_t *src, size_t count, float *mag);
+
+/**
+ * @brief Возвращает имя выбранной реализации ("scalar", "sse2", "avx2").
+ */
+const char* complex_convert_impl_name(void);
+
+/**
+ * @brief Принудительно выбирает реализацию по имени (для сравнения в бенчмарке).
+ * @return 0 в случае успеха, -1 если реализация недоступна на этом процессоре.
+ */
+int complex_convert_force_impl(const char *name);
+
+#endif // COMPLEX_CONVERT_H
@@ -7,7 +7,8 @@
 
 #include "message_utils.h"
 #include <arpa/inet.h> // Для htons, ntohs, htonl, ntohl
-#include <string.h>    // Для memcpy в будущем (для массивов)
+#include <string.h>    // Для memcpy (невыровненные массивы)
+#include <stdbool.h>
 
 // Получить полный номер сообщения
 uint16_t get_full_message_number(const MessageHeader *header) {
@@ -19,6 +20,14 @@ uint16_t get_full_message_number(const MessageHeader *header) {
 	return (highBits | header->message_number);
 }
 
+// Установить полный номер сообщения
+void set_full_message_number(MessageHeader *header, uint16_t message_num) {
+    header->flags.hc_t_bp = (message_num >> 8) & 0x01;
+    header->flags.hc_ct_bp = (message_num >> 9) & 0x01;
+    header->flags.hc_ct10p = (message_num >> 10) & 0x01;
+    header->message_number = message_num & 0xFF;
+}
+
 // --- Функции преобразования порядка байт ---
 
 // Вспомогательная функция для преобразования массива int16_t
@@ -28,6 +37,16 @@ static void convert_int16_array_order(int16_t *array, size_t count, uint16_t (*c
     }
 }
 
+// Вспомогательная функция для массива int16 по произвольному (возможно, невыровненному) адресу
+static void convert_int16_bytes_order(uint8_t *bytes, size_t count, uint16_t (*converter)(uint16_t)) {
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t v;
+        memcpy(&v, bytes + i * sizeof(v), sizeof(v));
+        v = converter(v);
+        memcpy(bytes + i * sizeof(v), &v, sizeof(v));
+    }
+}
+
 // Преобразовать в сетевой порядок
 void message_to_network_byte_order(Message *message) {
     // Преобразуем длину тела
@@ -97,7 +116,13 @@ void message_to_network_byte_order(Message *message) {
              body->sigmaybm = htons(ntohs(body->sigmaybm));
              body->nfft = htons(ntohs(body->nfft));
              body->mrr = htons(ntohs(body->mrr));
-             // Добавить преобразование HRR массива, если он передается вместе
+             // Массив HRR[MRR] (complex fixed16) - как при приеме, в пределах тела;
+             // MRR здесь уже в сетевом порядке
+             if (body_len_host > sizeof(*body)) {
+                 size_t hrr_avail = (body_len_host - sizeof(*body)) / sizeof(complex_fixed16_t);
+                 size_t hrr_count = ntohs(body->mrr) < hrr_avail ? ntohs(body->mrr) : hrr_avail;
+                 convert_int16_bytes_order(message->body + sizeof(*body), hrr_count * 2, htons);
+             }
              break;
          }
         case MESSAGE_TYPE_PRIYAT_PARAMETRY_3TSO: { // 4.2.13
@@ -120,7 +145,14 @@ void message_to_network_byte_order(Message *message) {
              body->nin = htons(ntohs(body->nin));
              body->nout = htons(ntohs(body->nout));
              body->mrn = htons(ntohs(body->mrn));
-             // Добавить преобразование OKM, HShMR, HAR массивов, если они передаются вместе
+             // OKM[Nout] и HShMR[Nin] - байтовые, HAR[NAR*Nin] - как при приеме (Nin/Nout уже сетевые)
+             size_t har_offset = sizeof(*body) + ntohs(body->nout) + ntohs(body->nin);
+             if (body_len_host > har_offset) {
+                 size_t har_avail = (body_len_host - har_offset) / sizeof(complex_fixed16_t);
+                 size_t har_count = (size_t)body->nar * ntohs(body->nin);
+                 if (har_count > har_avail) har_count = har_avail;
+                 convert_int16_bytes_order(message->body + har_offset, har_count * 2, htons);
+             }
              break;
          }
         // case MESSAGE_TYPE_NAVIGATSIONNYE_DANNYE: // 4.2.16 - uint8_t не требует
@@ -129,6 +161,16 @@ void message_to_network_byte_order(Message *message) {
             body->bcb = htonl(ntohl(body->bcb));
             break;
         }
+        case MESSAGE_TYPE_STROKA_K3:                // 4.2.21
+        case MESSAGE_TYPE_STROKA_IZOBRAZHENIYA_K4: { // 4.2.22 - только заголовок строки
+            if (body_len_host < sizeof(StrokaIzobrazheniyaHeader)) break;
+            StrokaIzobrazheniyaHeader *body = (StrokaIzobrazheniyaHeader *)message->body;
+            body->nomer_kadra = htons(ntohs(body->nomer_kadra));
+            body->nomer_stroki = htons(ntohs(body->nomer_stroki));
+            body->kolvo_strok = htons(ntohs(body->kolvo_strok));
+            body->bcb = htonl(ntohl(body->bcb));
+            break;
+        }
         // ... Добавить case'ы для других типов сообщений, имеющих поля uint16/uint32 ...
 		default:
 			// Типы сообщений без полей uint16/uint32 в теле или только с uint8/массивами
@@ -148,6 +190,10 @@ void message_to_host_byte_order(Message *message) {
         case MESSAGE_TYPE_CONFIRM_INIT: { // 4.2.2
             ConfirmInitBody *body = (ConfirmInitBody *)message->body;
             body->bcb = ntohl(body->bcb); // network -> host
+            if (message->header.body_length >= sizeof(ConfirmInitExtBody)) {
+                ConfirmInitExtBody *ext = (ConfirmInitExtBody *)message->body;
+                ext->param_signature = ntohl(ext->param_signature);
+            }
             break;
         }
         case MESSAGE_TYPE_PODTVERZHDENIE_KONTROLYA: { // 4.2.4
@@ -205,7 +251,12 @@ void message_to_host_byte_order(Message *message) {
              body->sigmaybm = ntohs(body->sigmaybm);
              body->nfft = ntohs(body->nfft);
              body->mrr = ntohs(body->mrr);
-             // Добавить преобразование HRR массива, если он читается
+             // Массив HRR[MRR] (complex fixed16) сразу за базовой частью, в пределах тела
+             if (message->header.body_length > sizeof(*body)) {
+                 size_t hrr_avail = (message->header.body_length - sizeof(*body)) / sizeof(complex_fixed16_t);
+                 size_t hrr_count = body->mrr < hrr_avail ? body->mrr : hrr_avail;
+                 convert_int16_bytes_order(message->body + sizeof(*body), hrr_count * 2, ntohs);
+             }
              break;
          }
         case MESSAGE_TYPE_PRIYAT_PARAMETRY_3TSO: { // 4.2.13
@@ -228,7 +279,14 @@ void message_to_host_byte_order(Message *message) {
              body->nin = ntohs(body->nin);
              body->nout = ntohs(body->nout);
              body->mrn = ntohs(body->mrn);
-             // Добавить преобразование OKM, HShMR, HAR массивов, если они читаются
+             // OKM[Nout] и HShMR[Nin] - байтовые, HAR[NAR*Nin] (complex fixed16) - преобразуем в пределах тела
+             size_t har_offset = sizeof(*body) + body->nout + body->nin;
+             if (message->header.body_length > har_offset) {
+                 size_t har_avail = (message->header.body_length - har_offset) / sizeof(complex_fixed16_t);
+                 size_t har_count = (size_t)body->nar * body->nin;
+                 if (har_count > har_avail) har_count = har_avail;
+                 convert_int16_bytes_order(message->body + har_offset, har_count * 2, ntohs);
+             }
              break;
          }
         // case MESSAGE_TYPE_NAVIGATSIONNYE_DANNYE: // 4.2.16 - не требует
@@ -236,10 +294,151 @@ void message_to_host_byte_order(Message *message) {
             PreduprezhdenieBody* body = (PreduprezhdenieBody*)message->body;
             body->bcb = ntohl(body->bcb);
             break;
+        }
+        case MESSAGE_TYPE_STROKA_K3:                // 4.2.21
+        case MESSAGE_TYPE_STROKA_IZOBRAZHENIYA_K4: { // 4.2.22 - только заголовок строки
+            if (message->header.body_length < sizeof(StrokaIzobrazheniyaHeader)) break;
+            StrokaIzobrazheniyaHeader *body = (StrokaIzobrazheniyaHeader *)message->body;
+            body->nomer_kadra = ntohs(body->nomer_kadra);
+            body->nomer_stroki = ntohs(body->nomer_stroki);
+            body->kolvo_strok = ntohs(body->kolvo_strok);
+            body->bcb = ntohl(body->bcb);
+            break;
         }
 		// ... Добавить case'ы для других типов сообщений ...
 		default:
 			// Типы без полей uint16/uint32 или еще не добавленные
 			break;
 	}
-}
\ No newline at end of file
+}
+
+// --- Подпись набора параметров съемки ---
+
+#define FNV1A_OFFSET 2166136261u
+#define FNV1A_PRIME 16777619u
+
+int param_signature_slot(uint8_t message_type) {
+    switch (message_type) {
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_SO:   return 0;
+        case MESSAGE_TYPE_PRIYAT_TIME_REF_RANGE: return 1;
+        case MESSAGE_TYPE_PRIYAT_REPER:          return 2;
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_SDR:  return 3;
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_3TSO: return 4;
+        case MESSAGE_TYPE_PRIYAT_REF_AZIMUTH:    return 5;
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_TSD:  return 6;
+        default:                                 return -1;
+    }
+}
+
+uint32_t param_table_hash(const uint8_t *body, uint16_t body_len) {
+    uint32_t h = FNV1A_OFFSET;
+    for (uint16_t i = 0; i < body_len; ++i) {
+        h = (h ^ body[i]) * FNV1A_PRIME;
+    }
+    return h ? h : 1; // 0 зарезервирован за отсутствующей таблицей
+}
+
+// Тело таблицы из порядка хоста в порядок линии (обратно message_to_host_byte_order):
+// все поля тела в порядке хоста, поэтому размеры массивов берутся до преобразования
+static void param_table_to_network_order(uint8_t message_type, uint8_t *body, uint16_t body_len) {
+    switch (message_type) {
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_SO: { // 4.2.9
+            if (body_len < sizeof(PrinyatParametrySoBody)) break;
+            PrinyatParametrySoBody *so = (PrinyatParametrySoBody *)body;
+            so->q = htons(so->q);
+            so->knk = htons(so->knk);
+            so->knk_or1 = htons(so->knk_or1);
+            so->l1 = htons(so->l1);
+            so->l2 = htons(so->l2);
+            so->l3 = htons(so->l3);
+            so->sigmaybm = htons(so->sigmaybm);
+            so->rgd = htons(so->rgd);
+            so->fixp = htons(so->fixp);
+            break;
+        }
+        case MESSAGE_TYPE_PRIYAT_REPER: { // 4.2.11
+            if (body_len < sizeof(PrinyatReperBody)) break;
+            PrinyatReperBody *reper = (PrinyatReperBody *)body;
+            reper->NTSO1 = htons(reper->NTSO1);
+            reper->ReperR1 = htons(reper->ReperR1);
+            reper->ReperA1 = htons(reper->ReperA1);
+            reper->NTSO2 = htons(reper->NTSO2);
+            reper->ReperR2 = htons(reper->ReperR2);
+            reper->ReperA2 = htons(reper->ReperA2);
+            reper->NTSO3 = htons(reper->NTSO3);
+            reper->ReperR3 = htons(reper->ReperR3);
+            reper->ReperA3 = htons(reper->ReperA3);
+            reper->NTSO4 = htons(reper->NTSO4);
+            reper->ReperR4 = htons(reper->ReperR4);
+            reper->ReperA4 = htons(reper->ReperA4);
+            break;
+        }
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_SDR: { // 4.2.12
+            if (body_len < sizeof(PrinyatParametrySdrBodyBase)) break;
+            PrinyatParametrySdrBodyBase *sdr = (PrinyatParametrySdrBodyBase *)body;
+            size_t hrr_avail = (body_len - sizeof(*sdr)) / sizeof(complex_fixed16_t);
+            size_t hrr_count = sdr->mrr < hrr_avail ? sdr->mrr : hrr_avail;
+            convert_int16_bytes_order(body + sizeof(*sdr), hrr_count * 2, htons);
+            sdr->q = htons(sdr->q);
+            sdr->sigmaybm = htons(sdr->sigmaybm);
+            sdr->nfft = htons(sdr->nfft);
+            sdr->mrr = htons(sdr->mrr);
+            break;
+        }
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_3TSO: { // 4.2.13
+            if (body_len < sizeof(PrinyatParametry3TsoBody)) break;
+            PrinyatParametry3TsoBody *tso = (PrinyatParametry3TsoBody *)body;
+            tso->Rezerv = htons(tso->Rezerv);
+            tso->Ncadr = htons(tso->Ncadr);
+            tso->Q1 = htons(tso->Q1);
+            tso->Q1_OR1 = htons(tso->Q1_OR1);
+            break;
+        }
+        case MESSAGE_TYPE_PRIYAT_REF_AZIMUTH: { // 4.2.14
+            if (body_len < sizeof(PrinyatRefAzimuthBody)) break;
+            PrinyatRefAzimuthBody *ref = (PrinyatRefAzimuthBody *)body;
+            ref->NTSO = htons(ref->NTSO);
+            convert_int16_array_order(ref->ref_azimuth, REF_AZIMUTH_SIZE, htons);
+            break;
+        }
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_TSD: { // 4.2.15
+            if (body_len < sizeof(PrinyatParametryTsdBodyBase)) break;
+            PrinyatParametryTsdBodyBase *tsd = (PrinyatParametryTsdBodyBase *)body;
+            size_t har_offset = sizeof(*tsd) + tsd->nout + tsd->nin;
+            if (body_len > har_offset) {
+                size_t har_avail = (body_len - har_offset) / sizeof(complex_fixed16_t);
+                size_t har_count = (size_t)tsd->nar * tsd->nin;
+                if (har_count > har_avail) har_count = har_avail;
+                convert_int16_bytes_order(body + har_offset, har_count * 2, htons);
+            }
+            tsd->rezerv = htons(tsd->rezerv);
+            tsd->nin = htons(tsd->nin);
+            tsd->nout = htons(tsd->nout);
+            tsd->mrn = htons(tsd->mrn);
+            break;
+        }
+        // MESSAGE_TYPE_PRIYAT_TIME_REF_RANGE (4.2.10) - complex_int8_t, не требует
+        default:
+            break;
+    }
+}
+
+uint32_t param_table_hash_host(uint8_t message_type, const uint8_t *body, uint16_t body_len, uint8_t *scratch) {
+    memcpy(scratch, body, body_len);
+    param_table_to_network_order(message_type, scratch, body_len);
+    return param_table_hash(scratch, body_len);
+}
+
+uint32_t param_signature(const uint32_t table_hash[PARAM_SIGNATURE_TABLES]) {
+    uint32_t h = FNV1A_OFFSET;
+    bool any = false;
+    for (int t = 0; t < PARAM_SIGNATURE_TABLES; ++t) {
+        uint32_t v = table_hash[t];
+        if (v) any = true;
+        for (int b = 0; b < 4; ++b) {
+            h = (h ^ ((v >> (8 * b)) & 0xFF)) * FNV1A_PRIME;
+        }
+    }
+    if (!any) return 0;
+    return h ? h : 1;
+}
@@ -3,7 +3,7 @@
  *
  * Описание:
  * Прототипы утилитных функций для работы со структурами сообщений:
- * - Получение полного номера сообщения.
+ * - Получение и установка полного номера сообщения.
  * - Преобразование порядка байт (network/host).
  */
 
@@ -15,6 +15,9 @@
 // Получить полный номер сообщения (биты 8-10 из флагов + биты 0-7 из номера)
 uint16_t get_full_message_number(const MessageHeader *header);
 
+// Установить полный номер сообщения (биты 8-10 во флаги, биты 0-7 в поле номера)
+void set_full_message_number(MessageHeader *header, uint16_t message_num);
+
 // Преобразовать поля сообщения (header.body_length и поля тела)
 // из Host Byte Order в Network Byte Order перед отправкой.
 void message_to_network_byte_order(Message *message);
@@ -23,4 +26,22 @@ void message_to_network_byte_order(Message *message);
 // из Network Byte Order в Host Byte Order после получения.
 void message_to_host_byte_order(Message *message);
 
+// Подпись набора параметров съемки: по одному хешу на таблицу («Принять ...» 4.2.9-4.2.15);
+// последняя принятая таблица каждого типа заменяет прежнюю.
+#define PARAM_SIGNATURE_TABLES 7
+
+// Номер таблицы для типа сообщения или -1, если сообщение не является таблицей параметров
+int param_signature_slot(uint8_t message_type);
+
+// Хеш тела таблицы в том виде, в каком оно идет по линии (после message_to_network_byte_order;
+// body_len - длина тела). Обе стороны хешируют этот вид, иначе подписи не совпадут
+uint32_t param_table_hash(const uint8_t *body, uint16_t body_len);
+
+// Хеш принятой таблицы по ее телу в порядке хоста (после message_to_host_byte_order):
+// тело переводится в порядок линии в scratch (не меньше body_len байт) и хешируется
+uint32_t param_table_hash_host(uint8_t message_type, const uint8_t *body, uint16_t body_len, uint8_t *scratch);
+
+// Подпись набора по хешам таблиц; 0 - ни одной таблицы
+uint32_t param_signature(const uint32_t table_hash[PARAM_SIGNATURE_TABLES]);
+
 #endif // MESSAGE_UTILS_H
\ No newline at end of file
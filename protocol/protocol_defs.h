@@ -139,6 +139,14 @@ typedef struct {
 	uint32_t bcb;  // Состояние счётчика времени работы СВ-М (ВСВ)
 } ConfirmInitBody;
 
+// Расширение «Подтверждения инициализации» эмулятором (вне Таблицы 4.7): подпись набора
+// параметров съемки, хранимого СВ-М. Передается сразу после тела; получатель определяет
+// наличие расширения по длине тела.
+typedef struct {
+	ConfirmInitBody base;
+	uint32_t param_signature; // Подпись набора параметров (0 - параметры не загружены)
+} ConfirmInitExtBody;
+
 // [4.2.3] «Провести контроль» (тело сообщения) - Таблица 4.9
 typedef struct {
 	uint8_t tk; // Тип контроля (ТК - битовая маска)
@@ -292,6 +300,17 @@ typedef struct {
 	uint8_t mnd[NAV_DATA_SIZE]; // Массив навигационных данных (МНД)
 } NavigatsionnyeDannyeBody; // Итого: 256 байт
 
+// [4.2.21] «Строка К3», [4.2.22] «Строка изображения К4» - заголовок тела строки
+// За заголовком следуют отсчеты строки: (body_length - sizeof(StrokaIzobrazheniyaHeader)) байт
+typedef struct {
+    uint8_t  lak;          // Логический адрес СВ-М
+    uint8_t  rezerv;       // Резерв
+    uint16_t nomer_kadra;  // Номер кадра
+    uint16_t nomer_stroki; // Номер строки в кадре (0 .. kolvo_strok-1)
+    uint16_t kolvo_strok;  // Количество строк в кадре
+    uint32_t bcb;          // Состояние ВСВ
+} StrokaIzobrazheniyaHeader; // Итого: 1+1+2+2+2+4 = 12 байт
+
 // ... Другие структуры тел сообщений (СУБК, КО, СтрокаГолограммы и т.д.) должны быть добавлены здесь ...
 // [5.2] Сообщение "Предупреждение" (Таблица 5.1)
 typedef struct {
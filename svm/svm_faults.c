@@ -0,0 +1,394 @@
+/*
+ * svm/svm_faults.c
+ *
+ * Описание:
+ * Реализация профиля нагрузки/сбоев экземпляров СВ-М.
+ * Решение по каждому исходящему сообщению (потеря, повтор, момент выдачи)
+ * принимается под мьютексом профиля экземпляра с его собственным генератором.
+ * Сообщения, которые нельзя отдать сразу, копируются в «линию задержки» экземпляра
+ * (FIFO с неубывающими моментами выдачи). Линию разгружает однократный таймер
+ * общей службы, взводимый на момент выдачи первого сообщения линии.
+ */
+#include "svm_faults.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include "../protocol/message_builder.h"
+#include "../utils/ts_queued_msg_queue.h"
+#include "svm_rng.h"
+#include "svm_scheduler.h"
+#include "svm_timers.h"
+
+// Верхняя граница задержки одного сообщения (хвост логнормального распределения)
+#define SVM_FAULTS_MAX_LATENCY_MS 600000.0
+
+extern ThreadSafeQueuedMsgQueue *svm_outgoing_queue;
+
+// Задержанное сообщение (копируется только фактическая длина)
+typedef struct DelayedMessage {
+    struct DelayedMessage *next;
+    uint64_t release_ns;
+    size_t message_size;
+    unsigned char message_bytes[];
+} DelayedMessage;
+
+// Отключение по времени, запланированное для конкретного сеанса
+typedef struct {
+    SvmInstance *instance;
+    uint32_t session_id;
+} ScheduledDisconnect;
+
+typedef struct {
+    pthread_mutex_t mutex SVM_CACHE_ALIGNED; // Защищает все поля ниже
+    bool initialized;                        // Слот настроен svm_faults_init (мьютекс создан)
+    bool enabled;
+
+    // --- Настройки (готовые к применению) ---
+    LatencyDistribution latency_dist;
+    double latency_a_ms;
+    double latency_b_ms;
+    uint64_t drop_threshold[256];      // Порог для 32-битного случайного числа (2^32 = всегда)
+    uint64_t duplicate_threshold[256];
+    double ns_per_byte;                // 0 = без ограничения полосы
+    uint64_t burst_ns;
+    uint32_t warning_period_ms;
+    uint32_t disconnect_after_ms;
+
+    // --- Состояние сеанса ---
+    SvmRng rng;
+    uint32_t session_id;
+    uint64_t bucket_tat_ns;    // Теоретический момент опустошения корзины (GCRA)
+    uint64_t last_release_ns;  // Момент выдачи последнего сообщения: выдача не обгоняет порядок
+    DelayedMessage *delayed_head;
+    DelayedMessage *delayed_tail;
+    bool release_armed;        // Взведен таймер разгрузки линии
+    bool releasing;            // Таймер выдает снятые с линии сообщения (новые должны ждать их)
+    SvmTimer *warning_timer;
+    unsigned long dropped;
+    unsigned long duplicated;
+    unsigned long delayed;
+    unsigned long warnings_skipped; // Внеочередные «Предупреждения», пропущенные из-за полной очереди
+} SvmFaultState;
+
+static SvmFaultState fault_states[MAX_SVM_INSTANCES];
+
+static uint64_t monotonic_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Равномерное число из (0, 1)
+static double rng_unit(SvmRng *rng) {
+    return ((double)svm_rng_next(rng) + 0.5) / 4294967296.0;
+}
+
+static bool rng_hit(SvmRng *rng, uint64_t threshold) {
+    return threshold != 0 && (uint64_t)svm_rng_next(rng) < threshold;
+}
+
+static uint64_t probability_threshold(float p) {
+    if (p <= 0.0f) return 0;
+    if (p >= 1.0f) return 1ull << 32;
+    return (uint64_t)((double)p * 4294967296.0);
+}
+
+static uint64_t sample_latency_ns_locked(SvmFaultState *fs) {
+    double ms = 0.0;
+    switch (fs->latency_dist) {
+        case LATENCY_FIXED:
+            ms = fs->latency_a_ms;
+            break;
+        case LATENCY_UNIFORM:
+            ms = fs->latency_a_ms + (fs->latency_b_ms - fs->latency_a_ms) * rng_unit(&fs->rng);
+            break;
+        case LATENCY_LOGNORMAL: {
+            // Бокс-Мюллер: z ~ N(0, 1); медиана распределения = latency_a_ms
+            double z = sqrt(-2.0 * log(rng_unit(&fs->rng))) * cos(2.0 * M_PI * rng_unit(&fs->rng));
+            ms = fs->latency_a_ms * exp(fs->latency_b_ms * z);
+            break;
+        }
+        case LATENCY_NONE:
+        default:
+            return 0;
+    }
+    if (ms > SVM_FAULTS_MAX_LATENCY_MS) ms = SVM_FAULTS_MAX_LATENCY_MS;
+    return (uint64_t)(ms * 1000000.0);
+}
+
+// Момент выдачи сообщения размером size с учетом задержки, полосы и порядка
+static uint64_t release_time_locked(SvmFaultState *fs, size_t size, uint64_t now) {
+    uint64_t release = now + sample_latency_ns_locked(fs);
+    if (fs->ns_per_byte > 0.0) {
+        uint64_t tat = fs->bucket_tat_ns > now ? fs->bucket_tat_ns : now;
+        uint64_t earliest = (tat > now + fs->burst_ns) ? tat - fs->burst_ns : now;
+        fs->bucket_tat_ns = tat + (uint64_t)((double)size * fs->ns_per_byte);
+        if (earliest > release) release = earliest;
+    }
+    if (fs->last_release_ns > release) release = fs->last_release_ns;
+    fs->last_release_ns = release;
+    return release;
+}
+
+static void delayed_release_fire(void *arg);
+
+static void arm_release_locked(SvmInstance *instance, SvmFaultState *fs, uint64_t now) {
+    if (fs->release_armed || !fs->delayed_head) return;
+    uint64_t wait_ns = fs->delayed_head->release_ns > now ? fs->delayed_head->release_ns - now : 0;
+    unsigned delay_ms = (unsigned)((wait_ns + 999999ull) / 1000000ull);
+    if (svm_scheduler_schedule(delay_ms, delayed_release_fire, instance, false)) {
+        fs->release_armed = true;
+    } else {
+        fprintf(stderr, "SVM Faults (Inst %d): Failed to schedule delayed messages.\n", instance->id);
+    }
+}
+
+static void delay_push_locked(SvmInstance *instance, SvmFaultState *fs, const Message *message,
+                              size_t message_size, uint64_t release, uint64_t now) {
+    DelayedMessage *dm = malloc(sizeof(DelayedMessage) + message_size);
+    if (!dm) {
+        perror("SVM Faults: malloc failed, message dropped");
+        return;
+    }
+    dm->next = NULL;
+    dm->release_ns = release;
+    dm->message_size = message_size;
+    memcpy(dm->message_bytes, message, message_size);
+    if (fs->delayed_tail) fs->delayed_tail->next = dm;
+    else fs->delayed_head = dm;
+    fs->delayed_tail = dm;
+    fs->delayed++;
+    arm_release_locked(instance, fs, now);
+}
+
+static void delay_flush_locked(SvmFaultState *fs) {
+    while (fs->delayed_head) {
+        DelayedMessage *dm = fs->delayed_head;
+        fs->delayed_head = dm->next;
+        free(dm);
+    }
+    fs->delayed_tail = NULL;
+}
+
+// Разгрузка линии задержки (поток службы таймеров)
+static void delayed_release_fire(void *arg) {
+    SvmInstance *instance = (SvmInstance*)arg;
+    SvmFaultState *fs = &fault_states[instance->id];
+
+    pthread_mutex_lock(&instance->instance_mutex);
+    bool active = instance->is_active;
+    uint32_t session_id = instance->session_id;
+    pthread_mutex_unlock(&instance->instance_mutex);
+
+    pthread_mutex_lock(&fs->mutex);
+    fs->release_armed = false;
+    if (!active || session_id != fs->session_id) {
+        delay_flush_locked(fs); // Сеанс закончился - задержанные сообщения некому отдавать
+        pthread_mutex_unlock(&fs->mutex);
+        return;
+    }
+    // Снимаем с линии наступившие сообщения и выдаем их без мьютекса профиля;
+    // до конца выдачи новые сообщения экземпляра встают в линию.
+    uint64_t now = monotonic_now_ns();
+    uint64_t slack_ns = (uint64_t)SVM_SCHEDULER_TICK_MS * 1000000ull / 2;
+    DelayedMessage *due = NULL, **due_tail = &due;
+    while (fs->delayed_head && fs->delayed_head->release_ns <= now + slack_ns) {
+        DelayedMessage *dm = fs->delayed_head;
+        fs->delayed_head = dm->next;
+        if (!fs->delayed_head) fs->delayed_tail = NULL;
+        dm->next = NULL;
+        *due_tail = dm;
+        due_tail = &dm->next;
+    }
+    fs->releasing = (due != NULL);
+    pthread_mutex_unlock(&fs->mutex);
+
+    // Поток службы не ждет на полной очереди: невыданный остаток возвращается в начало линии
+    // и выдается на следующем тике
+    while (due) {
+        QueuedMessage *slot = qmq_try_reserve(svm_outgoing_queue);
+        if (!slot) break;
+        DelayedMessage *dm = due;
+        due = dm->next;
+        slot->instance_id = instance->id;
+        memcpy(&slot->message, dm->message_bytes, dm->message_size);
+        qmq_commit(svm_outgoing_queue, slot);
+        free(dm);
+    }
+
+    pthread_mutex_lock(&fs->mutex);
+    if (due) {
+        DelayedMessage *last = due;
+        while (last->next) last = last->next;
+        last->next = fs->delayed_head;
+        if (!fs->delayed_head) fs->delayed_tail = last;
+        fs->delayed_head = due;
+    }
+    fs->releasing = false;
+    arm_release_locked(instance, fs, monotonic_now_ns());
+    pthread_mutex_unlock(&fs->mutex);
+}
+
+// Внеочередное «Предупреждение» (поток службы таймеров)
+static void warning_tick(void *arg) {
+    SvmInstance *instance = (SvmInstance*)arg;
+    SvmFaultState *fs = &fault_states[instance->id];
+    uint8_t pks_dummy[6] = {0};
+    // Поток службы не ждет на полной очереди: «Предупреждение» пропускается до следующего периода
+    QueuedMessage *slot = qmq_try_reserve(svm_outgoing_queue);
+    if (!slot) {
+        pthread_mutex_lock(&fs->mutex);
+        fs->warnings_skipped++;
+        pthread_mutex_unlock(&fs->mutex);
+        return;
+    }
+    slot->instance_id = instance->id;
+    slot->message = create_preduprezhdenie_message(instance->assigned_lak, instance->warning_tks, pks_dummy,
+                                                   get_instance_bcb_counter(instance),
+                                                   svm_instance_next_message_number(instance));
+    printf("SVM Faults (Inst %d): Injecting 'Preduprezhdenie' (TKS=%u).\n", instance->id, instance->warning_tks);
+    svm_faults_submit(instance, slot);
+}
+
+// Отключение по времени (поток службы таймеров)
+static void disconnect_fire(void *arg) {
+    ScheduledDisconnect *sd = (ScheduledDisconnect*)arg;
+    SvmInstance *instance = sd->instance;
+    pthread_mutex_lock(&instance->instance_mutex);
+    if (instance->is_active && instance->session_id == sd->session_id) {
+        fprintf(stderr, "SVM Faults: SIMULATING scheduled disconnect for instance %d (handle %d) after %u ms.\n",
+                instance->id, instance->client_handle, fault_states[instance->id].disconnect_after_ms);
+        instance->is_active = false;
+        if (instance->client_handle >= 0 && !instance->muxed) { // Общее соединение остается другим экземплярам
+            shutdown(instance->client_handle, SHUT_RDWR); // Receiver узнает
+        }
+        if (instance->incoming_queue) qmq_shutdown(instance->incoming_queue);
+    }
+    pthread_mutex_unlock(&instance->instance_mutex);
+    free(sd);
+}
+
+void svm_faults_init(SvmInstance *instance, const SvmFaultProfileSettings *settings) {
+    if (!instance || !settings) return;
+    SvmFaultState *fs = &fault_states[instance->id];
+    memset(fs, 0, sizeof(*fs));
+    pthread_mutex_init(&fs->mutex, NULL);
+    fs->initialized = true;
+
+    bool any_probability = false;
+    for (int t = 0; t < 256; ++t) {
+        fs->drop_threshold[t] = probability_threshold(settings->drop_probability[t]);
+        fs->duplicate_threshold[t] = probability_threshold(settings->duplicate_probability[t]);
+        if (fs->drop_threshold[t] || fs->duplicate_threshold[t]) any_probability = true;
+    }
+    fs->latency_dist = settings->latency_dist;
+    fs->latency_a_ms = settings->latency_a_ms;
+    fs->latency_b_ms = settings->latency_b_ms;
+    if (settings->bandwidth_limit_kbps > 0) {
+        uint32_t burst = settings->bandwidth_burst_bytes ? settings->bandwidth_burst_bytes : SVM_FAULTS_DEFAULT_BURST_BYTES;
+        fs->ns_per_byte = 8.0e6 / (double)settings->bandwidth_limit_kbps;
+        fs->burst_ns = (uint64_t)((double)burst * fs->ns_per_byte);
+    }
+    fs->warning_period_ms = settings->warning_period_ms;
+    fs->disconnect_after_ms = settings->disconnect_after_ms;
+    fs->enabled = any_probability || fs->latency_dist != LATENCY_NONE || fs->ns_per_byte > 0.0;
+    if (fs->enabled || fs->warning_period_ms || fs->disconnect_after_ms) {
+        printf("SVM Instance %d: Load/fault profile enabled.\n", instance->id);
+    }
+}
+
+void svm_faults_session_start(SvmInstance *instance) {
+    if (!instance) return;
+    SvmFaultState *fs = &fault_states[instance->id];
+    pthread_mutex_lock(&fs->mutex);
+    delay_flush_locked(fs);
+    svm_rng_seed(&fs->rng, instance->rng_seed, (uint64_t)(instance->id + MAX_SVM_INSTANCES)); // Отдельный поток от счетчиков линии
+    fs->session_id = instance->session_id;
+    fs->bucket_tat_ns = 0;
+    fs->last_release_ns = 0;
+    fs->releasing = false;
+    fs->dropped = fs->duplicated = fs->delayed = fs->warnings_skipped = 0;
+    pthread_mutex_unlock(&fs->mutex);
+
+    if (fs->warning_period_ms) {
+        fs->warning_timer = svm_scheduler_schedule_periodic(fs->warning_period_ms, warning_tick, instance);
+        if (!fs->warning_timer) fprintf(stderr, "SVM Faults (Inst %d): Failed to start warning injection.\n", instance->id);
+    }
+    if (fs->disconnect_after_ms) {
+        ScheduledDisconnect *sd = malloc(sizeof(ScheduledDisconnect));
+        if (sd) {
+            sd->instance = instance;
+            sd->session_id = instance->session_id;
+            if (!svm_scheduler_schedule(fs->disconnect_after_ms, disconnect_fire, sd, true)) free(sd);
+        }
+    }
+}
+
+void svm_faults_session_stop(SvmInstance *instance) {
+    if (!instance) return;
+    SvmFaultState *fs = &fault_states[instance->id];
+    svm_scheduler_cancel(fs->warning_timer); // Вне мьютекса профиля: обработчик таймера его захватывает
+    fs->warning_timer = NULL;
+    pthread_mutex_lock(&fs->mutex);
+    delay_flush_locked(fs);
+    if (fs->enabled || fs->warnings_skipped) {
+        printf("SVM Faults (Inst %d): Session profile stats: dropped %lu, duplicated %lu, delayed %lu, warnings skipped %lu.\n",
+               instance->id, fs->dropped, fs->duplicated, fs->delayed, fs->warnings_skipped);
+    }
+    pthread_mutex_unlock(&fs->mutex);
+}
+
+void svm_faults_submit(SvmInstance *instance, QueuedMessage *slot) {
+    SvmFaultState *fs = &fault_states[instance->id];
+    if (!fs->enabled) {
+        qmq_commit(svm_outgoing_queue, slot);
+        return;
+    }
+    const Message *message = &slot->message;
+    uint8_t type = message->header.message_type;
+    size_t message_size = sizeof(MessageHeader) + ntohs(message->header.body_length);
+
+    pthread_mutex_lock(&fs->mutex);
+    if (rng_hit(&fs->rng, fs->drop_threshold[type])) {
+        fs->dropped++;
+        pthread_mutex_unlock(&fs->mutex);
+        printf("SVM Faults (Inst %d): SIMULATING loss of message type %u.\n", instance->id, type);
+        qmq_cancel(svm_outgoing_queue, slot);
+        return;
+    }
+    bool duplicate = rng_hit(&fs->rng, fs->duplicate_threshold[type]);
+    uint64_t now = monotonic_now_ns();
+    uint64_t release = release_time_locked(fs, message_size, now);
+    bool send_now = (release <= now && !fs->delayed_head && !fs->releasing);
+    if (send_now) {
+        qmq_commit(svm_outgoing_queue, slot); // Под мьютексом: задержанные сообщения не обгонят
+    } else {
+        delay_push_locked(instance, fs, message, message_size, release, now);
+    }
+    if (duplicate) {
+        // Повтор идет через линию задержки, чтобы не обогнать последующие сообщения
+        fs->duplicated++;
+        delay_push_locked(instance, fs, message, message_size, release_time_locked(fs, message_size, now), now);
+    }
+    pthread_mutex_unlock(&fs->mutex);
+    if (!send_now) qmq_cancel(svm_outgoing_queue, slot);
+    if (duplicate) printf("SVM Faults (Inst %d): SIMULATING duplicate of message type %u.\n", instance->id, type);
+}
+
+void svm_faults_cleanup(void) {
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        SvmFaultState *fs = &fault_states[i];
+        if (!fs->initialized) continue; // Экземпляр не сконфигурирован: мьютекс не создавался
+        pthread_mutex_lock(&fs->mutex);
+        delay_flush_locked(fs);
+        pthread_mutex_unlock(&fs->mutex);
+        pthread_mutex_destroy(&fs->mutex);
+        fs->initialized = false;
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * svm/svm_faults.h
+ *
+ * Описание:
+ * Профиль нагрузки/сбоев экземпляра СВ-М (настраивается в [settings_svmN] config.ini).
+ * Применяется к исходящим сообщениям экземпляра:
+ *  - задержка ответа: фиксированная, равномерная или логнормальная;
+ *  - потеря и повтор сообщения с вероятностью, заданной по типу сообщения;
+ *  - ограничение полосы (корзина токенов);
+ * и к сеансу связи:
+ *  - периодические внеочередные «Предупреждения»;
+ *  - отключение через заданное время после подключения.
+ * Задержанные сообщения экземпляра выдаются строго в порядке поступления.
+ */
+#ifndef SVM_FAULTS_H
+#define SVM_FAULTS_H
+
+#include <stdbool.h>
+#include "../config/config.h"
+#include "svm_types.h"
+
+// Емкость корзины токенов по умолчанию (байт), если bandwidth_burst_bytes не задан
+#define SVM_FAULTS_DEFAULT_BURST_BYTES 4096
+
+/**
+ * @brief Готовит профиль экземпляра по настройкам (вызывается при инициализации экземпляра).
+ */
+void svm_faults_init(SvmInstance *instance, const SvmFaultProfileSettings *settings);
+
+/**
+ * @brief Начало сеанса: сброс состояния профиля, запуск «Предупреждений» и отключения по времени.
+ * Служба таймеров должна быть запущена.
+ */
+void svm_faults_session_start(SvmInstance *instance);
+
+/**
+ * @brief Конец сеанса: остановка таймеров профиля, задержанные сообщения отбрасываются.
+ */
+void svm_faults_session_stop(SvmInstance *instance);
+
+/**
+ * @brief Отдает заполненный слот общей исходящей очереди с сообщением экземпляра.
+ * Без профиля слот просто подтверждается; иначе сообщение может быть потеряно,
+ * повторено или задержано (слот тогда отменяется, сообщение копируется).
+ */
+void svm_faults_submit(SvmInstance *instance, QueuedMessage *slot);
+
+/**
+ * @brief Освобождает задержанные сообщения всех экземпляров (после остановки службы таймеров).
+ */
+void svm_faults_cleanup(void);
+
+#endif // SVM_FAULTS_H
@@ -5,6 +5,11 @@
  */
 #include "svm_handlers.h"
 #include "svm_timers.h" // Для get_instance_*
+#include "svm_params.h"
+#include "svm_scheduler.h"
+#include "svm_replies.h"
+#include "svm_faults.h"
+#include "../utils/ts_queued_msg_queue.h"
 #include "../protocol/message_builder.h"
 #include "../protocol/message_utils.h"
 #include <stdio.h>
@@ -13,16 +18,20 @@
 #include <unistd.h>
 #include <arpa/inet.h> // Для ntohs
 
+extern ThreadSafeQueuedMsgQueue *svm_outgoing_queue; // Общая исходящая очередь
+
 // Массив указателей
 MessageHandler message_handlers[256];
+// Может ли обработчик сформировать ответ (для остальных слот ответа не резервируется)
+bool message_handler_replies[256];
 
 // --- Реализации обработчиков (принимают SvmInstance*) ---
 
-Message* handle_init_channel_message(SvmInstance *instance, Message *receivedMessage) {
-    if (!instance || !receivedMessage) return NULL;
+bool handle_init_channel_message(SvmInstance *instance, const Message *receivedMessage, Message *response) {
+    if (!instance || !receivedMessage || !response) return false;
 
     printf("Processor (Inst %d): Обработка 'Инициализация канала'\n", instance->id);
-    InitChannelBody *req_body = (InitChannelBody *)receivedMessage->body;
+    const InitChannelBody *req_body = (const InitChannelBody *)receivedMessage->body;
 
     // Проверяем запрошенный LAK (хотя он уже установлен при инициализации instance)
     if (req_body->lak != instance->assigned_lak) {
@@ -37,47 +46,63 @@ Message* handle_init_channel_message(SvmInstance *instance, Message *receivedMes
     if (instance->send_warning_on_confirm) {
          printf("  SVM (Inst %d, LAK 0x%02X): SIMULATING warning instead of confirm init (TKS=%u).\n",
                 instance->id, instance->assigned_lak, instance->warning_tks);
-         Message *warnMsg = malloc(sizeof(Message));
-         if (!warnMsg) { perror("handle_init_channel: malloc warnMsg"); return NULL; }
          uint8_t pks_dummy[6] = {0};
          uint32_t bcb = get_instance_bcb_counter(instance); // Получаем счетчик BCB
-         *warnMsg = create_preduprezhdenie_message(instance->assigned_lak, instance->warning_tks, pks_dummy, bcb, instance->message_counter++);
-         return warnMsg; // Возвращаем ПРЕДУПРЕЖДЕНИЕ
+         *response = create_preduprezhdenie_message(instance->assigned_lak, instance->warning_tks, pks_dummy, bcb, svm_instance_next_message_number(instance));
+         return true; // Отвечаем ПРЕДУПРЕЖДЕНИЕМ
     }
     // --- Конец проверки на имитацию сбоя ---
 
     printf("  SVM (Inst %d): Эмуляция выключения лазера...\n", instance->id);
-    uint8_t slp = 0x03, vdr = 0x10, bop1 = 0x11, bop2 = 0x12;
     uint32_t current_bcb = get_instance_bcb_counter(instance);
 
-    Message *responseMessage = (Message*)malloc(sizeof(Message));
-    if (!responseMessage) { perror("handle_init_channel: malloc response"); return NULL; }
-
-    *responseMessage = create_confirm_init_message(
-                                instance->assigned_lak,
-                                slp, vdr, bop1, bop2, current_bcb,
-                                instance->message_counter++); // Счетчик экземпляра
+    svm_reply_confirm_init(&instance->replies, response, current_bcb,
+                           svm_params_signature(&instance->params), // Параметры переживают переподключение
+                           svm_instance_next_message_number(instance)); // Счетчик экземпляра
 
     printf("  Ответ 'Подтверждение инициализации' сформирован (LAK=0x%02X).\n", instance->assigned_lak);
 
     pthread_mutex_lock(&instance->instance_mutex);
     instance->current_state = STATE_INITIALIZED;
     pthread_mutex_unlock(&instance->instance_mutex);
-    return responseMessage;
+    return true;
+}
+
+// Контекст отложенного «Подтверждения контроля»: ответ формируется по окончании самопроверки
+typedef struct {
+    uint8_t tk;
+} KontrolReplyContext;
+
+static void build_podtverzhdenie_kontrolya(SvmInstance *instance, const void *context, Message *response) {
+    const KontrolReplyContext *ctx = (const KontrolReplyContext*)context;
+    svm_reply_podtverzhdenie_kontrolya(&instance->replies, response, ctx->tk, get_instance_bcb_counter(instance),
+                                       svm_instance_next_message_number(instance));
 }
 
-Message* handle_provesti_kontrol_message(SvmInstance *instance, Message *receivedMessage) {
-    if (!instance || !receivedMessage) return NULL;
+// Ответ без отложенной отправки: слот резервируется только здесь, когда служба таймеров недоступна
+static void send_podtverzhdenie_kontrolya_now(SvmInstance *instance, const KontrolReplyContext *ctx) {
+    QueuedMessage *reply_slot = qmq_reserve(svm_outgoing_queue);
+    if (!reply_slot) {
+        fprintf(stderr, "Processor (Inst %d): Failed to reserve response slot for 'Podtverzhdenie Kontrolya'.\n",
+                instance->id);
+        return;
+    }
+    reply_slot->instance_id = instance->id;
+    build_podtverzhdenie_kontrolya(instance, ctx, &reply_slot->message);
+    svm_faults_submit(instance, reply_slot);
+}
+
+// Отвечает отложенно: слот для ответа диспетчер не резервирует (response == NULL)
+bool handle_provesti_kontrol_message(SvmInstance *instance, const Message *receivedMessage, Message *response) {
+    (void)response;
+    if (!instance || !receivedMessage) return false;
     printf("Processor (Inst %d): Обработка 'Провести контроль'\n", instance->id);
 
     pthread_mutex_lock(&instance->instance_mutex);
     instance->current_state = STATE_SELF_TEST;
     pthread_mutex_unlock(&instance->instance_mutex);
     printf("  SVM (Inst %d): Эмуляция самопроверки...\n", instance->id);
-    sleep(1); // Обычная задержка на самопроверку
-    pthread_mutex_lock(&instance->instance_mutex);
-    instance->current_state = STATE_INITIALIZED;
-    pthread_mutex_unlock(&instance->instance_mutex);
+    unsigned delay_ms = SVM_SELF_TEST_DURATION_MS; // Обычная длительность самопроверки
 
     // --- Проверка на имитацию таймаута (задержка или полное прекращение ответа) ---
     if (instance->simulate_response_timeout) {
@@ -89,27 +114,31 @@ Message* handle_provesti_kontrol_message(SvmInstance *instance, Message *receive
         pthread_mutex_lock(&instance->instance_mutex);
         instance->user_flag1 = true; // Устанавливаем флаг "перестать отвечать"
         pthread_mutex_unlock(&instance->instance_mutex);
-        sleep(10); // Имитируем задержку ответа на ЭТУ команду
+        delay_ms += SVM_SIMULATED_RESPONSE_DELAY_MS; // Имитируем задержку ответа на ЭТУ команду
     }
     // --- Конец проверки ---
 
-    ProvestiKontrolBody *req_body = (ProvestiKontrolBody *)receivedMessage->body;
-    uint32_t current_bcb = get_instance_bcb_counter(instance);
+    const ProvestiKontrolBody *req_body = (const ProvestiKontrolBody *)receivedMessage->body;
+    KontrolReplyContext ctx = { .tk = req_body->tk };
 
-    Message *responseMessage = (Message*)malloc(sizeof(Message));
-    if (!responseMessage) {
-        perror("handle_provesti_kontrol_message: malloc failed");
-        return NULL;
+    // Ответ (номер сообщения, BCB) формируется по окончании самопроверки;
+    // поток-обработчик тем временем обслуживает другие сообщения
+    if (svm_scheduler_defer_response(instance, build_podtverzhdenie_kontrolya, &ctx, sizeof(ctx),
+                                     delay_ms, STATE_INITIALIZED)) {
+        printf("  Ответ 'Подтверждение контроля' запланирован, отправка через %u мс.\n", delay_ms);
+        return false;
     }
-    *responseMessage = create_podtverzhdenie_kontrolya_message(
-                                instance->assigned_lak, req_body->tk, current_bcb,
-                                instance->message_counter++);
+    // Служба недоступна - отвечаем сразу
+    pthread_mutex_lock(&instance->instance_mutex);
+    instance->current_state = STATE_INITIALIZED;
+    pthread_mutex_unlock(&instance->instance_mutex);
+    send_podtverzhdenie_kontrolya_now(instance, &ctx);
     printf("  Ответ 'Подтверждение контроля' сформирован.\n");
-    return responseMessage;
+    return false;
 }
 
-Message* handle_vydat_rezultaty_kontrolya_message(SvmInstance *instance, Message *receivedMessage) {
-    if (!instance || !receivedMessage) return NULL;
+bool handle_vydat_rezultaty_kontrolya_message(SvmInstance *instance, const Message *receivedMessage, Message *response) {
+    if (!instance || !receivedMessage || !response) return false;
 
     // --- Проверка, не должен ли этот экземпляр перестать отвечать ---
     pthread_mutex_lock(&instance->instance_mutex);
@@ -119,7 +148,7 @@ Message* handle_vydat_rezultaty_kontrolya_message(SvmInstance *instance, Message
     if (should_not_respond) {
         printf("Processor (Inst %d, LAK 0x%02X): SIMULATING NO RESPONSE for 'Vydat Rezultaty Kontrolya' due to timeout simulation.\n",
                instance->id, instance->assigned_lak);
-        return NULL; // Не отправляем ответ
+        return false; // Не отправляем ответ
     }
     // --- Конец проверки ---
 
@@ -142,20 +171,14 @@ Message* handle_vydat_rezultaty_kontrolya_message(SvmInstance *instance, Message
     uint16_t vsk = 150;
     uint32_t current_bcb = get_instance_bcb_counter(instance);
 
-    Message *responseMessage = (Message*)malloc(sizeof(Message));
-    if (!responseMessage) {
-        perror("handle_vydat_rezultaty_kontrolya_message: malloc failed");
-        return NULL;
-    }
-    *responseMessage = create_rezultaty_kontrolya_message(
-                                instance->assigned_lak, rsk, vsk, current_bcb,
-                                instance->message_counter++);
+    svm_reply_rezultaty_kontrolya(&instance->replies, response, rsk, vsk, current_bcb,
+                                  svm_instance_next_message_number(instance));
     printf("  Ответ 'Результаты контроля' сформирован.\n");
-    return responseMessage;
+    return true;
 }
 
-Message* handle_vydat_sostoyanie_linii_message(SvmInstance *instance, Message *receivedMessage) {
-    if (!instance || !receivedMessage) return NULL;
+bool handle_vydat_sostoyanie_linii_message(SvmInstance *instance, const Message *receivedMessage, Message *response) {
+    if (!instance || !receivedMessage || !response) return false;
 
     // --- Проверка, не должен ли этот экземпляр перестать отвечать ---
     pthread_mutex_lock(&instance->instance_mutex);
@@ -165,7 +188,7 @@ Message* handle_vydat_sostoyanie_linii_message(SvmInstance *instance, Message *r
     if (should_not_respond) {
         printf("Processor (Inst %d, LAK 0x%02X): SIMULATING NO RESPONSE for 'Vydat Sostoyanie Linii' due to timeout simulation.\n",
                instance->id, instance->assigned_lak);
-        return NULL; // Не отправляем ответ
+        return false; // Не отправляем ответ
     }
     // --- Конец проверки ---
 
@@ -180,38 +203,46 @@ Message* handle_vydat_sostoyanie_linii_message(SvmInstance *instance, Message *r
     uint32_t current_bcb = get_instance_bcb_counter(instance);
     get_instance_line_status_counters(instance, &kla_val, &sla_val_us100, &ksa_val);
 
-    Message *responseMessage = (Message*)malloc(sizeof(Message));
-    if (!responseMessage) {
-        perror("handle_vydat_sostoyanie_linii_message: malloc failed");
-        return NULL;
-    }
-    *responseMessage = create_sostoyanie_linii_message(
-                                instance->assigned_lak, kla_val, sla_val_us100, ksa_val, current_bcb,
-                                instance->message_counter++);
+    svm_reply_sostoyanie_linii(&instance->replies, response, kla_val, sla_val_us100, ksa_val, current_bcb,
+                               svm_instance_next_message_number(instance));
     printf("  Ответ 'Состояние линии' сформирован.\n");
-    return responseMessage;
+    return true;
 }
 
 
 // --- Заглушки и обработчики без ответа ---
 // (Используют instance->id для логов)
-Message* handle_confirm_init_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Подтверждение инициализации' (не ожидается) - ответа нет.\n", i?i->id:-1); return NULL; }
-Message* handle_podtverzhdenie_kontrolya_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Подтверждение контроля' (не ожидается) - ответа нет.\n", i?i->id:-1); return NULL; }
-Message* handle_rezultaty_kontrolya_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Результаты контроля' (не ожидается) - ответа нет.\n", i?i->id:-1); return NULL; }
-Message* handle_sostoyanie_linii_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Состояние линии' (не ожидается) - ответа нет.\n", i?i->id:-1); return NULL; }
-Message* handle_prinyat_parametry_so_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Принять параметры СО' (нет ответа).\n", i?i->id:-1); return NULL; }
-Message* handle_prinyat_time_ref_range_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Принять TIME_REF_RANGE' (нет ответа).\n", i?i->id:-1); return NULL; }
-Message* handle_prinyat_reper_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Принять Reper' (нет ответа).\n", i?i->id:-1); return NULL; }
-Message* handle_prinyat_parametry_sdr_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Принять параметры СДР' (нет ответа).\n", i?i->id:-1); return NULL; }
-Message* handle_prinyat_parametry_3tso_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Принять параметры 3ЦО' (нет ответа).\n", i?i->id:-1); return NULL; }
-Message* handle_prinyat_ref_azimuth_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Принять REF_AZIMUTH' (нет ответа).\n", i?i->id:-1); return NULL; }
-Message* handle_prinyat_parametry_tsd_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Принять параметры ЦДР' (нет ответа).\n", i?i->id:-1); return NULL; }
-Message* handle_navigatsionnye_dannye_message(SvmInstance *i, Message *m) { (void)i; (void)m; printf("Processor (Inst %d): Обработка 'Навигационные данные' (нет ответа).\n", i?i->id:-1); return NULL; }
+bool handle_confirm_init_message(SvmInstance *i, const Message *m, Message *response) { (void)i; (void)m; (void)response; printf("Processor (Inst %d): Обработка 'Подтверждение инициализации' (не ожидается) - ответа нет.\n", i?i->id:-1); return false; }
+bool handle_podtverzhdenie_kontrolya_message(SvmInstance *i, const Message *m, Message *response) { (void)i; (void)m; (void)response; printf("Processor (Inst %d): Обработка 'Подтверждение контроля' (не ожидается) - ответа нет.\n", i?i->id:-1); return false; }
+bool handle_rezultaty_kontrolya_message(SvmInstance *i, const Message *m, Message *response) { (void)i; (void)m; (void)response; printf("Processor (Inst %d): Обработка 'Результаты контроля' (не ожидается) - ответа нет.\n", i?i->id:-1); return false; }
+bool handle_sostoyanie_linii_message(SvmInstance *i, const Message *m, Message *response) { (void)i; (void)m; (void)response; printf("Processor (Inst %d): Обработка 'Состояние линии' (не ожидается) - ответа нет.\n", i?i->id:-1); return false; }
+bool handle_navigatsionnye_dannye_message(SvmInstance *i, const Message *m, Message *response) { (void)i; (void)m; (void)response; printf("Processor (Inst %d): Обработка 'Навигационные данные' (нет ответа).\n", i?i->id:-1); return false; }
+
+// --- Прием таблиц параметров съемки (ответа нет, таблица декодируется в собираемый набор) ---
+static bool handle_parameter_table(SvmInstance *instance, const Message *receivedMessage, const char *name) {
+    if (!instance || !receivedMessage) return false;
+    if (svm_params_apply_message(&instance->params, receivedMessage) == 0) {
+        printf("Processor (Inst %d): Обработка '%s' - таблица принята, активация на границе цикла обзора.\n", instance->id, name);
+    } else {
+        fprintf(stderr, "Processor (Inst %d): '%s' - некорректная таблица (длина тела %u), отброшена.\n",
+                instance->id, name, receivedMessage->header.body_length);
+    }
+    return false;
+}
+
+bool handle_prinyat_parametry_so_message(SvmInstance *i, const Message *m, Message *response) { (void)response; return handle_parameter_table(i, m, "Принять параметры СО"); }
+bool handle_prinyat_time_ref_range_message(SvmInstance *i, const Message *m, Message *response) { (void)response; return handle_parameter_table(i, m, "Принять TIME_REF_RANGE"); }
+bool handle_prinyat_reper_message(SvmInstance *i, const Message *m, Message *response) { (void)response; return handle_parameter_table(i, m, "Принять Reper"); }
+bool handle_prinyat_parametry_sdr_message(SvmInstance *i, const Message *m, Message *response) { (void)response; return handle_parameter_table(i, m, "Принять параметры СДР"); }
+bool handle_prinyat_parametry_3tso_message(SvmInstance *i, const Message *m, Message *response) { (void)response; return handle_parameter_table(i, m, "Принять параметры 3ЦО"); }
+bool handle_prinyat_ref_azimuth_message(SvmInstance *i, const Message *m, Message *response) { (void)response; return handle_parameter_table(i, m, "Принять REF_AZIMUTH"); }
+bool handle_prinyat_parametry_tsd_message(SvmInstance *i, const Message *m, Message *response) { (void)response; return handle_parameter_table(i, m, "Принять параметры ЦДР"); }
 
 // --- Инициализация диспетчера ---
 void init_message_handlers(void) {
 	for (int i = 0; i < 256; ++i) {
 		message_handlers[i] = NULL; // Обнуляем все указатели
+		message_handler_replies[i] = false;
 	}
 	// УВМ -> СВМ (Реальные обработчики)
 	message_handlers[MESSAGE_TYPE_INIT_CHANNEL] = handle_init_channel_message;
@@ -226,6 +257,10 @@ void init_message_handlers(void) {
 	message_handlers[MESSAGE_TYPE_PRIYAT_REF_AZIMUTH] = handle_prinyat_ref_azimuth_message;
 	message_handlers[MESSAGE_TYPE_PRIYAT_PARAMETRY_TSD] = handle_prinyat_parametry_tsd_message;
 	message_handlers[MESSAGE_TYPE_NAVIGATSIONNYE_DANNYE] = handle_navigatsionnye_dannye_message;
+	// PROVESTI_KONTROL отвечает отложенно: слот резервирует служба таймеров в момент отправки
+	message_handler_replies[MESSAGE_TYPE_INIT_CHANNEL] = true;
+	message_handler_replies[MESSAGE_TYPE_VYDAT_RESULTATY_KONTROLYA] = true;
+	message_handler_replies[MESSAGE_TYPE_VYDAT_SOSTOYANIE_LINII] = true;
 
     // СВМ -> УВМ (Заглушки, так как SVM обычно не получает эти сообщения)
 	message_handlers[MESSAGE_TYPE_CONFIRM_INIT] = handle_confirm_init_message;
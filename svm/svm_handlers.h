@@ -14,30 +14,37 @@
 #include "../io/io_interface.h" // Не используется напрямую, но может быть полезно для контекста
 #include "svm_types.h" // <-- ВКЛЮЧЕНО для SvmInstance
 
+// --- Эмулируемые длительности операций ---
+#define SVM_SELF_TEST_DURATION_MS 1000        // Длительность самопроверки («Провести контроль»)
+#define SVM_SIMULATED_RESPONSE_DELAY_MS 10000 // Дополнительная задержка при simulate_response_timeout
+
 // --- Тип указателя на функцию-обработчик ---
-// Теперь принимает SvmInstance* и Message*, возвращает Message* (ответ) или NULL
-typedef Message* (*MessageHandler)(SvmInstance *instance, Message *message);
+// Принимает SvmInstance* и входящее сообщение; ответ (body_length в сетевом порядке) формируется
+// прямо в response - слоте исходящей очереди. Возвращает true, если ответ сформирован и его нужно
+// отправить; при false слот возвращается очереди.
+typedef bool (*MessageHandler)(SvmInstance *instance, const Message *message, Message *response);
 
-// --- Глобальный массив указателей (объявляем как extern) ---
+// --- Глобальные массивы диспетчера (объявляем как extern) ---
 extern MessageHandler message_handlers[256];
+extern bool message_handler_replies[256]; // true - обработчику нужен слот для ответа
 
 // --- Прототипы функций-обработчиков (теперь принимают SvmInstance*) ---
-Message* handle_init_channel_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_confirm_init_message(SvmInstance *instance, Message *receivedMessage); // Заглушка
-Message* handle_provesti_kontrol_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_podtverzhdenie_kontrolya_message(SvmInstance *instance, Message *receivedMessage); // Заглушка
-Message* handle_vydat_rezultaty_kontrolya_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_rezultaty_kontrolya_message(SvmInstance *instance, Message *receivedMessage); // Заглушка
-Message* handle_vydat_sostoyanie_linii_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_sostoyanie_linii_message(SvmInstance *instance, Message *receivedMessage); // Заглушка
-Message* handle_prinyat_parametry_so_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_prinyat_time_ref_range_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_prinyat_reper_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_prinyat_parametry_sdr_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_prinyat_parametry_3tso_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_prinyat_ref_azimuth_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_prinyat_parametry_tsd_message(SvmInstance *instance, Message *receivedMessage);
-Message* handle_navigatsionnye_dannye_message(SvmInstance *instance, Message *receivedMessage);
+bool handle_init_channel_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_confirm_init_message(SvmInstance *instance, const Message *receivedMessage, Message *response); // Заглушка
+bool handle_provesti_kontrol_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_podtverzhdenie_kontrolya_message(SvmInstance *instance, const Message *receivedMessage, Message *response); // Заглушка
+bool handle_vydat_rezultaty_kontrolya_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_rezultaty_kontrolya_message(SvmInstance *instance, const Message *receivedMessage, Message *response); // Заглушка
+bool handle_vydat_sostoyanie_linii_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_sostoyanie_linii_message(SvmInstance *instance, const Message *receivedMessage, Message *response); // Заглушка
+bool handle_prinyat_parametry_so_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_prinyat_time_ref_range_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_prinyat_reper_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_prinyat_parametry_sdr_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_prinyat_parametry_3tso_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_prinyat_ref_azimuth_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_prinyat_parametry_tsd_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
+bool handle_navigatsionnye_dannye_message(SvmInstance *instance, const Message *receivedMessage, Message *response);
 // ... Добавить прототипы для остальных обработчиков ...
 
 // --- Функция инициализации диспетчера ---
@@ -1,8 +1,10 @@
 /*
  * svm/svm_main.c
  * Описание: Основной файл SVM: инициализация, управление МНОЖЕСТВОМ экземпляров СВ-М,
- * создание потоков (ОБЩИЙ Sender, ПЕРСОНАЛЬНЫЕ Listener/Receiver/Processor/Timer),
+ * создание потоков (ОБЩИЕ Sender и пул обработчиков, ПЕРСОНАЛЬНЫЕ Listener/Receiver),
  * управление их жизненным циклом. Использует подход "1 поток accept на порт".
+ * Receiver и входящая очередь экземпляра создаются один раз при запуске и между
+ * подключениями ждут в горячем резерве, так что accept сразу переходит к приему.
  */
 
 #include <stdio.h>
@@ -27,8 +29,12 @@
 #include "../io/io_interface.h"
 #include "../utils/ts_queued_msg_queue.h"
 #include "svm_handlers.h"
-#include "svm_timers.h" // Содержит объявления get_instance_..._counter и svm_instance_timer_thread_func
+#include "svm_timers.h" // Содержит объявления get_instance_..._counter и svm_instance_timers_start/stop
 #include "svm_types.h"
+#include "svm_params.h"
+#include "svm_scheduler.h"
+#include "svm_processor.h"
+#include "svm_faults.h"
 
 // --- Глобальные переменные ---
 AppConfig config;
@@ -38,16 +44,18 @@ pthread_mutex_t svm_instances_mutex; // Глобальный мьютекс дл
                                       // Пока что каждый instance имеет свой мьютекс.
 int listen_sockets[MAX_SVM_INSTANCES];
 pthread_t listener_threads[MAX_SVM_INSTANCES];
+volatile int mux_listen_socket = -1;  // Слушающий сокет мультиплексированного транспорта
+volatile int mux_client_socket = -1;  // Текущее общее соединение (для остановки по сигналу)
+pthread_t mux_thread = 0;
 
 volatile bool keep_running = true; // Общий флаг работы для всего svm_app
 
 // --- Прототипы потоков ---
 extern void* receiver_thread_func(void* arg);
-extern void* processor_thread_func(void* arg);
 extern void* sender_thread_func(void* arg);
 // extern void* timer_thread_func(void* arg); // Общий таймер УДАЛЕН
-extern void* svm_instance_timer_thread_func(void* arg); // Персональный таймер ОБЪЯВЛЕН в svm_timers.h
 void* listener_thread_func(void* arg);
+void* mux_listener_thread_func(void* arg);
 
 // --- Обработчик сигналов ---
 void handle_shutdown_signal(int sig) {
@@ -63,17 +71,26 @@ void handle_shutdown_signal(int sig) {
             shutdown(fd, SHUT_RDWR);
             close(fd);
         }
-        // Сигнализируем персональным таймерам через их флаги (если они уже запущены)
-        // Это будет сделано в listener_thread_func при его завершении или здесь, если необходимо экстренно
-        // pthread_mutex_lock(&svm_instances[i].instance_mutex);
-        // svm_instances[i].personal_timer_keep_running = false;
-        // pthread_mutex_unlock(&svm_instances[i].instance_mutex);
+        // Таймеры экземпляров отменяет listener_thread_func при завершении сеанса
     }
+    if (mux_listen_socket >= 0) {
+        int fd = mux_listen_socket;
+        mux_listen_socket = -1;
+        shutdown(fd, SHUT_RDWR);
+        close(fd);
+    }
+    if (mux_client_socket >= 0) shutdown(mux_client_socket, SHUT_RDWR); // Закроет владелец
 
     if (svm_outgoing_queue) qmq_shutdown(svm_outgoing_queue);
     // stop_timer_thread_signal(); // Общего таймера больше нет
 }
 
+static uint64_t monotonic_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
 // --- Функция инициализации экземпляра ---
 void initialize_svm_instance(SvmInstance *instance, int id, LogicalAddress lak_from_config, const SvmInstanceSettings* settings_from_config) {
     if (!instance || !settings_from_config) return;
@@ -83,28 +100,177 @@ void initialize_svm_instance(SvmInstance *instance, int id, LogicalAddress lak_f
     instance->is_active = false; // Станет true, когда все потоки экземпляра запущены
     instance->incoming_queue = NULL;
     instance->receiver_tid = 0;
-    instance->processor_tid = 0;
-    instance->timer_tid = 0; // Инициализация ID персонального таймера
-    instance->personal_timer_keep_running = false; // Инициализация флага персонального таймера
+    instance->proc_scheduled = 0;
+    instance->proc_pending = 0;
+    instance->cycle_timer = NULL;
 
     instance->current_state = STATE_NOT_INITIALIZED;
     instance->message_counter = 0;
     instance->messages_sent_count = 0;
 
-    instance->bcb_counter = 0;
-    instance->link_up_changes_counter = 0;
-    instance->link_up_low_time_us100 = 0;
-    instance->sign_det_changes_counter = 0;
-    instance->link_status_timer_counter = 0; // Переименованное поле
-
     instance->assigned_lak = lak_from_config;
+    svm_replies_init(&instance->replies, lak_from_config, config.confirm_init_signature);
 	instance->user_flag1 = false;
     instance->simulate_control_failure = settings_from_config->simulate_control_failure;
     instance->disconnect_after_messages = settings_from_config->disconnect_after_messages;
     instance->simulate_response_timeout = settings_from_config->simulate_response_timeout;
     instance->send_warning_on_confirm = settings_from_config->send_warning_on_confirm;
     instance->warning_tks = settings_from_config->warning_tks;
-    // Мьютекс instance->instance_mutex инициализируется в main()
+    instance->rng_seed = settings_from_config->rng_seed;
+    if (instance->rng_seed == 0) {
+        instance->rng_seed = (uint64_t)time(NULL) ^ ((uint64_t)(id + 1) << 32);
+    }
+    if (config.svm_config_loaded[id]) { // Ненастроенные слоты не запускаются
+        printf("SVM Instance %d: RNG seed %llu (set rng_seed in [settings_svm%d] to repeat this run).\n",
+               id, (unsigned long long)instance->rng_seed, id);
+    }
+    svm_instance_reset_counters(instance);
+    svm_faults_init(instance, &settings_from_config->profile);
+    // Мьютекс instance->instance_mutex и session_cond инициализируются в main()
+}
+
+// Горячий резерв: входящая очередь (с заранее затронутой памятью) и Receiver,
+// ждущий подключения. Возвращает false, если что-то не удалось создать.
+static bool svm_instance_warm_up(SvmInstance *instance) {
+    instance->incoming_queue = qmq_create(100);
+    if (!instance->incoming_queue) {
+        fprintf(stderr, "SVM: Failed to create incoming queue for instance %d.\n", instance->id);
+        return false;
+    }
+    qmq_prefault(instance->incoming_queue); // Страницы буфера выделяются до первого подключения
+    instance->session_phase = SESSION_STANDBY;
+    instance->receiver_exit = false;
+    if (pthread_create(&instance->receiver_tid, NULL, receiver_thread_func, instance) != 0) {
+        perror("SVM: Failed to create standby receiver thread");
+        instance->receiver_tid = 0;
+        qmq_destroy(instance->incoming_queue);
+        instance->incoming_queue = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Снятие экземпляра с резерва (после завершения его listener'а). Безопасно повторно.
+static void svm_instance_release_standby(SvmInstance *instance) {
+    if (instance->receiver_tid != 0) {
+        pthread_mutex_lock(&instance->instance_mutex);
+        instance->receiver_exit = true;
+        pthread_cond_broadcast(&instance->session_cond);
+        pthread_mutex_unlock(&instance->instance_mutex);
+        pthread_join(instance->receiver_tid, NULL);
+        instance->receiver_tid = 0;
+    }
+    if (instance->incoming_queue) {
+        qmq_destroy(instance->incoming_queue);
+        instance->incoming_queue = NULL;
+    }
+}
+
+// Начало сеанса связи экземпляра (под instance_mutex; на время отката при ошибке мьютекс
+// отпускается). Сбрасывает состояние сеанса, подключает входящую очередь к пулу обработчиков,
+// запускает таймеры и профиль сбоев. Receiver не будится: это делает вызывающий.
+static bool svm_instance_session_begin(SvmInstance *instance, IOInterface *io, int handle) {
+    instance->accept_ns = monotonic_now_ns(); // Начало отсчета accept -> «Подтверждение инициализации»
+    instance->tcp_info_ns = 0;
+    instance->client_handle = handle;
+    instance->io_handle = io; // Сохраняем указатель на IO для этого клиента
+    instance->session_id++; // Отложенные ответы прошлого сеанса не должны уйти новому клиенту
+    instance->current_state = STATE_NOT_INITIALIZED;
+    instance->message_counter = 0;
+    instance->messages_sent_count = 0; // Сброс счетчика для имитации disconnect_after_messages
+    svm_instance_reset_counters(instance); // BCB отсчитывается от момента подключения
+    instance->user_flag1 = false; // Сброс флагов имитации
+
+    // Очередь и Receiver уже готовы (горячий резерв): очередь лишь открывается заново
+    qmq_reset(instance->incoming_queue);
+    // Входящую очередь обслуживает общий пул обработчиков
+    svm_processor_attach(instance);
+
+    // Периодические таймеры экземпляра живут в общей службе таймеров
+    if (!svm_instance_timers_start(instance)) {
+        pthread_mutex_unlock(&instance->instance_mutex);
+        svm_processor_detach(instance);
+        pthread_mutex_lock(&instance->instance_mutex);
+        instance->client_handle = -1;
+        instance->io_handle = NULL;
+        instance->accept_ns = 0;
+        return false;
+    }
+    svm_faults_session_start(instance);
+    instance->is_active = true;
+    return true;
+}
+
+// Конец сеанса связи экземпляра (без instance_mutex; входящая очередь уже закрыта):
+// отключение от пула и таймеров, возврат в горячий резерв. Собственное соединение
+// экземпляра закрывается; общее (мультиплексированное) закрывает его владелец.
+static void svm_instance_session_end(SvmInstance *instance) {
+    svm_processor_detach(instance);
+    printf("SVM Instance %d: Incoming queue drained by processor pool.\n", instance->id);
+
+    // Остановка таймеров экземпляра (без instance_mutex: обработчики таймеров его захватывают)
+    svm_instance_timers_stop(instance);
+    svm_faults_session_stop(instance);
+    printf("SVM Instance %d: Instance timers cancelled.\n", instance->id);
+
+    pthread_mutex_lock(&instance->instance_mutex);
+    if (instance->client_handle >= 0 && !instance->muxed) {
+        if (instance->io_handle) instance->io_handle->disconnect(instance->io_handle, instance->client_handle);
+        else close(instance->client_handle);
+    }
+    instance->client_handle = -1;
+    instance->is_active = false;
+    instance->muxed = false;
+    instance->io_handle = NULL;
+    instance->accept_ns = 0;
+    instance->session_phase = SESSION_STANDBY;
+    pthread_mutex_unlock(&instance->instance_mutex);
+}
+
+static SvmTimer *tcp_info_timer = NULL; // Периодический снимок TCP_INFO (tcp_info_interval_ms > 0)
+
+// Снимок TCP_INFO соединений активных экземпляров и строка в журнал (в потоке службы таймеров).
+// Снимается под instance_mutex: соединение сеанса закрывается тоже под ним, поэтому дескриптор
+// не может смениться во время снимка
+static void svm_sample_tcp_info(void *arg) {
+    (void)arg;
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        SvmInstance *instance = &svm_instances[i];
+        EthernetTcpInfo info;
+        bool sampled = false, muxed = false;
+        pthread_mutex_lock(&instance->instance_mutex);
+        if (instance->is_active && instance->io_handle && instance->client_handle >= 0 &&
+            io_tcp_info(instance->io_handle, instance->client_handle, &info) == 0) {
+            instance->tcp_info = info;
+            instance->tcp_info_ns = monotonic_now_ns();
+            muxed = instance->muxed;
+            sampled = true;
+        }
+        pthread_mutex_unlock(&instance->instance_mutex);
+        if (sampled) {
+            printf("SVM TcpInfo (Inst %d): srtt %u us, rttvar %u us, retransmits %u, cwnd %u, unacked %u B, send queue %u B%s\n",
+                   i, info.srtt_us, info.rttvar_us, info.retransmits, info.cwnd, info.unacked_bytes, info.sendq_bytes,
+                   muxed ? " (shared connection)" : "");
+        }
+    }
+}
+
+// Слушающий интерфейс для порта: TCP (при interface_type = uring - на io_uring) или,
+// при interface_type = unix/shm, сокет svm_<port>.sock (для shm - управляющий, данные идут через общую память)
+static IOInterface* svm_create_listener_io(uint16_t port) {
+    bool shm = strcasecmp(config.interface_type, "shm") == 0;
+    if (shm || strcasecmp(config.interface_type, "unix") == 0) {
+        UnixConfig unix_config = {0};
+        if (unix_socket_path(unix_config.path, sizeof(unix_config.path), config.unix_socket_dir, port) != 0) return NULL;
+        return shm ? create_shm_interface(&unix_config) : create_unix_interface(&unix_config);
+    }
+    EthernetConfig listen_config = {0};
+    listen_config.port = port;
+    listen_config.profile = config.socket_profile;
+    if (strcasecmp(config.interface_type, "uring") == 0) {
+        return create_uring_interface(&listen_config); // Без io_uring - обычный Ethernet
+    }
+    return create_ethernet_interface(&listen_config);
 }
 
 // --- Поток-слушатель для одного порта/экземпляра ---
@@ -126,9 +292,7 @@ void* listener_thread_func(void* arg) {
     SvmInstance *instance = &svm_instances[svm_id];
     // instance->assigned_lak = lak; // LAK уже установлен в initialize_svm_instance, который вызовет main
 
-    EthernetConfig listen_config = {0};
-    listen_config.port = port; // Используем порт из аргументов
-    listener_io = create_ethernet_interface(&listen_config);
+    listener_io = svm_create_listener_io(port);
     if (!listener_io) {
         fprintf(stderr, "Listener (SVM %d, Port %u): Failed to create IO interface.\n", svm_id, port);
         return NULL;
@@ -166,108 +330,213 @@ void* listener_thread_func(void* arg) {
         if (instance->is_active) {
              pthread_mutex_unlock(&instance->instance_mutex);
              fprintf(stderr, "Listener (SVM %d, Port %u): Instance is already active! Rejecting new connection.\n", svm_id, port);
-             close(client_handle);
+             listener_io->disconnect(listener_io, client_handle);
              continue;
         }
 
-        instance->client_handle = client_handle;
-        instance->io_handle = listener_io; // Сохраняем указатель на IO для этого клиента
-        instance->current_state = STATE_NOT_INITIALIZED;
-        instance->message_counter = 0;
-        instance->messages_sent_count = 0; // Сброс счетчика для имитации disconnect_after_messages
-        instance->bcb_counter = 0;
-        instance->link_up_changes_counter = 0;
-        instance->link_up_low_time_us100 = 0;
-        instance->sign_det_changes_counter = 0;
-        instance->link_status_timer_counter = 0;
-        instance->user_flag1 = false; // Сброс флагов имитации
-
-        instance->incoming_queue = qmq_create(100);
-        if (!instance->incoming_queue) {
+        if (instance->receiver_tid == 0 || !instance->incoming_queue) {
              pthread_mutex_unlock(&instance->instance_mutex);
-             fprintf(stderr, "Listener (SVM %d, Port %u): Failed to create incoming queue. Rejecting.\n", svm_id, port);
-             close(client_handle);
-             instance->io_handle = NULL;
+             fprintf(stderr, "Listener (SVM %d, Port %u): Instance has no standby receiver. Rejecting.\n", svm_id, port);
+             listener_io->disconnect(listener_io, client_handle);
              continue;
         }
 
-        bool receiver_ok = false, processor_ok = false, timer_ok = false;
-        instance->receiver_tid = 0; instance->processor_tid = 0; instance->timer_tid = 0;
-        instance->personal_timer_keep_running = true; // Готовим флаг для таймера
-
-        if (pthread_create(&instance->receiver_tid, NULL, receiver_thread_func, instance) == 0) {
-            receiver_ok = true;
-            if (pthread_create(&instance->processor_tid, NULL, processor_thread_func, instance) == 0) {
-                processor_ok = true;
-                if (pthread_create(&instance->timer_tid, NULL, svm_instance_timer_thread_func, instance) == 0) {
-                    timer_ok = true;
-                } else {
-                    perror("Listener: Failed to create instance timer thread");
-                    instance->personal_timer_keep_running = false; // Отменить, если таймер не стартанул
-                    // Отменяем processor и receiver
-                    if(processor_ok) { pthread_cancel(instance->processor_tid); pthread_join(instance->processor_tid, NULL); instance->processor_tid = 0; processor_ok=false;}
-                    if(receiver_ok) { pthread_cancel(instance->receiver_tid); pthread_join(instance->receiver_tid, NULL); instance->receiver_tid = 0; receiver_ok=false;}
-                }
-            } else {
-                perror("Listener: Failed to create processor thread");
-                if(receiver_ok) { pthread_cancel(instance->receiver_tid); pthread_join(instance->receiver_tid, NULL); instance->receiver_tid = 0; receiver_ok=false;}
-            }
-        } else {
-             perror("Listener: Failed to create receiver thread");
+        if (!svm_instance_session_begin(instance, listener_io, client_handle)) {
+            pthread_mutex_unlock(&instance->instance_mutex);
+            fprintf(stderr, "Listener (SVM %d, Port %u): Failed to start instance timers. Rejecting.\n", svm_id, port);
+            listener_io->disconnect(listener_io, client_handle);
+            continue;
+        }
+        instance->session_phase = SESSION_RUNNING; // Будим Receiver из резерва
+        pthread_cond_broadcast(&instance->session_cond);
+        printf("Listener (SVM %d, Port %u): Instance activated from warm standby.\n", svm_id, port);
+        while (instance->session_phase == SESSION_RUNNING) {
+            pthread_cond_wait(&instance->session_cond, &instance->instance_mutex);
         }
+        pthread_mutex_unlock(&instance->instance_mutex);
+        printf("Listener (SVM %d, Port %u): Receiver finished the session.\n", svm_id, port);
 
-        if (receiver_ok && processor_ok && timer_ok) {
-            instance->is_active = true;
-            printf("Listener (SVM %d, Port %u): Instance activated. Worker threads (Recv, Proc, Timer) started.\n", svm_id, port);
-            pthread_mutex_unlock(&instance->instance_mutex);
+        svm_instance_session_end(instance);
+        printf("Listener (SVM %d, Port %u): Instance back in warm standby. Ready for new connection.\n", svm_id, port);
+    } // end while(keep_running)
 
-            if (instance->receiver_tid != 0) pthread_join(instance->receiver_tid, NULL);
-            printf("Listener (SVM %d, Port %u): Receiver thread joined.\n", svm_id, port);
-            if (instance->processor_tid != 0) pthread_join(instance->processor_tid, NULL);
-            printf("Listener (SVM %d, Port %u): Processor thread joined.\n", svm_id, port);
-            
-            // Остановка персонального таймера
-            pthread_mutex_lock(&instance->instance_mutex);
-            if (instance->timer_tid != 0) { // Проверяем, был ли таймер успешно запущен
-                instance->personal_timer_keep_running = false;
-                 printf("Listener (SVM %d, Port %u): Signaled instance timer thread to stop.\n", svm_id, port);
-            }
-            pthread_mutex_unlock(&instance->instance_mutex);
+    printf("Listener thread for SVM ID %d (Port %u) finished.\n", svm_id, port);
+    if (lfd >= 0) { close(lfd); listen_sockets[svm_id] = -1; }
+    if(listener_io) listener_io->destroy(listener_io); // Уничтожаем IO интерфейс листенера
+    return NULL;
+}
 
-            if (instance->timer_tid != 0) {
-                pthread_join(instance->timer_tid, NULL);
-                printf("Listener (SVM %d, Port %u): Instance timer thread joined.\n", svm_id, port);
-            }
+// --- Мультиплексированный транспорт: одно соединение (TCP или последовательный порт)
+// на все экземпляры среза, разбор входящих по логическому адресу в заголовке ---
+
+// Новый сеанс экземпляра на общем соединении - «Инициализация канала» для него играет роль
+// нового подключения на собственном порту. Сеанс, в котором еще ничего не произошло, не трогается.
+// Возвращает false, если экземпляр не удалось запустить заново (он остается в резерве).
+static bool svm_mux_rearm(SvmInstance *instance, IOInterface *io, int handle) {
+    pthread_mutex_lock(&instance->instance_mutex);
+    bool fresh = instance->is_active && instance->current_state == STATE_NOT_INITIALIZED;
+    pthread_mutex_unlock(&instance->instance_mutex);
+    if (fresh) return true;
+
+    qmq_shutdown(instance->incoming_queue); // Как при обрыве: очередь закрыта до конца сеанса
+    svm_instance_session_end(instance);
+    pthread_mutex_lock(&instance->instance_mutex);
+    instance->muxed = true;
+    bool started = svm_instance_session_begin(instance, io, handle);
+    if (!started) instance->muxed = false;
+    pthread_mutex_unlock(&instance->instance_mutex);
+    if (started) printf("SVM Mux: Instance %d re-armed by 'Инициализация канала'.\n", instance->id);
+    return started;
+}
 
-             printf("Listener (SVM %d, Port %u): Worker threads finished. Cleaning up instance...\n", svm_id, port);
-             pthread_mutex_lock(&instance->instance_mutex);
-             if (instance->client_handle >= 0) {
-                 if (instance->io_handle) instance->io_handle->disconnect(instance->io_handle, instance->client_handle);
-                 else { close(instance->client_handle); instance->client_handle = -1; }
-             }
-             if (instance->incoming_queue) { qmq_destroy(instance->incoming_queue); instance->incoming_queue = NULL; }
-             instance->is_active = false;
-             instance->receiver_tid = 0; instance->processor_tid = 0; instance->timer_tid = 0;
-             instance->io_handle = NULL;
-             pthread_mutex_unlock(&instance->instance_mutex);
-             printf("Listener (SVM %d, Port %u): Instance deactivated. Ready for new connection.\n", svm_id, port);
-        } else {
+// Сеанс общего соединения: все свободные экземпляры среза обслуживаются через handle
+static void svm_mux_session(IOInterface *io, int handle) {
+    int8_t instance_by_lak[256]; // LAK -> экземпляр (-1 - не обслуживается)
+    unsigned long dropped_inactive[MAX_SVM_INSTANCES] = {0}; // Сообщения «отключившимся» экземплярам
+    int attached = 0;
+    memset(instance_by_lak, -1, sizeof(instance_by_lak));
+
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        if (!config.svm_config_loaded[i] || !config_instance_in_slice(&config, i)) continue;
+        SvmInstance *instance = &svm_instances[i];
+        if (instance_by_lak[instance->assigned_lak] >= 0) { // Разбор идет по LAK: он должен быть уникальным
+            fprintf(stderr, "SVM Mux: Instance %d has the same LAK 0x%02X as instance %d, not attached.\n",
+                    i, instance->assigned_lak, instance_by_lak[instance->assigned_lak]);
+            continue;
+        }
+        pthread_mutex_lock(&instance->instance_mutex);
+        if (instance->is_active || instance->receiver_tid == 0 || !instance->incoming_queue) {
             pthread_mutex_unlock(&instance->instance_mutex);
-            fprintf(stderr, "Listener (SVM %d, Port %u): Failed to start all worker threads. Rejecting.\n", svm_id, port);
-            if(instance->incoming_queue) { qmq_destroy(instance->incoming_queue); instance->incoming_queue = NULL; }
-            if(instance->client_handle >=0) { close(instance->client_handle); instance->client_handle = -1;}
-            instance->io_handle = NULL; // Указатель на listener_io не должен быть NULL здесь, т.к. он общий для листенера
+            fprintf(stderr, "SVM Mux: Instance %d is busy or not in standby, not attached.\n", i);
+            continue;
         }
-    } // end while(keep_running)
+        instance->muxed = true; // Receiver экземпляра остается в резерве: прием ведет этот поток
+        if (!svm_instance_session_begin(instance, io, handle)) {
+            instance->muxed = false;
+            pthread_mutex_unlock(&instance->instance_mutex);
+            fprintf(stderr, "SVM Mux: Failed to start instance %d timers, not attached.\n", i);
+            continue;
+        }
+        pthread_mutex_unlock(&instance->instance_mutex);
+        instance_by_lak[instance->assigned_lak] = (int8_t)i;
+        attached++;
+    }
+    printf("SVM Mux: Session started on handle %d, %d instance(s) attached.\n", handle, attached);
+
+    Message message;
+    while (keep_running && attached > 0) {
+        int recvStatus = receive_protocol_message(io, handle, &message);
+        if (recvStatus == -2) continue; // Таймаут/EINTR
+        if (recvStatus != 0) {
+            if (keep_running) printf("SVM Mux: Connection %s, session finished.\n", recvStatus == 1 ? "closed by UVM" : "failed");
+            break;
+        }
+        int id = instance_by_lak[message.header.address];
+        if (id < 0) {
+            fprintf(stderr, "SVM Mux: Message type %u for unknown LAK 0x%02X dropped.\n",
+                    message.header.message_type, message.header.address);
+            continue;
+        }
+        SvmInstance *instance = &svm_instances[id];
+        if (message.header.message_type == MESSAGE_TYPE_INIT_CHANNEL) {
+            if (dropped_inactive[id] > 0) {
+                printf("SVM Mux: Instance %d: %lu message(s) dropped while disconnected.\n", id, dropped_inactive[id]);
+                dropped_inactive[id] = 0;
+            }
+            if (!svm_mux_rearm(instance, io, handle)) {
+                fprintf(stderr, "SVM Mux: Failed to re-arm instance %d, detached from the shared connection.\n", id);
+                instance_by_lak[message.header.address] = -1;
+                attached--;
+                continue;
+            }
+        }
+        pthread_mutex_lock(&instance->instance_mutex);
+        bool active = instance->is_active;
+        pthread_mutex_unlock(&instance->instance_mutex);
+        if (!active) { // Экземпляр «отключился» (имитация сбоя) и молчит до «Инициализации канала»
+            if (dropped_inactive[id]++ == 0) {
+                fprintf(stderr, "SVM Mux: Instance %d is disconnected, its messages are dropped until 'Инициализация канала'.\n", id);
+            }
+            continue;
+        }
+        QueuedMessage *slot = qmq_reserve(instance->incoming_queue);
+        if (!slot) continue;
+        slot->instance_id = id;
+        memcpy(&slot->message, &message, sizeof(MessageHeader) + message.header.body_length);
+        qmq_commit(instance->incoming_queue, slot);
+    }
 
-    printf("Listener thread for SVM ID %d (Port %u) finished.\n", svm_id, port);
-    if (lfd >= 0) { close(lfd); listen_sockets[svm_id] = -1; }
-    if(listener_io) listener_io->destroy(listener_io); // Уничтожаем IO интерфейс листенера
+    for (int lak = 0; lak < 256; ++lak) {
+        if (instance_by_lak[lak] < 0) continue;
+        SvmInstance *instance = &svm_instances[instance_by_lak[lak]];
+        if (dropped_inactive[instance->id] > 0) {
+            printf("SVM Mux: Instance %d: %lu message(s) dropped while disconnected.\n",
+                   instance->id, dropped_inactive[instance->id]);
+        }
+        qmq_shutdown(instance->incoming_queue); // Новых сообщений не будет (как у Receiver'а)
+        svm_instance_session_end(instance);
+    }
+    printf("SVM Mux: All instances back in warm standby.\n");
+}
+
+void* mux_listener_thread_func(void* arg) {
+    (void)arg;
+    bool serial = strcasecmp(config.interface_type, "serial") == 0;
+    IOInterface *mux_io = NULL;
+    if (serial) {
+        mux_io = create_serial_interface(&config.serial);
+    } else {
+        mux_io = svm_create_listener_io((uint16_t)config.mux_port);
+    }
+    if (!mux_io) {
+        fprintf(stderr, "SVM Mux: Failed to create IO interface.\n");
+        return NULL;
+    }
+
+    if (serial) {
+        // Последовательный порт - общая шина: открывается заново после каждой ошибки
+        printf("SVM Mux: Serving all instances over serial port %s.\n", config.serial.device);
+        while (keep_running) {
+            int handle = mux_io->connect(mux_io);
+            if (handle < 0) { sleep(1); continue; }
+            mux_client_socket = handle;
+            svm_mux_session(mux_io, handle);
+            mux_client_socket = -1;
+            mux_io->disconnect(mux_io, handle);
+        }
+    } else {
+        int lfd = mux_io->listen(mux_io);
+        if (lfd < 0) {
+            fprintf(stderr, "SVM Mux: Failed to listen on port %d.\n", config.mux_port);
+            mux_io->destroy(mux_io);
+            return NULL;
+        }
+        mux_listen_socket = lfd;
+        printf("SVM Mux: Listening on port %d (Listen FD %d) for a multiplexed UVM connection.\n", config.mux_port, lfd);
+        while (keep_running) {
+            char client_ip_str[INET_ADDRSTRLEN];
+            uint16_t client_port_num;
+            int handle = mux_io->accept(mux_io, client_ip_str, sizeof(client_ip_str), &client_port_num);
+            if (handle < 0) {
+                if (keep_running && errno == EINTR) continue;
+                if (keep_running) perror("SVM Mux: accept failed");
+                break;
+            }
+            printf("SVM Mux: Accepted connection from %s:%u (Client FD %d)\n", client_ip_str, client_port_num, handle);
+            mux_client_socket = handle;
+            svm_mux_session(mux_io, handle);
+            mux_client_socket = -1;
+            mux_io->disconnect(mux_io, handle);
+        }
+        if (mux_listen_socket >= 0) { close(mux_listen_socket); mux_listen_socket = -1; }
+    }
+    mux_io->destroy(mux_io);
+    printf("SVM Mux: Thread finished.\n");
     return NULL;
 }
 
 // --- Основная функция ---
-int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused))) {
+int main(int argc, char *argv[]) {
     // pthread_t timer_tid = 0; // Общий таймер УДАЛЕН
     pthread_t sender_tid = 0;
     // bool common_threads_started = false; // Флаг не совсем актуален в прежнем виде
@@ -285,13 +554,30 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
         // pthread_mutex_destroy(&svm_instances_mutex);
         exit(EXIT_FAILURE);
     }
-    num_svms_to_run = config.num_svm_configs_found;
+    // Срез экземпляров из командной строки (--instances A-B) перекрывает svm_instances из config.ini:
+    // так один config.ini раздается всем узлам эмуляции
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+            if (parse_instance_slice(argv[++i], &config.svm_instance_first, &config.svm_instance_count) != 0) {
+                fprintf(stderr, "SVM: Invalid --instances value '%s' (expected A-B). Exiting.\n", argv[i]);
+                destroy_svm_app_wide_resources();
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            printf("SVM: Warning: Unknown argument '%s' ignored.\n", argv[i]);
+        }
+    }
+    num_svms_to_run = 0;
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        if (config.svm_config_loaded[i] && config_instance_in_slice(&config, i)) num_svms_to_run++;
+    }
     if (num_svms_to_run == 0) { 
-        fprintf(stderr, "SVM: No SVM configurations found. Exiting.\n");
+        fprintf(stderr, "SVM: No SVM configurations found in the instance slice. Exiting.\n");
         destroy_svm_app_wide_resources();
         exit(EXIT_FAILURE);
      }
-    printf("SVM: Will attempt to start %d instances based on config.\n", num_svms_to_run);
+    printf("SVM: Will attempt to start %d instances based on config (slice from ID %d).\n",
+           num_svms_to_run, config.svm_instance_first);
 
     for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
         initialize_svm_instance(&svm_instances[i], i,
@@ -299,14 +585,34 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
                                 &config.svm_settings[i]);
         if (pthread_mutex_init(&svm_instances[i].instance_mutex, NULL) != 0) {
             perror("Failed to initialize instance mutex");
-            for (int j = 0; j < i; ++j) pthread_mutex_destroy(&svm_instances[j].instance_mutex);
+            for (int j = 0; j < i; ++j) {
+                pthread_mutex_destroy(&svm_instances[j].instance_mutex);
+                pthread_cond_destroy(&svm_instances[j].session_cond);
+            }
+            destroy_svm_app_wide_resources();
+            exit(EXIT_FAILURE);
+        }
+        if (pthread_cond_init(&svm_instances[i].session_cond, NULL) != 0) {
+            perror("Failed to initialize instance session condition");
+            for (int j = 0; j < i; ++j) pthread_cond_destroy(&svm_instances[j].session_cond);
+            for (int j = 0; j <= i; ++j) pthread_mutex_destroy(&svm_instances[j].instance_mutex);
             destroy_svm_app_wide_resources();
             // if (svm_outgoing_queue) qmq_destroy(svm_outgoing_queue); // Очередь еще не создана
             exit(EXIT_FAILURE);
         }
+        if (svm_params_init(&svm_instances[i].params) != 0) {
+            fprintf(stderr, "SVM: Failed to initialize parameter store for instance %d.\n", i);
+            for (int j = 0; j <= i; ++j) {
+                pthread_mutex_destroy(&svm_instances[j].instance_mutex);
+                pthread_cond_destroy(&svm_instances[j].session_cond);
+            }
+            for (int j = 0; j < i; ++j) svm_params_destroy(&svm_instances[j].params);
+            destroy_svm_app_wide_resources();
+            exit(EXIT_FAILURE);
+        }
         listen_sockets[i] = -1;
         listener_threads[i] = 0;
-        printf("DEBUG SVM MAIN - Instance %d Settings: LAK=0x%02X, simulate_control_failure=%d, "
+        if (config.svm_config_loaded[i]) printf("DEBUG SVM MAIN - Instance %d Settings: LAK=0x%02X, simulate_control_failure=%d, "
                "disconnect_after=%d, simulate_timeout=%d, send_warning=%d, tks=%u\n",
                i, svm_instances[i].assigned_lak, svm_instances[i].simulate_control_failure,
                svm_instances[i].disconnect_after_messages, svm_instances[i].simulate_response_timeout,
@@ -319,12 +625,29 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
         goto cleanup_instance_mutexes; 
     }
 
+    if (svm_processor_pool_start(config.svm_worker_threads) != 0) {
+        fprintf(stderr, "SVM: Failed to start processor pool.\n");
+        goto cleanup_outgoing_queue;
+    }
+    if (svm_scheduler_start() != 0) {
+        fprintf(stderr, "SVM: Failed to start scheduler.\n");
+        goto cleanup_outgoing_queue;
+    }
+    if (svm_counters_timer_start() != 0) {
+        goto cleanup_outgoing_queue;
+    }
+    if (config.tcp_info_interval_ms > 0) {
+        tcp_info_timer = svm_scheduler_schedule_periodic((unsigned)config.tcp_info_interval_ms, svm_sample_tcp_info, NULL);
+        if (!tcp_info_timer) fprintf(stderr, "SVM: Failed to register TCP_INFO sampling timer.\n");
+    }
+
     signal(SIGINT, handle_shutdown_signal);
     signal(SIGTERM, handle_shutdown_signal);
 
     int listeners_started = 0;
     for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
-        if (config.svm_config_loaded[i]) {
+        if (config.svm_config_loaded[i] && config_instance_in_slice(&config, i)) {
+            if (!svm_instance_warm_up(&svm_instances[i])) continue;
             ListenerArgs *args = malloc(sizeof(ListenerArgs));
             if (!args) { perror("SVM: Failed to allocate listener args"); continue; }
             args->svm_id = i;
@@ -334,12 +657,22 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
             if (pthread_create(&listener_threads[i], NULL, listener_thread_func, args) != 0) {
                 perror("SVM: Failed to create listener thread");
                 free(args);
+                svm_instance_release_standby(&svm_instances[i]);
             } else {
                 listeners_started++;
             }
         }
     }
 
+    if (config.mux_port > 0 || strcasecmp(config.interface_type, "serial") == 0) {
+        if (pthread_create(&mux_thread, NULL, mux_listener_thread_func, NULL) != 0) {
+            perror("SVM: Failed to create mux listener thread");
+            mux_thread = 0;
+        } else {
+            listeners_started++;
+        }
+    }
+
     if (listeners_started == 0) {
         fprintf(stderr, "SVM: Failed to start any listeners. Exiting.\n");
         goto cleanup_outgoing_queue;
@@ -371,7 +704,19 @@ cleanup_listeners_on_error: // Метка для случая, если sender 
             printf("SVM Main: Listener thread for SVM ID %d joined.\n", i);
         }
     }
+    if (mux_thread != 0) {
+        pthread_join(mux_thread, NULL);
+        printf("SVM Main: Mux listener thread joined.\n");
+    }
     printf("SVM Main: All listener threads joined.\n");
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) svm_instance_release_standby(&svm_instances[i]);
+    printf("SVM Main: Standby receiver threads joined.\n");
+    svm_processor_pool_stop();
+
+    svm_scheduler_cancel(tcp_info_timer);
+    tcp_info_timer = NULL;
+    svm_counters_timer_stop();
+    svm_scheduler_stop(); // Отложенные ответы больше некому отправлять
 
     if (sender_tid != 0) {
         if (svm_outgoing_queue && !svm_outgoing_queue->shutdown) {
@@ -382,11 +727,18 @@ cleanup_listeners_on_error: // Метка для случая, если sender 
     }
 
 cleanup_outgoing_queue:
+    keep_running = false; // Резервные Receiver'ы не должны ждать нового подключения
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) svm_instance_release_standby(&svm_instances[i]);
+    svm_scheduler_stop(); // Безопасно, если уже остановлен или не запускался
+    svm_processor_pool_stop();
+    svm_faults_cleanup();
     if (svm_outgoing_queue) qmq_destroy(svm_outgoing_queue);
 
 cleanup_instance_mutexes:
     for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
         pthread_mutex_destroy(&svm_instances[i].instance_mutex);
+        pthread_cond_destroy(&svm_instances[i].session_cond);
+        svm_params_destroy(&svm_instances[i].params);
     }
     // pthread_mutex_destroy(&svm_instances_mutex); // Глобальный мьютекс для массива не используется активно
     destroy_svm_app_wide_resources(); // Переименованная функция
@@ -0,0 +1,220 @@
+/*
+ * svm/svm_params.c
+ *
+ * Описание:
+ * Реализация хранилища параметров съемки с двумя наборами и активацией по NTSO.
+ * Поток-обработчик пишет только в staging (под staging_mutex), таймер экземпляра
+ * публикует staging как активный набор заменой указателя под тем же мьютексом.
+ * Прежний активный набор становится новым staging: читателей вне мьютекса нет,
+ * поэтому ждать перед его переиспользованием нечего.
+ */
+#include "svm_params.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../protocol/complex_convert.h"
+
+// Цикл target уже наступил (сравнение с учетом переполнения 16-битного счетчика)
+static inline bool params_ntso_reached(uint16_t current, uint16_t target) {
+    return (int16_t)(current - target) >= 0;
+}
+
+int svm_params_init(SvmParamStore *store) {
+    if (!store) return -1;
+    memset(store, 0, sizeof(SvmParamStore));
+
+    for (int i = 0; i < 2; ++i) {
+        if (posix_memalign((void**)&store->banks[i], 64, sizeof(SvmParamSet)) != 0) {
+            store->banks[i] = NULL;
+            fprintf(stderr, "svm_params_init: Failed to allocate parameter set (%zu bytes).\n", sizeof(SvmParamSet));
+            goto cleanup;
+        }
+        memset(store->banks[i], 0, sizeof(SvmParamSet));
+    }
+    if (posix_memalign((void**)&store->scratch, 64, MAX_MESSAGE_BODY_SIZE) != 0) {
+        store->scratch = NULL;
+        fprintf(stderr, "svm_params_init: Failed to allocate scratch buffer.\n");
+        goto cleanup;
+    }
+    if (pthread_mutex_init(&store->staging_mutex, NULL) != 0) {
+        perror("svm_params_init: mutex init failed");
+        goto cleanup;
+    }
+    store->active = store->banks[0];
+    store->staging = store->banks[1];
+    return 0;
+
+cleanup:
+    free(store->scratch); store->scratch = NULL;
+    free(store->banks[0]); store->banks[0] = NULL;
+    free(store->banks[1]); store->banks[1] = NULL;
+    return -1;
+}
+
+void svm_params_destroy(SvmParamStore *store) {
+    if (!store || !store->banks[0]) return;
+    pthread_mutex_destroy(&store->staging_mutex);
+    free(store->scratch); store->scratch = NULL;
+    free(store->banks[0]); store->banks[0] = NULL;
+    free(store->banks[1]); store->banks[1] = NULL;
+    store->active = NULL;
+    store->staging = NULL;
+}
+
+// Готовит staging к изменению (вызывается под staging_mutex).
+// Первое изменение после активации копирует в staging текущий активный набор,
+// чтобы частичная загрузка дополняла, а не заменяла действующие таблицы.
+static void params_begin_update(SvmParamStore *store) {
+    if (!store->staging_dirty) {
+        memcpy(store->staging, store->active, sizeof(SvmParamSet));
+        store->staging_dirty = true;
+    }
+    store->quiet_cycles = 0;
+}
+
+static int params_decode(SvmParamStore *store, SvmParamSet *set, const Message *msg) {
+    size_t body_len = msg->header.body_length;
+
+    switch (msg->header.message_type) {
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_SO:
+            if (body_len < sizeof(PrinyatParametrySoBody)) return -1;
+            memcpy(&set->so, msg->body, sizeof(set->so));
+            set->valid_mask |= SVM_PARAM_SO;
+            return 0;
+
+        case MESSAGE_TYPE_PRIYAT_TIME_REF_RANGE: {
+            if (body_len < sizeof(PrinyatTimeRefRangeBody)) return -1;
+            const PrinyatTimeRefRangeBody *body = (const PrinyatTimeRefRangeBody*)msg->body;
+            complex_i8_to_planes_f32(body->time_ref_range, TIME_REF_RANGE_ELEMENTS, set->time_ref_re, set->time_ref_im);
+            set->valid_mask |= SVM_PARAM_TIME_REF;
+            return 0;
+        }
+
+        case MESSAGE_TYPE_PRIYAT_REPER:
+            if (body_len < sizeof(PrinyatReperBody)) return -1;
+            memcpy(&set->reper, msg->body, sizeof(set->reper));
+            set->valid_mask |= SVM_PARAM_REPER;
+            return 0;
+
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_SDR: {
+            if (body_len < sizeof(PrinyatParametrySdrBodyBase)) return -1;
+            memcpy(&set->sdr, msg->body, sizeof(set->sdr));
+            size_t avail = (body_len - sizeof(PrinyatParametrySdrBodyBase)) / sizeof(complex_fixed16_t);
+            size_t count = set->sdr.mrr < avail ? set->sdr.mrr : avail;
+            if (count > MAX_SDR_HRR_ELEMENTS) count = MAX_SDR_HRR_ELEMENTS;
+            // HRR идет сразу за базовой частью и может быть не выровнен - копируем в scratch
+            memcpy(store->scratch, msg->body + sizeof(PrinyatParametrySdrBodyBase), count * sizeof(complex_fixed16_t));
+            complex_i16_to_planes_f32(store->scratch, count, set->hrr_re, set->hrr_im);
+            set->hrr_count = (uint16_t)count;
+            set->valid_mask |= SVM_PARAM_SDR;
+            return 0;
+        }
+
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_3TSO:
+            if (body_len < sizeof(PrinyatParametry3TsoBody)) return -1;
+            memcpy(&set->tso3, msg->body, sizeof(set->tso3));
+            set->valid_mask |= SVM_PARAM_3TSO;
+            return 0;
+
+        case MESSAGE_TYPE_PRIYAT_REF_AZIMUTH: {
+            if (body_len < sizeof(PrinyatRefAzimuthBody)) return -1;
+            const PrinyatRefAzimuthBody *body = (const PrinyatRefAzimuthBody*)msg->body;
+            // ref_azimuth[512][16][2]: пары {imag, real} в формате complex_fixed16_t
+            complex_i16_to_planes_f32((const complex_fixed16_t*)body->ref_azimuth,
+                                      SVM_PARAMS_REF_AZ_ROWS * SVM_PARAMS_REF_AZ_COLS,
+                                      &set->ref_az_re[0][0], &set->ref_az_im[0][0]);
+            set->ref_az_ntso = body->NTSO;
+            set->valid_mask |= SVM_PARAM_REF_AZ;
+            return 0;
+        }
+
+        case MESSAGE_TYPE_PRIYAT_PARAMETRY_TSD: {
+            if (body_len < sizeof(PrinyatParametryTsdBodyBase)) return -1;
+            PrinyatParametryTsdBodyBase base;
+            memcpy(&base, msg->body, sizeof(base));
+            size_t har_count = (size_t)base.nar * base.nin;
+            size_t need = sizeof(base) + base.nout + base.nin + har_count * sizeof(complex_fixed16_t);
+            if (base.nout > SVM_PARAMS_MAX_TSD_ROWS || base.nin > SVM_PARAMS_MAX_TSD_ROWS ||
+                har_count > SVM_PARAMS_MAX_HAR_ELEMENTS || need > body_len) {
+                return -1;
+            }
+            const uint8_t *p = msg->body + sizeof(base);
+            set->tsd = base;
+            memcpy(set->tsd_okm, p, base.nout);
+            p += base.nout;
+            memcpy(set->tsd_hshmr, p, base.nin);
+            p += base.nin;
+            memcpy(store->scratch, p, har_count * sizeof(complex_fixed16_t));
+            complex_i16_to_planes_f32(store->scratch, har_count, set->har_re, set->har_im);
+            set->har_count = (uint32_t)har_count;
+            set->valid_mask |= SVM_PARAM_TSD;
+            return 0;
+        }
+
+        default:
+            return -1;
+    }
+}
+
+int svm_params_apply_message(SvmParamStore *store, const Message *msg) {
+    if (!store || !store->staging || !msg) return -1;
+
+    pthread_mutex_lock(&store->staging_mutex);
+    bool was_dirty = store->staging_dirty;
+    params_begin_update(store);
+    int rc = params_decode(store, store->staging, msg);
+    if (rc != 0) {
+        store->staging_dirty = was_dirty; // Некорректная таблица не должна инициировать активацию
+    } else {
+        int slot = param_signature_slot(msg->header.message_type);
+        if (slot >= 0) { // Хеш тела в порядке линии - как его считает УВМ (scratch под staging_mutex свободен)
+            store->staging->table_hash[slot] = param_table_hash_host(msg->header.message_type, msg->body,
+                                                                     msg->header.body_length, (uint8_t*)store->scratch);
+        }
+        if (msg->header.message_type == MESSAGE_TYPE_PRIYAT_REF_AZIMUTH) {
+            store->staging_has_ntso = true;
+            store->staging_ntso = store->staging->ref_az_ntso;
+        }
+    }
+    pthread_mutex_unlock(&store->staging_mutex);
+    return rc;
+}
+
+uint32_t svm_params_signature(SvmParamStore *store) {
+    if (!store || !store->staging) return 0;
+    pthread_mutex_lock(&store->staging_mutex);
+    const SvmParamSet *set = store->staging_dirty ? store->staging : store->active;
+    uint32_t signature = param_signature(set->table_hash);
+    pthread_mutex_unlock(&store->staging_mutex);
+    return signature;
+}
+
+void svm_params_cycle_tick(SvmParamStore *store) {
+    if (!store || !store->staging) return;
+    uint16_t current = (uint16_t)(store->current_ntso + 1);
+    __atomic_store_n(&store->current_ntso, current, __ATOMIC_RELEASE);
+
+    // Идет декодирование большой таблицы - переключение откладывается до следующего цикла
+    if (pthread_mutex_trylock(&store->staging_mutex) != 0) return;
+
+    if (store->staging_dirty) {
+        if (store->quiet_cycles < UINT16_MAX) store->quiet_cycles++;
+        bool activate = store->staging_has_ntso ? params_ntso_reached(current, store->staging_ntso)
+                                                : (store->quiet_cycles > SVM_PARAMS_QUIET_CYCLES);
+        if (activate) {
+            SvmParamSet *next = store->staging;
+            SvmParamSet *prev = store->active;
+            next->generation = prev->generation + 1;
+            next->activated_ntso = current;
+            store->active = next;
+            store->staging = prev;
+            store->staging_dirty = false;
+            store->staging_has_ntso = false;
+            __atomic_add_fetch(&store->activations, 1, __ATOMIC_RELAXED);
+            printf("SvmParams: Activated parameter set #%u at NTSO %u (tables mask 0x%02X).\n",
+                   next->generation, current, next->valid_mask);
+        }
+    }
+    pthread_mutex_unlock(&store->staging_mutex);
+}
@@ -0,0 +1,120 @@
+/*
+ * svm/svm_params.h
+ *
+ * Описание:
+ * Хранилище параметров съемки одного экземпляра СВ-М.
+ * Принятые таблицы (СО, СДР+HRR, 3ЦО, ЦДР, TIME_REF_RANGE, Reper, REF_AZIMUTH)
+ * декодируются в выровненные наборы, готовые к использованию
+ * (комплексные массивы - раздельными плоскостями float).
+ * Наборов два: активный (только чтение) и собираемый (staging).
+ * Новый набор становится активным целиком на границе цикла обзора:
+ *  - в цикле NTSO, указанном в «Принять REF_AZIMUTH»;
+ *  - если NTSO не задан - после SVM_PARAMS_QUIET_CYCLES циклов без новых таблиц
+ *    (загрузка из нескольких сообщений не разрывается).
+ * Активный набор публикуется заменой указателя под staging_mutex; читатели (подпись набора)
+ * обращаются к нему под тем же мьютексом, поэтому не видят частично обновленный набор.
+ */
+#ifndef SVM_PARAMS_H
+#define SVM_PARAMS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "../protocol/protocol_defs.h"
+#include "../protocol/message_utils.h"
+
+// Число циклов обзора без новых таблиц, после которого набор без NTSO активируется
+#define SVM_PARAMS_QUIET_CYCLES 1
+// Размеры таблиц в наборе
+#define SVM_PARAMS_REF_AZ_ROWS 512
+#define SVM_PARAMS_REF_AZ_COLS 16
+#define SVM_PARAMS_MAX_TSD_ROWS 8192                                          // Максимум Nin / Nout
+#define SVM_PARAMS_MAX_HAR_ELEMENTS (MAX_MESSAGE_BODY_SIZE / sizeof(complex_fixed16_t)) // Максимум NAR*Nin
+
+// Биты valid_mask: какие таблицы присутствуют в наборе
+#define SVM_PARAM_SO        (1u << 0)
+#define SVM_PARAM_TIME_REF  (1u << 1)
+#define SVM_PARAM_REPER     (1u << 2)
+#define SVM_PARAM_SDR       (1u << 3)
+#define SVM_PARAM_3TSO      (1u << 4)
+#define SVM_PARAM_REF_AZ    (1u << 5)
+#define SVM_PARAM_TSD       (1u << 6)
+
+// Один набор параметров (выделяется с выравниванием 64 байта)
+typedef struct {
+    uint32_t valid_mask;
+    uint32_t generation;          // Порядковый номер активации
+    uint16_t activated_ntso;      // Цикл обзора, в котором набор стал активным
+    uint32_t table_hash[PARAM_SIGNATURE_TABLES]; // Хеши принятых таблиц (для подписи набора)
+
+    PrinyatParametrySoBody so;
+    PrinyatReperBody reper;
+    PrinyatParametrySdrBodyBase sdr;
+    PrinyatParametry3TsoBody tso3;
+    PrinyatParametryTsdBodyBase tsd;
+    uint16_t ref_az_ntso;         // NTSO из «Принять REF_AZIMUTH»
+    uint16_t hrr_count;           // Количество элементов HRR
+    uint32_t har_count;           // Количество элементов HAR (NAR * Nin)
+
+    float time_ref_re[TIME_REF_RANGE_ELEMENTS] __attribute__((aligned(64)));
+    float time_ref_im[TIME_REF_RANGE_ELEMENTS] __attribute__((aligned(64)));
+    float ref_az_re[SVM_PARAMS_REF_AZ_ROWS][SVM_PARAMS_REF_AZ_COLS] __attribute__((aligned(64)));
+    float ref_az_im[SVM_PARAMS_REF_AZ_ROWS][SVM_PARAMS_REF_AZ_COLS] __attribute__((aligned(64)));
+    float hrr_re[MAX_SDR_HRR_ELEMENTS] __attribute__((aligned(64)));
+    float hrr_im[MAX_SDR_HRR_ELEMENTS] __attribute__((aligned(64)));
+    int8_t tsd_okm[SVM_PARAMS_MAX_TSD_ROWS] __attribute__((aligned(64)));
+    uint8_t tsd_hshmr[SVM_PARAMS_MAX_TSD_ROWS] __attribute__((aligned(64)));
+    float har_re[SVM_PARAMS_MAX_HAR_ELEMENTS] __attribute__((aligned(64)));
+    float har_im[SVM_PARAMS_MAX_HAR_ELEMENTS] __attribute__((aligned(64)));
+} SvmParamSet;
+
+// Хранилище параметров одного экземпляра
+typedef struct {
+    SvmParamSet *banks[2];
+    SvmParamSet *active;              // Активный набор
+    SvmParamSet *staging;             // Собираемый набор
+
+    pthread_mutex_t staging_mutex;    // Защищает active, staging и поля ниже
+    bool staging_dirty;               // В staging есть непримененные таблицы
+    bool staging_has_ntso;            // Для staging задан цикл активации
+    uint16_t staging_ntso;
+    uint16_t quiet_cycles;            // Циклов подряд без новых таблиц
+    complex_fixed16_t *scratch;       // Выровненный буфер для декодирования массивов
+
+    volatile uint16_t current_ntso;   // Номер текущего цикла обзора
+    volatile uint32_t activations;    // Счетчик переключений наборов
+} SvmParamStore;
+
+/**
+ * @brief Выделяет наборы и инициализирует хранилище.
+ * @return 0 в случае успеха, -1 в случае ошибки.
+ */
+int svm_params_init(SvmParamStore *store);
+
+/**
+ * @brief Освобождает наборы хранилища.
+ */
+void svm_params_destroy(SvmParamStore *store);
+
+/**
+ * @brief Декодирует сообщение с таблицей (порядок байт хоста) в собираемый набор.
+ * Вызывается потоком-обработчиком; не ждет границы цикла.
+ * @return 0 в случае успеха, -1 если сообщение некорректно или тип не поддерживается.
+ */
+int svm_params_apply_message(SvmParamStore *store, const Message *msg);
+
+/**
+ * @brief Отмечает начало нового цикла обзора и при необходимости активирует собранный набор.
+ * Вызывается таймером экземпляра; не блокируется на загрузке (использует trylock).
+ */
+void svm_params_cycle_tick(SvmParamStore *store);
+
+/**
+ * @brief Подпись последнего принятого набора (собираемого, если в нем есть непримененные
+ * таблицы, иначе активного). Сообщается УВМ в «Подтверждении инициализации»,
+ * чтобы после переподключения не загружать неизменные параметры повторно.
+ * @return Подпись или 0, если таблицы не принимались.
+ */
+uint32_t svm_params_signature(SvmParamStore *store);
+
+#endif // SVM_PARAMS_H
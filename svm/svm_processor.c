@@ -2,121 +2,288 @@
  * svm/svm_processor.c
  *
  * Описание:
- * Реализация потока-обработчика для ОДНОГО экземпляра SVM.
- * Читает сообщения из входящей очереди экземпляра, вызывает обработчик
- * и помещает ответ (если есть) в ОБЩУЮ исходящую очередь.
- * ВРЕМЕННАЯ РЕАЛИЗАЦИЯ: 1 поток на 1 экземпляр.
+ * Общий пул потоков-обработчиков для всех экземпляров SVM.
+ * Когда Receiver подтверждает сообщение во входящей очереди экземпляра, экземпляр
+ * ставится в очередь готовых одного из потоков пула (по ID экземпляра). Поток
+ * обрабатывает до SVM_PROCESSOR_BATCH сообщений экземпляра, вызывая обработчики,
+ * и формирует ответы прямо в слотах ОБЩЕЙ исходящей очереди. Поток без работы
+ * забирает готовые экземпляры из чужих очередей (с конца), свои берет с начала.
+ * Экземпляр находится не более чем в одной очереди и обрабатывается не более
+ * чем одним потоком (флаг proc_scheduled), поэтому порядок его сообщений сохраняется.
  */
 #include <stdio.h>
-#include <stdlib.h> // Для free, malloc
+#include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <stdbool.h>
-#include <string.h> // Для memcpy
-#include <arpa/inet.h>
 #include "../protocol/protocol_defs.h"
 #include "../protocol/message_utils.h"
-#include "../utils/ts_queue.h"
 #include "../utils/ts_queued_msg_queue.h"
 #include "svm_handlers.h"
-#include "svm_timers.h" // Для global_timer_keep_running
+#include "svm_processor.h"
+#include "svm_faults.h"
 #include "svm_types.h"  // Для SvmInstance, QueuedMessage
 
 // Внешние переменные (доступны из main)
 extern ThreadSafeQueuedMsgQueue *svm_outgoing_queue; // Общая исходящая очередь
-// extern SvmInstance svm_instances[MAX_SVM_INSTANCES]; // Не нужен прямой доступ к массиву здесь
-extern volatile bool global_timer_keep_running; // Глобальный флаг остановки
 
-void* processor_thread_func(void* arg) {
-    SvmInstance *instance = (SvmInstance*)arg;
-     if (!instance || !instance->incoming_queue) {
-         fprintf(stderr,"Processor Thread (Inst %d): Invalid arguments or instance not properly initialized.\n", instance ? instance->id : -1);
-         return NULL;
-     }
+// Поток пула и его очередь готовых экземпляров
+typedef struct {
+    pthread_mutex_t mutex SVM_CACHE_ALIGNED; // Защищает ready/head/count
+    SvmInstance *ready[MAX_SVM_INSTANCES];    // Кольцо готовых экземпляров
+    int head;
+    int count;               // Пишется под mutex, читается ворами без блокировки
+    int index;
+    pthread_t tid;
+    unsigned long processed; // Обработано сообщений
+    unsigned long stolen;    // Экземпляров забрано у других потоков
+} SvmProcessorWorker;
 
-    printf("SVM Processor thread started for instance %d.\n", instance->id);
-    QueuedMessage processing_q_msg; // Структура для извлеченного сообщения + ID
+static SvmProcessorWorker pool_workers[SVM_PROCESSOR_MAX_WORKERS];
+static int pool_num_workers = 0;
+static bool pool_running = false;   // Под pool_mutex
+static int pool_queued = 0;         // Экземпляров во всех очередях готовых (__atomic)
+static int pool_idle = 0;           // Потоков, ждущих работу (__atomic)
+static int pool_detach_waiters = 0; // Потоков в svm_processor_detach (__atomic)
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work_cond = PTHREAD_COND_INITIALIZER;     // Появилась работа / остановка
+static pthread_cond_t pool_released_cond = PTHREAD_COND_INITIALIZER; // Экземпляр отпущен пулом
+static __thread int pool_current_worker = -1; // Индекс потока пула, -1 вне пула
+
+// Добавляет экземпляр в конец очереди готовых потока w и будит ждущий поток
+static void pool_push(int w, SvmInstance *instance) {
+    SvmProcessorWorker *worker = &pool_workers[w];
+    pthread_mutex_lock(&worker->mutex);
+    worker->ready[(worker->head + worker->count) % MAX_SVM_INSTANCES] = instance;
+    __atomic_store_n(&worker->count, worker->count + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&worker->mutex);
+
+    __atomic_add_fetch(&pool_queued, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool_idle, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool_mutex);
+        pthread_cond_signal(&pool_work_cond);
+        pthread_mutex_unlock(&pool_mutex);
+    }
+}
+
+// Берет самый старый экземпляр из своей очереди
+static SvmInstance* pool_pop_own(SvmProcessorWorker *worker) {
+    SvmInstance *instance = NULL;
+    if (__atomic_load_n(&worker->count, __ATOMIC_ACQUIRE) == 0) return NULL;
+    pthread_mutex_lock(&worker->mutex);
+    if (worker->count > 0) {
+        instance = worker->ready[worker->head];
+        worker->head = (worker->head + 1) % MAX_SVM_INSTANCES;
+        __atomic_store_n(&worker->count, worker->count - 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    if (instance) __atomic_sub_fetch(&pool_queued, 1, __ATOMIC_SEQ_CST);
+    return instance;
+}
+
+// Забирает самый новый экземпляр из очереди другого потока
+static SvmInstance* pool_steal(SvmProcessorWorker *thief) {
+    for (int k = 1; k < pool_num_workers; ++k) {
+        SvmProcessorWorker *victim = &pool_workers[(thief->index + k) % pool_num_workers];
+        if (__atomic_load_n(&victim->count, __ATOMIC_ACQUIRE) == 0) continue;
+        SvmInstance *instance = NULL;
+        pthread_mutex_lock(&victim->mutex);
+        if (victim->count > 0) {
+            int last = victim->count - 1;
+            instance = victim->ready[(victim->head + last) % MAX_SVM_INSTANCES];
+            __atomic_store_n(&victim->count, last, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&victim->mutex);
+        if (instance) {
+            __atomic_sub_fetch(&pool_queued, 1, __ATOMIC_SEQ_CST);
+            thief->stolen++;
+            return instance;
+        }
+    }
+    return NULL;
+}
+
+// Ставит экземпляр в очередь готовых, если он еще не стоит в ней и не обрабатывается
+static void pool_schedule(SvmInstance *instance) {
+    __atomic_store_n(&instance->proc_pending, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&instance->proc_scheduled, 1, __ATOMIC_SEQ_CST)) return;
+    int w = (pool_current_worker >= 0) ? pool_current_worker : instance->id % pool_num_workers;
+    pool_push(w, instance);
+}
+
+// Уведомление входящей очереди экземпляра о новом сообщении (поток Receiver'а)
+static void pool_on_incoming_ready(void *arg) {
+    pool_schedule((SvmInstance*)arg);
+}
+
+// Обрабатывает одно сообщение экземпляра; слот освобождает вызывающий
+static void process_message(SvmInstance *instance, QueuedMessage *request_slot) {
+    // Проверяем ID на всякий случай (хотя читаем из очереди экземпляра)
+    if (request_slot->instance_id != instance->id) {
+        fprintf(stderr, "Processor (Inst %d): Mismatched instance ID %d in instance queue. Message dropped.\n",
+                instance->id, request_slot->instance_id);
+        return;
+    }
+
+    const Message *request = &request_slot->message;
+    uint8_t type = request->header.message_type;
+    MessageHandler handler = message_handlers[type];
+
+    if (handler == NULL) {
+        printf("Processor (Inst %d): Unknown message type: %u (number %u)\n",
+               instance->id, type, get_full_message_number(&request->header));
+    } else if (!message_handler_replies[type]) {
+        handler(instance, request, NULL); // Обработчик без ответа
+    } else {
+        // Ответ формируется прямо в слоте ОБЩЕЙ ИСХОДЯЩЕЙ очереди: без malloc и промежуточной копии
+        QueuedMessage *reply_slot = qmq_reserve(svm_outgoing_queue);
+        if (!reply_slot) {
+            // Исходящая очередь закрыта (глобальное завершение)
+            fprintf(stderr, "Processor (Inst %d): Failed to reserve response slot (type %u) in global outgoing queue.\n",
+                    instance->id, type);
+            return;
+        }
+        reply_slot->instance_id = instance->id; // Сохраняем ID экземпляра-отправителя
+        if (handler(instance, request, &reply_slot->message)) {
+            svm_faults_submit(instance, reply_slot); // Подтверждает слот или применяет профиль сбоев
+        } else {
+            qmq_cancel(svm_outgoing_queue, reply_slot); // Ответа нет (имитация сбоя)
+        }
+    }
+}
+
+// Обрабатывает пачку сообщений экземпляра и отпускает его (или оставляет за собой)
+static void process_instance(SvmProcessorWorker *worker, SvmInstance *instance) {
+    __atomic_store_n(&instance->proc_pending, 0, __ATOMIC_SEQ_CST);
+    int processed = 0;
+    while (processed < SVM_PROCESSOR_BATCH) {
+        QueuedMessage *slot = qmq_try_dequeue_begin(instance->incoming_queue);
+        if (!slot) break;
+        process_message(instance, slot);
+        qmq_dequeue_end(instance->incoming_queue);
+        processed++;
+    }
+    worker->processed += processed;
+
+    if (processed == SVM_PROCESSOR_BATCH) {
+        // Вероятно, есть еще: экземпляр остается запланированным и встает в конец своей очереди
+        pool_push(worker->index, instance);
+        return;
+    }
+    __atomic_store_n(&instance->proc_scheduled, 0, __ATOMIC_SEQ_CST);
+    // Сообщение пришло после последней проверки, а Receiver видел экземпляр занятым
+    if (__atomic_load_n(&instance->proc_pending, __ATOMIC_SEQ_CST) &&
+        !__atomic_exchange_n(&instance->proc_scheduled, 1, __ATOMIC_SEQ_CST)) {
+        pool_push(worker->index, instance);
+        return;
+    }
+    if (__atomic_load_n(&pool_detach_waiters, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool_mutex);
+        pthread_cond_broadcast(&pool_released_cond);
+        pthread_mutex_unlock(&pool_mutex);
+    }
+}
+
+static void* pool_worker_func(void *arg) {
+    SvmProcessorWorker *worker = (SvmProcessorWorker*)arg;
+    pool_current_worker = worker->index;
+    printf("SVM Processor worker %d started.\n", worker->index);
 
     while (true) {
-        // Пытаемся извлечь сообщение из ВХОДЯЩЕЙ очереди ЭТОГО экземпляра
-        if (!qmq_dequeue(instance->incoming_queue, &processing_q_msg)) {
-            // Очередь пуста и закрыта (Receiver завершился или shutdown из main)
-            // Проверяем глобальный флаг или активность экземпляра (хотя is_active может быть неактуально, если main вызвал shutdown)
-            if (!global_timer_keep_running || instance->incoming_queue->shutdown) {
-                 printf("Processor Thread (Inst %d): Incoming queue empty and shutdown. Exiting.\n", instance->id);
-                 break; // Корректный выход
-            }
-            // В противном случае это может быть ложное пробуждение, просто продолжаем
-            usleep(10000);
+        SvmInstance *instance = pool_pop_own(worker);
+        if (!instance) instance = pool_steal(worker);
+        if (instance) {
+            process_instance(worker, instance);
             continue;
         }
 
-        // Сообщение успешно извлечено
-        // Проверяем ID на всякий случай (хотя читаем из очереди экземпляра)
-        if (processing_q_msg.instance_id != instance->id) {
-            fprintf(stderr, "Processor Thread (Inst %d): FATAL: Mismatched instance ID %d in instance queue.\n", instance->id, processing_q_msg.instance_id);
-            break; // Ошибка логики
+        pthread_mutex_lock(&pool_mutex);
+        __atomic_add_fetch(&pool_idle, 1, __ATOMIC_SEQ_CST);
+        while (pool_running && __atomic_load_n(&pool_queued, __ATOMIC_SEQ_CST) <= 0) {
+            pthread_cond_wait(&pool_work_cond, &pool_mutex);
         }
+        __atomic_sub_fetch(&pool_idle, 1, __ATOMIC_SEQ_CST);
+        bool stop = !pool_running;
+        pthread_mutex_unlock(&pool_mutex);
+        if (stop) break;
+    }
 
-        MessageHandler handler = message_handlers[processing_q_msg.message.header.message_type];
-        Message* responseMessagePtr = NULL; // Указатель на ответное сообщение (malloc'нутое)
+    printf("SVM Processor worker %d finished (processed %lu messages, stole %lu instances).\n",
+           worker->index, worker->processed, worker->stolen);
+    return NULL;
+}
 
-        if (handler != NULL) {
-            // Вызываем обработчик, передавая ему указатель на ЭКЗЕМПЛЯР и СООБЩЕНИЕ
-            responseMessagePtr = handler(instance, &processing_q_msg.message);
-        } else {
-            printf("Processor Thread (Inst %d): Unknown message type: %u (number %u)\n",
-                   instance->id,
-                   processing_q_msg.message.header.message_type,
-                   get_full_message_number(&processing_q_msg.message.header));
-        }
+int svm_processor_pool_start(int num_workers) {
+    if (num_workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = (cpus > 0) ? (int)cpus : 1;
+    }
+    if (num_workers > SVM_PROCESSOR_MAX_WORKERS) num_workers = SVM_PROCESSOR_MAX_WORKERS;
+
+    for (int i = 0; i < num_workers; ++i) {
+        SvmProcessorWorker *worker = &pool_workers[i];
+        pthread_mutex_init(&worker->mutex, NULL);
+        worker->head = 0;
+        worker->count = 0;
+        worker->index = i;
+        worker->processed = 0;
+        worker->stolen = 0;
+    }
+    pool_queued = 0;
+    pool_running = true;
+    pool_num_workers = num_workers;
 
-        // Если обработчик вернул ответное сообщение
-        if (responseMessagePtr != NULL) {
-            // Создаем QueuedMessage для ответа
-            QueuedMessage response_q_msg;
-            response_q_msg.instance_id = instance->id; // Сохраняем ID экземпляра-отправителя
-
-            // Копируем данные из responseMessagePtr в response_q_msg.message
-            // Проверяем размер перед копированием на всякий случай
-            uint16_t resp_body_len_host = ntohs(responseMessagePtr->header.body_length);
-            size_t resp_message_size = sizeof(MessageHeader) + resp_body_len_host;
-             if (resp_message_size > sizeof(Message)) {
-                 fprintf(stderr,"Processor Thread (Inst %d): ERROR: Response message size %zu exceeds buffer size %zu\n",
-                         instance->id, resp_message_size, sizeof(Message));
-                 // Можно либо обрезать, либо не отправлять. Пока копируем как есть.
-                  memcpy(&response_q_msg.message, responseMessagePtr, sizeof(Message));
-             } else {
-                  memcpy(&response_q_msg.message, responseMessagePtr, resp_message_size);
-                  // Опционально: обнулить остаток тела сообщения в response_q_msg.message.body
-                  // memset(response_q_msg.message.body + resp_body_len_host, 0, MAX_MESSAGE_BODY_SIZE - resp_body_len_host);
-             }
-             // Убедимся, что заголовок скопирован корректно
-             response_q_msg.message.header = responseMessagePtr->header;
-
-
-            free(responseMessagePtr); // Освобождаем память, выделенную в handler'е
-
-            // Помещаем ответ в ОБЩУЮ ИСХОДЯЩУЮ очередь
-            if (!qmq_enqueue(svm_outgoing_queue, &response_q_msg)) {
-                fprintf(stderr, "Processor Thread (Inst %d): Failed to enqueue response (type %u) to global outgoing queue.\n",
-                       instance->id, response_q_msg.message.header.message_type);
-                // Если не удалось поместить в исходящую очередь, она может быть закрыта (глобальное завершение)
-                if (global_timer_keep_running) {
-                    // Это неожиданно, если мы еще работаем. Сигнализируем о завершении?
-                    // Пока просто выходим из потока экземпляра.
-                     fprintf(stderr, "Processor Thread (Inst %d): Assuming global shutdown. Exiting.\n", instance->id);
-                }
-                break; // Выходим из цикла
-            }
-             //else {
-             //    printf("Processor (Inst %d): Enqueued response type %u to outgoing queue\n", instance->id, response_q_msg.message.header.message_type);
-             //}
+    for (int i = 0; i < num_workers; ++i) {
+        if (pthread_create(&pool_workers[i].tid, NULL, pool_worker_func, &pool_workers[i]) != 0) {
+            perror("SVM Processor: Failed to create worker thread");
+            // Останавливаем уже запущенные
+            pthread_mutex_lock(&pool_mutex);
+            pool_running = false;
+            pthread_cond_broadcast(&pool_work_cond);
+            pthread_mutex_unlock(&pool_mutex);
+            for (int j = 0; j < i; ++j) pthread_join(pool_workers[j].tid, NULL);
+            for (int j = 0; j < num_workers; ++j) pthread_mutex_destroy(&pool_workers[j].mutex);
+            pool_num_workers = 0;
+            return -1;
         }
-        // Если responseMessagePtr == NULL, ничего не делаем
-     } // end while
+    }
+    printf("SVM Processor pool started with %d worker(s).\n", num_workers);
+    return 0;
+}
+
+void svm_processor_pool_stop(void) {
+    if (pool_num_workers == 0) return;
+    pthread_mutex_lock(&pool_mutex);
+    pool_running = false;
+    pthread_cond_broadcast(&pool_work_cond);
+    pthread_cond_broadcast(&pool_released_cond);
+    pthread_mutex_unlock(&pool_mutex);
+
+    for (int i = 0; i < pool_num_workers; ++i) {
+        pthread_join(pool_workers[i].tid, NULL);
+        pthread_mutex_destroy(&pool_workers[i].mutex);
+    }
+    printf("SVM Processor pool stopped (%d worker(s)).\n", pool_num_workers);
+    pool_num_workers = 0;
+}
+
+void svm_processor_attach(SvmInstance *instance) {
+    if (!instance || !instance->incoming_queue) return;
+    instance->proc_scheduled = 0;
+    instance->proc_pending = 0;
+    qmq_set_ready_callback(instance->incoming_queue, pool_on_incoming_ready, instance);
+}
 
-     printf("SVM Processor thread finished for instance %d.\n", instance->id);
-     // НЕ закрываем здесь общую исходящую очередь, это делает main
-     return NULL;
-}
\ No newline at end of file
+void svm_processor_detach(SvmInstance *instance) {
+    if (!instance) return;
+    pthread_mutex_lock(&pool_mutex);
+    __atomic_add_fetch(&pool_detach_waiters, 1, __ATOMIC_SEQ_CST);
+    while (pool_running &&
+           (__atomic_load_n(&instance->proc_scheduled, __ATOMIC_SEQ_CST) ||
+            __atomic_load_n(&instance->proc_pending, __ATOMIC_SEQ_CST))) {
+        pthread_cond_wait(&pool_released_cond, &pool_mutex);
+    }
+    __atomic_sub_fetch(&pool_detach_waiters, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool_mutex);
+    if (instance->incoming_queue) qmq_set_ready_callback(instance->incoming_queue, NULL, NULL);
+}
@@ -0,0 +1,45 @@
+/*
+ * svm/svm_processor.h
+ *
+ * Описание:
+ * Общий пул потоков-обработчиков входящих сообщений всех экземпляров СВ-М.
+ * Входящая очередь экземпляра служит его почтовым ящиком: экземпляр с готовыми
+ * сообщениями ставится в очередь одного из обработчиков и в каждый момент
+ * обрабатывается только одним потоком, поэтому порядок сообщений каждого СВ-М
+ * сохраняется. Свободный обработчик забирает готовые экземпляры у занятых.
+ */
+#ifndef SVM_PROCESSOR_H
+#define SVM_PROCESSOR_H
+
+#include "svm_types.h"
+
+// Наибольшее число потоков пула
+#define SVM_PROCESSOR_MAX_WORKERS 64
+// Сколько сообщений экземпляра обрабатывается подряд, прежде чем он уступит поток другим
+#define SVM_PROCESSOR_BATCH 16
+
+/**
+ * @brief Запускает пул обработчиков.
+ * @param num_workers Число потоков; 0 - по числу процессоров.
+ * @return 0 при успехе, -1 при ошибке.
+ */
+int svm_processor_pool_start(int num_workers);
+
+/**
+ * @brief Останавливает пул и ждет завершения его потоков. Безопасно, если пул не запускался.
+ * Экземпляры к этому моменту должны быть отключены (svm_processor_detach).
+ */
+void svm_processor_pool_stop(void);
+
+/**
+ * @brief Подключает входящую очередь экземпляра к пулу (до запуска Receiver'а).
+ */
+void svm_processor_attach(SvmInstance *instance);
+
+/**
+ * @brief Ждет, пока пул обработает все готовые сообщения экземпляра и отпустит его.
+ * Вызывается после завершения Receiver'а, перед уничтожением входящей очереди.
+ */
+void svm_processor_detach(SvmInstance *instance);
+
+#endif // SVM_PROCESSOR_H
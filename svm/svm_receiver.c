@@ -4,7 +4,8 @@
  * Описание:
  * Реализация потока-приемника для ОДНОГО экземпляра SVM.
  * Читает сообщения из сети и помещает их во входящую очередь экземпляра.
- * ВРЕМЕННАЯ РЕАЛИЗАЦИЯ: 1 поток на 1 экземпляр.
+ * Поток создается один раз при запуске и между подключениями ждет в горячем
+ * резерве (SESSION_STANDBY): listener лишь передает ему новый сокет.
  */
 #include <stdio.h>
 #include <pthread.h>
@@ -14,35 +15,41 @@
 #include "../io/io_common.h"
 #include "../utils/ts_queue.h"
 #include "../utils/ts_queued_msg_queue.h"
-#include "svm_timers.h" // Для global_timer_keep_running (как внешний флаг)
 #include "svm_types.h"  // Для SvmInstance, QueuedMessage
 #include <stdbool.h>
 
 // Внешняя переменная (общий флаг работы svm_app)
-// extern volatile bool global_timer_keep_running; // Если вы переименовали в svm_main.c
 extern volatile bool keep_running; // Используем имя из svm_main.c
 
 // extern pthread_mutex_t svm_instances_mutex; // Это было для глобального мьютекса,
                                              // который мы решили не использовать для is_active
 
-void* receiver_thread_func(void* arg) {
-    SvmInstance *instance = (SvmInstance*)arg;
-    if (!instance || instance->client_handle < 0 || !instance->io_handle || !instance->incoming_queue) {
-         fprintf(stderr,"Receiver Thread (Inst %d): Invalid arguments or instance not properly initialized.\n", instance ? instance->id : -1);
-         return NULL;
+// Прием сообщений одного подключения УВМ
+static void receive_session(SvmInstance *instance) {
+    if (instance->client_handle < 0 || !instance->io_handle || !instance->incoming_queue) {
+         fprintf(stderr,"Receiver Thread (Inst %d): Instance not properly initialized for session.\n", instance->id);
+         if (instance->incoming_queue) qmq_shutdown(instance->incoming_queue);
+         return;
     }
 
-    printf("SVM Receiver thread started for instance %d (LAK 0x%02X, handle: %d).\n",
+    printf("SVM Receiver (Inst %d, LAK 0x%02X): Session started (handle: %d).\n",
            instance->id, instance->assigned_lak, instance->client_handle);
-    Message receivedMessage;
-    QueuedMessage q_msg;
-    q_msg.instance_id = instance->id;
     // bool should_stop_instance_locally = false; // Переименуем для ясности
 
     // Используем instance->is_active (который управляется listener'ом)
     // и глобальный keep_running
     while (keep_running && instance->is_active) {
-        int recvStatus = receive_protocol_message(instance->io_handle, instance->client_handle, &receivedMessage);
+        // Сообщение принимается прямо в слот входящей очереди (без промежуточной копии)
+        QueuedMessage *slot = qmq_reserve(instance->incoming_queue);
+        if (!slot) {
+            if (keep_running && instance->is_active) { // Логируем, только если еще должны работать
+                fprintf(stderr, "Receiver Thread (Inst %d): Incoming queue closed. Stopping instance.\n", instance->id);
+            }
+            break;
+        }
+        slot->instance_id = instance->id;
+        int recvStatus = receive_protocol_message(instance->io_handle, instance->client_handle, &slot->message);
+        if (recvStatus != 0) qmq_cancel(instance->incoming_queue, slot);
 
         // Проверяем состояние instance->is_active СРАЗУ после блокирующего вызова,
         // так как listener мог изменить его во время нашего ожидания на recv.
@@ -52,19 +59,12 @@ void* receiver_thread_func(void* arg) {
 
         if (!keep_running || !instance->is_active) { // Проверяем флаги еще раз
             // printf("Receiver Thread (Inst %d): Shutdown signaled or instance deactivated during/after receive. Exiting.\n", instance->id);
+            if (recvStatus == 0) qmq_cancel(instance->incoming_queue, slot);
             break;
         }
 
         if (recvStatus == 0) { // Успешное получение сообщения
-            memcpy(&q_msg.message, &receivedMessage, sizeof(Message));
-            if (!qmq_enqueue(instance->incoming_queue, &q_msg)) {
-                 if (keep_running && instance->is_active) { // Логируем, только если еще должны работать
-                    fprintf(stderr, "Receiver Thread (Inst %d): Failed to enqueue message to instance incoming queue. Stopping instance.\n", instance->id);
-                 }
-                 // Listener должен будет сам закрыть сокет и пометить is_active = false
-                 // Здесь мы просто завершаем поток, сигнализируя процессору.
-                 break; 
-            }
+            qmq_commit(instance->incoming_queue, slot);
         } else if (recvStatus == 1) { // Соединение закрыто удаленно
             if(keep_running && instance->is_active) {
                printf("Receiver Thread (Inst %d): Connection closed by UVM. Stopping instance processing.\n", instance->id);
@@ -91,7 +91,7 @@ void* receiver_thread_func(void* arg) {
     // Это лучше делать в listener'е, который ждет этот поток.
     // Здесь мы просто сигнализируем процессору.
 
-    printf("SVM Receiver thread (Inst %d, LAK 0x%02X): Shutting down incoming queue and finishing.\n", instance->id, instance->assigned_lak);
+    printf("SVM Receiver (Inst %d, LAK 0x%02X): Shutting down incoming queue, session finished.\n", instance->id, instance->assigned_lak);
     if (instance->incoming_queue) {
         qmq_shutdown(instance->incoming_queue); // Сигнализируем процессору
     }
@@ -100,6 +100,31 @@ void* receiver_thread_func(void* arg) {
     // pthread_mutex_lock(&instance->instance_mutex); // Неправильно, это может привести к дедлоку с listener
     // instance->is_active = false;
     // pthread_mutex_unlock(&instance->instance_mutex);
+}
+
+void* receiver_thread_func(void* arg) {
+    SvmInstance *instance = (SvmInstance*)arg;
+    if (!instance || !instance->incoming_queue) {
+         fprintf(stderr,"Receiver Thread (Inst %d): Invalid arguments or instance not properly initialized.\n", instance ? instance->id : -1);
+         return NULL;
+    }
+    printf("SVM Receiver thread started for instance %d (LAK 0x%02X), warm standby.\n", instance->id, instance->assigned_lak);
+
+    pthread_mutex_lock(&instance->instance_mutex);
+    while (true) {
+        while (instance->session_phase != SESSION_RUNNING && !instance->receiver_exit) {
+            pthread_cond_wait(&instance->session_cond, &instance->instance_mutex);
+        }
+        if (instance->receiver_exit) break;
+        pthread_mutex_unlock(&instance->instance_mutex);
+
+        receive_session(instance);
+
+        pthread_mutex_lock(&instance->instance_mutex);
+        instance->session_phase = SESSION_FINISHED; // Listener освободит подключение
+        pthread_cond_broadcast(&instance->session_cond);
+    }
+    pthread_mutex_unlock(&instance->instance_mutex);
 
     printf("SVM Receiver thread finished for instance %d (LAK 0x%02X).\n", instance->id, instance->assigned_lak);
     return NULL;
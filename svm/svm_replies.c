@@ -0,0 +1,89 @@
+/*
+ * svm/svm_replies.c
+ *
+ * Описание:
+ * Построение шаблонов управляющих ответов СВ-М (через обычные билдеры, один раз)
+ * и формирование ответов по шаблонам.
+ */
+#include "svm_replies.h"
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "../protocol/message_builder.h"
+#include "../protocol/message_utils.h"
+
+// Копирует заголовок и тело закодированного билдером сообщения в шаблон
+static void template_from_message(SvmReplyTemplate *tpl, const Message *msg) {
+    size_t body_len = ntohs(msg->header.body_length);
+    if (body_len > SVM_REPLY_MAX_BODY) body_len = SVM_REPLY_MAX_BODY; // Не случается для управляющих ответов
+    memset(tpl, 0, sizeof(*tpl));
+    tpl->header = msg->header;
+    memcpy(tpl->body, msg->body, body_len);
+}
+
+// Копирует шаблон в ответ (только заголовок и фактическое тело) и ставит номер
+static inline void *reply_from_template(const SvmReplyTemplate *tpl, Message *out, size_t body_size, uint16_t message_num) {
+    memcpy(out, tpl, sizeof(MessageHeader) + body_size);
+    set_full_message_number(&out->header, message_num);
+    return out->body;
+}
+
+void svm_replies_init(SvmReplyTemplates *replies, LogicalAddress lak, bool confirm_init_signature) {
+    if (!replies) return;
+    Message *msg = (Message*)malloc(sizeof(Message)); // Разово; Message слишком велик для стека вызывающих потоков
+    if (!msg) {
+        memset(replies, 0, sizeof(*replies));
+        return;
+    }
+    replies->confirm_init_signature = confirm_init_signature;
+    *msg = create_confirm_init_message(lak, SVM_REPLY_SLP, SVM_REPLY_VDR, SVM_REPLY_BOP1, SVM_REPLY_BOP2, 0, 0);
+    template_from_message(&replies->confirm_init, msg);
+    *msg = create_podtverzhdenie_kontrolya_message(lak, 0, 0, 0);
+    template_from_message(&replies->podtverzhdenie_kontrolya, msg);
+    *msg = create_rezultaty_kontrolya_message(lak, 0, 0, 0, 0);
+    template_from_message(&replies->rezultaty_kontrolya, msg);
+    *msg = create_sostoyanie_linii_message(lak, 0, 0, 0, 0, 0);
+    template_from_message(&replies->sostoyanie_linii, msg);
+    free(msg);
+}
+
+void svm_reply_confirm_init(const SvmReplyTemplates *replies, Message *out, uint32_t bcb,
+                            uint32_t param_signature, uint16_t message_num) {
+    if (!replies->confirm_init_signature) { // Тело по Таблице 4.7
+        ConfirmInitBody *body = reply_from_template(&replies->confirm_init, out, sizeof(ConfirmInitBody), message_num);
+        body->bcb = htonl(bcb);
+        return;
+    }
+    ConfirmInitExtBody *body = reply_from_template(&replies->confirm_init, out, sizeof(ConfirmInitExtBody), message_num);
+    out->header.body_length = htons(sizeof(ConfirmInitExtBody));
+    body->base.bcb = htonl(bcb);
+    body->param_signature = htonl(param_signature);
+}
+
+void svm_reply_podtverzhdenie_kontrolya(const SvmReplyTemplates *replies, Message *out,
+                                        uint8_t tk, uint32_t bcb, uint16_t message_num) {
+    PodtverzhdenieKontrolyaBody *body = reply_from_template(&replies->podtverzhdenie_kontrolya, out,
+                                                            sizeof(PodtverzhdenieKontrolyaBody), message_num);
+    body->tk = tk;
+    body->bcb = htonl(bcb);
+}
+
+void svm_reply_rezultaty_kontrolya(const SvmReplyTemplates *replies, Message *out,
+                                   uint8_t rsk, uint16_t vsk, uint32_t bcb, uint16_t message_num) {
+    RezultatyKontrolyaBody *body = reply_from_template(&replies->rezultaty_kontrolya, out,
+                                                       sizeof(RezultatyKontrolyaBody), message_num);
+    body->rsk = rsk;
+    body->vsk = htons(vsk);
+    body->bcb = htonl(bcb);
+}
+
+void svm_reply_sostoyanie_linii(const SvmReplyTemplates *replies, Message *out,
+                                uint16_t kla, uint32_t sla, uint16_t ksa, uint32_t bcb, uint16_t message_num) {
+    SostoyanieLiniiBody *body = reply_from_template(&replies->sostoyanie_linii, out,
+                                                    sizeof(SostoyanieLiniiBody), message_num);
+    body->kla = htons(kla);
+    body->sla = htonl(sla);
+    body->ksa = htons(ksa);
+    body->bcb = htonl(bcb);
+}
@@ -0,0 +1,73 @@
+/*
+ * svm/svm_replies.h
+ *
+ * Описание:
+ * Заранее закодированные (сетевой порядок байт) шаблоны управляющих ответов СВ-М:
+ * «Подтверждение инициализации», «Подтверждение контроля», «Результаты контроля»,
+ * «Состояние линии». Шаблоны строятся один раз для экземпляра; ответ формируется
+ * копированием шаблона (заголовок + тело, не более 22 байт) и записью только
+ * номера сообщения и изменяющихся полей.
+ */
+#ifndef SVM_REPLIES_H
+#define SVM_REPLIES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../protocol/protocol_defs.h"
+
+// Наибольшее тело среди управляющих ответов (SostoyanieLiniiBody)
+#define SVM_REPLY_MAX_BODY 16
+
+// Постоянные поля «Подтверждения инициализации» эмулируемого СВ-М
+#define SVM_REPLY_SLP 0x03  // Состояние линий передач
+#define SVM_REPLY_VDR 0x10  // Версия прошивки МОДР
+#define SVM_REPLY_BOP1 0x11 // Версия прошивки МОСВ1
+#define SVM_REPLY_BOP2 0x12 // Версия прошивки МОСВ2
+
+// Закодированный ответ; раскладка совпадает с началом Message
+typedef struct {
+    MessageHeader header;
+    uint8_t body[SVM_REPLY_MAX_BODY];
+} SvmReplyTemplate;
+
+typedef struct {
+    bool confirm_init_signature;   // «Подтверждение инициализации» с расширением (подпись набора параметров)
+    SvmReplyTemplate confirm_init;
+    SvmReplyTemplate podtverzhdenie_kontrolya;
+    SvmReplyTemplate rezultaty_kontrolya;
+    SvmReplyTemplate sostoyanie_linii;
+} SvmReplyTemplates;
+
+/**
+ * @brief Строит шаблоны ответов для экземпляра с логическим адресом lak.
+ * @param confirm_init_signature Дополнять «Подтверждение инициализации» подписью набора
+ * параметров (расширение эмулятора вне Таблицы 4.7, confirm_init_signature в config.ini).
+ */
+void svm_replies_init(SvmReplyTemplates *replies, LogicalAddress lak, bool confirm_init_signature);
+
+/**
+ * @brief Формирует «Подтверждение инициализации» в out. Подпись набора параметров
+ * добавляется, только если расширение включено при построении шаблонов.
+ */
+void svm_reply_confirm_init(const SvmReplyTemplates *replies, Message *out, uint32_t bcb,
+                            uint32_t param_signature, uint16_t message_num);
+
+/**
+ * @brief Формирует «Подтверждение контроля» в out.
+ */
+void svm_reply_podtverzhdenie_kontrolya(const SvmReplyTemplates *replies, Message *out,
+                                        uint8_t tk, uint32_t bcb, uint16_t message_num);
+
+/**
+ * @brief Формирует «Результаты контроля» в out.
+ */
+void svm_reply_rezultaty_kontrolya(const SvmReplyTemplates *replies, Message *out,
+                                   uint8_t rsk, uint16_t vsk, uint32_t bcb, uint16_t message_num);
+
+/**
+ * @brief Формирует «Состояние линии» в out.
+ */
+void svm_reply_sostoyanie_linii(const SvmReplyTemplates *replies, Message *out,
+                                uint16_t kla, uint32_t sla, uint16_t ksa, uint32_t bcb, uint16_t message_num);
+
+#endif // SVM_REPLIES_H
@@ -0,0 +1,50 @@
+/*
+ * svm/svm_rng.h
+ *
+ * Описание:
+ * Быстрый детерминированный генератор псевдослучайных чисел (PCG32) для
+ * эмуляции СВ-М. У каждого экземпляра свой генератор: нет общей блокировки
+ * glibc rand(), а последовательность воспроизводится при одинаковом зерне.
+ * Генератор не потокобезопасен - им пользуется один поток.
+ */
+#ifndef SVM_RNG_H
+#define SVM_RNG_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint64_t state;
+    uint64_t inc; // Номер потока последовательности (всегда нечетный)
+} SvmRng;
+
+/**
+ * @brief Возвращает следующее 32-битное псевдослучайное число.
+ */
+static inline uint32_t svm_rng_next(SvmRng *rng) {
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ull + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+}
+
+/**
+ * @brief Инициализирует генератор зерном seed; stream разделяет последовательности
+ * экземпляров с одинаковым зерном (обычно ID экземпляра).
+ */
+static inline void svm_rng_seed(SvmRng *rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1u) | 1u;
+    svm_rng_next(rng);
+    rng->state += seed;
+    svm_rng_next(rng);
+}
+
+/**
+ * @brief Возвращает true с вероятностью 1/n (n > 0), как rand() % n == 0.
+ */
+static inline int svm_rng_one_in(SvmRng *rng, uint32_t n) {
+    return svm_rng_next(rng) % n == 0;
+}
+
+#endif // SVM_RNG_H
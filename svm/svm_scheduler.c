@@ -0,0 +1,359 @@
+/*
+ * svm/svm_scheduler.c
+ *
+ * Описание:
+ * Реализация службы таймеров SVM: иерархическое колесо таймеров
+ * (SVM_WHEEL_LEVELS уровней по 64 слота) и один поток, который просыпается
+ * по timerfd раз в SVM_SCHEDULER_TICK_MS. Число пробуждений не зависит от числа
+ * экземпляров и таймеров. Таймеры одного тика выполняются в порядке постановки.
+ */
+#include "svm_scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+
+#include "../utils/ts_queued_msg_queue.h"
+
+extern ThreadSafeQueuedMsgQueue *svm_outgoing_queue;
+
+#define SVM_WHEEL_BITS 6
+#define SVM_WHEEL_SLOTS (1u << SVM_WHEEL_BITS)
+#define SVM_WHEEL_MASK (SVM_WHEEL_SLOTS - 1)
+#define SVM_WHEEL_LEVELS 4
+#define SVM_WHEEL_MAX_TICKS ((1ull << (SVM_WHEEL_BITS * SVM_WHEEL_LEVELS)) - 1) // ~46 ч при тике 10 мс
+// Сколько тиков отложенный ответ ждет места в исходящей очереди, прежде чем будет отброшен
+#define SVM_DEFERRED_MAX_RETRIES 100
+
+struct SvmTimer {
+    struct SvmTimer *next;
+    struct SvmTimer *prev;
+    uint64_t expires;       // Номер тика срабатывания
+    uint32_t period_ticks;  // 0 - однократный таймер
+    bool cancelled;         // Отменен во время выполнения обработчика
+    bool free_on_return;    // Отменен из собственного обработчика: освобождает поток службы
+    bool free_arg_on_drop;
+    SvmTimerCallback callback;
+    void *arg;
+};
+
+// Слот колеса: кольцевой двусвязный список с фиктивной головой
+typedef struct {
+    SvmTimer head;
+} WheelSlot;
+
+// Отложенный ответ: контекст запроса хранится сразу за структурой, ответ формируется при срабатывании
+typedef struct {
+    SvmInstance *instance;
+    uint32_t session_id;
+    SVMState state_on_send;
+    SvmReplyBuilder build;
+    unsigned retries;       // Повторы из-за полной исходящей очереди
+    uint8_t context[];
+} DeferredResponse;
+
+static WheelSlot wheel[SVM_WHEEL_LEVELS][SVM_WHEEL_SLOTS];
+static uint64_t wheel_tick = 0;        // Следующий обрабатываемый тик
+static size_t wheel_pending = 0;       // Число таймеров в колесе
+static SvmTimer *wheel_current = NULL; // Таймер, обработчик которого выполняется сейчас
+static pthread_mutex_t sched_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sched_idle_cond = PTHREAD_COND_INITIALIZER; // Сигнал окончания обработчика
+static pthread_t sched_tid;
+static int sched_timerfd = -1;
+static bool sched_running = false;
+
+static inline void slot_init(WheelSlot *slot) {
+    slot->head.next = slot->head.prev = &slot->head;
+}
+
+static inline bool slot_empty(const WheelSlot *slot) {
+    return slot->head.next == &slot->head;
+}
+
+static inline void timer_unlink(SvmTimer *t) {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->next = t->prev = NULL;
+}
+
+static inline void slot_append(WheelSlot *slot, SvmTimer *t) {
+    t->prev = slot->head.prev;
+    t->next = &slot->head;
+    slot->head.prev->next = t;
+    slot->head.prev = t;
+}
+
+static unsigned ms_to_ticks(unsigned ms) {
+    unsigned ticks = (ms + SVM_SCHEDULER_TICK_MS - 1) / SVM_SCHEDULER_TICK_MS;
+    return ticks ? ticks : 1;
+}
+
+// Размещение таймера по уровню в зависимости от удаленности срока (вызывается под sched_mutex)
+static void wheel_insert_locked(SvmTimer *t) {
+    uint64_t delta = t->expires > wheel_tick ? t->expires - wheel_tick : 0;
+    if (delta > SVM_WHEEL_MAX_TICKS) {
+        delta = SVM_WHEEL_MAX_TICKS;
+        t->expires = wheel_tick + delta;
+    }
+    int level = 0;
+    while (level < SVM_WHEEL_LEVELS - 1 && delta >= (1ull << (SVM_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    unsigned index = (unsigned)((delta == 0 ? wheel_tick : t->expires) >> (SVM_WHEEL_BITS * level)) & SVM_WHEEL_MASK;
+    slot_append(&wheel[level][index], t);
+}
+
+// Перенос таймеров слота старшего уровня на младшие; возвращает индекс слота
+static unsigned wheel_cascade_locked(int level) {
+    unsigned index = (unsigned)(wheel_tick >> (SVM_WHEEL_BITS * level)) & SVM_WHEEL_MASK;
+    WheelSlot *slot = &wheel[level][index];
+    while (!slot_empty(slot)) {
+        SvmTimer *t = slot->head.next;
+        timer_unlink(t);
+        wheel_insert_locked(t);
+    }
+    return index;
+}
+
+// Обработка одного тика: каскад при переходе через границу уровня и выполнение слота уровня 0
+static void wheel_advance_locked(void) {
+    unsigned index = (unsigned)wheel_tick & SVM_WHEEL_MASK;
+    if (index == 0) {
+        for (int level = 1; level < SVM_WHEEL_LEVELS; ++level) {
+            if (wheel_cascade_locked(level) != 0) break;
+        }
+    }
+
+    WheelSlot *slot = &wheel[0][index];
+    while (!slot_empty(slot)) {
+        SvmTimer *t = slot->head.next;
+        timer_unlink(t);
+        wheel_pending--;
+
+        wheel_current = t;
+        pthread_mutex_unlock(&sched_mutex); // Обработчик выполняется без блокировки колеса
+        t->callback(t->arg);
+        pthread_mutex_lock(&sched_mutex);
+        wheel_current = NULL;
+
+        if (t->period_ticks && !t->cancelled) {
+            t->expires += t->period_ticks;
+            if (t->expires <= wheel_tick) t->expires = wheel_tick + 1; // Не догоняем пропущенные периоды
+            wheel_insert_locked(t);
+            wheel_pending++;
+        } else if (!t->period_ticks || t->free_on_return) {
+            free(t);
+        }
+        // Отмененный из другого потока периодический таймер освобождает отменивший поток
+        pthread_cond_broadcast(&sched_idle_cond);
+    }
+    wheel_tick++;
+}
+
+static void* svm_scheduler_thread_func(void *arg) {
+    (void)arg;
+    printf("SVM Scheduler thread started (tick %d ms).\n", SVM_SCHEDULER_TICK_MS);
+
+    for (;;) {
+        uint64_t expirations = 0;
+        ssize_t n = read(sched_timerfd, &expirations, sizeof(expirations));
+        if (n != (ssize_t)sizeof(expirations)) {
+            if (n < 0 && errno == EINTR) continue;
+            perror("SVM Scheduler: timerfd read failed");
+            break;
+        }
+        pthread_mutex_lock(&sched_mutex);
+        // При задержке потока обрабатываем все пропущенные тики подряд
+        for (uint64_t i = 0; i < expirations && sched_running; ++i) {
+            wheel_advance_locked();
+        }
+        bool running = sched_running;
+        pthread_mutex_unlock(&sched_mutex);
+        if (!running) break;
+    }
+
+    printf("SVM Scheduler thread finished.\n");
+    return NULL;
+}
+
+int svm_scheduler_start(void) {
+    for (int level = 0; level < SVM_WHEEL_LEVELS; ++level) {
+        for (unsigned i = 0; i < SVM_WHEEL_SLOTS; ++i) slot_init(&wheel[level][i]);
+    }
+    wheel_tick = 0;
+    wheel_pending = 0;
+
+    sched_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (sched_timerfd < 0) {
+        perror("svm_scheduler_start: timerfd_create failed");
+        return -1;
+    }
+    struct itimerspec its;
+    its.it_interval.tv_sec = SVM_SCHEDULER_TICK_MS / 1000;
+    its.it_interval.tv_nsec = (long)(SVM_SCHEDULER_TICK_MS % 1000) * 1000000L;
+    its.it_value = its.it_interval;
+    if (timerfd_settime(sched_timerfd, 0, &its, NULL) != 0) {
+        perror("svm_scheduler_start: timerfd_settime failed");
+        close(sched_timerfd);
+        sched_timerfd = -1;
+        return -1;
+    }
+
+    sched_running = true;
+    if (pthread_create(&sched_tid, NULL, svm_scheduler_thread_func, NULL) != 0) {
+        perror("svm_scheduler_start: Failed to create scheduler thread");
+        sched_running = false;
+        close(sched_timerfd);
+        sched_timerfd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void svm_scheduler_stop(void) {
+    pthread_mutex_lock(&sched_mutex);
+    if (!sched_running) { pthread_mutex_unlock(&sched_mutex); return; }
+    sched_running = false; // Поток завершится на ближайшем тике
+    pthread_mutex_unlock(&sched_mutex);
+    pthread_join(sched_tid, NULL);
+    close(sched_timerfd);
+    sched_timerfd = -1;
+
+    if (wheel_pending > 0) printf("SVM Scheduler: Dropping %zu pending timers.\n", wheel_pending);
+    for (int level = 0; level < SVM_WHEEL_LEVELS; ++level) {
+        for (unsigned i = 0; i < SVM_WHEEL_SLOTS; ++i) {
+            WheelSlot *slot = &wheel[level][i];
+            while (!slot_empty(slot)) {
+                SvmTimer *t = slot->head.next;
+                timer_unlink(t);
+                if (t->free_arg_on_drop) free(t->arg);
+                free(t);
+            }
+        }
+    }
+    wheel_pending = 0;
+}
+
+static SvmTimer* scheduler_add(unsigned delay_ms, unsigned period_ms, SvmTimerCallback callback,
+                               void *arg, bool free_arg_on_drop) {
+    if (!callback) return NULL;
+    SvmTimer *t = calloc(1, sizeof(SvmTimer));
+    if (!t) {
+        perror("svm_scheduler: malloc failed");
+        return NULL;
+    }
+    t->callback = callback;
+    t->arg = arg;
+    t->free_arg_on_drop = free_arg_on_drop;
+    t->period_ticks = period_ms ? ms_to_ticks(period_ms) : 0;
+
+    pthread_mutex_lock(&sched_mutex);
+    if (!sched_running) {
+        pthread_mutex_unlock(&sched_mutex);
+        free(t);
+        return NULL;
+    }
+    t->expires = wheel_tick + ms_to_ticks(delay_ms);
+    wheel_insert_locked(t);
+    wheel_pending++;
+    pthread_mutex_unlock(&sched_mutex);
+    return t;
+}
+
+bool svm_scheduler_schedule(unsigned delay_ms, SvmTimerCallback callback, void *arg, bool free_arg_on_drop) {
+    return scheduler_add(delay_ms, 0, callback, arg, free_arg_on_drop) != NULL;
+}
+
+SvmTimer* svm_scheduler_schedule_periodic(unsigned period_ms, SvmTimerCallback callback, void *arg) {
+    if (period_ms == 0) return NULL;
+    return scheduler_add(period_ms, period_ms, callback, arg, false);
+}
+
+void svm_scheduler_cancel(SvmTimer *timer) {
+    if (!timer) return;
+    pthread_mutex_lock(&sched_mutex);
+    if (timer->next) {
+        // Таймер ждет в колесе - просто убираем
+        timer_unlink(timer);
+        wheel_pending--;
+    } else if (timer == wheel_current) {
+        timer->cancelled = true;
+        if (pthread_equal(pthread_self(), sched_tid)) {
+            // Отмена из собственного обработчика: поток службы не вернет таймер в колесо
+            // и освободит его после возврата обработчика
+            timer->free_on_return = true;
+            pthread_mutex_unlock(&sched_mutex);
+            return;
+        }
+        while (wheel_current == timer) pthread_cond_wait(&sched_idle_cond, &sched_mutex);
+    }
+    pthread_mutex_unlock(&sched_mutex);
+    free(timer);
+}
+
+static void deferred_response_fire(void *arg) {
+    DeferredResponse *dr = (DeferredResponse*)arg;
+    SvmInstance *instance = dr->instance;
+
+    // Поток службы не ждет на полной очереди: ответ откладывается на следующий тик
+    QueuedMessage *slot = qmq_try_reserve(svm_outgoing_queue);
+    if (!slot) {
+        if (dr->retries++ < SVM_DEFERRED_MAX_RETRIES &&
+            svm_scheduler_schedule(SVM_SCHEDULER_TICK_MS, deferred_response_fire, dr, true)) {
+            return;
+        }
+        fprintf(stderr, "SVM Scheduler: Outgoing queue unavailable, deferred response for instance %d dropped.\n",
+                instance->id);
+        free(dr);
+        return;
+    }
+
+    pthread_mutex_lock(&instance->instance_mutex);
+    bool same_session = instance->is_active && instance->session_id == dr->session_id;
+    if (same_session) instance->current_state = dr->state_on_send;
+    pthread_mutex_unlock(&instance->instance_mutex);
+
+    if (!same_session) {
+        qmq_cancel(svm_outgoing_queue, slot);
+        printf("SVM Scheduler: Deferred response for instance %d dropped (session %u ended).\n",
+               instance->id, dr->session_id);
+        free(dr);
+        return;
+    }
+
+    // Ответ (номер сообщения, BCB) формируется в момент отправки, прямо в слоте очереди
+    slot->instance_id = instance->id;
+    dr->build(instance, dr->context, &slot->message);
+    qmq_commit(svm_outgoing_queue, slot);
+    free(dr);
+}
+
+bool svm_scheduler_defer_response(SvmInstance *instance, SvmReplyBuilder build,
+                                  const void *context, size_t context_size,
+                                  unsigned delay_ms, SVMState state_on_send) {
+    if (!instance || !build || (context_size > 0 && !context)) return false;
+
+    DeferredResponse *dr = malloc(sizeof(DeferredResponse) + context_size);
+    if (!dr) {
+        perror("svm_scheduler_defer_response: malloc failed");
+        return false;
+    }
+    pthread_mutex_lock(&instance->instance_mutex);
+    dr->session_id = instance->session_id;
+    pthread_mutex_unlock(&instance->instance_mutex);
+    dr->instance = instance;
+    dr->state_on_send = state_on_send;
+    dr->build = build;
+    dr->retries = 0;
+    if (context_size > 0) memcpy(dr->context, context, context_size);
+
+    if (!svm_scheduler_schedule(delay_ms, deferred_response_fire, dr, true)) {
+        free(dr);
+        return false;
+    }
+    return true;
+}
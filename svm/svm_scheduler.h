@@ -0,0 +1,74 @@
+/*
+ * svm/svm_scheduler.h
+ *
+ * Описание:
+ * Общая служба таймеров SVM: одно колесо таймеров и один поток на все экземпляры.
+ * Владеет всеми периодическими (статус линии, цикл обзора) и однократными
+ * (отложенные ответы обработчиков) таймерами svm_app.
+ */
+#ifndef SVM_SCHEDULER_H
+#define SVM_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "svm_types.h"
+
+// Шаг колеса таймеров; задержки и периоды округляются вверх до целого числа тиков
+#define SVM_SCHEDULER_TICK_MS 10
+
+// Функция, вызываемая службой по истечении задержки (в потоке службы).
+// Не должна блокироваться надолго: пока она выполняется, остальные таймеры ждут.
+typedef void (*SvmTimerCallback)(void *arg);
+
+// Формирует отложенный ответ экземпляра в response (в потоке службы, в момент отправки).
+// context - копия контекста запроса, переданного в svm_scheduler_defer_response.
+typedef void (*SvmReplyBuilder)(SvmInstance *instance, const void *context, Message *response);
+
+// Дескриптор периодического таймера (непрозрачный)
+typedef struct SvmTimer SvmTimer;
+
+/**
+ * @brief Запускает поток службы отложенных действий.
+ * @return 0 в случае успеха, -1 в случае ошибки.
+ */
+int svm_scheduler_start(void);
+
+/**
+ * @brief Останавливает поток службы. Невыполненные таймеры отбрасываются.
+ */
+void svm_scheduler_stop(void);
+
+/**
+ * @brief Планирует вызов callback(arg) через delay_ms миллисекунд.
+ * @param free_arg_on_drop Освободить arg через free(), если действие будет отброшено при остановке.
+ * @return true, если действие запланировано.
+ */
+bool svm_scheduler_schedule(unsigned delay_ms, SvmTimerCallback callback, void *arg, bool free_arg_on_drop);
+
+/**
+ * @brief Запускает периодический вызов callback(arg) с периодом period_ms (первый вызов через period_ms).
+ * @return Дескриптор таймера или NULL в случае ошибки.
+ */
+SvmTimer* svm_scheduler_schedule_periodic(unsigned period_ms, SvmTimerCallback callback, void *arg);
+
+/**
+ * @brief Отменяет периодический таймер и освобождает его.
+ * Если обработчик таймера выполняется в другом потоке, дожидается его завершения:
+ * после возврата callback гарантированно больше не вызывается.
+ * Можно вызывать из самого callback: таймер освобождается после его возврата.
+ */
+void svm_scheduler_cancel(SvmTimer *timer);
+
+/**
+ * @brief Планирует ответ экземпляра через delay_ms миллисекунд.
+ * Сохраняется только контекст запроса (копия context_size байт). При срабатывании, если экземпляр
+ * все еще активен и сеанс связи (session_id) не сменился, экземпляр переводится в состояние
+ * state_on_send, а build формирует ответ (с номером сообщения и BCB момента отправки)
+ * прямо в слоте общей исходящей очереди.
+ * @return true, если ответ запланирован.
+ */
+bool svm_scheduler_defer_response(SvmInstance *instance, SvmReplyBuilder build,
+                                  const void *context, size_t context_size,
+                                  unsigned delay_ms, SVMState state_on_send);
+
+#endif // SVM_SCHEDULER_H
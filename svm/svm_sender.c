@@ -2,7 +2,8 @@
  * svm/svm_sender.c
  * Описание: ОБЩИЙ поток-отправитель.
  * Читает QueuedMessage из общей очереди, находит экземпляр,
- * отправляет, имитирует отключение по счетчику.
+ * отправляет (готовые сообщения - пачкой), имитирует отключение по счетчику.
+ * Замеряет время от accept до отправки «Подтверждения инициализации канала».
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,7 +12,9 @@
 #include <stdbool.h>
 #include <sys/socket.h>
 #include <errno.h>
+#include <time.h>
 #include "../io/io_common.h"
+#include "../protocol/protocol_defs.h"
 #include "../utils/ts_queued_msg_queue.h"
 #include "svm_timers.h"
 #include "svm_types.h"
@@ -22,117 +25,197 @@ extern SvmInstance svm_instances[MAX_SVM_INSTANCES];
 extern volatile bool keep_running;
 extern pthread_mutex_t svm_instances_mutex;
 
+#define SVM_SEND_BURST_MAX 32 // Сообщений из очереди за одну отправку
+
+static uint64_t monotonic_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Учет задержки accept -> «Подтверждение инициализации» (первый ответ сеанса)
+static void record_activation_latency(SvmInstance *instance) {
+    uint64_t now = monotonic_now_ns();
+    pthread_mutex_lock(&instance->instance_mutex);
+    if (instance->accept_ns == 0) { // Повторная инициализация в том же сеансе не учитывается
+        pthread_mutex_unlock(&instance->instance_mutex);
+        return;
+    }
+    uint64_t latency = now - instance->accept_ns;
+    instance->accept_ns = 0;
+    instance->activation_count++;
+    if (instance->activation_count == 1 || latency < instance->activation_min_ns) instance->activation_min_ns = latency;
+    if (latency > instance->activation_max_ns) instance->activation_max_ns = latency;
+    instance->activation_sum_ns += latency;
+    unsigned long count = instance->activation_count;
+    double min_ms = instance->activation_min_ns / 1e6;
+    double avg_ms = instance->activation_sum_ns / 1e6 / count;
+    double max_ms = instance->activation_max_ns / 1e6;
+    pthread_mutex_unlock(&instance->instance_mutex);
+
+    printf("Sender Thread: Instance %d accept-to-ConfirmInit %.3f ms (sessions %lu, min/avg/max %.3f/%.3f/%.3f ms).\n",
+           instance->id, latency / 1e6, count, min_ms, avg_ms, max_ms);
+}
+
+// Решение по сообщению пачки, принятое до отправки
+typedef struct {
+    SvmInstance *instance;
+    int client_handle;
+    IOInterface *io_handle;
+    bool instance_is_active;
+    bool limit_reached_this_time;
+    bool send_error;
+} SendPlan;
+
+// --- Проверяем статус и счетчик ДО отправки ---
+static void sender_prepare(QueuedMessage *slot, SendPlan *plan) {
+    Message *message = &slot->message;
+    int instance_id = slot->instance_id;
+    plan->instance = NULL;
+    plan->client_handle = -1;
+    plan->io_handle = NULL;
+    plan->instance_is_active = false;
+    plan->limit_reached_this_time = false;
+    plan->send_error = false;
+
+    if (instance_id < 0 || instance_id >= MAX_SVM_INSTANCES) {
+         fprintf(stderr,"Sender Thread: Invalid instance ID %d in outgoing queue.\n", instance_id);
+         return;
+    }
+    SvmInstance *instance = &svm_instances[instance_id];
+    plan->instance = instance;
+
+    pthread_mutex_lock(&instance->instance_mutex);
+    plan->instance_is_active = instance->is_active;
+    if (plan->instance_is_active) {
+        plan->client_handle = instance->client_handle;
+        plan->io_handle = instance->io_handle;
+        // В общем соединении получатель (УВМ) единственный, поэтому поле адреса несет
+        // LAK отправителя: по нему УВМ раздает ответы линкам
+        if (instance->muxed) message->header.address = instance->assigned_lak;
+        int disconnect_threshold = instance->disconnect_after_messages;
+
+        if (disconnect_threshold > 0) {
+             // Проверяем, НЕ достигли ли мы лимита НА ПРЕДЫДУЩЕМ сообщении
+             if (instance->messages_sent_count < disconnect_threshold) {
+                  // Увеличиваем счетчик ПЕРЕД отправкой ТЕКУЩЕГО
+                  instance->messages_sent_count++;
+                  // Проверяем, НЕ достиг ли лимит ИМЕННО СЕЙЧАС
+                  if (instance->messages_sent_count >= disconnect_threshold) {
+                       plan->limit_reached_this_time = true;
+                       printf("Sender Thread: Instance %d reached message limit (%d >= %d). Will disconnect AFTER this send.\n",
+                              instance_id, instance->messages_sent_count, disconnect_threshold);
+                       // НЕ помечаем is_active=false здесь, сделаем после отправки
+                  }
+             } else {
+                  // Лимит уже был достигнут ранее (в том числе раньше в этой же пачке), отправлять не должны
+                  plan->instance_is_active = false;
+                  printf("Sender Thread: Instance %d message limit %d already reached. Discarding msg type %u.\n",
+                         instance_id, disconnect_threshold, message->header.message_type);
+             }
+        }
+    }
+    pthread_mutex_unlock(&instance->instance_mutex);
+
+    if (plan->instance_is_active && (plan->client_handle < 0 || plan->io_handle == NULL)) { // Был активен, но хэндлы невалидны?
+         fprintf(stderr,"Sender Thread: Instance %d active but handles invalid? Discarding msg type %u.\n",
+                 instance_id, message->header.message_type);
+         plan->send_error = true; // Считаем ошибкой
+    }
+    // Если !instance_is_active, сообщение просто игнорируется
+}
+
+// --- Обработка после попытки отправки ---
+static void sender_finish(SendPlan *plan) {
+    SvmInstance *instance = plan->instance;
+    if (!instance || !(plan->send_error || plan->limit_reached_this_time)) return;
+
+    pthread_mutex_lock(&instance->instance_mutex); // Берем мьютекс для изменения состояния instance
+    if (instance->is_active) { // Проверяем снова, активен ли он еще
+
+         // Сначала логируем причину деактивации
+         if (plan->limit_reached_this_time) {
+              // ---> Сообщение об имитации отключения <---
+              fprintf(stderr, "Sender Thread: SIMULATING disconnect for instance %d (handle %d) NOW after sending message %d.\n",
+                     instance->id, instance->client_handle, instance->messages_sent_count);
+         } else { // send_error == true
+              fprintf(stderr, "Sender Thread: Deactivating instance %d (handle %d) due to send error.\n",
+                      instance->id, instance->client_handle);
+         }
+
+         // Теперь деактивируем и закрываем ресурсы
+         instance->is_active = false; // Помечаем неактивным
+
+         // Закрываем сокет, чтобы Receiver узнал. Общее соединение закрывается только при ошибке
+         // отправки (оно неисправно для всех); имитация отключения лишь заставляет экземпляр замолчать
+         if (instance->client_handle >= 0 && (!instance->muxed || plan->send_error)) {
+             shutdown(instance->client_handle, SHUT_RDWR);
+             // close() будет вызван в listener'е при очистке
+         }
+         // Закрываем входящую очередь, чтобы Processor завершился
+         if (instance->incoming_queue) {
+              qmq_shutdown(instance->incoming_queue);
+         }
+    }
+    // Если !instance->is_active, значит его уже деактивировали (возможно, Receiver или другой вызов Sender'а)
+    pthread_mutex_unlock(&instance->instance_mutex); // Отпускаем мьютекс
+}
+
 void* sender_thread_func(void* arg) {
     (void)arg;
     printf("SVM Sender thread started (reads global outgoing queue).\n");
-    QueuedMessage queuedMsgToSend;
+
+    QueuedMessage *slots[SVM_SEND_BURST_MAX];
+    SendPlan plans[SVM_SEND_BURST_MAX];
+    IOSendItem items[SVM_SEND_BURST_MAX];
+    int item_of[SVM_SEND_BURST_MAX];
 
     while(true) {
-        if (!qmq_dequeue(svm_outgoing_queue, &queuedMsgToSend)) {
+        // Сообщения отправляются прямо из слотов очереди; все готовые слоты подряд - одной пачкой
+        // (для io_uring - одна подача на все соединения). Слоты освобождаются в конце итерации
+        size_t count = qmq_dequeue_begin_burst(svm_outgoing_queue, slots, SVM_SEND_BURST_MAX);
+        if (count == 0) {
             if (!keep_running && svm_outgoing_queue->count == 0) { break; }
             if (keep_running) usleep(10000);
             continue;
         }
 
-        int instance_id = queuedMsgToSend.instance_id;
-        SvmInstance *instance = NULL;
-        int client_handle = -1;
-        IOInterface *io_handle = NULL;
-        bool instance_is_active = false;
-        bool limit_reached_this_time = false;
-
-        if (instance_id < 0 || instance_id >= MAX_SVM_INSTANCES) {
-             fprintf(stderr,"Sender Thread: Invalid instance ID %d in outgoing queue.\n", instance_id);
-             continue;
-        }
-        instance = &svm_instances[instance_id];
-
-        // --- Проверяем статус и счетчик ДО отправки ---
-        pthread_mutex_lock(&instance->instance_mutex);
-        instance_is_active = instance->is_active;
-        if (instance_is_active) {
-            client_handle = instance->client_handle;
-            io_handle = instance->io_handle;
-            int disconnect_threshold = instance->disconnect_after_messages;
-
-            if (disconnect_threshold > 0) {
-                 // Проверяем, НЕ достигли ли мы лимита НА ПРЕДЫДУЩЕМ сообщении
-                 if (instance->messages_sent_count < disconnect_threshold) {
-                      // Увеличиваем счетчик ПЕРЕД отправкой ТЕКУЩЕГО
-                      instance->messages_sent_count++;
-                      // Проверяем, НЕ достиг ли лимит ИМЕННО СЕЙЧАС
-                      if (instance->messages_sent_count >= disconnect_threshold) {
-                           limit_reached_this_time = true;
-                           printf("Sender Thread: Instance %d reached message limit (%d >= %d). Will disconnect AFTER this send.\n",
-                                  instance_id, instance->messages_sent_count, disconnect_threshold);
-                           // НЕ помечаем is_active=false здесь, сделаем после отправки
-                           // Но можем закрыть очередь процессора
-                           // if (instance->incoming_queue) qmq_shutdown(instance->incoming_queue); // Рано?
-                      }
-                 } else {
-                      // Лимит уже был достигнут ранее, отправлять не должны
-                      instance_is_active = false;
-                      printf("Sender Thread: Instance %d message limit %d already reached. Discarding msg type %u.\n",
-                             instance_id, disconnect_threshold, queuedMsgToSend.message.header.message_type);
-                 }
+        size_t item_count = 0;
+        for (size_t i = 0; i < count; ++i) {
+            sender_prepare(slots[i], &plans[i]);
+            item_of[i] = -1;
+            // Отправляем, только если все еще активны и хэндлы валидны
+            if (plans[i].instance_is_active && !plans[i].send_error) {
+                items[item_count].io = plans[i].io_handle;
+                items[item_count].handle = plans[i].client_handle;
+                items[item_count].message = &slots[i]->message;
+                items[item_count].result = -1;
+                item_of[i] = (int)item_count++;
             }
         }
-        pthread_mutex_unlock(&instance->instance_mutex);
-        // --- Конец проверки статуса и счетчика ---
-
-        // Отправляем, только если все еще активны и хэндлы валидны
-        bool send_error = false;
-        if (instance_is_active && client_handle >= 0 && io_handle != NULL) {
-             // printf("Sender Thread: Sending msg type %u to instance %d (handle %d), sent count %d\n", ...);
-            if (send_protocol_message(io_handle, client_handle, &queuedMsgToSend.message) != 0) {
-                send_error = true; // Ошибка отправки
-                if (keep_running) {
-                     fprintf(stderr, "Sender Thread: Error sending message (type %u) to instance %d (handle %d).\n",
-                            queuedMsgToSend.message.header.message_type, instance_id, client_handle);
-                }
-            }
-        } else if (instance_is_active) { // Был активен, но хэндлы невалидны?
-             fprintf(stderr,"Sender Thread: Instance %d active but handles invalid? Discarding msg type %u.\n",
-                     instance_id, queuedMsgToSend.message.header.message_type);
-             send_error = true; // Считаем ошибкой
+        if (item_count > 0) {
+            send_protocol_messages(items, item_count);
         }
-        // Если !instance_is_active, сообщение просто игнорируется
-
-		// --- Обработка после попытки отправки ---
-        if (send_error || limit_reached_this_time) {
-             pthread_mutex_lock(&instance->instance_mutex); // Берем мьютекс для изменения состояния instance
-             if (instance->is_active) { // Проверяем снова, активен ли он еще
-
-                  // Сначала логируем причину деактивации
-                  if (limit_reached_this_time) {
-                       // ---> Сообщение об имитации отключения <---
-                       fprintf(stderr, "Sender Thread: SIMULATING disconnect for instance %d (handle %d) NOW after sending message %d.\n",
-                              instance_id, instance->client_handle, instance->messages_sent_count);
-                  } else { // send_error == true
-                       fprintf(stderr, "Sender Thread: Deactivating instance %d (handle %d) due to send error.\n",
-                               instance_id, instance->client_handle);
-                  }
 
-                  // Теперь деактивируем и закрываем ресурсы
-                  instance->is_active = false; // Помечаем неактивным
-
-                  // Закрываем сокет, чтобы Receiver узнал
-                  if (instance->client_handle >= 0) {
-                      shutdown(instance->client_handle, SHUT_RDWR);
-                      // close() будет вызван в listener'е при очистке
-                  }
-                  // Закрываем входящую очередь, чтобы Processor завершился
-                  if (instance->incoming_queue) {
-                       qmq_shutdown(instance->incoming_queue);
-                  }
-             }
-             // Если !instance->is_active, значит его уже деактивировали (возможно, Receiver или другой вызов Sender'а)
-             pthread_mutex_unlock(&instance->instance_mutex); // Отпускаем мьютекс
+        for (size_t i = 0; i < count; ++i) {
+            Message *message = &slots[i]->message;
+            if (item_of[i] >= 0) {
+                if (items[item_of[i]].result != 0) {
+                    plans[i].send_error = true; // Ошибка отправки
+                    if (keep_running) {
+                         fprintf(stderr, "Sender Thread: Error sending message (type %u) to instance %d (handle %d).\n",
+                                message->header.message_type, slots[i]->instance_id, plans[i].client_handle);
+                    }
+                } else if (message->header.message_type == MESSAGE_TYPE_CONFIRM_INIT) {
+                    record_activation_latency(plans[i].instance);
+                }
+            }
+            sender_finish(&plans[i]);
         }
-        // --- Конец обработки ---
+        qmq_dequeue_end_burst(svm_outgoing_queue, count);
 
     } // end while
 
     printf("SVM Sender thread finished.\n");
     return NULL;
-}
\ No newline at end of file
+}
@@ -2,110 +2,177 @@
  * svm/svm_timers.c
  *
  * Описание:
- * Реализация логики потока таймера и потокобезопасного доступа
- * к счетчикам для МНОЖЕСТВА экземпляров SVM.
+ * Реализация периодических таймеров экземпляров SVM (на общей службе таймеров)
+ * и потокобезопасного доступа к счетчикам для МНОЖЕСТВА экземпляров SVM.
  */
 
 #include "svm_timers.h"
+#include "svm_scheduler.h"
+#include "svm_rng.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
 #include <time.h>
 #include <pthread.h>
 #include <stdbool.h>
 #include <errno.h>
 #include <limits.h> // Для UINT*_MAX
 
-// --- Глобальные переменные для синхронизации таймера ---
-pthread_mutex_t svm_timer_management_mutex;
-pthread_cond_t svm_timer_cond;
-volatile bool global_timer_keep_running = false; // Инициализируем как false
+// --- Таблица счетчиков экземпляров (структура массивов) ---
+// Массовое обновление одним таймером проходит по непрерывным массивам; писатели (служба таймеров
+// раз в TIMER_INTERVAL_LINK_STATUS_MS и listener при сбросе) сериализуются counters_write_mutex,
+// читатели-обработчики берут снимок без блокировок по seqlock экземпляра.
+typedef struct {
+    uint32_t seq[MAX_SVM_INSTANCES];  // Seqlock KLA/SLA/KSA (нечетное значение - идет запись)
+    uint16_t kla[MAX_SVM_INSTANCES];
+    uint32_t sla_us100[MAX_SVM_INSTANCES];
+    uint16_t ksa[MAX_SVM_INSTANCES];
+    // Только чтение между подключениями
+    uint64_t bcb_epoch_ns[MAX_SVM_INSTANCES] SVM_CACHE_ALIGNED; // Начало отсчета BCB (CLOCK_MONOTONIC)
+    // Только писатели под counters_write_mutex
+    SvmRng rng[MAX_SVM_INSTANCES] SVM_CACHE_ALIGNED;
+    bool active[MAX_SVM_INSTANCES];
+} SvmCounterTable;
+
+static SvmCounterTable svm_counters SVM_CACHE_ALIGNED;
+static pthread_mutex_t counters_write_mutex = PTHREAD_MUTEX_INITIALIZER;
+static SvmTimer *link_status_timer = NULL;
 
 // --- Реализация функций ---
 
-// Персональный таймер для одного экземпляра SVM
-void* svm_instance_timer_thread_func(void* arg) {
-    SvmInstance *instance = (SvmInstance*)arg;
-    if (!instance) {
-        fprintf(stderr, "InstanceTimer (ID %d): Invalid argument (NULL instance).\n", instance ? instance->id : -1);
-        return NULL;
-    }
-
-    printf("InstanceTimer (ID %d, LAK 0x%02X): Thread started.\n", instance->id, instance->assigned_lak);
-
-    // Для usleep интервал в микросекундах
-    useconds_t sleep_interval_us = TIMER_INTERVAL_BCB_MS * 1000;
+static uint64_t monotonic_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
 
-    while (instance->personal_timer_keep_running && keep_running) {
-        usleep(sleep_interval_us); // Спим заданный интервал
+// Публикация счетчиков линии одного экземпляра (под counters_write_mutex)
+static void counters_publish_locked(int id, uint16_t kla, uint32_t sla, uint16_t ksa) {
+    uint32_t seq = svm_counters.seq[id];
+    __atomic_store_n(&svm_counters.seq[id], seq + 1, __ATOMIC_RELAXED); // Нечетное: идет запись
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&svm_counters.kla[id], kla, __ATOMIC_RELAXED);
+    __atomic_store_n(&svm_counters.sla_us100[id], sla, __ATOMIC_RELAXED);
+    __atomic_store_n(&svm_counters.ksa[id], ksa, __ATOMIC_RELAXED);
+    __atomic_store_n(&svm_counters.seq[id], seq + 2, __ATOMIC_RELEASE);
+}
 
-        // Проверяем флаги снова после сна, на случай если их изменили во время сна
-        if (!(instance->personal_timer_keep_running && keep_running)) {
-            break;
+// Эмуляция изменения счетчиков линии (KLA, SLA, KSA) сразу для всех активных экземпляров
+static void link_status_tick_all(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&counters_write_mutex);
+    for (int id = 0; id < MAX_SVM_INSTANCES; ++id) {
+        if (!svm_counters.active[id]) continue;
+        SvmRng *rng = &svm_counters.rng[id];
+        uint16_t kla = svm_counters.kla[id];
+        uint32_t sla = svm_counters.sla_us100[id];
+        uint16_t ksa = svm_counters.ksa[id];
+        bool changed = false;
+
+        if (svm_rng_one_in(rng, LINK_CHANGE_PROBABILITY)) {
+            if (kla < UINT16_MAX) { kla++; changed = true; }
+            if (svm_rng_one_in(rng, LINK_LOW_PROBABILITY)) {
+                uint32_t increment = (uint32_t)TIMER_INTERVAL_LINK_STATUS_MS * 10;
+                sla = (sla <= UINT32_MAX - increment) ? sla + increment : UINT32_MAX;
+                changed = true;
+            }
+        }
+        if (svm_rng_one_in(rng, SIGN_DET_CHANGE_PROBABILITY)) {
+            if (ksa < UINT16_MAX) { ksa++; changed = true; }
         }
+        if (changed) counters_publish_locked(id, kla, sla, ksa);
+    }
+    pthread_mutex_unlock(&counters_write_mutex);
+}
 
-        pthread_mutex_lock(&instance->instance_mutex); // Блокируем мьютекс этого экземпляра
+// Граница цикла обзора: переключение набора параметров (вне instance_mutex)
+static void instance_cycle_tick(void *arg) {
+    SvmInstance *instance = (SvmInstance*)arg;
+    svm_params_cycle_tick(&instance->params);
+}
 
-        // Обновляем BCB
-        if (instance->bcb_counter < UINT32_MAX) {
-            instance->bcb_counter++;
-        } else {
-            instance->bcb_counter = 0; // Переполнение
-        }
+int svm_counters_timer_start(void) {
+    link_status_timer = svm_scheduler_schedule_periodic(TIMER_INTERVAL_LINK_STATUS_MS, link_status_tick_all, NULL);
+    if (!link_status_timer) {
+        fprintf(stderr, "SVM Timers: Failed to register link status timer.\n");
+        return -1;
+    }
+    return 0;
+}
 
-        // Обновление счетчиков линии (KLA, SLA, KSA)
-		instance->link_status_timer_counter++;
-		if (instance->link_status_timer_counter >= (TIMER_INTERVAL_LINK_STATUS_MS / TIMER_INTERVAL_BCB_MS)) {
-			instance->link_status_timer_counter = 0; // Сброс
-
-            if (rand() % LINK_CHANGE_PROBABILITY == 0) {
-                if (instance->link_up_changes_counter < UINT16_MAX) {
-                    instance->link_up_changes_counter++;
-                }
-                if (rand() % LINK_LOW_PROBABILITY == 0) {
-                    uint32_t increment = (uint32_t)TIMER_INTERVAL_LINK_STATUS_MS * 10;
-                    if (instance->link_up_low_time_us100 <= UINT32_MAX - increment) {
-                        instance->link_up_low_time_us100 += increment;
-                    } else {
-                        instance->link_up_low_time_us100 = UINT32_MAX;
-                    }
-                }
-            }
-            if (rand() % SIGN_DET_CHANGE_PROBABILITY == 0) {
-                if (instance->sign_det_changes_counter < UINT16_MAX) {
-                    instance->sign_det_changes_counter++;
-                }
-            }
-        }
-        pthread_mutex_unlock(&instance->instance_mutex); // Отпускаем мьютекс
+void svm_counters_timer_stop(void) {
+    svm_scheduler_cancel(link_status_timer);
+    link_status_timer = NULL;
+}
+
+bool svm_instance_timers_start(SvmInstance *instance) {
+    if (!instance) return false;
+    instance->cycle_timer = svm_scheduler_schedule_periodic(TIMER_INTERVAL_NTSO_MS, instance_cycle_tick, instance);
+    if (!instance->cycle_timer) {
+        fprintf(stderr, "InstanceTimers (ID %d): Failed to register periodic timers.\n", instance->id);
+        return false;
     }
+    pthread_mutex_lock(&counters_write_mutex);
+    svm_counters.active[instance->id] = true; // Счетчики линии обновляет общий таймер
+    pthread_mutex_unlock(&counters_write_mutex);
+    printf("InstanceTimers (ID %d, LAK 0x%02X): Periodic timers registered.\n", instance->id, instance->assigned_lak);
+    return true;
+}
 
-    printf("InstanceTimer (ID %d, LAK 0x%02X): Thread finished.\n", instance->id, instance->assigned_lak);
-    return NULL;
+void svm_instance_timers_stop(SvmInstance *instance) {
+    if (!instance) return;
+    pthread_mutex_lock(&counters_write_mutex);
+    svm_counters.active[instance->id] = false;
+    pthread_mutex_unlock(&counters_write_mutex);
+    svm_scheduler_cancel(instance->cycle_timer);
+    instance->cycle_timer = NULL;
 }
 
-uint32_t get_instance_bcb_counter(SvmInstance *instance) {
-    if (!instance) return 0;
-    uint32_t val;
+void svm_instance_reset_counters(SvmInstance *instance) {
+    if (!instance) return;
+    int id = instance->id;
+    pthread_mutex_lock(&counters_write_mutex);
+    __atomic_store_n(&svm_counters.bcb_epoch_ns[id], monotonic_now_ns(), __ATOMIC_RELAXED);
+    counters_publish_locked(id, 0, 0, 0);
+    svm_rng_seed(&svm_counters.rng[id], instance->rng_seed, (uint64_t)id); // Повторяемая последовательность сеанса
+    pthread_mutex_unlock(&counters_write_mutex);
+}
+
+uint16_t svm_instance_next_message_number(SvmInstance *instance) {
     pthread_mutex_lock(&instance->instance_mutex);
-    val = instance->bcb_counter;
+    uint16_t message_num = instance->message_counter++;
     pthread_mutex_unlock(&instance->instance_mutex);
-    return val;
+    return message_num;
+}
+
+uint32_t get_instance_bcb_counter(SvmInstance *instance) {
+    if (!instance) return 0;
+    // BCB - число интервалов TIMER_INTERVAL_BCB_MS с начала сеанса; переполнение uint32 как у аппаратного счетчика
+    uint64_t epoch = __atomic_load_n(&svm_counters.bcb_epoch_ns[instance->id], __ATOMIC_RELAXED);
+    uint64_t elapsed = monotonic_now_ns() - epoch;
+    return (uint32_t)(elapsed / ((uint64_t)TIMER_INTERVAL_BCB_MS * 1000000ull));
 }
 
 void get_instance_line_status_counters(SvmInstance *instance, uint16_t *kla, uint32_t *sla_us100, uint16_t *ksa) {
-     if (!instance) return;
-     pthread_mutex_lock(&instance->instance_mutex);
-     if (kla) *kla = instance->link_up_changes_counter;
-     if (sla_us100) *sla_us100 = instance->link_up_low_time_us100; // Используем новое имя
-     if (ksa) *ksa = instance->sign_det_changes_counter;
-     pthread_mutex_unlock(&instance->instance_mutex);
+    if (!instance) return;
+    int id = instance->id;
+    uint16_t kla_val, ksa_val;
+    uint32_t sla_val, seq_before, seq_after;
+    do {
+        seq_before = __atomic_load_n(&svm_counters.seq[id], __ATOMIC_ACQUIRE);
+        kla_val = __atomic_load_n(&svm_counters.kla[id], __ATOMIC_RELAXED);
+        sla_val = __atomic_load_n(&svm_counters.sla_us100[id], __ATOMIC_RELAXED);
+        ksa_val = __atomic_load_n(&svm_counters.ksa[id], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_after = __atomic_load_n(&svm_counters.seq[id], __ATOMIC_RELAXED);
+    } while ((seq_before & 1u) || seq_before != seq_after); // Повтор, если попали на запись
+    if (kla) *kla = kla_val;
+    if (sla_us100) *sla_us100 = sla_val;
+    if (ksa) *ksa = ksa_val;
 }
 
-// Глобальный init_svm_timer_sync теперь может быть проще или только для srand
+// Общих ресурсов сейчас нет: генераторы случайных чисел у каждого экземпляра свои
 int init_svm_app_wide_resources(void) { // Переименовал
-    srand(time(NULL));
-    printf("SVM App-wide resources (srand) initialized.\n");
+    printf("SVM App-wide resources initialized.\n");
     return 0;
 }
 
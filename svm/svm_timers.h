@@ -15,26 +15,58 @@
 #include "svm_types.h" // <-- ВКЛЮЧЕНО для SvmInstance
 
 // --- Константы для таймеров ---
-#define TIMER_INTERVAL_BCB_MS 50           // Интервал основного таймера BCB (в миллисекундах)
+#define TIMER_INTERVAL_BCB_MS 50           // Цена единицы счетчика BCB (в миллисекундах)
 #define TIMER_INTERVAL_LINK_STATUS_MS 500 // Частота эмуляции проверки статуса линии (в миллисекундах)
+#define TIMER_INTERVAL_NTSO_MS 1000        // Длительность эмулируемого цикла обзора (NTSO)
 #define LINK_CHANGE_PROBABILITY 2          // Вероятность изменения LinkUp (1/X)
 #define LINK_LOW_PROBABILITY 10            // Вероятность увеличения времени низкого уровня (1/Y) когда LinkUp меняется
 #define SIGN_DET_CHANGE_PROBABILITY 3      // Вероятность изменения SignDet (1/Z)
 
-// --- Глобальные переменные для таймера ---
-// (Определены в svm_timers.c)
-extern pthread_mutex_t svm_timer_management_mutex; // Мьютекс для управления запуском/остановкой таймера
-extern pthread_cond_t svm_timer_cond;              // Условная переменная для пробуждения/остановки таймера
-extern volatile bool keep_running;
+extern volatile bool keep_running; // Общий флаг работы svm_app (svm_main.c)
 
-// Прототип новой функции потока для персонального таймера
-void* svm_instance_timer_thread_func(void* arg);
+/**
+ * @brief Регистрирует общий таймер счетчиков линии (KLA/SLA/KSA) всех экземпляров.
+ * Служба таймеров должна быть запущена.
+ * @return 0 в случае успеха, -1 в случае ошибки.
+ */
+int svm_counters_timer_start(void);
+
+/**
+ * @brief Отменяет общий таймер счетчиков линии.
+ */
+void svm_counters_timer_stop(void);
+
+/**
+ * @brief Регистрирует таймер цикла обзора экземпляра в общей службе таймеров и включает
+ * экземпляр в массовое обновление счетчиков линии. Служба должна быть запущена.
+ * @return true в случае успеха.
+ */
+bool svm_instance_timers_start(SvmInstance *instance);
+
+/**
+ * @brief Отменяет таймеры экземпляра и исключает его из обновления счетчиков линии.
+ * После возврата обработчики таймеров экземпляра больше не выполняются.
+ */
+void svm_instance_timers_stop(SvmInstance *instance);
 
 // Функции для инициализации/уничтожения общих ресурсов (если нужны, например, srand)
 int init_svm_app_wide_resources(void); // Переименовано
 void destroy_svm_app_wide_resources(void); // Переименовано
 
-// Функции доступа к счетчикам остаются
+/**
+ * @brief Сбрасывает счетчики экземпляра: BCB начинает отсчет с текущего момента, KLA/SLA/KSA обнуляются,
+ * генератор эмуляции заново засевается instance->rng_seed.
+ * Вызывается до запуска таймеров экземпляра (без конкурирующего писателя).
+ */
+void svm_instance_reset_counters(SvmInstance *instance);
+
+/**
+ * @brief Выдает номер очередного исходящего сообщения экземпляра (message_counter, под instance_mutex).
+ * Ответы формируют потоки-обработчики, служба таймеров (отложенные ответы) и профиль сбоев.
+ */
+uint16_t svm_instance_next_message_number(SvmInstance *instance);
+
+// Функции доступа к счетчикам (без блокировок: BCB вычисляется по часам, KLA/SLA/KSA - снимок seqlock)
 uint32_t get_instance_bcb_counter(SvmInstance *instance);
 void get_instance_line_status_counters(SvmInstance *instance, uint16_t *kla, uint32_t *sla_us100, uint16_t *ksa);
 
@@ -14,53 +14,78 @@
 #include "../protocol/protocol_defs.h"
 // #include "../utils/ts_queued_msg_queue_fwd.h" // <-- УДАЛЕНО
 #include "../io/io_interface.h"
+#include "svm_params.h"
+#include "svm_replies.h"
 
-// Максимальное количество эмулируемых экземпляров СВ-М
-#define MAX_SVM_INSTANCES 4
+// Максимальное количество эмулируемых экземпляров СВ-М (совпадает с config/config.h)
+#define MAX_SVM_INSTANCES 16
 
 // Предварительное объявление структуры очереди
 struct ThreadSafeQueuedMsgQueue;
 
 extern pthread_mutex_t svm_instances_mutex;
 
-// Структура для хранения состояния связи с одним SVM
+// Размер строки кэша: границы групп полей, которые пишут разные потоки
+#define SVM_CACHE_LINE_SIZE 64
+#define SVM_CACHE_ALIGNED __attribute__((aligned(SVM_CACHE_LINE_SIZE)))
+
+// Фаза сеанса экземпляра (под instance_mutex)
+typedef enum {
+    SESSION_STANDBY = 0, // Receiver и входящая очередь готовы, ждем подключения УВМ
+    SESSION_RUNNING,     // Receiver обслуживает подключение
+    SESSION_FINISHED     // Receiver закончил, listener освобождает подключение
+} SvmSessionPhase;
+
+// Структура для хранения состояния связи с одним SVM.
+// Поля сгруппированы по потокам-писателям; горячие группы начинаются с новой строки кэша,
+// а выравнивание всей структуры исключает ложное разделение соседних элементов svm_instances[].
+// Счетчики BCB/KLA/SLA/KSA и генераторы эмуляции вынесены в таблицу svm_timers.c (структура массивов).
 typedef struct SvmInstance {
-    // --- Основные поля (как были) ---
+    // --- Холодная часть: меняется только listener'ом при подключении/отключении ---
     int id;
+    LogicalAddress assigned_lak;
     pthread_t receiver_tid;
-    pthread_t processor_tid;
-    pthread_t timer_tid; // <--- НОВОЕ ПОЛЕ для ID персонального таймер-потока
     IOInterface *io_handle; // Указатель на IO интерфейс listener'а этого экземпляра
     int client_handle;
-    bool is_active;
-    LogicalAddress assigned_lak;
+    bool muxed; // Сеанс идет по общему (мультиплексированному) соединению: client_handle не принадлежит экземпляру
     struct ThreadSafeQueuedMsgQueue *incoming_queue; // Используем предварительное объявление
+    struct SvmTimer *cycle_timer; // Таймер цикла обзора (в общей службе таймеров)
+    uint64_t rng_seed; // Зерно генератора эмуляции; генератор засевается им в начале каждого сеанса
 
-    // --- Состояние, специфичное для экземпляра ---
-    SVMState current_state;
-    uint16_t message_counter; // Счетчик исходящих сообщений
-    // --- Счетчики ---
-    volatile uint32_t bcb_counter;
-    uint16_t link_up_changes_counter;
-    uint32_t link_up_low_time_us100;
-    uint16_t sign_det_changes_counter;
-    int link_status_timer_counter;
-
-    pthread_mutex_t instance_mutex;
-	
-    // --- Флаг для управления персональным таймером ---
-    volatile bool personal_timer_keep_running; // <--- НОВЫЙ ФЛАГ
-
-    // --- ПОЛЯ ДЛЯ ИМИТАЦИИ СБОЕВ ---
-	bool user_flag1; // Для кастомной логики сбоев (например, прекратить отвечать)
+    // --- Настройки имитации сбоев (из конфигурации) ---
     bool simulate_control_failure;
     int disconnect_after_messages; // -1 = off
-    int messages_sent_count;      // Счетчик отправленных для disconnect_after
     bool simulate_response_timeout;
     bool send_warning_on_confirm;
     uint8_t warning_tks;
-    // -----------------------------------------
 
+    SvmReplyTemplates replies; // Шаблоны управляющих ответов (строятся при инициализации, далее только чтение)
+
+    // --- Горячий резерв: Receiver и входящая очередь живут все время работы (под instance_mutex) ---
+    pthread_cond_t session_cond;   // Смена session_phase
+    SvmSessionPhase session_phase;
+    bool receiver_exit;            // Receiver должен завершиться (остановка svm_app)
+    uint64_t accept_ns;            // Момент accept текущего сеанса; 0 - «Подтверждение инициализации» уже ушло
+    unsigned long activation_count; // Статистика accept -> «Подтверждение инициализации»
+    uint64_t activation_min_ns;
+    uint64_t activation_max_ns;
+    uint64_t activation_sum_ns;
+    EthernetTcpInfo tcp_info;      // Снимок TCP_INFO соединения сеанса (tcp_info_interval_ms; пишет main)
+    uint64_t tcp_info_ns;          // Момент снимка (0 - в этом сеансе снимков не было)
+
+    // --- Горячая часть: состояние под instance_mutex (обработчик, отправитель, служба таймеров) ---
+    pthread_mutex_t instance_mutex SVM_CACHE_ALIGNED;
+    bool is_active;
+    SVMState current_state;
+    uint32_t session_id;      // Номер сеанса связи (увеличивается при каждом подключении УВМ)
+    uint16_t message_counter; // Счетчик исходящих сообщений
+    int messages_sent_count;  // Счетчик отправленных для disconnect_after
+    bool user_flag1; // Для кастомной логики сбоев (например, прекратить отвечать)
+    int proc_scheduled; // Экземпляр стоит в очереди пула обработчиков или обрабатывается (__atomic)
+    int proc_pending;   // Во входящей очереди появилось сообщение после начала обработки (__atomic)
+
+    // --- Параметры съемки (активный и собираемый наборы) ---
+    SvmParamStore params SVM_CACHE_ALIGNED;
 } SvmInstance;
 
 // Структура для передачи сообщений в очередях
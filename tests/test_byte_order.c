@@ -0,0 +1,145 @@
+/*
+ * tests/test_byte_order.c
+ *
+ * Описание:
+ * Проверка преобразования порядка байт сообщений туда и обратно:
+ * отправитель переводит сообщение в сетевой порядок (message_to_network_byte_order),
+ * получатель - в порядок хоста (message_to_host_byte_order); массивы таблиц
+ * (HRR «Принять параметры СДР», HAR «Принять параметры ЦДР», REF_AZIMUTH)
+ * должны прийти без искажений, а в кадре на линии - идти старшим байтом вперед.
+ * Запуск: make test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <arpa/inet.h>
+
+#include "../protocol/protocol_defs.h"
+#include "../protocol/message_utils.h"
+
+#define TEST_HRR_COUNT 100
+#define TEST_TSD_NIN 12
+#define TEST_TSD_NOUT 5
+#define TEST_TSD_NAR 3
+
+static int failures = 0;
+
+#define CHECK(cond, what) do { \
+        if (!(cond)) { fprintf(stderr, "FAIL: %s (%s:%d)\n", (what), __FILE__, __LINE__); failures++; } \
+    } while (0)
+
+// Значение i-го int16 массива: оба байта различны и ненулевые, чтобы перестановка была видна
+static int16_t sample_value(size_t i) {
+    return (int16_t)(0x0102 + (uint16_t)(i * 0x0203));
+}
+
+static void fill_int16(uint8_t *bytes, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        int16_t v = sample_value(i);
+        memcpy(bytes + i * sizeof(v), &v, sizeof(v));
+    }
+}
+
+static bool int16_equal(const uint8_t *bytes, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        int16_t v;
+        memcpy(&v, bytes + i * sizeof(v), sizeof(v));
+        if (v != sample_value(i)) return false;
+    }
+    return true;
+}
+
+// Кадр на линии: int16 массива - старшим байтом вперед
+static bool int16_big_endian(const uint8_t *bytes, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t v = (uint16_t)sample_value(i);
+        if (bytes[2 * i] != (uint8_t)(v >> 8) || bytes[2 * i + 1] != (uint8_t)(v & 0xFF)) return false;
+    }
+    return true;
+}
+
+// Отправка и прием: копия кадра «на линии» переводится получателем в порядок хоста
+static void round_trip(const Message *sent, Message *wire, Message *received) {
+    memcpy(wire, sent, sizeof(Message));
+    message_to_network_byte_order(wire);
+    memcpy(received, wire, sizeof(Message));
+    message_to_host_byte_order(received);
+}
+
+static void test_sdr_hrr(void) {
+    static Message sent, wire, received;
+    memset(&sent, 0, sizeof(sent));
+    sent.header.message_type = MESSAGE_TYPE_PRIYAT_PARAMETRY_SDR;
+    size_t body_len = sizeof(PrinyatParametrySdrBodyBase) + TEST_HRR_COUNT * sizeof(complex_fixed16_t);
+    sent.header.body_length = htons((uint16_t)body_len); // Заголовок и поля - как у построителей сообщений
+    PrinyatParametrySdrBodyBase *base = (PrinyatParametrySdrBodyBase*)sent.body;
+    base->mrr = htons(TEST_HRR_COUNT);
+    base->nfft = htons(1024);
+    uint8_t *hrr = sent.body + sizeof(*base);
+    fill_int16(hrr, TEST_HRR_COUNT * 2);
+
+    round_trip(&sent, &wire, &received);
+    const PrinyatParametrySdrBodyBase *rbase = (const PrinyatParametrySdrBodyBase*)received.body;
+    CHECK(received.header.body_length == body_len, "SDR body_length");
+    CHECK(rbase->mrr == TEST_HRR_COUNT && rbase->nfft == 1024, "SDR scalar fields");
+    CHECK(int16_big_endian(wire.body + sizeof(*base), TEST_HRR_COUNT * 2), "SDR HRR on the wire is big-endian");
+    CHECK(int16_equal(received.body + sizeof(*base), TEST_HRR_COUNT * 2), "SDR HRR survives the round trip");
+
+    // Отправитель после send_protocol_message переводит свой буфер обратно в порядок хоста
+    memcpy(&wire, &sent, sizeof(Message));
+    message_to_network_byte_order(&wire);
+    message_to_host_byte_order(&wire);
+    CHECK(int16_equal(wire.body + sizeof(*base), TEST_HRR_COUNT * 2), "SDR HRR restored in the sender's buffer");
+}
+
+static void test_tsd_har(void) {
+    static Message sent, wire, received;
+    memset(&sent, 0, sizeof(sent));
+    sent.header.message_type = MESSAGE_TYPE_PRIYAT_PARAMETRY_TSD;
+    size_t har_offset = sizeof(PrinyatParametryTsdBodyBase) + TEST_TSD_NOUT + TEST_TSD_NIN;
+    size_t har_values = (size_t)TEST_TSD_NAR * TEST_TSD_NIN * 2;
+    size_t body_len = har_offset + har_values * sizeof(int16_t);
+    sent.header.body_length = htons((uint16_t)body_len);
+    PrinyatParametryTsdBodyBase *base = (PrinyatParametryTsdBodyBase*)sent.body;
+    base->nin = htons(TEST_TSD_NIN);
+    base->nout = htons(TEST_TSD_NOUT);
+    base->nar = TEST_TSD_NAR;
+    for (size_t i = 0; i < TEST_TSD_NOUT + TEST_TSD_NIN; ++i) sent.body[sizeof(*base) + i] = (uint8_t)(0xA0 + i);
+    fill_int16(sent.body + har_offset, har_values);
+
+    round_trip(&sent, &wire, &received);
+    const PrinyatParametryTsdBodyBase *rbase = (const PrinyatParametryTsdBodyBase*)received.body;
+    CHECK(rbase->nin == TEST_TSD_NIN && rbase->nout == TEST_TSD_NOUT && rbase->nar == TEST_TSD_NAR, "TSD scalar fields");
+    CHECK(memcmp(received.body + sizeof(*base), sent.body + sizeof(*base), TEST_TSD_NOUT + TEST_TSD_NIN) == 0,
+          "TSD OKM/HShMR bytes unchanged");
+    CHECK(int16_big_endian(wire.body + har_offset, har_values), "TSD HAR on the wire is big-endian");
+    CHECK(int16_equal(received.body + har_offset, har_values), "TSD HAR survives the round trip");
+}
+
+static void test_ref_azimuth(void) {
+    static Message sent, wire, received;
+    memset(&sent, 0, sizeof(sent));
+    sent.header.message_type = MESSAGE_TYPE_PRIYAT_REF_AZIMUTH;
+    sent.header.body_length = htons(sizeof(PrinyatRefAzimuthBody));
+    PrinyatRefAzimuthBody *body = (PrinyatRefAzimuthBody*)sent.body;
+    body->NTSO = htons(7);
+    fill_int16((uint8_t*)body->ref_azimuth, REF_AZIMUTH_SIZE);
+
+    round_trip(&sent, &wire, &received);
+    const PrinyatRefAzimuthBody *rbody = (const PrinyatRefAzimuthBody*)received.body;
+    CHECK(rbody->NTSO == 7, "REF_AZIMUTH NTSO");
+    CHECK(int16_equal((const uint8_t*)rbody->ref_azimuth, REF_AZIMUTH_SIZE), "REF_AZIMUTH survives the round trip");
+}
+
+int main(void) {
+    test_sdr_hrr();
+    test_tsd_har();
+    test_ref_azimuth();
+    if (failures > 0) {
+        fprintf(stderr, "test_byte_order: %d check(s) failed.\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("test_byte_order: all checks passed.\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*
+ * tests/test_complex_convert.c
+ *
+ * Описание:
+ * Проверка ядер преобразования комплексных отсчетов (protocol/complex_convert.c):
+ * каждая доступная на процессоре реализация (scalar, SSE2, AVX2) сравнивается со
+ * скалярной формулой для плоскостей float и int32 и для модуля - на длинах, не кратных
+ * ширине векторов, на невыровненных массивах и на крайних значениях int8/int16.
+ * Запуск: make test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "../protocol/complex_convert.h"
+
+#define TEST_MAX_COUNT 4099
+#define TEST_OFFSET 1 // Сдвиг массивов на элемент: ядра не должны требовать выравнивания
+
+static int failures = 0;
+
+#define CHECK(cond, what) do { \
+        if (!(cond)) { fprintf(stderr, "FAIL: %s (%s:%d)\n", (what), __FILE__, __LINE__); failures++; } \
+    } while (0)
+
+static complex_int8_t src8[TEST_MAX_COUNT + TEST_OFFSET];
+static complex_fixed16_t src16[TEST_MAX_COUNT + TEST_OFFSET];
+static float re_f[TEST_MAX_COUNT + TEST_OFFSET], im_f[TEST_MAX_COUNT + TEST_OFFSET], mag[TEST_MAX_COUNT + TEST_OFFSET];
+static int32_t re_i[TEST_MAX_COUNT + TEST_OFFSET], im_i[TEST_MAX_COUNT + TEST_OFFSET];
+
+// Отсчеты с крайними значениями в начале и псевдослучайными далее
+static void fill_sources(void) {
+    static const int16_t edges16[] = { -32768, 32767, 0, -1, 1, -32767 };
+    static const int8_t edges8[] = { -128, 127, 0, -1, 1, -127 };
+    unsigned seed = 12345;
+    for (size_t i = 0; i < TEST_MAX_COUNT + TEST_OFFSET; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        size_t e = i % 6;
+        bool edge = i < 12;
+        src8[i].real = edge ? edges8[e] : (int8_t)(seed >> 8);
+        src8[i].imag = edge ? edges8[5 - e] : (int8_t)(seed >> 16);
+        src16[i].real = edge ? edges16[e] : (int16_t)(seed >> 4);
+        src16[i].imag = edge ? edges16[5 - e] : (int16_t)(seed >> 12);
+    }
+}
+
+static bool magnitude_ok(float got, int32_t r, int32_t m) {
+    float want = sqrtf((float)r * (float)r + (float)m * (float)m);
+    return fabsf(got - want) <= 1e-3f * (want + 1.0f);
+}
+
+static void check_count(const char *impl, size_t count) {
+    const complex_int8_t *s8 = src8 + TEST_OFFSET;
+    const complex_fixed16_t *s16 = src16 + TEST_OFFSET;
+    float *rf = re_f + TEST_OFFSET, *imf = im_f + TEST_OFFSET, *mg = mag + TEST_OFFSET;
+    int32_t *ri = re_i + TEST_OFFSET, *imi = im_i + TEST_OFFSET;
+    char what[96];
+    bool ok;
+
+    complex_i8_to_planes_f32(s8, count, rf, imf);
+    ok = true;
+    for (size_t i = 0; i < count; ++i) ok &= rf[i] == (float)s8[i].real && imf[i] == (float)s8[i].imag;
+    snprintf(what, sizeof(what), "%s i8->f32, %zu elements", impl, count);
+    CHECK(ok, what);
+
+    complex_i8_to_planes_i32(s8, count, ri, imi);
+    ok = true;
+    for (size_t i = 0; i < count; ++i) ok &= ri[i] == s8[i].real && imi[i] == s8[i].imag;
+    snprintf(what, sizeof(what), "%s i8->i32, %zu elements", impl, count);
+    CHECK(ok, what);
+
+    complex_i8_magnitude_f32(s8, count, mg);
+    ok = true;
+    for (size_t i = 0; i < count; ++i) ok &= magnitude_ok(mg[i], s8[i].real, s8[i].imag);
+    snprintf(what, sizeof(what), "%s i8 |z|, %zu elements", impl, count);
+    CHECK(ok, what);
+
+    complex_i16_to_planes_f32(s16, count, rf, imf);
+    ok = true;
+    for (size_t i = 0; i < count; ++i) ok &= rf[i] == (float)s16[i].real && imf[i] == (float)s16[i].imag;
+    snprintf(what, sizeof(what), "%s i16->f32, %zu elements", impl, count);
+    CHECK(ok, what);
+
+    complex_i16_to_planes_i32(s16, count, ri, imi);
+    ok = true;
+    for (size_t i = 0; i < count; ++i) ok &= ri[i] == s16[i].real && imi[i] == s16[i].imag;
+    snprintf(what, sizeof(what), "%s i16->i32, %zu elements", impl, count);
+    CHECK(ok, what);
+
+    complex_i16_magnitude_f32(s16, count, mg);
+    ok = true;
+    for (size_t i = 0; i < count; ++i) ok &= magnitude_ok(mg[i], s16[i].real, s16[i].imag);
+    snprintf(what, sizeof(what), "%s i16 |z|, %zu elements", impl, count);
+    CHECK(ok, what);
+}
+
+int main(void) {
+    static const char *impls[] = { "scalar", "sse2", "avx2" };
+    static const size_t counts[] = { 0, 1, 3, 7, 8, 15, 16, 17, 31, 33, TIME_REF_RANGE_ELEMENTS, TEST_MAX_COUNT };
+    fill_sources();
+    int tested = 0;
+    for (size_t k = 0; k < sizeof(impls) / sizeof(impls[0]); ++k) {
+        if (complex_convert_force_impl(impls[k]) != 0) {
+            printf("test_complex_convert: %s is not available on this CPU, skipped.\n", impls[k]);
+            continue;
+        }
+        tested++;
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) check_count(impls[k], counts[c]);
+    }
+    CHECK(tested > 0, "at least the scalar implementation is tested");
+    if (failures > 0) {
+        fprintf(stderr, "test_complex_convert: %d check(s) failed.\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("test_complex_convert: all checks passed (%d implementations).\n", tested);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/*
+ * tests/test_param_signature.c
+ *
+ * Описание:
+ * Проверка подписи набора параметров съемки (расширение «Подтверждения инициализации»):
+ * УВМ хеширует таблицу, отправленную в СВ-М (копию после message_to_network_byte_order),
+ * СВ-М - ту же таблицу после приема (message_to_host_byte_order, svm_params_apply_message).
+ * Хеши обязаны совпасть и для таблиц с ненулевыми 16-битными полями и массивами HRR/HAR,
+ * иначе УВМ не узнает уже загруженный набор при переподключении.
+ * Запуск: make test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <arpa/inet.h>
+
+#include "../protocol/protocol_defs.h"
+#include "../protocol/message_utils.h"
+#include "../svm/svm_params.h"
+
+#define TEST_HRR_COUNT 100
+#define TEST_TSD_NIN 12
+#define TEST_TSD_NOUT 5
+#define TEST_TSD_NAR 3
+
+static int failures = 0;
+
+#define CHECK(cond, what) do { \
+        if (!(cond)) { fprintf(stderr, "FAIL: %s (%s:%d)\n", (what), __FILE__, __LINE__); failures++; } \
+    } while (0)
+
+static void fill_int16(uint8_t *bytes, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        int16_t v = (int16_t)(0x0102 + (uint16_t)(i * 0x0203)); // Оба байта различны
+        memcpy(bytes + i * sizeof(v), &v, sizeof(v));
+    }
+}
+
+// Таблицы - как их строит УВМ: скалярные поля сразу в сетевом порядке, массивы - в порядке хоста
+static void build_so(Message *m) {
+    memset(m, 0, sizeof(*m));
+    m->header.message_type = MESSAGE_TYPE_PRIYAT_PARAMETRY_SO;
+    m->header.body_length = htons(sizeof(PrinyatParametrySoBody));
+    PrinyatParametrySoBody *body = (PrinyatParametrySoBody*)m->body;
+    body->q = htons(0x1234);
+    body->knk = htons(7);
+    body->l1 = htons(0x0A0B);
+    body->rgd = htons(300);
+    body->fixp = htons(0x0102);
+}
+
+static void build_reper(Message *m) {
+    memset(m, 0, sizeof(*m));
+    m->header.message_type = MESSAGE_TYPE_PRIYAT_REPER;
+    m->header.body_length = htons(sizeof(PrinyatReperBody));
+    PrinyatReperBody *body = (PrinyatReperBody*)m->body;
+    body->NTSO1 = htons(11);
+    body->ReperR1 = htons(0x2345);
+    body->ReperA4 = htons(0x3456);
+}
+
+static void build_sdr(Message *m) {
+    memset(m, 0, sizeof(*m));
+    m->header.message_type = MESSAGE_TYPE_PRIYAT_PARAMETRY_SDR;
+    m->header.body_length = htons((uint16_t)(sizeof(PrinyatParametrySdrBodyBase) + TEST_HRR_COUNT * sizeof(complex_fixed16_t)));
+    PrinyatParametrySdrBodyBase *base = (PrinyatParametrySdrBodyBase*)m->body;
+    base->q = htons(0x0102);
+    base->nfft = htons(1024);
+    base->mrr = htons(TEST_HRR_COUNT);
+    fill_int16(m->body + sizeof(*base), TEST_HRR_COUNT * 2);
+}
+
+static void build_tsd(Message *m) {
+    memset(m, 0, sizeof(*m));
+    m->header.message_type = MESSAGE_TYPE_PRIYAT_PARAMETRY_TSD;
+    size_t har_offset = sizeof(PrinyatParametryTsdBodyBase) + TEST_TSD_NOUT + TEST_TSD_NIN;
+    size_t har_values = (size_t)TEST_TSD_NAR * TEST_TSD_NIN * 2;
+    m->header.body_length = htons((uint16_t)(har_offset + har_values * sizeof(int16_t)));
+    PrinyatParametryTsdBodyBase *base = (PrinyatParametryTsdBodyBase*)m->body;
+    base->nin = htons(TEST_TSD_NIN);
+    base->nout = htons(TEST_TSD_NOUT);
+    base->mrn = htons(0x0304);
+    base->nar = TEST_TSD_NAR;
+    for (size_t i = 0; i < TEST_TSD_NOUT + TEST_TSD_NIN; ++i) m->body[sizeof(*base) + i] = (uint8_t)(0xA0 + i);
+    fill_int16(m->body + har_offset, har_values);
+}
+
+static void build_ref_azimuth(Message *m) {
+    memset(m, 0, sizeof(*m));
+    m->header.message_type = MESSAGE_TYPE_PRIYAT_REF_AZIMUTH;
+    m->header.body_length = htons(sizeof(PrinyatRefAzimuthBody));
+    PrinyatRefAzimuthBody *body = (PrinyatRefAzimuthBody*)m->body;
+    body->NTSO = htons(7);
+    fill_int16((uint8_t*)body->ref_azimuth, REF_AZIMUTH_SIZE);
+}
+
+// Хеш УВМ (как uvm_send_param_table): копия таблицы в порядке линии
+static uint32_t uvm_table_hash(const Message *sent, Message *wire) {
+    memcpy(wire, sent, sizeof(Message));
+    message_to_network_byte_order(wire);
+    return param_table_hash(wire->body, ntohs(wire->header.body_length));
+}
+
+int main(void) {
+    static Message sent, wire, received;
+    static void (*const builders[])(Message*) = { build_so, build_reper, build_sdr, build_tsd, build_ref_azimuth };
+    SvmParamStore store;
+    if (svm_params_init(&store) != 0) {
+        fprintf(stderr, "test_param_signature: svm_params_init failed.\n");
+        return EXIT_FAILURE;
+    }
+    uint32_t uvm_hashes[PARAM_SIGNATURE_TABLES] = {0};
+
+    for (size_t t = 0; t < sizeof(builders) / sizeof(builders[0]); ++t) {
+        builders[t](&sent);
+        int slot = param_signature_slot(sent.header.message_type);
+        uvm_hashes[slot] = uvm_table_hash(&sent, &wire);
+
+        // СВ-М: прием кадра с линии и применение таблицы
+        memcpy(&received, &wire, sizeof(Message));
+        message_to_host_byte_order(&received);
+        CHECK(svm_params_apply_message(&store, &received) == 0, "SVM accepts the table");
+        char what[96];
+        snprintf(what, sizeof(what), "table type %u hashes equal on both sides", sent.header.message_type);
+        CHECK(store.staging->table_hash[slot] == uvm_hashes[slot], what);
+    }
+    CHECK(svm_params_signature(&store) == param_signature(uvm_hashes), "set signatures equal on both sides");
+
+    svm_params_destroy(&store);
+    if (failures > 0) {
+        fprintf(stderr, "test_param_signature: %d check(s) failed.\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("test_param_signature: all checks passed.\n");
+    return EXIT_SUCCESS;
+}
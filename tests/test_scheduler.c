@@ -0,0 +1,100 @@
+/*
+ * tests/test_scheduler.c
+ *
+ * Описание:
+ * Проверка отмены периодических таймеров службы svm_scheduler: таймер, отмененный
+ * из собственного обработчика, больше не вызывается и освобождается потоком службы;
+ * таймер, отмененный из другого потока, освобождается отменившим потоком.
+ * Освобождение отслеживается подменой free (сборка с -Wl,--wrap=free).
+ * Запуск: make test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "../svm/svm_scheduler.h"
+#include "../utils/ts_queued_msg_queue.h"
+
+#define TEST_PERIOD_MS 10
+#define TEST_SELF_CANCEL_AFTER 3
+
+ThreadSafeQueuedMsgQueue *svm_outgoing_queue = NULL; // Отложенные ответы в тесте не используются
+
+static int failures = 0;
+
+#define CHECK(cond, what) do { \
+        if (!(cond)) { fprintf(stderr, "FAIL: %s (%s:%d)\n", (what), __FILE__, __LINE__); failures++; } \
+    } while (0)
+
+// Подмена free: отмечает освобождение отслеживаемого таймера
+void __real_free(void *ptr);
+static void *volatile watched_timer = NULL;
+static volatile bool watched_freed = false;
+
+void __wrap_free(void *ptr) {
+    if (ptr && ptr == watched_timer) watched_freed = true;
+    __real_free(ptr);
+}
+
+typedef struct {
+    SvmTimer *timer;
+    volatile int calls;
+    bool self_cancel;
+} TestTimer;
+
+static void test_tick(void *arg) {
+    TestTimer *tt = (TestTimer*)arg;
+    int calls = __atomic_add_fetch(&tt->calls, 1, __ATOMIC_RELAXED);
+    if (tt->self_cancel && calls == TEST_SELF_CANCEL_AFTER) {
+        svm_scheduler_cancel(__atomic_load_n(&tt->timer, __ATOMIC_ACQUIRE));
+    }
+}
+
+static void test_self_cancel(void) {
+    static TestTimer tt = { NULL, 0, true };
+    SvmTimer *timer = svm_scheduler_schedule_periodic(TEST_PERIOD_MS, test_tick, &tt);
+    CHECK(timer != NULL, "periodic timer scheduled");
+    if (!timer) return;
+    watched_freed = false;
+    watched_timer = timer;
+    __atomic_store_n(&tt.timer, timer, __ATOMIC_RELEASE);
+
+    usleep(TEST_PERIOD_MS * (TEST_SELF_CANCEL_AFTER + 10) * 1000);
+    CHECK(__atomic_load_n(&tt.calls, __ATOMIC_RELAXED) == TEST_SELF_CANCEL_AFTER, "self-cancelled timer is not called again");
+    CHECK(watched_freed, "self-cancelled periodic timer is freed");
+}
+
+static void test_cancel_from_other_thread(void) {
+    static TestTimer tt = { NULL, 0, false };
+    SvmTimer *timer = svm_scheduler_schedule_periodic(TEST_PERIOD_MS, test_tick, &tt);
+    CHECK(timer != NULL, "periodic timer scheduled");
+    if (!timer) return;
+    watched_freed = false;
+    watched_timer = timer;
+
+    usleep(TEST_PERIOD_MS * 5 * 1000);
+    svm_scheduler_cancel(timer);
+    CHECK(watched_freed, "cancelled periodic timer is freed by the cancelling thread");
+    int calls = __atomic_load_n(&tt.calls, __ATOMIC_RELAXED);
+    CHECK(calls > 0, "timer ran before cancellation");
+    usleep(TEST_PERIOD_MS * 5 * 1000);
+    CHECK(__atomic_load_n(&tt.calls, __ATOMIC_RELAXED) == calls, "cancelled timer is not called again");
+}
+
+int main(void) {
+    if (svm_scheduler_start() != 0) {
+        fprintf(stderr, "test_scheduler: svm_scheduler_start failed.\n");
+        return EXIT_FAILURE;
+    }
+    test_self_cancel();
+    test_cancel_from_other_thread();
+    svm_scheduler_stop();
+    watched_timer = NULL;
+    if (failures > 0) {
+        fprintf(stderr, "test_scheduler: %d check(s) failed.\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("test_scheduler: all checks passed.\n");
+    return EXIT_SUCCESS;
+}
@@ -20,16 +20,19 @@ ThreadSafeReqQueue* queue_req_create(size_t capacity) {
     // Выделяем память под UvmRequest
     queue->buffer = (UvmRequest*)malloc(capacity * sizeof(UvmRequest));
     if (!queue->buffer) { /* ... */ free(queue); return NULL; }
+    queue->released = (bool*)calloc(capacity, sizeof(bool));
+    if (!queue->released) { free(queue->buffer); free(queue); return NULL; }
 
     queue->capacity = capacity;
     queue->count = 0;
+    queue->taken = 0;
     queue->head = 0;
     queue->tail = 0;
     queue->shutdown = false;
 
-    if (pthread_mutex_init(&queue->mutex, NULL) != 0) { /* ... */ free(queue->buffer); free(queue); return NULL; }
-    if (pthread_cond_init(&queue->cond_not_empty, NULL) != 0) { /* ... */ pthread_mutex_destroy(&queue->mutex); free(queue->buffer); free(queue); return NULL; }
-    if (pthread_cond_init(&queue->cond_not_full, NULL) != 0) { /* ... */ pthread_cond_destroy(&queue->cond_not_empty); pthread_mutex_destroy(&queue->mutex); free(queue->buffer); free(queue); return NULL; }
+    if (pthread_mutex_init(&queue->mutex, NULL) != 0) { /* ... */ free(queue->released); free(queue->buffer); free(queue); return NULL; }
+    if (pthread_cond_init(&queue->cond_not_empty, NULL) != 0) { /* ... */ pthread_mutex_destroy(&queue->mutex); free(queue->released); free(queue->buffer); free(queue); return NULL; }
+    if (pthread_cond_init(&queue->cond_not_full, NULL) != 0) { /* ... */ pthread_cond_destroy(&queue->cond_not_empty); pthread_mutex_destroy(&queue->mutex); free(queue->released); free(queue->buffer); free(queue); return NULL; }
 
     printf("Thread-safe UVM request queue created with capacity %zu\n", capacity);
     return queue;
@@ -40,6 +43,7 @@ void queue_req_destroy(ThreadSafeReqQueue *queue) {
     pthread_mutex_destroy(&queue->mutex);
     pthread_cond_destroy(&queue->cond_not_empty);
     pthread_cond_destroy(&queue->cond_not_full);
+    free(queue->released);
     free(queue->buffer);
     free(queue);
     printf("Thread-safe UVM request queue destroyed\n");
@@ -70,25 +74,50 @@ bool queue_req_enqueue(ThreadSafeReqQueue *queue, const UvmRequest *request) {
 
 // Работаем с UvmRequest
 bool queue_req_dequeue(ThreadSafeReqQueue *queue, UvmRequest *request) {
-     if (!queue || !request) return false;
+    if (!queue || !request) return false;
+    UvmRequest *slot = queue_req_dequeue_begin(queue);
+    if (!slot) return false;
+    // Копируем структуру UvmRequest
+    memcpy(request, slot, sizeof(UvmRequest));
+    queue_req_dequeue_end(queue, slot);
+    return true;
+}
+
+UvmRequest* queue_req_dequeue_begin(ThreadSafeReqQueue *queue) {
+    if (!queue) return NULL;
 
     pthread_mutex_lock(&queue->mutex);
-    while (queue->count == 0 && !queue->shutdown) {
+    // Выданные потребителю слоты остаются в count, пока он их не вернет
+    while (queue->count == queue->taken && !queue->shutdown) {
         pthread_cond_wait(&queue->cond_not_empty, &queue->mutex);
     }
-    if (queue->shutdown && queue->count == 0) {
+    if (queue->count == queue->taken) {
         pthread_mutex_unlock(&queue->mutex);
-        return false;
+        return NULL;
     }
+    UvmRequest *slot = &queue->buffer[(queue->tail + queue->taken) % queue->capacity];
+    queue->taken++;
+    pthread_mutex_unlock(&queue->mutex);
+    return slot;
+}
 
-    // Копируем структуру UvmRequest
-    memcpy(request, &queue->buffer[queue->tail], sizeof(UvmRequest));
+void queue_req_dequeue_end(ThreadSafeReqQueue *queue, const UvmRequest *slot) {
+    if (!queue || !slot) return;
 
-    queue->tail = (queue->tail + 1) % queue->capacity;
-    queue->count--;
-    pthread_cond_signal(&queue->cond_not_full);
+    pthread_mutex_lock(&queue->mutex);
+    queue->released[slot - queue->buffer] = true;
+    // Место освобождается с начала очереди: слот, возвращенный раньше более старых, ждет их
+    size_t freed = 0;
+    while (queue->taken > 0 && queue->released[queue->tail]) {
+        queue->released[queue->tail] = false;
+        queue->tail = (queue->tail + 1) % queue->capacity;
+        queue->count--;
+        queue->taken--;
+        freed++;
+    }
+    if (freed > 1) pthread_cond_broadcast(&queue->cond_not_full);
+    else if (freed == 1) pthread_cond_signal(&queue->cond_not_full);
     pthread_mutex_unlock(&queue->mutex);
-    return true;
 }
 
 void queue_req_shutdown(ThreadSafeReqQueue *queue) {
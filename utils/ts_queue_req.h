@@ -4,6 +4,10 @@
  * Описание:
  * Потокобезопасная очередь для передачи UvmRequest между потоками UVM.
  * (Адаптированная копия ts_queue.h)
+ * Кроме копирующего dequeue потребитель может читать запрос прямо в слоте буфера
+ * (queue_req_dequeue_begin/queue_req_dequeue_end) и удерживать несколько слотов сразу:
+ * так поток отправки отдает кадр ядру без копирования (MSG_ZEROCOPY). Слоты
+ * возвращаются очереди в любом порядке, место освобождается по мере возврата самых старых.
  */
 
 #ifndef TS_QUEUE_REQ_H
@@ -16,8 +20,10 @@
 
 typedef struct {
     UvmRequest *buffer; // <--- Тип буфера изменен на UvmRequest*
+    bool *released;     // Слот, выданный потребителю, уже возвращен (queue_req_dequeue_end)
     size_t capacity;
-    size_t count;
+    size_t count;       // Занятые слоты, включая выданные потребителю
+    size_t taken;       // Из них выданы потребителю и еще не освобождены (начиная с tail)
     size_t head;
     size_t tail;
     pthread_mutex_t mutex;
@@ -46,6 +52,18 @@ bool queue_req_enqueue(ThreadSafeReqQueue *queue, const UvmRequest *request); //
  */
 bool queue_req_dequeue(ThreadSafeReqQueue *queue, UvmRequest *request); // <--- Имя и тип аргумента изменены
 
+/**
+ * @brief Возвращает указатель на следующий запрос без копирования (ждет, если очередь пуста).
+ * Только для единственного потребителя очереди; слот действителен до queue_req_dequeue_end().
+ * @return Указатель на слот или NULL, если очередь закрыта и невыданных запросов нет.
+ */
+UvmRequest* queue_req_dequeue_begin(ThreadSafeReqQueue *queue);
+
+/**
+ * @brief Возвращает очереди слот, полученный от queue_req_dequeue_begin().
+ */
+void queue_req_dequeue_end(ThreadSafeReqQueue *queue, const UvmRequest *slot);
+
 /**
  * @brief Сигнализирует о завершении работы очереди запросов.
  */
@@ -12,6 +12,14 @@
 #include <pthread.h>
 #include <stdbool.h>
 
+// Состояния слотов кольцевого буфера
+enum {
+    QMQ_SLOT_FREE = 0,
+    QMQ_SLOT_RESERVED,  // Производитель заполняет слот
+    QMQ_SLOT_READY,     // Слот готов к выдаче потребителю
+    QMQ_SLOT_CANCELLED  // Производитель отказался от слота
+};
+
 ThreadSafeQueuedMsgQueue* qmq_create(size_t capacity) {
     if (capacity == 0) {
         fprintf(stderr, "qmq_create: Capacity must be greater than 0\n");
@@ -28,14 +36,23 @@ ThreadSafeQueuedMsgQueue* qmq_create(size_t capacity) {
         free(queue);
         return NULL;
     }
+    queue->slot_state = (unsigned char*)calloc(capacity, sizeof(unsigned char));
+    if (!queue->slot_state) {
+        perror("qmq_create: Failed to allocate slot states");
+        free(queue->buffer);
+        free(queue);
+        return NULL;
+    }
     queue->capacity = capacity;
     queue->count = 0;
     queue->head = 0;
     queue->tail = 0;
     queue->shutdown = false;
-    if (pthread_mutex_init(&queue->mutex, NULL) != 0) { /* ... error handling ... */ free(queue->buffer); free(queue); return NULL; }
-    if (pthread_cond_init(&queue->cond_not_empty, NULL) != 0) { /* ... error handling ... */ pthread_mutex_destroy(&queue->mutex); free(queue->buffer); free(queue); return NULL; }
-    if (pthread_cond_init(&queue->cond_not_full, NULL) != 0) { /* ... error handling ... */ pthread_cond_destroy(&queue->cond_not_empty); pthread_mutex_destroy(&queue->mutex); free(queue->buffer); free(queue); return NULL; }
+    queue->on_ready = NULL;
+    queue->on_ready_arg = NULL;
+    if (pthread_mutex_init(&queue->mutex, NULL) != 0) { /* ... error handling ... */ free(queue->slot_state); free(queue->buffer); free(queue); return NULL; }
+    if (pthread_cond_init(&queue->cond_not_empty, NULL) != 0) { /* ... error handling ... */ pthread_mutex_destroy(&queue->mutex); free(queue->slot_state); free(queue->buffer); free(queue); return NULL; }
+    if (pthread_cond_init(&queue->cond_not_full, NULL) != 0) { /* ... error handling ... */ pthread_cond_destroy(&queue->cond_not_empty); pthread_mutex_destroy(&queue->mutex); free(queue->slot_state); free(queue->buffer); free(queue); return NULL; }
     printf("Thread-safe QueuedMessage queue created with capacity %zu\n", capacity);
     return queue;
 }
@@ -45,47 +62,149 @@ void qmq_destroy(ThreadSafeQueuedMsgQueue *queue) {
     pthread_mutex_destroy(&queue->mutex);
     pthread_cond_destroy(&queue->cond_not_empty);
     pthread_cond_destroy(&queue->cond_not_full);
+    free(queue->slot_state);
     free(queue->buffer);
     free(queue);
     printf("Thread-safe QueuedMessage queue destroyed\n");
 }
 
-bool qmq_enqueue(ThreadSafeQueuedMsgQueue *queue, const QueuedMessage *queued_message) {
-    if (!queue || !queued_message) return false;
+static QueuedMessage* qmq_reserve_slot(ThreadSafeQueuedMsgQueue *queue, bool wait) {
+    if (!queue) return NULL;
     pthread_mutex_lock(&queue->mutex);
-    while (queue->count == queue->capacity && !queue->shutdown) {
+    while (wait && queue->count == queue->capacity && !queue->shutdown) {
         pthread_cond_wait(&queue->cond_not_full, &queue->mutex);
     }
-    if (queue->shutdown) {
+    if (queue->shutdown || queue->count == queue->capacity) {
         pthread_mutex_unlock(&queue->mutex);
-        return false;
+        return NULL;
     }
-    memcpy(&queue->buffer[queue->head], queued_message, sizeof(QueuedMessage));
+    size_t index = queue->head;
+    queue->slot_state[index] = QMQ_SLOT_RESERVED;
     queue->head = (queue->head + 1) % queue->capacity;
     queue->count++;
-    pthread_cond_signal(&queue->cond_not_empty);
     pthread_mutex_unlock(&queue->mutex);
-    return true;
+    return &queue->buffer[index];
 }
 
-bool qmq_dequeue(ThreadSafeQueuedMsgQueue *queue, QueuedMessage *queued_message) {
-     if (!queue || !queued_message) return false;
+QueuedMessage* qmq_reserve(ThreadSafeQueuedMsgQueue *queue) {
+    return qmq_reserve_slot(queue, true);
+}
+
+QueuedMessage* qmq_try_reserve(ThreadSafeQueuedMsgQueue *queue) {
+    return qmq_reserve_slot(queue, false);
+}
+
+static void qmq_finish_slot(ThreadSafeQueuedMsgQueue *queue, QueuedMessage *slot, unsigned char state) {
+    if (!queue || !slot) return;
+    size_t index = (size_t)(slot - queue->buffer);
+    pthread_mutex_lock(&queue->mutex);
+    queue->slot_state[index] = state;
+    // Потребитель ждет именно первый слот; будим, только если он стал доступен
+    if (index == queue->tail) pthread_cond_signal(&queue->cond_not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+    if (state == QMQ_SLOT_READY && queue->on_ready) queue->on_ready(queue->on_ready_arg);
+}
+
+void qmq_commit(ThreadSafeQueuedMsgQueue *queue, QueuedMessage *slot) {
+    qmq_finish_slot(queue, slot, QMQ_SLOT_READY);
+}
+
+void qmq_cancel(ThreadSafeQueuedMsgQueue *queue, QueuedMessage *slot) {
+    qmq_finish_slot(queue, slot, QMQ_SLOT_CANCELLED);
+}
+
+static QueuedMessage* qmq_begin_slot(ThreadSafeQueuedMsgQueue *queue, bool wait) {
+    if (!queue) return NULL;
     pthread_mutex_lock(&queue->mutex);
-    while (queue->count == 0 && !queue->shutdown) {
+    for (;;) {
+        // Пропускаем слоты, от которых производители отказались
+        while (queue->count > 0 && queue->slot_state[queue->tail] == QMQ_SLOT_CANCELLED) {
+            queue->slot_state[queue->tail] = QMQ_SLOT_FREE;
+            queue->tail = (queue->tail + 1) % queue->capacity;
+            queue->count--;
+            pthread_cond_signal(&queue->cond_not_full);
+        }
+        if (queue->count > 0 && queue->slot_state[queue->tail] == QMQ_SLOT_READY) break;
+        // При закрытии не ждем слоты, которые еще заполняются
+        if (queue->shutdown || !wait) {
+            pthread_mutex_unlock(&queue->mutex);
+            return NULL;
+        }
         pthread_cond_wait(&queue->cond_not_empty, &queue->mutex);
     }
-    if (queue->shutdown && queue->count == 0) {
-        pthread_mutex_unlock(&queue->mutex);
-        return false;
+    QueuedMessage *slot = &queue->buffer[queue->tail];
+    pthread_mutex_unlock(&queue->mutex);
+    return slot;
+}
+
+QueuedMessage* qmq_dequeue_begin(ThreadSafeQueuedMsgQueue *queue) {
+    return qmq_begin_slot(queue, true);
+}
+
+QueuedMessage* qmq_try_dequeue_begin(ThreadSafeQueuedMsgQueue *queue) {
+    return qmq_begin_slot(queue, false);
+}
+
+void qmq_dequeue_end(ThreadSafeQueuedMsgQueue *queue) {
+    qmq_dequeue_end_burst(queue, 1);
+}
+
+size_t qmq_dequeue_begin_burst(ThreadSafeQueuedMsgQueue *queue, QueuedMessage **slots, size_t max_slots) {
+    if (!slots || max_slots == 0) return 0;
+    QueuedMessage *first = qmq_begin_slot(queue, true);
+    if (!first) return 0;
+    slots[0] = first;
+    size_t taken = 1;
+    // Следом - только готовые слоты подряд: зарезервированный или отмененный слот завершает пачку
+    pthread_mutex_lock(&queue->mutex);
+    while (taken < max_slots && taken < queue->count) {
+        size_t index = (queue->tail + taken) % queue->capacity;
+        if (queue->slot_state[index] != QMQ_SLOT_READY) break;
+        slots[taken++] = &queue->buffer[index];
     }
-    memcpy(queued_message, &queue->buffer[queue->tail], sizeof(QueuedMessage));
-    queue->tail = (queue->tail + 1) % queue->capacity;
-    queue->count--;
-    pthread_cond_signal(&queue->cond_not_full);
     pthread_mutex_unlock(&queue->mutex);
+    return taken;
+}
+
+void qmq_dequeue_end_burst(ThreadSafeQueuedMsgQueue *queue, size_t count) {
+    if (!queue || count == 0) return;
+    pthread_mutex_lock(&queue->mutex);
+    for (size_t i = 0; i < count && queue->count > 0; ++i) {
+        queue->slot_state[queue->tail] = QMQ_SLOT_FREE;
+        queue->tail = (queue->tail + 1) % queue->capacity;
+        queue->count--;
+    }
+    if (count > 1) pthread_cond_broadcast(&queue->cond_not_full);
+    else pthread_cond_signal(&queue->cond_not_full);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+bool qmq_enqueue(ThreadSafeQueuedMsgQueue *queue, const QueuedMessage *queued_message) {
+    if (!queue || !queued_message) return false;
+    QueuedMessage *slot = qmq_reserve(queue);
+    if (!slot) return false;
+    memcpy(slot, queued_message, sizeof(QueuedMessage));
+    qmq_commit(queue, slot);
+    return true;
+}
+
+bool qmq_dequeue(ThreadSafeQueuedMsgQueue *queue, QueuedMessage *queued_message) {
+    if (!queue || !queued_message) return false;
+    QueuedMessage *slot = qmq_dequeue_begin(queue);
+    if (!slot) return false;
+    memcpy(queued_message, slot, sizeof(QueuedMessage));
+    qmq_dequeue_end(queue);
     return true;
 }
 
+void qmq_set_ready_callback(ThreadSafeQueuedMsgQueue *queue, void (*on_ready)(void *arg), void *arg) {
+    if (!queue) return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->on_ready = on_ready;
+    queue->on_ready_arg = arg;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
 void qmq_shutdown(ThreadSafeQueuedMsgQueue *queue) {
     if (!queue) return;
     pthread_mutex_lock(&queue->mutex);
@@ -96,4 +215,20 @@ void qmq_shutdown(ThreadSafeQueuedMsgQueue *queue) {
        pthread_cond_broadcast(&queue->cond_not_full);
     }
     pthread_mutex_unlock(&queue->mutex);
-}
\ No newline at end of file
+}
+
+void qmq_reset(ThreadSafeQueuedMsgQueue *queue) {
+    if (!queue) return;
+    pthread_mutex_lock(&queue->mutex);
+    memset(queue->slot_state, QMQ_SLOT_FREE, queue->capacity);
+    queue->count = 0;
+    queue->head = 0;
+    queue->tail = 0;
+    queue->shutdown = false;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void qmq_prefault(ThreadSafeQueuedMsgQueue *queue) {
+    if (!queue) return;
+    memset(queue->buffer, 0, queue->capacity * sizeof(QueuedMessage));
+}
@@ -3,7 +3,13 @@
  *
  * Описание:
  * Потокобезопасная очередь для передачи QueuedMessage (сообщение + ID экземпляра).
- * Реализована как кольцевой буфер.
+ * Реализована как кольцевой буфер. Кроме копирующих enqueue/dequeue поддерживает
+ * работу прямо в слотах буфера: производитель резервирует слот и заполняет его
+ * (qmq_reserve/qmq_commit/qmq_cancel), потребитель читает слот на месте
+ * (qmq_dequeue_begin/qmq_dequeue_end). Слоты выдаются потребителю в порядке резервирования.
+ * Потребитель может не ждать на очереди, а получать уведомление о готовом слоте
+ * (qmq_set_ready_callback) и забирать слоты без ожидания (qmq_try_dequeue_begin).
+ * Отправитель может забрать готовые слоты пачкой (qmq_dequeue_begin_burst).
  */
 
 #ifndef TS_QUEUED_MSG_QUEUE_H
@@ -18,14 +24,17 @@
 // Определение структуры и typedef здесь
 typedef struct ThreadSafeQueuedMsgQueue {
     QueuedMessage *buffer;      // Буфер для хранения сообщений + ID экземпляра
+    unsigned char *slot_state;  // Состояние каждого слота (QMQ_SLOT_*)
     size_t capacity;            // Максимальная вместимость очереди
-    size_t count;               // Текущее количество элементов в очереди
+    size_t count;               // Текущее количество занятых слотов (включая зарезервированные)
     size_t head;                // Индекс для добавления следующего элемента
     size_t tail;                // Индекс для извлечения следующего элемента
     pthread_mutex_t mutex;      // Мьютекс для защиты доступа к очереди
     pthread_cond_t cond_not_empty; // Условная переменная: очередь не пуста
     pthread_cond_t cond_not_full;  // Условная переменная: очередь не полна
     bool shutdown;              // Флаг для сигнализации о завершении работы
+    void (*on_ready)(void *arg); // Вызывается после qmq_commit (вне мьютекса), может быть NULL
+    void *on_ready_arg;
 } ThreadSafeQueuedMsgQueue; // <--- Typedef добавлен здесь
 
 // Функции с префиксом qmq_
@@ -33,6 +42,78 @@ ThreadSafeQueuedMsgQueue* qmq_create(size_t capacity);
 void qmq_destroy(ThreadSafeQueuedMsgQueue *queue);
 bool qmq_enqueue(ThreadSafeQueuedMsgQueue *queue, const QueuedMessage *queued_message);
 bool qmq_dequeue(ThreadSafeQueuedMsgQueue *queue, QueuedMessage *queued_message);
+
+/**
+ * @brief Резервирует слот в конце очереди для заполнения на месте (ждет, если очередь полна).
+ * Слот нужно заполнить и передать в qmq_commit() или qmq_cancel(); пока он не
+ * подтвержден, потребитель не получит ни его, ни следующие за ним слоты.
+ * @return Указатель на слот или NULL, если очередь закрыта.
+ */
+QueuedMessage* qmq_reserve(ThreadSafeQueuedMsgQueue *queue);
+
+/**
+ * @brief Как qmq_reserve(), но не ждет: для потоков, которые не должны блокироваться
+ * на полной очереди (служба таймеров).
+ * @return Указатель на слот или NULL, если очередь полна или закрыта.
+ */
+QueuedMessage* qmq_try_reserve(ThreadSafeQueuedMsgQueue *queue);
+
+/**
+ * @brief Делает зарезервированный слот доступным потребителю.
+ */
+void qmq_commit(ThreadSafeQueuedMsgQueue *queue, QueuedMessage *slot);
+
+/**
+ * @brief Отказывается от зарезервированного слота (потребитель его пропустит).
+ */
+void qmq_cancel(ThreadSafeQueuedMsgQueue *queue, QueuedMessage *slot);
+
+/**
+ * @brief Возвращает указатель на первый готовый слот без копирования (ждет, если очередь пуста).
+ * Только для единственного потребителя очереди; слот действителен до qmq_dequeue_end().
+ * @return Указатель на слот или NULL, если очередь закрыта и готовых слотов нет.
+ */
+QueuedMessage* qmq_dequeue_begin(ThreadSafeQueuedMsgQueue *queue);
+
+/**
+ * @brief Как qmq_dequeue_begin(), но не ждет.
+ * @return Указатель на слот или NULL, если готовых слотов сейчас нет.
+ */
+QueuedMessage* qmq_try_dequeue_begin(ThreadSafeQueuedMsgQueue *queue);
+
+/**
+ * @brief Освобождает слот, полученный от qmq_dequeue_begin().
+ */
+void qmq_dequeue_end(ThreadSafeQueuedMsgQueue *queue);
+
+/**
+ * @brief Как qmq_dequeue_begin(), но выдает сразу все готовые слоты подряд от начала
+ * очереди (не больше max_slots): пачку для одной отправки. Ждет, если очередь пуста.
+ * @return Количество слотов в slots; 0, если очередь закрыта и готовых слотов нет.
+ */
+size_t qmq_dequeue_begin_burst(ThreadSafeQueuedMsgQueue *queue, QueuedMessage **slots, size_t max_slots);
+
+/**
+ * @brief Освобождает count слотов, полученных от qmq_dequeue_begin_burst().
+ */
+void qmq_dequeue_end_burst(ThreadSafeQueuedMsgQueue *queue, size_t count);
+
+/**
+ * @brief Устанавливает уведомление о готовом слоте. Устанавливается до появления производителей.
+ */
+void qmq_set_ready_callback(ThreadSafeQueuedMsgQueue *queue, void (*on_ready)(void *arg), void *arg);
+
 void qmq_shutdown(ThreadSafeQueuedMsgQueue *queue);
 
+/**
+ * @brief Возвращает закрытую очередь в исходное (пустое, открытое) состояние для повторного использования.
+ * Вызывается, когда у очереди нет ни производителей, ни потребителей.
+ */
+void qmq_reset(ThreadSafeQueuedMsgQueue *queue);
+
+/**
+ * @brief Заранее затрагивает все страницы буфера, чтобы первый сеанс не тратил время на их выделение ядром.
+ */
+void qmq_prefault(ThreadSafeQueuedMsgQueue *queue);
+
 #endif // TS_QUEUED_MSG_QUEUE_H
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <string.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <time.h>
+#include <errno.h>
 
 ThreadSafeUvmRespQueue* uvq_create(size_t capacity) {
     if (capacity == 0) { /*...*/ return NULL; }
@@ -40,6 +42,16 @@ bool uvq_enqueue(ThreadSafeUvmRespQueue *queue, const UvmResponseMessage *resp_m
     pthread_mutex_unlock(&queue->mutex); return true;
 }
 
+bool uvq_try_enqueue(ThreadSafeUvmRespQueue *queue, const UvmResponseMessage *resp_message) {
+    if (!queue || !resp_message) return false;
+    pthread_mutex_lock(&queue->mutex);
+    if (queue->shutdown || queue->count == queue->capacity) { pthread_mutex_unlock(&queue->mutex); return false; }
+    memcpy(&queue->buffer[queue->head], resp_message, sizeof(UvmResponseMessage));
+    queue->head = (queue->head + 1) % queue->capacity; queue->count++;
+    pthread_cond_signal(&queue->cond_not_empty);
+    pthread_mutex_unlock(&queue->mutex); return true;
+}
+
 bool uvq_dequeue(ThreadSafeUvmRespQueue *queue, UvmResponseMessage *resp_message) {
      if (!queue || !resp_message) return false;
     pthread_mutex_lock(&queue->mutex);
@@ -51,6 +63,24 @@ bool uvq_dequeue(ThreadSafeUvmRespQueue *queue, UvmResponseMessage *resp_message
     pthread_mutex_unlock(&queue->mutex); return true;
 }
 
+bool uvq_dequeue_timed(ThreadSafeUvmRespQueue *queue, UvmResponseMessage *resp_message, int timeout_ms) {
+    if (!queue || !resp_message) return false;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) { deadline.tv_sec++; deadline.tv_nsec -= 1000000000L; }
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == 0 && !queue->shutdown) {
+        if (pthread_cond_timedwait(&queue->cond_not_empty, &queue->mutex, &deadline) == ETIMEDOUT) break;
+    }
+    if (queue->count == 0) { pthread_mutex_unlock(&queue->mutex); return false; }
+    memcpy(resp_message, &queue->buffer[queue->tail], sizeof(UvmResponseMessage));
+    queue->tail = (queue->tail + 1) % queue->capacity; queue->count--;
+    pthread_cond_signal(&queue->cond_not_full);
+    pthread_mutex_unlock(&queue->mutex); return true;
+}
+
 void uvq_shutdown(ThreadSafeUvmRespQueue *queue) {
     if (!queue) return;
     pthread_mutex_lock(&queue->mutex);
@@ -24,7 +24,11 @@ struct ThreadSafeUvmRespQueue {
 ThreadSafeUvmRespQueue* uvq_create(size_t capacity);
 void uvq_destroy(ThreadSafeUvmRespQueue *queue);
 bool uvq_enqueue(ThreadSafeUvmRespQueue *queue, const UvmResponseMessage *resp_message);
+// Как uvq_enqueue, но не ждет места: false - очередь заполнена или закрыта
+bool uvq_try_enqueue(ThreadSafeUvmRespQueue *queue, const UvmResponseMessage *resp_message);
 bool uvq_dequeue(ThreadSafeUvmRespQueue *queue, UvmResponseMessage *resp_message);
+// Как uvq_dequeue, но ждет не дольше timeout_ms (false - таймаут или очередь закрыта)
+bool uvq_dequeue_timed(ThreadSafeUvmRespQueue *queue, UvmResponseMessage *resp_message, int timeout_ms);
 void uvq_shutdown(ThreadSafeUvmRespQueue *queue);
 
 #endif // TS_UVM_RESP_QUEUE_H
\ No newline at end of file
@@ -0,0 +1,361 @@
+/*
+ * uvm/uvm_data_sink.c
+ *
+ * Описание:
+ * Реализация приемника потоковых данных УВМ.
+ * Файл данных и индексный файл каждого сеанса заранее размещаются на диске
+ * экстентами (posix_fallocate) и заполняются через mmap, без write() на каждую строку.
+ * При закрытии сеанса файлы обрезаются до фактического размера.
+ * Сеанс каждой строки определяется при ее приеме (UvmResponseMessage.session).
+ * Конец сеанса передается через ту же очередь маркером: файлы сеанса закрываются,
+ * как только поток приемника дойдет до маркера.
+ */
+#include "uvm_data_sink.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../protocol/message_utils.h"
+#include "../utils/ts_uvm_resp_queue.h"
+#include "uvm_frame_assembler.h"
+
+// Состояние одного сеанса записи (на один СВ-М)
+typedef struct {
+    bool open;
+    unsigned generation;        // Поколение сеанса, для которого открыты файлы
+    int data_fd;
+    int index_fd;
+
+    uint8_t *data_map;          // Текущий отображенный экстент файла данных
+    uint64_t data_map_base;     // Смещение этого экстента в файле
+    uint64_t data_pos;          // Текущая позиция записи в файле данных
+    uint64_t data_allocated;    // Сколько байт уже предразмещено в файле данных
+
+    UvmDataIndexRecord *index_map; // Текущий отображенный экстент индекса
+    uint64_t index_map_first;   // Номер первой записи в отображенном экстенте
+    uint64_t index_count;       // Количество записанных записей индекса
+    uint64_t index_allocated;   // Сколько записей предразмещено
+
+    uint64_t lines_written;
+} SinkSession;
+
+// Тип маркера конца сеанса в очереди приемника (протоколом тип 0 не используется)
+#define SINK_SESSION_END_TYPE 0
+
+static SinkSession sink_sessions[MAX_SVM_INSTANCES];
+static volatile unsigned sink_generation[MAX_SVM_INSTANCES];
+static volatile uint32_t sink_last_bcb[MAX_SVM_INSTANCES];
+
+static ThreadSafeUvmRespQueue *sink_queue = NULL;
+static pthread_t sink_tid = 0;
+static uint64_t sink_dropped = 0;   // Строки, отброшенные при заполненной очереди (атомарно)
+static char sink_dir[256] = "data";
+static size_t sink_extent_bytes = (size_t)UVM_DATA_SINK_DEFAULT_EXTENT_MB * 1024 * 1024;
+static UvmResponseMessage sink_item; // Буфер для извлечения из очереди (используется только потоком приемника)
+
+bool uvm_data_sink_is_data_type(uint8_t message_type) {
+    switch (message_type) {
+        case MESSAGE_TYPE_STROKA_GOLOGRAMMY_SUBK:
+        case MESSAGE_TYPE_STROKA_RADIOGOLOGRAMMY_DR:
+        case MESSAGE_TYPE_STROKA_K3:
+        case MESSAGE_TYPE_STROKA_IZOBRAZHENIYA_K4:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Увеличивает файл на extent байт начиная с offset (с запасным вариантом через ftruncate)
+static int sink_preallocate(int fd, uint64_t offset, uint64_t extent) {
+    int rc = posix_fallocate(fd, (off_t)offset, (off_t)extent);
+    if (rc == 0) return 0;
+    if (rc != EOPNOTSUPP && rc != EINVAL) {
+        fprintf(stderr, "DataSink: posix_fallocate failed: %s\n", strerror(rc));
+        return -1;
+    }
+    // Файловая система не поддерживает fallocate - просто расширяем файл
+    if (ftruncate(fd, (off_t)(offset + extent)) != 0) {
+        perror("DataSink: ftruncate (preallocate) failed");
+        return -1;
+    }
+    return 0;
+}
+
+// Отображает экстент файла данных, начинающийся с base
+static int sink_map_data_extent(SinkSession *s, uint64_t base) {
+    if (s->data_map) {
+        munmap(s->data_map, sink_extent_bytes);
+        s->data_map = NULL;
+    }
+    if (base + sink_extent_bytes > s->data_allocated) {
+        if (sink_preallocate(s->data_fd, s->data_allocated, sink_extent_bytes) != 0) return -1;
+        s->data_allocated += sink_extent_bytes;
+    }
+    void *p = mmap(NULL, sink_extent_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, s->data_fd, (off_t)base);
+    if (p == MAP_FAILED) {
+        perror("DataSink: mmap data extent failed");
+        return -1;
+    }
+    s->data_map = (uint8_t*)p;
+    s->data_map_base = base;
+    return 0;
+}
+
+// Отображает экстент индексного файла, начинающийся с записи first
+static int sink_map_index_extent(SinkSession *s, uint64_t first) {
+    const size_t extent_bytes = (size_t)UVM_DATA_SINK_INDEX_EXTENT_RECORDS * sizeof(UvmDataIndexRecord);
+    if (s->index_map) {
+        munmap(s->index_map, extent_bytes);
+        s->index_map = NULL;
+    }
+    if (first + UVM_DATA_SINK_INDEX_EXTENT_RECORDS > s->index_allocated) {
+        if (sink_preallocate(s->index_fd, s->index_allocated * sizeof(UvmDataIndexRecord), extent_bytes) != 0) return -1;
+        s->index_allocated += UVM_DATA_SINK_INDEX_EXTENT_RECORDS;
+    }
+    void *p = mmap(NULL, extent_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, s->index_fd,
+                   (off_t)(first * sizeof(UvmDataIndexRecord)));
+    if (p == MAP_FAILED) {
+        perror("DataSink: mmap index extent failed");
+        return -1;
+    }
+    s->index_map = (UvmDataIndexRecord*)p;
+    s->index_map_first = first;
+    return 0;
+}
+
+static void sink_close_session(int svm_id) {
+    SinkSession *s = &sink_sessions[svm_id];
+    if (!s->open) return;
+
+    if (s->data_map) { munmap(s->data_map, sink_extent_bytes); s->data_map = NULL; }
+    if (s->index_map) {
+        munmap(s->index_map, (size_t)UVM_DATA_SINK_INDEX_EXTENT_RECORDS * sizeof(UvmDataIndexRecord));
+        s->index_map = NULL;
+    }
+    // Обрезаем предразмещенный хвост до фактически записанных данных
+    if (ftruncate(s->data_fd, (off_t)s->data_pos) != 0) perror("DataSink: ftruncate data failed");
+    if (ftruncate(s->index_fd, (off_t)(s->index_count * sizeof(UvmDataIndexRecord))) != 0) perror("DataSink: ftruncate index failed");
+    close(s->data_fd);
+    close(s->index_fd);
+
+    printf("DataSink (SVM %d): Session closed. Lines=%llu, Bytes=%llu.\n",
+           svm_id, (unsigned long long)s->lines_written, (unsigned long long)s->data_pos);
+    memset(s, 0, sizeof(*s));
+    s->data_fd = -1;
+    s->index_fd = -1;
+}
+
+static int sink_open_session(int svm_id, unsigned generation) {
+    SinkSession *s = &sink_sessions[svm_id];
+    char stamp[32];
+    char data_path[512];
+    char index_path[512];
+
+    if (mkdir(sink_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "DataSink: Cannot create output dir '%s': %s\n", sink_dir, strerror(errno));
+        return -1;
+    }
+
+    time_t now = time(NULL);
+    struct tm tm_now;
+    localtime_r(&now, &tm_now);
+    strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm_now);
+    memset(s, 0, sizeof(*s));
+    s->data_fd = -1;
+    // Файлы не перезаписываются: строки сеанса, пришедшие после закрытия его файлов
+    // по маркеру конца, идут в следующую часть (_p<N>)
+    for (int part = 0; s->data_fd < 0 && part < 100; ++part) {
+        char suffix[16] = "";
+        if (part > 0) snprintf(suffix, sizeof(suffix), "_p%d", part);
+        snprintf(data_path, sizeof(data_path), "%s/svm%d_%s_s%u%s.dat", sink_dir, svm_id, stamp, generation, suffix);
+        snprintf(index_path, sizeof(index_path), "%s/svm%d_%s_s%u%s.idx", sink_dir, svm_id, stamp, generation, suffix);
+        s->data_fd = open(data_path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (s->data_fd < 0 && errno != EEXIST) break;
+    }
+    if (s->data_fd < 0) {
+        fprintf(stderr, "DataSink: Cannot open '%s': %s\n", data_path, strerror(errno));
+        return -1;
+    }
+    s->index_fd = open(index_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (s->index_fd < 0) {
+        fprintf(stderr, "DataSink: Cannot open '%s': %s\n", index_path, strerror(errno));
+        close(s->data_fd);
+        s->data_fd = -1;
+        return -1;
+    }
+    s->open = true;
+    s->generation = generation;
+    if (sink_map_data_extent(s, 0) != 0 || sink_map_index_extent(s, 0) != 0) {
+        sink_close_session(svm_id);
+        return -1;
+    }
+    printf("DataSink (SVM %d): Session opened: %s\n", svm_id, data_path);
+    return 0;
+}
+
+// Записывает одну строку в файл данных сеанса и добавляет запись индекса
+static int sink_write_line(int svm_id, const Message *msg) {
+    SinkSession *s = &sink_sessions[svm_id];
+    const uint8_t *src = msg->body;
+    size_t remaining = msg->header.body_length;
+    uint64_t line_offset = s->data_pos;
+
+    while (remaining > 0) {
+        uint64_t in_extent = s->data_pos - s->data_map_base;
+        if (in_extent >= sink_extent_bytes) {
+            if (sink_map_data_extent(s, s->data_map_base + sink_extent_bytes) != 0) return -1;
+            in_extent = 0;
+        }
+        size_t chunk = sink_extent_bytes - (size_t)in_extent;
+        if (chunk > remaining) chunk = remaining;
+        memcpy(s->data_map + in_extent, src, chunk);
+        src += chunk;
+        remaining -= chunk;
+        s->data_pos += chunk;
+    }
+
+    if (s->index_count - s->index_map_first >= UVM_DATA_SINK_INDEX_EXTENT_RECORDS) {
+        if (sink_map_index_extent(s, s->index_count) != 0) return -1;
+    }
+    UvmDataIndexRecord *rec = &s->index_map[s->index_count - s->index_map_first];
+    rec->message_number = get_full_message_number(&msg->header);
+    rec->message_type = msg->header.message_type;
+    rec->reserved = 0;
+    rec->bcb = sink_last_bcb[svm_id];
+    rec->offset = line_offset;
+    rec->length = msg->header.body_length;
+    rec->reserved2 = 0;
+    s->index_count++;
+    s->lines_written++;
+    return 0;
+}
+
+static void* uvm_data_sink_thread_func(void *arg) {
+    (void)arg;
+    printf("DataSink thread started (dir '%s', extent %zu bytes).\n", sink_dir, sink_extent_bytes);
+
+    while (true) {
+        if (!uvq_dequeue(sink_queue, &sink_item)) break; // Очередь закрыта и пуста
+        int svm_id = sink_item.source_svm_id;
+        if (svm_id < 0 || svm_id >= MAX_SVM_INSTANCES) continue;
+
+        // Конец сеанса: строки, поставленные до маркера, уже записаны - закрываем файлы сразу
+        if (sink_item.message.header.message_type == SINK_SESSION_END_TYPE) {
+            if (sink_sessions[svm_id].open && sink_sessions[svm_id].generation == sink_item.session) {
+                sink_close_session(svm_id);
+                uvm_frame_assembler_end_session(svm_id);
+            }
+            continue;
+        }
+
+        // Сеанс строки задан приемником сообщений при ее приеме, а не моментом записи:
+        // строки, принятые до разрыва, дописываются в файлы своего сеанса
+        SinkSession *s = &sink_sessions[svm_id];
+        if (s->open && s->generation != sink_item.session) {
+            sink_close_session(svm_id); // Сеанс связи сменился
+            uvm_frame_assembler_end_session(svm_id);
+        }
+        if (!s->open && sink_open_session(svm_id, sink_item.session) != 0) {
+            continue; // Строка теряется, но поток продолжает работу
+        }
+        if (sink_write_line(svm_id, &sink_item.message) != 0) {
+            fprintf(stderr, "DataSink (SVM %d): Write failed, closing session.\n", svm_id);
+            sink_close_session(svm_id);
+        }
+        // Строки К3/К4 дополнительно собираются в кадры (если сборщик инициализирован)
+        if (uvm_frame_assembler_handles_type(sink_item.message.header.message_type)) {
+            uvm_frame_assembler_feed(svm_id, &sink_item.message);
+        }
+    }
+
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) sink_close_session(i);
+    printf("DataSink thread finished.\n");
+    return NULL;
+}
+
+int uvm_data_sink_start(const char *output_dir, int extent_mb, size_t queue_capacity) {
+    if (sink_queue) return 0; // Уже запущен
+
+    if (output_dir && output_dir[0] != '\0') {
+        snprintf(sink_dir, sizeof(sink_dir), "%s", output_dir);
+    }
+    if (extent_mb <= 0) extent_mb = UVM_DATA_SINK_DEFAULT_EXTENT_MB;
+    sink_extent_bytes = (size_t)extent_mb * 1024 * 1024;
+
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        memset(&sink_sessions[i], 0, sizeof(SinkSession));
+        sink_sessions[i].data_fd = -1;
+        sink_sessions[i].index_fd = -1;
+    }
+
+    if (queue_capacity == 0) queue_capacity = UVM_DATA_SINK_DEFAULT_QUEUE_LINES;
+    sink_queue = uvq_create(queue_capacity);
+    if (!sink_queue) {
+        fprintf(stderr, "DataSink: Failed to create queue.\n");
+        return -1;
+    }
+    if (pthread_create(&sink_tid, NULL, uvm_data_sink_thread_func, NULL) != 0) {
+        perror("DataSink: Failed to create thread");
+        uvq_destroy(sink_queue);
+        sink_queue = NULL;
+        sink_tid = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void uvm_data_sink_stop(void) {
+    if (!sink_queue) return;
+    uvq_shutdown(sink_queue); // Поток допишет оставшиеся строки и выйдет
+    if (sink_tid != 0) {
+        pthread_join(sink_tid, NULL);
+        sink_tid = 0;
+    }
+    uvq_destroy(sink_queue);
+    sink_queue = NULL;
+    uint64_t dropped = uvm_data_sink_dropped();
+    if (dropped > 0) printf("DataSink: %llu lines dropped (queue full).\n", (unsigned long long)dropped);
+}
+
+bool uvm_data_sink_submit(const UvmResponseMessage *data_msg) {
+    if (!sink_queue || !data_msg) return false;
+    if (uvq_try_enqueue(sink_queue, data_msg)) return true;
+    // Поток управления не ждет запись на диск: строка теряется, но учитывается
+    __atomic_add_fetch(&sink_dropped, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+uint64_t uvm_data_sink_dropped(void) {
+    return __atomic_load_n(&sink_dropped, __ATOMIC_RELAXED);
+}
+
+unsigned uvm_data_sink_session(int svm_id) {
+    if (svm_id < 0 || svm_id >= MAX_SVM_INSTANCES) return 0;
+    return __atomic_load_n(&sink_generation[svm_id], __ATOMIC_ACQUIRE);
+}
+
+void uvm_data_sink_note_bcb(int svm_id, uint32_t bcb) {
+    if (svm_id < 0 || svm_id >= MAX_SVM_INSTANCES) return;
+    __atomic_store_n(&sink_last_bcb[svm_id], bcb, __ATOMIC_RELAXED);
+}
+
+void uvm_data_sink_end_session(int svm_id) {
+    if (svm_id < 0 || svm_id >= MAX_SVM_INSTANCES) return;
+    unsigned ended = __atomic_fetch_add(&sink_generation[svm_id], 1, __ATOMIC_RELEASE);
+    if (!sink_queue) return;
+
+    // Маркер не отбрасывается при заполненной очереди: вызывающий поток ждет места
+    UvmResponseMessage marker;
+    memset(&marker.message.header, 0, sizeof(marker.message.header));
+    marker.source_svm_id = svm_id;
+    marker.session = ended;
+    marker.message.header.message_type = SINK_SESSION_END_TYPE;
+    uvq_enqueue(sink_queue, &marker);
+}
@@ -0,0 +1,87 @@
+/*
+ * uvm/uvm_data_sink.h
+ *
+ * Описание:
+ * Приемник потоковых данных УВМ: сообщения-строки (голограммы, радиоголограммы ДР,
+ * К3, изображения К4) записываются в отображаемые в память (mmap) файлы,
+ * отдельные для каждого СВ-М и каждого сеанса связи.
+ * Запись выполняется собственным потоком приемника, а не потоком управления (main).
+ */
+#ifndef UVM_DATA_SINK_H
+#define UVM_DATA_SINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uvm_types.h"
+
+// Размер экстента по умолчанию (файл данных растет экстентами такого размера)
+#define UVM_DATA_SINK_DEFAULT_EXTENT_MB 64
+// Емкость очереди строк к потоку приемника по умолчанию (одна строка - до ~64 КБ памяти)
+#define UVM_DATA_SINK_DEFAULT_QUEUE_LINES 32
+// Количество записей индекса в одном экстенте индексного файла
+#define UVM_DATA_SINK_INDEX_EXTENT_RECORDS 65536
+
+// Запись индексного файла: одна запись на одну принятую строку
+typedef struct {
+    uint16_t message_number; // Полный (11-битный) номер сообщения
+    uint8_t  message_type;   // Тип сообщения (строки)
+    uint8_t  reserved;
+    uint32_t bcb;            // Последний известный ВСВ этого СВ-М на момент приема
+    uint64_t offset;         // Смещение тела строки в файле данных
+    uint32_t length;         // Длина тела строки в байтах
+    uint32_t reserved2;
+} UvmDataIndexRecord; // Итого: 24 байта
+
+/**
+ * @brief Проверяет, относится ли тип сообщения к потоковым данным (строки/изображения).
+ */
+bool uvm_data_sink_is_data_type(uint8_t message_type);
+
+/**
+ * @brief Запускает поток приемника данных.
+ * @param output_dir Каталог для файлов сеансов (создается при необходимости).
+ * @param extent_mb Размер экстента файла данных в мегабайтах.
+ * @param queue_capacity Емкость очереди между потоком управления и приемником.
+ * @return 0 в случае успеха, -1 в случае ошибки.
+ */
+int uvm_data_sink_start(const char *output_dir, int extent_mb, size_t queue_capacity);
+
+/**
+ * @brief Останавливает поток приемника, дописывает и закрывает все файлы сеансов.
+ */
+void uvm_data_sink_stop(void);
+
+/**
+ * @brief Передает строку данных приемнику (копия ставится в очередь приемника).
+ * Не блокирует вызывающий поток: если приемник не успевает и очередь заполнена,
+ * строка отбрасывается и учитывается в uvm_data_sink_dropped().
+ * Строка попадает в файлы сеанса data_msg->session.
+ * @return true, если сообщение принято в очередь.
+ */
+bool uvm_data_sink_submit(const UvmResponseMessage *data_msg);
+
+/**
+ * @brief Количество строк, отброшенных из-за переполнения очереди приемника.
+ */
+uint64_t uvm_data_sink_dropped(void);
+
+/**
+ * @brief Текущий сеанс связи СВ-М: приемники сообщений ставят его в UvmResponseMessage.session,
+ * чтобы строки, принятые до разрыва, не попали в файлы следующего сеанса.
+ */
+unsigned uvm_data_sink_session(int svm_id);
+
+/**
+ * @brief Запоминает последний ВСВ, полученный от СВ-М (используется в индексе).
+ */
+void uvm_data_sink_note_bcb(int svm_id, uint32_t bcb);
+
+/**
+ * @brief Завершает текущий сеанс СВ-М: следующие строки пойдут в новые файлы,
+ * а файлы завершенного сеанса закрываются, как только приемник допишет строки,
+ * поставленные в очередь до этого вызова.
+ * Безопасно вызывать из любого потока; может ждать места в очереди приемника.
+ */
+void uvm_data_sink_end_session(int svm_id);
+
+#endif // UVM_DATA_SINK_H
@@ -0,0 +1,337 @@
+/*
+ * uvm/uvm_frame_assembler.c
+ *
+ * Описание:
+ * Реализация сборщика кадров К3/К4.
+ * Арена выделяется один раз при инициализации: на каждый поток (СВ-М, тип строки)
+ * приходится UVM_FA_SLOTS_PER_STREAM слотов, каждый слот содержит данные кадра,
+ * длины строк и битовую карту принятых строк. Свободные слоты хранятся в стеке.
+ */
+#include "uvm_frame_assembler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../protocol/message_utils.h"
+
+#define FA_MSG_NUM_MODULO 2048 // 11-битный номер сообщения
+#define FA_TYPES_PER_SVM 2     // К3 и К4
+
+// Слот сборки одного кадра
+typedef struct {
+    bool in_use;
+    uint16_t frame_number;
+    uint16_t line_count;
+    uint16_t lines_received;
+    uint32_t bcb;
+    uint64_t first_line_ns;
+    uint8_t *data;
+    uint32_t *line_lengths;
+    uint64_t *bitmap;
+} FrameSlot;
+
+// Состояние потока строк одного типа от одного СВ-М
+typedef struct {
+    int svm_id;
+    uint8_t message_type;
+    int slots[UVM_FA_SLOTS_PER_STREAM]; // Индексы занятых слотов (-1 - нет)
+} FrameStream;
+
+// Нумерация сообщений одного СВ-М (пишет только поток управления)
+typedef struct {
+    bool have_expected;
+    unsigned session;           // Сеанс связи, к которому относится expected_msg_num
+    uint16_t expected_msg_num;  // Ожидаемый следующий номер сообщения
+} FrameNumbering;
+
+static FrameSlot *fa_slots = NULL;
+static int fa_num_slots = 0;
+static int *fa_free_stack = NULL;
+static int fa_free_top = 0;
+static FrameStream *fa_streams = NULL;
+static FrameNumbering *fa_numbering = NULL;
+static int fa_num_svms = 0;
+static uint8_t *fa_arena = NULL;
+static uint16_t fa_max_lines = 0;
+static size_t fa_line_bytes = 0;
+static size_t fa_bitmap_words = 0;
+static UvmFrameConsumer fa_consumer = NULL;
+static void *fa_consumer_data = NULL;
+// Счетчики пишут два потока: приемник данных (feed, выдача кадров) и поток управления
+// (нумерация сообщений), поэтому все изменения и чтения - атомарные
+static UvmFrameAssemblerStats fa_stats;
+
+static uint64_t fa_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static FrameStream* fa_stream_for(int svm_id, uint8_t message_type) {
+    if (svm_id < 0 || svm_id >= fa_num_svms) return NULL;
+    int type_index = (message_type == MESSAGE_TYPE_STROKA_K3) ? 0 : 1;
+    return &fa_streams[svm_id * FA_TYPES_PER_SVM + type_index];
+}
+
+// Выдает кадр потребителю и возвращает слот в стек свободных
+static void fa_emit_and_release(FrameStream *stream, int stream_slot) {
+    int slot_index = stream->slots[stream_slot];
+    FrameSlot *slot = &fa_slots[slot_index];
+    bool complete = (slot->lines_received == slot->line_count);
+    uint64_t elapsed = fa_now_ns() - slot->first_line_ns;
+
+    if (complete) {
+        __atomic_add_fetch(&fa_stats.frames_complete, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&fa_stats.total_assembly_ns, elapsed, __ATOMIC_RELAXED);
+        // Кадры выдает только поток приемника данных: максимум меняет один писатель
+        if (elapsed > __atomic_load_n(&fa_stats.max_assembly_ns, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&fa_stats.max_assembly_ns, elapsed, __ATOMIC_RELAXED);
+        }
+    } else {
+        __atomic_add_fetch(&fa_stats.frames_incomplete, 1, __ATOMIC_RELAXED);
+    }
+
+    if (fa_consumer) {
+        UvmAssembledFrame frame;
+        frame.svm_id = stream->svm_id;
+        frame.message_type = stream->message_type;
+        frame.frame_number = slot->frame_number;
+        frame.line_count = slot->line_count;
+        frame.lines_received = slot->lines_received;
+        frame.complete = complete;
+        frame.bcb = slot->bcb;
+        frame.line_stride = fa_line_bytes;
+        frame.data = slot->data;
+        frame.line_lengths = slot->line_lengths;
+        frame.line_bitmap = slot->bitmap;
+        frame.assembly_ns = elapsed;
+        fa_consumer(&frame, fa_consumer_data);
+    }
+
+    slot->in_use = false;
+    stream->slots[stream_slot] = -1;
+    fa_free_stack[fa_free_top++] = slot_index;
+}
+
+// Подготавливает свободный слот под новый кадр (очищаются только длины и битовая карта)
+static int fa_acquire_slot(FrameStream *stream, uint16_t frame_number, uint16_t line_count) {
+    int free_pos = -1;
+    int oldest_pos = -1;
+    for (int i = 0; i < UVM_FA_SLOTS_PER_STREAM; ++i) {
+        if (stream->slots[i] < 0) {
+            if (free_pos < 0) free_pos = i;
+        } else if (oldest_pos < 0 ||
+                   fa_slots[stream->slots[i]].first_line_ns < fa_slots[stream->slots[oldest_pos]].first_line_ns) {
+            oldest_pos = i;
+        }
+    }
+    if (free_pos < 0) {
+        // Все слоты потока заняты: самый старый кадр уже не будет дополнен
+        fa_emit_and_release(stream, oldest_pos);
+        free_pos = oldest_pos;
+    }
+    if (fa_free_top == 0) return -1; // Не должно происходить: слотов по числу потоков
+
+    int slot_index = fa_free_stack[--fa_free_top];
+    FrameSlot *slot = &fa_slots[slot_index];
+    slot->in_use = true;
+    slot->frame_number = frame_number;
+    slot->line_count = line_count;
+    slot->lines_received = 0;
+    slot->bcb = 0;
+    slot->first_line_ns = fa_now_ns();
+    memset(slot->line_lengths, 0, (size_t)line_count * sizeof(uint32_t));
+    memset(slot->bitmap, 0, fa_bitmap_words * sizeof(uint64_t));
+    stream->slots[free_pos] = slot_index;
+    return free_pos;
+}
+
+int uvm_frame_assembler_init(int num_svms, uint16_t max_lines, size_t line_bytes,
+                             UvmFrameConsumer consumer, void *user_data) {
+    if (fa_arena) return 0; // Уже инициализирован
+    if (num_svms <= 0 || max_lines == 0 || line_bytes == 0) {
+        fprintf(stderr, "FrameAssembler: Invalid parameters.\n");
+        return -1;
+    }
+
+    fa_num_svms = num_svms;
+    fa_max_lines = max_lines;
+    fa_line_bytes = (line_bytes + 63) & ~(size_t)63; // Строки выровнены по 64 байта
+    fa_bitmap_words = ((size_t)max_lines + 63) / 64;
+    fa_num_slots = num_svms * FA_TYPES_PER_SVM * UVM_FA_SLOTS_PER_STREAM;
+
+    size_t data_bytes = (size_t)max_lines * fa_line_bytes;
+    size_t lengths_bytes = (((size_t)max_lines * sizeof(uint32_t)) + 63) & ~(size_t)63;
+    size_t bitmap_bytes = ((fa_bitmap_words * sizeof(uint64_t)) + 63) & ~(size_t)63;
+    size_t slot_bytes = data_bytes + lengths_bytes + bitmap_bytes;
+
+    if (posix_memalign((void**)&fa_arena, 64, slot_bytes * (size_t)fa_num_slots) != 0) {
+        fa_arena = NULL;
+        fprintf(stderr, "FrameAssembler: Failed to allocate arena (%zu bytes).\n", slot_bytes * (size_t)fa_num_slots);
+        return -1;
+    }
+    fa_slots = calloc((size_t)fa_num_slots, sizeof(FrameSlot));
+    fa_free_stack = calloc((size_t)fa_num_slots, sizeof(int));
+    fa_streams = calloc((size_t)num_svms * FA_TYPES_PER_SVM, sizeof(FrameStream));
+    fa_numbering = calloc((size_t)num_svms, sizeof(FrameNumbering));
+    if (!fa_slots || !fa_free_stack || !fa_streams || !fa_numbering) {
+        fprintf(stderr, "FrameAssembler: Failed to allocate slot tables.\n");
+        goto cleanup;
+    }
+
+    for (int i = 0; i < fa_num_slots; ++i) {
+        uint8_t *base = fa_arena + (size_t)i * slot_bytes;
+        fa_slots[i].data = base;
+        fa_slots[i].line_lengths = (uint32_t*)(base + data_bytes);
+        fa_slots[i].bitmap = (uint64_t*)(base + data_bytes + lengths_bytes);
+        fa_free_stack[i] = i;
+    }
+    fa_free_top = fa_num_slots;
+
+    for (int s = 0; s < num_svms; ++s) {
+        for (int t = 0; t < FA_TYPES_PER_SVM; ++t) {
+            FrameStream *stream = &fa_streams[s * FA_TYPES_PER_SVM + t];
+            stream->svm_id = s;
+            stream->message_type = (t == 0) ? MESSAGE_TYPE_STROKA_K3 : MESSAGE_TYPE_STROKA_IZOBRAZHENIYA_K4;
+            for (int k = 0; k < UVM_FA_SLOTS_PER_STREAM; ++k) stream->slots[k] = -1;
+        }
+    }
+
+    fa_consumer = consumer;
+    fa_consumer_data = user_data;
+    memset(&fa_stats, 0, sizeof(fa_stats));
+    printf("FrameAssembler: Arena %zu bytes (%d slots, %u lines x %zu bytes).\n",
+           slot_bytes * (size_t)fa_num_slots, fa_num_slots, max_lines, fa_line_bytes);
+    return 0;
+
+cleanup:
+    free(fa_numbering); fa_numbering = NULL;
+    free(fa_streams); fa_streams = NULL;
+    free(fa_free_stack); fa_free_stack = NULL;
+    free(fa_slots); fa_slots = NULL;
+    free(fa_arena); fa_arena = NULL;
+    return -1;
+}
+
+void uvm_frame_assembler_destroy(void) {
+    if (!fa_arena) return;
+    for (int s = 0; s < fa_num_svms; ++s) uvm_frame_assembler_end_session(s);
+    free(fa_numbering); fa_numbering = NULL;
+    free(fa_streams); fa_streams = NULL;
+    free(fa_free_stack); fa_free_stack = NULL;
+    free(fa_slots); fa_slots = NULL;
+    free(fa_arena); fa_arena = NULL;
+    fa_num_slots = 0;
+    fa_num_svms = 0;
+}
+
+bool uvm_frame_assembler_handles_type(uint8_t message_type) {
+    return message_type == MESSAGE_TYPE_STROKA_K3 || message_type == MESSAGE_TYPE_STROKA_IZOBRAZHENIYA_K4;
+}
+
+bool uvm_frame_assembler_feed(int svm_id, const Message *msg) {
+    if (!fa_arena || !msg || !uvm_frame_assembler_handles_type(msg->header.message_type)) return false;
+
+    FrameStream *stream = fa_stream_for(svm_id, msg->header.message_type);
+    if (!stream) return false;
+
+    if (msg->header.body_length < sizeof(StrokaIzobrazheniyaHeader)) {
+        __atomic_add_fetch(&fa_stats.lines_rejected, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    const StrokaIzobrazheniyaHeader *line = (const StrokaIzobrazheniyaHeader*)msg->body;
+    size_t payload_len = msg->header.body_length - sizeof(StrokaIzobrazheniyaHeader);
+    if (line->kolvo_strok == 0 || line->kolvo_strok > fa_max_lines ||
+        line->nomer_stroki >= line->kolvo_strok || payload_len > fa_line_bytes) {
+        __atomic_add_fetch(&fa_stats.lines_rejected, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    // Ищем кадр среди собираемых
+    int stream_slot = -1;
+    for (int i = 0; i < UVM_FA_SLOTS_PER_STREAM; ++i) {
+        if (stream->slots[i] >= 0 && fa_slots[stream->slots[i]].frame_number == line->nomer_kadra) {
+            stream_slot = i;
+            break;
+        }
+    }
+    if (stream_slot >= 0 && fa_slots[stream->slots[stream_slot]].line_count != line->kolvo_strok) {
+        // Тот же номер кадра с другой геометрией - это уже новый кадр (номер прокрутился)
+        fa_emit_and_release(stream, stream_slot);
+        stream_slot = -1;
+    }
+    if (stream_slot < 0) {
+        stream_slot = fa_acquire_slot(stream, line->nomer_kadra, line->kolvo_strok);
+        if (stream_slot < 0) {
+            __atomic_add_fetch(&fa_stats.lines_rejected, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    }
+
+    FrameSlot *slot = &fa_slots[stream->slots[stream_slot]];
+    uint64_t bit = 1ull << (line->nomer_stroki % 64);
+    uint64_t *word = &slot->bitmap[line->nomer_stroki / 64];
+    if (*word & bit) {
+        __atomic_add_fetch(&fa_stats.lines_duplicate, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    memcpy(slot->data + (size_t)line->nomer_stroki * fa_line_bytes,
+           msg->body + sizeof(StrokaIzobrazheniyaHeader), payload_len);
+    slot->line_lengths[line->nomer_stroki] = (uint32_t)payload_len;
+    *word |= bit;
+    slot->lines_received++;
+    slot->bcb = line->bcb;
+    __atomic_add_fetch(&fa_stats.lines_accepted, 1, __ATOMIC_RELAXED);
+
+    if (slot->lines_received == slot->line_count) {
+        fa_emit_and_release(stream, stream_slot);
+    }
+    return true;
+}
+
+void uvm_frame_assembler_end_session(int svm_id) {
+    if (!fa_arena || svm_id < 0 || svm_id >= fa_num_svms) return;
+    for (int t = 0; t < FA_TYPES_PER_SVM; ++t) {
+        FrameStream *stream = &fa_streams[svm_id * FA_TYPES_PER_SVM + t];
+        for (int i = 0; i < UVM_FA_SLOTS_PER_STREAM; ++i) {
+            if (stream->slots[i] >= 0) fa_emit_and_release(stream, i);
+        }
+    }
+}
+
+// Номер по модулю 2048: впереди ожидаемого - пропуск, позади - опоздавшее сообщение
+void uvm_frame_assembler_track_message_number(int svm_id, unsigned session, uint16_t msg_num) {
+    if (!fa_numbering || svm_id < 0 || svm_id >= fa_num_svms) return;
+    FrameNumbering *numbering = &fa_numbering[svm_id];
+    if (!numbering->have_expected || numbering->session != session) {
+        numbering->have_expected = true;
+        numbering->session = session;
+        numbering->expected_msg_num = (uint16_t)((msg_num + 1) % FA_MSG_NUM_MODULO);
+        return;
+    }
+    uint16_t ahead = (uint16_t)((msg_num - numbering->expected_msg_num + FA_MSG_NUM_MODULO) % FA_MSG_NUM_MODULO);
+    if (ahead == 0) {
+        numbering->expected_msg_num = (uint16_t)((msg_num + 1) % FA_MSG_NUM_MODULO);
+    } else if (ahead < FA_MSG_NUM_MODULO / 2) {
+        __atomic_add_fetch(&fa_stats.message_gaps, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&fa_stats.messages_missed, ahead, __ATOMIC_RELAXED);
+        numbering->expected_msg_num = (uint16_t)((msg_num + 1) % FA_MSG_NUM_MODULO);
+    } else {
+        __atomic_add_fetch(&fa_stats.messages_out_of_order, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void uvm_frame_assembler_get_stats(UvmFrameAssemblerStats *stats) {
+    if (!stats) return;
+    stats->lines_accepted = __atomic_load_n(&fa_stats.lines_accepted, __ATOMIC_RELAXED);
+    stats->lines_duplicate = __atomic_load_n(&fa_stats.lines_duplicate, __ATOMIC_RELAXED);
+    stats->lines_rejected = __atomic_load_n(&fa_stats.lines_rejected, __ATOMIC_RELAXED);
+    stats->messages_out_of_order = __atomic_load_n(&fa_stats.messages_out_of_order, __ATOMIC_RELAXED);
+    stats->message_gaps = __atomic_load_n(&fa_stats.message_gaps, __ATOMIC_RELAXED);
+    stats->messages_missed = __atomic_load_n(&fa_stats.messages_missed, __ATOMIC_RELAXED);
+    stats->frames_complete = __atomic_load_n(&fa_stats.frames_complete, __ATOMIC_RELAXED);
+    stats->frames_incomplete = __atomic_load_n(&fa_stats.frames_incomplete, __ATOMIC_RELAXED);
+    stats->max_assembly_ns = __atomic_load_n(&fa_stats.max_assembly_ns, __ATOMIC_RELAXED);
+    stats->total_assembly_ns = __atomic_load_n(&fa_stats.total_assembly_ns, __ATOMIC_RELAXED);
+}
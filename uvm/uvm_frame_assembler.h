@@ -0,0 +1,107 @@
+/*
+ * uvm/uvm_frame_assembler.h
+ *
+ * Описание:
+ * Сборщик кадров из строк «Строка К3» и «Строка изображения К4».
+ * Строки раскладываются по кадрам (ключ: СВ-М, тип строки, номер кадра) в заранее
+ * выделенной арене; выделения памяти на каждую строку нет.
+ * Строки могут приходить не по порядку. Готовый (или вытесненный неполным) кадр
+ * передается потребителю. Сборка (feed/end_session) выполняется одним потоком - потоком
+ * приемника данных. Пропуски отслеживаются по 11-битному номеру сообщения отдельно:
+ * номер у СВ-М общий для всех типов сообщений, поэтому его проверяет поток управления,
+ * через который проходят все сообщения (uvm_frame_assembler_track_message_number).
+ */
+#ifndef UVM_FRAME_ASSEMBLER_H
+#define UVM_FRAME_ASSEMBLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../protocol/protocol_defs.h"
+
+// Сколько кадров одного потока (СВ-М + тип строки) может собираться одновременно
+#define UVM_FA_SLOTS_PER_STREAM 2
+// Значения по умолчанию для размеров кадра
+#define UVM_FA_DEFAULT_MAX_LINES 1024
+#define UVM_FA_DEFAULT_LINE_BYTES 4096
+
+// Собранный кадр, передаваемый потребителю.
+// Указатели действительны только во время вызова обработчика (память арены переиспользуется).
+typedef struct {
+    int svm_id;
+    uint8_t message_type;          // MESSAGE_TYPE_STROKA_K3 или MESSAGE_TYPE_STROKA_IZOBRAZHENIYA_K4
+    uint16_t frame_number;         // Номер кадра
+    uint16_t line_count;           // Объявленное количество строк в кадре
+    uint16_t lines_received;       // Сколько строк фактически принято
+    bool complete;                 // true, если приняты все строки
+    uint32_t bcb;                  // ВСВ последней принятой строки
+    size_t line_stride;            // Шаг строк в data (байт)
+    const uint8_t *data;           // Отсчеты: строка i начинается с data + i * line_stride
+    const uint32_t *line_lengths;  // Длина каждой строки (0 для непринятых)
+    const uint64_t *line_bitmap;   // Битовая карта принятых строк
+    uint64_t assembly_ns;          // Время от первой строки кадра до выдачи
+} UvmAssembledFrame;
+
+// Обработчик готовых кадров
+typedef void (*UvmFrameConsumer)(const UvmAssembledFrame *frame, void *user_data);
+
+// Статистика сборщика
+typedef struct {
+    uint64_t lines_accepted;
+    uint64_t lines_duplicate;      // Повторно пришедшая строка кадра
+    uint64_t lines_rejected;       // Некорректный заголовок или размер
+    uint64_t messages_out_of_order; // Номер сообщения меньше ожидаемого
+    uint64_t message_gaps;         // Количество обнаруженных разрывов нумерации
+    uint64_t messages_missed;      // Суммарное число пропущенных номеров сообщений
+    uint64_t frames_complete;
+    uint64_t frames_incomplete;    // Выданы неполными (вытеснены или завершен сеанс)
+    uint64_t max_assembly_ns;
+    uint64_t total_assembly_ns;    // Для подсчета среднего по frames_complete
+} UvmFrameAssemblerStats;
+
+/**
+ * @brief Выделяет арену сборщика.
+ * @param num_svms Количество СВ-М (потоков на каждый СВ-М - два: К3 и К4).
+ * @param max_lines Максимальное число строк в кадре.
+ * @param line_bytes Максимальный размер отсчетов одной строки (без заголовка).
+ * @param consumer Обработчик готовых кадров.
+ * @param user_data Параметр, передаваемый обработчику.
+ * @return 0 в случае успеха, -1 в случае ошибки.
+ */
+int uvm_frame_assembler_init(int num_svms, uint16_t max_lines, size_t line_bytes,
+                             UvmFrameConsumer consumer, void *user_data);
+
+/**
+ * @brief Освобождает арену (предварительно выдает неполные кадры).
+ */
+void uvm_frame_assembler_destroy(void);
+
+/**
+ * @brief Проверяет, собирает ли сборщик кадры из сообщений данного типа.
+ */
+bool uvm_frame_assembler_handles_type(uint8_t message_type);
+
+/**
+ * @brief Принимает одну строку (сообщение в порядке байт хоста).
+ * @return true, если строка принята в кадр.
+ */
+bool uvm_frame_assembler_feed(int svm_id, const Message *msg);
+
+/**
+ * @brief Проверяет нумерацию сообщений СВ-М (message_gaps, messages_missed, messages_out_of_order).
+ * Вызывается потоком управления для каждого сообщения СВ-М любого типа;
+ * в новом сеансе связи (session) нумерация начинается заново.
+ */
+void uvm_frame_assembler_track_message_number(int svm_id, unsigned session, uint16_t msg_num);
+
+/**
+ * @brief Завершает сеанс СВ-М: незавершенные кадры выдаются неполными.
+ */
+void uvm_frame_assembler_end_session(int svm_id);
+
+/**
+ * @brief Копирует текущую статистику (из любого потока).
+ */
+void uvm_frame_assembler_get_stats(UvmFrameAssemblerStats *stats);
+
+#endif // UVM_FRAME_ASSEMBLER_H
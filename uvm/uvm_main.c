@@ -2,6 +2,7 @@
  * uvm/uvm_main.c
  * ... (описание как раньше) ...
  */
+#define _GNU_SOURCE // Для pthread_tryjoin_np
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,9 +15,11 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <errno.h>
+#include <sys/epoll.h>
 
 #include "../config/config.h"
 #include "../io/io_interface.h"
+#include "../io/io_common.h"
 #include "../protocol/protocol_defs.h"
 #include "../protocol/message_builder.h"
 #include "../protocol/message_utils.h"
@@ -24,11 +27,15 @@
 #include "../utils/ts_uvm_resp_queue.h"
 #include "uvm_types.h"
 #include "uvm_utils.h"
+#include "uvm_data_sink.h"
+#include "uvm_frame_assembler.h"
 
 // --- Глобальные переменные ---
 AppConfig config;
 UvmSvmLink svm_links[MAX_SVM_INSTANCES]; // Используем MAX_SVM_INSTANCES
 pthread_mutex_t uvm_links_mutex;
+UvmMuxChannel uvm_mux_channels[MAX_SVM_INSTANCES]; // Общие соединения (mux_port или последовательный порт)
+int uvm_num_mux_channels = 0;
 
 ThreadSafeReqQueue *uvm_outgoing_request_queue = NULL;
 ThreadSafeUvmRespQueue *uvm_incoming_response_queue = NULL;
@@ -46,6 +53,7 @@ pthread_mutex_t gui_socket_mutex = PTHREAD_MUTEX_INITIALIZER;
 // Прототипы
 void* uvm_sender_thread_func(void* arg);
 void* uvm_receiver_thread_func(void* arg);
+void* uvm_mux_receiver_thread_func(void* arg);
 void* gui_server_thread(void* arg);
 void send_to_gui_socket(const char *message_to_gui); // Объявляем здесь
 
@@ -58,16 +66,20 @@ void uvm_handle_shutdown_signal(int sig) {
     // Сигналим очередям
     if (uvm_outgoing_request_queue) queue_req_shutdown(uvm_outgoing_request_queue);
     if (uvm_incoming_response_queue) uvq_shutdown(uvm_incoming_response_queue);
+    // Мьютексы берутся только через trylock: сигнал мог прервать поток, который их держит
+    // (например, основной цикл в send_to_gui_socket); тогда все закроет очистка в main
     // Сигналим условию ожидания
-    pthread_mutex_lock(&uvm_send_counter_mutex);
-    uvm_outstanding_sends = 0;
-    pthread_cond_broadcast(&uvm_all_sent_cond); // Используем broadcast
-    pthread_mutex_unlock(&uvm_send_counter_mutex);
+    if (pthread_mutex_trylock(&uvm_send_counter_mutex) == 0) {
+        uvm_outstanding_sends = 0;
+        pthread_cond_broadcast(&uvm_all_sent_cond); // Используем broadcast
+        pthread_mutex_unlock(&uvm_send_counter_mutex);
+    }
     // Закрываем сокеты GUI
-    pthread_mutex_lock(&gui_socket_mutex);
-    if (gui_listen_fd >= 0) { int fd=gui_listen_fd; gui_listen_fd=-1; shutdown(fd, SHUT_RDWR); close(fd); }
-    if (gui_client_fd >= 0) { int fd=gui_client_fd; gui_client_fd=-1; shutdown(fd, SHUT_RDWR); close(fd); }
-    pthread_mutex_unlock(&gui_socket_mutex);
+    if (pthread_mutex_trylock(&gui_socket_mutex) == 0) {
+        if (gui_listen_fd >= 0) { int fd=gui_listen_fd; gui_listen_fd=-1; shutdown(fd, SHUT_RDWR); close(fd); }
+        if (gui_client_fd >= 0) { int fd=gui_client_fd; gui_client_fd=-1; shutdown(fd, SHUT_RDWR); close(fd); }
+        pthread_mutex_unlock(&gui_socket_mutex);
+    }
     // Закрываем сокеты SVM (делается в main при cleanup)
 }
 
@@ -145,6 +157,8 @@ bool send_uvm_request(UvmRequest *request) {
                 message_to_host_byte_order(&temp_msg_for_weight); // Гарантируем хостовый порядок для body_length
                 uint16_t body_len_sent_host = temp_msg_for_weight.header.body_length;
                 size_t weight_sent = sizeof(MessageHeader) + body_len_sent_host;
+                link->tx_messages++;
+                link->tx_bytes += weight_sent;
 				// printf("DEBUG SENT Type 160: body_len_sent_host = %u, sizeof(PrinyatParametrySoBody) = %zu, calculated_weight = %zu\n", body_len_sent_host, sizeof(PrinyatParametrySoBody), weight_sent);
 
                 // --- КОНЕЦ---
@@ -299,7 +313,7 @@ void* gui_server_thread(void* arg) {
 
         // --- Отправка начального состояния всех SVM новому клиенту GUI ---
         printf("GUI Server: Sending initial state to new GUI client (FD %d).\n", new_client_fd);
-        for (int i = 0; i < config.num_svm_configs_found; ++i) {
+        for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
             if (!config.svm_config_loaded[i]) continue; // Пропускаем незагруженные
 
             pthread_mutex_lock(&uvm_links_mutex); // Блокируем доступ к svm_links
@@ -382,6 +396,671 @@ void* gui_server_thread(void* arg) {
 }
 
 // Основная функция
+// Обработчик собранных кадров К3/К4 (вызывается из потока приемника данных)
+// События о собранных кадрах: обработчик сборщика работает в потоке приемника данных,
+// а сокет GUI - дело потока main, поэтому события передаются через небольшую очередь
+#define UVM_FRAME_EVENT_QUEUE 64
+static char uvm_frame_events[UVM_FRAME_EVENT_QUEUE][256];
+static int uvm_frame_events_head = 0;
+static int uvm_frame_events_count = 0;
+static unsigned long uvm_frame_events_dropped = 0;
+static pthread_mutex_t uvm_frame_events_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void uvm_on_frame_assembled(const UvmAssembledFrame *frame, void *user_data) {
+    (void)user_data;
+    pthread_mutex_lock(&uvm_frame_events_mutex);
+    if (uvm_frame_events_count == UVM_FRAME_EVENT_QUEUE) {
+        uvm_frame_events_dropped++; // main давно не забирал события - приемник данных не ждет
+        pthread_mutex_unlock(&uvm_frame_events_mutex);
+        return;
+    }
+    int slot = (uvm_frame_events_head + uvm_frame_events_count) % UVM_FRAME_EVENT_QUEUE;
+    snprintf(uvm_frame_events[slot], sizeof(uvm_frame_events[slot]),
+             "EVENT;SVM_ID:%d;Type:Frame;Details:Kind=%s,Frame=%u,Lines=%u/%u,Complete=%d,BCB=0x%08X,AssemblyUs=%llu",
+             frame->svm_id, frame->message_type == MESSAGE_TYPE_STROKA_K3 ? "K3" : "K4",
+             frame->frame_number, frame->lines_received, frame->line_count, frame->complete ? 1 : 0,
+             frame->bcb, (unsigned long long)(frame->assembly_ns / 1000));
+    uvm_frame_events_count++;
+    pthread_mutex_unlock(&uvm_frame_events_mutex);
+}
+
+// Отправляет в GUI накопленные события о кадрах (поток main); true - было что отправить
+static bool uvm_flush_frame_events(void) {
+    char event[sizeof(uvm_frame_events[0])];
+    bool sent_any = false;
+    while (true) {
+        pthread_mutex_lock(&uvm_frame_events_mutex);
+        if (uvm_frame_events_count == 0) {
+            pthread_mutex_unlock(&uvm_frame_events_mutex);
+            break;
+        }
+        memcpy(event, uvm_frame_events[uvm_frame_events_head], sizeof(event));
+        uvm_frame_events_head = (uvm_frame_events_head + 1) % UVM_FRAME_EVENT_QUEUE;
+        uvm_frame_events_count--;
+        pthread_mutex_unlock(&uvm_frame_events_mutex);
+        send_to_gui_socket(event);
+        sent_any = true;
+    }
+    return sent_any;
+}
+
+static uint64_t uvm_monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+static uint64_t uvm_monotonic_ms(void) {
+    return uvm_monotonic_us() / 1000ull;
+}
+
+// Статистика по узлам эмуляции: линки группируются по адресу узла СВ-М (под uvm_links_mutex)
+static void uvm_print_node_stats(int num_svms_in_config) {
+    bool reported[MAX_SVM_INSTANCES] = { false };
+    printf("UVM: --- Статистика по узлам СВ-М ---\n");
+    for (int i = 0; i < num_svms_in_config; ++i) {
+        if (!config.svm_config_loaded[i] || reported[i]) continue;
+        const char *node = config.svm_ethernet[i].target_ip;
+        int links = 0, active = 0;
+        uint64_t tx_msgs = 0, tx_bytes = 0, rx_msgs = 0, rx_bytes = 0;
+        uint64_t rtt_count = 0, rtt_sum = 0, rtt_max = 0;
+        uint32_t tcp_srtt_max = 0, tcp_retransmits = 0;
+        unsigned long recoveries = 0;
+        for (int j = i; j < num_svms_in_config; ++j) {
+            if (!config.svm_config_loaded[j] || strcmp(config.svm_ethernet[j].target_ip, node) != 0) continue;
+            const UvmSvmLink *link = &svm_links[j];
+            reported[j] = true;
+            links++;
+            if (link->status == UVM_LINK_ACTIVE || link->status == UVM_LINK_WARNING) active++;
+            tx_msgs += link->tx_messages;
+            tx_bytes += link->tx_bytes;
+            rx_msgs += link->rx_messages;
+            rx_bytes += link->rx_bytes;
+            rtt_count += link->rtt_count;
+            rtt_sum += link->rtt_sum_us;
+            if (link->rtt_max_us > rtt_max) rtt_max = link->rtt_max_us;
+            recoveries += link->recoveries;
+            if (link->tcp_info_at_ms != 0) {
+                if (link->tcp_info.srtt_us > tcp_srtt_max) tcp_srtt_max = link->tcp_info.srtt_us;
+                if (link->tcp_info.retransmits > tcp_retransmits) tcp_retransmits = link->tcp_info.retransmits; // Общее соединение - не суммируем
+            }
+        }
+        printf("UVM: Узел %s: СВ-М %d (активно %d), отправлено %llu сообщ./%llu байт, принято %llu сообщ./%llu байт, "
+               "ответ на команду avg %llu мкс, max %llu мкс (%llu), восстановлений %lu, TCP srtt max %u мкс, повторов %u\n",
+               node, links, active, (unsigned long long)tx_msgs, (unsigned long long)tx_bytes,
+               (unsigned long long)rx_msgs, (unsigned long long)rx_bytes,
+               (unsigned long long)(rtt_count ? rtt_sum / rtt_count : 0), (unsigned long long)rtt_max,
+               (unsigned long long)rtt_count, recoveries, tcp_srtt_max, tcp_retransmits);
+        char gui_msg[256];
+        snprintf(gui_msg, sizeof(gui_msg),
+                 "EVENT;SVM_ID:%d;Type:NodeStats;Details:Node=%s,Links=%d,Active=%d,TxMsgs=%llu,TxBytes=%llu,"
+                 "RxMsgs=%llu,RxBytes=%llu,RttAvgUs=%llu,RttMaxUs=%llu",
+                 i, node, links, active, (unsigned long long)tx_msgs, (unsigned long long)tx_bytes,
+                 (unsigned long long)rx_msgs, (unsigned long long)rx_bytes,
+                 (unsigned long long)(rtt_count ? rtt_sum / rtt_count : 0), (unsigned long long)rtt_max);
+        send_to_gui_socket(gui_msg);
+    }
+    if (config.zerocopy_threshold > 0) {
+        EthernetZcStats zc;
+        ethernet_zerocopy_stats(&zc);
+        printf("UVM: Zero-copy (от %d байт): отправок %llu, %llu байт без копирования, из них скопировано ядром %llu отправок, "
+               "обычной отправкой при нехватке памяти сокета %llu байт\n", config.zerocopy_threshold,
+               (unsigned long long)zc.zerocopy_sends, (unsigned long long)zc.zerocopy_bytes,
+               (unsigned long long)zc.kernel_copied, (unsigned long long)zc.fallback_bytes);
+    }
+    if (config.frame_assembler_enabled) {
+        UvmFrameAssemblerStats fa;
+        uvm_frame_assembler_get_stats(&fa);
+        printf("UVM: Сборка кадров: строк принято %llu, повторов %llu, отклонено %llu; кадров полных %llu "
+               "(сборка avg %llu мкс, max %llu мкс), неполных %llu; разрывов нумерации %llu (пропущено сообщений %llu), "
+               "не по порядку %llu\n",
+               (unsigned long long)fa.lines_accepted, (unsigned long long)fa.lines_duplicate,
+               (unsigned long long)fa.lines_rejected, (unsigned long long)fa.frames_complete,
+               (unsigned long long)(fa.frames_complete ? fa.total_assembly_ns / fa.frames_complete / 1000 : 0),
+               (unsigned long long)(fa.max_assembly_ns / 1000), (unsigned long long)fa.frames_incomplete,
+               (unsigned long long)fa.message_gaps, (unsigned long long)fa.messages_missed,
+               (unsigned long long)fa.messages_out_of_order);
+    }
+    pthread_mutex_lock(&uvm_frame_events_mutex);
+    unsigned long frame_events_dropped = uvm_frame_events_dropped;
+    pthread_mutex_unlock(&uvm_frame_events_mutex);
+    if (frame_events_dropped > 0) {
+        printf("UVM: Событий о кадрах не передано в GUI (очередь заполнена): %lu\n", frame_events_dropped);
+    }
+    if (config.data_sink_enabled && uvm_data_sink_dropped() > 0) {
+        printf("UVM: Приемник данных не успевал: отброшено строк %llu\n", (unsigned long long)uvm_data_sink_dropped());
+    }
+}
+
+// Снимок TCP_INFO активных линков (вызывается под uvm_links_mutex) и событие TcpInfo в GUI.
+// Медленная обработка на СВ-М видна как большой ответ на команду при малом srtt,
+// перегрузка сети - как рост srtt/rttvar, повторов и очередей отправки
+static void uvm_sample_tcp_info(int num_svms_in_config, uint64_t now_ms) {
+    for (int i = 0; i < num_svms_in_config; ++i) {
+        UvmSvmLink *link = &svm_links[i];
+        if (!config.svm_config_loaded[i] || !link->io_handle || link->connection_handle < 0) continue;
+        if (link->status != UVM_LINK_ACTIVE && link->status != UVM_LINK_WARNING) continue;
+        EthernetTcpInfo info;
+        if (io_tcp_info(link->io_handle, link->connection_handle, &info) != 0) continue; // Не TCP
+        link->tcp_info = info;
+        link->tcp_info_at_ms = now_ms;
+        char gui_msg[256];
+        snprintf(gui_msg, sizeof(gui_msg),
+                 "EVENT;SVM_ID:%d;Type:TcpInfo;Details:SrttUs=%u,RttvarUs=%u,Retrans=%u,Cwnd=%u,UnackedBytes=%u,SendQBytes=%u",
+                 i, info.srtt_us, info.rttvar_us, info.retransmits, info.cwnd, info.unacked_bytes, info.sendq_bytes);
+        send_to_gui_socket(gui_msg);
+    }
+}
+
+// IO интерфейс подключения к СВ-М: TCP к узлу (при interface_type = uring - на io_uring) или,
+// при interface_type = unix/shm, локальный сокет svm_<port>.sock (узел тогда - эта же машина)
+static IOInterface* uvm_create_target_io(const char *target_ip, uint16_t port) {
+    bool shm = strcasecmp(config.interface_type, "shm") == 0;
+    if (shm || strcasecmp(config.interface_type, "unix") == 0) {
+        UnixConfig unix_config = {0};
+        if (unix_socket_path(unix_config.path, sizeof(unix_config.path), config.unix_socket_dir, port) != 0) return NULL;
+        return shm ? create_shm_interface(&unix_config) : create_unix_interface(&unix_config);
+    }
+    EthernetConfig ethernet_config = {0};
+    strncpy(ethernet_config.target_ip, target_ip, sizeof(ethernet_config.target_ip) - 1);
+    ethernet_config.port = port;
+    ethernet_config.base.type = IO_TYPE_ETHERNET;
+    ethernet_config.zerocopy_threshold = (uint32_t)config.zerocopy_threshold;
+    ethernet_config.profile = config.socket_profile;
+    if (strcasecmp(config.interface_type, "uring") == 0) {
+        return create_uring_interface(&ethernet_config); // Без io_uring - обычный Ethernet
+    }
+    return create_ethernet_interface(&ethernet_config);
+}
+
+// Неблокирующее подключение по типу интерфейса (последовательный порт открывается сразу)
+static int uvm_io_connect_start(IOInterface *io) {
+    switch (io->type) {
+        case IO_TYPE_SERIAL: return io->connect(io);
+        case IO_TYPE_UNIX:   return unix_connect_start(io);
+        case IO_TYPE_SHM:    return shm_connect_start(io);
+        case IO_TYPE_URING:  return uring_connect_start(io);
+        default:             return ethernet_connect_start(io);
+    }
+}
+
+static int uvm_io_connect_finish(IOInterface *io) {
+    switch (io->type) {
+        case IO_TYPE_SERIAL: return io->io_handle;
+        case IO_TYPE_UNIX:   return unix_connect_finish(io);
+        case IO_TYPE_SHM:    return shm_connect_finish(io);
+        case IO_TYPE_URING:  return uring_connect_finish(io);
+        default:             return ethernet_connect_finish(io);
+    }
+}
+
+// Незавершенные неблокирующие подключения (линков и общих соединений) в одном epoll.
+// Их завершает основной цикл (uvm_connect_tick): подготовка линка начинается, как только
+// подключился он сам, не дожидаясь остальных.
+static int uvm_connect_epfd = -1;
+// Метка общего соединения в epoll_event.data.u32 (иначе там ID линка)
+#define UVM_EPOLL_MUX_TAG 0x80000000u
+
+static bool uvm_connect_watch(int fd, uint32_t tag) {
+    struct epoll_event ev = { .events = EPOLLOUT, .data.u32 = tag };
+    if (epoll_ctl(uvm_connect_epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("UVM: epoll_ctl failed");
+        return false;
+    }
+    return true;
+}
+
+static void uvm_connect_unwatch(int fd) {
+    if (fd >= 0) epoll_ctl(uvm_connect_epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+static void uvm_link_abort_connect(UvmSvmLink *link);
+
+// Начинает неблокирующее подключение линка (под uvm_links_mutex). IO интерфейс линка
+// создается один раз и переиспользуется при переподключениях.
+static bool uvm_link_begin_connect(UvmSvmLink *link) {
+    int i = link->id;
+    if (!link->io_handle) {
+        link->io_handle = uvm_create_target_io(config.svm_ethernet[i].target_ip, config.svm_ethernet[i].port);
+        if (!link->io_handle) {
+            fprintf(stderr, "UVM: Failed to create IO interface for SVM ID %d.\n", i);
+            link->status = UVM_LINK_FAILED;
+            return false;
+        }
+    }
+    printf("UVM: Attempting to connect to SVM ID %d (IP: %s, Port: %d)...\n",
+           i, config.svm_ethernet[i].target_ip, config.svm_ethernet[i].port);
+    link->status = UVM_LINK_CONNECTING;
+    link->assigned_lak = config.svm_settings[i].lak; // LAK из конфига SVM
+    if (uvm_io_connect_start(link->io_handle) < 0) { // Прежний сокет линка закрывается здесь
+        fprintf(stderr, "UVM: Failed to start connection to SVM ID %d.\n", i);
+        link->status = UVM_LINK_FAILED;
+        link->connect_deadline_ms = 0;
+        return false;
+    }
+    link->connect_deadline_ms = uvm_monotonic_ms() + (uint64_t)config.uvm_connect_timeout_ms;
+    if (!uvm_connect_watch(link->io_handle->io_handle, (uint32_t)i)) {
+        uvm_link_abort_connect(link);
+        return false;
+    }
+    return true;
+}
+
+// Попытка подключения не удалась или истек ее срок (под uvm_links_mutex).
+// Следующую попытку (если переподключение включено) планирует uvm_reconnect_tick.
+static void uvm_link_abort_connect(UvmSvmLink *link) {
+    link->status = UVM_LINK_FAILED;
+    link->connect_deadline_ms = 0;
+    link->reconnect_at_ms = 0;
+    if (link->io_handle && link->io_handle->io_handle >= 0) {
+        uvm_connect_unwatch(link->io_handle->io_handle);
+        link->io_handle->disconnect(link->io_handle, link->io_handle->io_handle);
+    }
+}
+
+// Линк снова готов к работе (под uvm_links_mutex): подготовка начинается заново с «Инициализации канала»
+static void uvm_link_activate(UvmSvmLink *link) {
+    link->status = UVM_LINK_ACTIVE;
+    link->last_activity_time = time(NULL);
+    link->prep_state = PREP_STATE_READY_TO_SEND_INIT_CHANNEL;
+    link->current_preparation_msg_num = 0;
+    link->last_command_sent_time = 0;
+    link->reconnect_at_ms = 0;
+    link->params_resume = false;
+    link->timeout_detected = false;
+    link->response_timeout_detected = false;
+    link->lak_mismatch_detected = false;
+}
+
+// Отправка события LinkStatus в GUI
+static void uvm_send_link_status(const UvmSvmLink *link) {
+    char gui_msg[128];
+    snprintf(gui_msg, sizeof(gui_msg), "EVENT;SVM_ID:%d;Type:LinkStatus;Details:NewStatus=%d", link->id, link->status);
+    send_to_gui_socket(gui_msg);
+}
+
+// Подключение завершено (вызывается под uvm_links_mutex): линк сразу становится рабочим
+static bool uvm_link_on_connected(UvmSvmLink *link) {
+    link->connect_deadline_ms = 0;
+    uvm_connect_unwatch(link->io_handle->io_handle);
+    link->connection_handle = uvm_io_connect_finish(link->io_handle); // При ошибке сокет закрыт
+    if (link->connection_handle < 0) {
+        fprintf(stderr, "UVM: Failed to connect to SVM ID %d.\n", link->id);
+        link->status = UVM_LINK_FAILED;
+        link->reconnect_at_ms = 0;
+        return false;
+    }
+    printf("UVM: Successfully connected to SVM ID %d (Handle: %d).\n", link->id, link->connection_handle);
+    uvm_link_activate(link);
+    if (pthread_create(&link->receiver_tid, NULL, uvm_receiver_thread_func, link) != 0) {
+        perror("UVM: Failed to create receiver thread");
+        link->receiver_tid = 0;
+        // Без Receiver'а сокет никто не закроет
+        link->io_handle->disconnect(link->io_handle, link->connection_handle);
+        link->connection_handle = -1;
+        link->status = UVM_LINK_FAILED; // Помечаем как ошибку
+        link->reconnect_at_ms = 0;
+        return false;
+    }
+    uvm_send_link_status(link);
+    return true;
+}
+
+// --- Общие (мультиплексированные) соединения с узлами эмуляции ---
+
+// Группировка СВ-М в общие соединения: по одному на узел (TCP, mux_port)
+// или одно на всех (последовательный порт, сокет Unix). Возвращает false при ошибке.
+static bool uvm_mux_setup(int num_svms_in_config) {
+    bool serial = strcasecmp(config.interface_type, "serial") == 0;
+    bool local = strcasecmp(config.interface_type, "unix") == 0 || strcasecmp(config.interface_type, "shm") == 0;
+    if (!serial && config.mux_port <= 0) return true; // У каждого СВ-М свое соединение
+    for (int i = 0; i < num_svms_in_config; ++i) {
+        if (!config.svm_config_loaded[i]) continue;
+        int c = 0;
+        if (!serial && !local) { // Канал узла: тот же адрес (сокет Unix - один узел, эта машина)
+            for (c = 0; c < uvm_num_mux_channels; ++c) {
+                if (strcmp(config.svm_ethernet[uvm_mux_channels[c].link_ids[0]].target_ip,
+                           config.svm_ethernet[i].target_ip) == 0) break;
+            }
+        }
+        UvmMuxChannel *channel = &uvm_mux_channels[c];
+        if (c == uvm_num_mux_channels) {
+            memset(channel, 0, sizeof(*channel));
+            channel->id = c;
+            channel->connection_handle = -1;
+            memset(channel->link_by_lak, -1, sizeof(channel->link_by_lak));
+            if (serial) {
+                channel->io_handle = create_serial_interface(&config.serial);
+            } else {
+                channel->io_handle = uvm_create_target_io(config.svm_ethernet[i].target_ip, (uint16_t)config.mux_port);
+            }
+            if (!channel->io_handle) {
+                fprintf(stderr, "UVM: Failed to create IO interface for shared channel %d.\n", c);
+                return false;
+            }
+            uvm_num_mux_channels++;
+        }
+        LogicalAddress lak = config.svm_settings[i].lak;
+        if (channel->link_by_lak[lak] >= 0) {
+            fprintf(stderr, "UVM: SVM %d and SVM %d share LAK 0x%02X on one connection. Exiting.\n",
+                    channel->link_by_lak[lak], i, lak);
+            return false;
+        }
+        channel->link_by_lak[lak] = (int16_t)i;
+        channel->link_ids[channel->num_links++] = i;
+        svm_links[i].mux_channel = c;
+        svm_links[i].io_handle = channel->io_handle; // Отправитель пишет в общее соединение
+        svm_links[i].assigned_lak = lak;
+    }
+    for (int c = 0; c < uvm_num_mux_channels; ++c) {
+        printf("UVM: Shared channel %d -> %s: %d SVM multiplexed by LAK.\n", c,
+               serial ? config.serial.device : config.svm_ethernet[uvm_mux_channels[c].link_ids[0]].target_ip,
+               uvm_mux_channels[c].num_links);
+    }
+    return true;
+}
+
+static bool uvm_mux_on_connected(UvmMuxChannel *channel);
+
+// Попытка подключения общего соединения не удалась или истек ее срок (под uvm_links_mutex)
+static void uvm_mux_abort_connect(UvmMuxChannel *channel) {
+    channel->connect_deadline_ms = 0;
+    channel->reconnect_at_ms = 0;
+    if (channel->io_handle->io_handle >= 0) {
+        uvm_connect_unwatch(channel->io_handle->io_handle);
+        channel->io_handle->disconnect(channel->io_handle, channel->io_handle->io_handle);
+    }
+    for (int k = 0; k < channel->num_links; ++k) svm_links[channel->link_ids[k]].status = UVM_LINK_FAILED;
+}
+
+// Начинает подключение общего соединения (под uvm_links_mutex); последовательный порт открывается сразу
+static bool uvm_mux_begin_connect(UvmMuxChannel *channel) {
+    for (int k = 0; k < channel->num_links; ++k) svm_links[channel->link_ids[k]].status = UVM_LINK_CONNECTING;
+    int handle = uvm_io_connect_start(channel->io_handle);
+    if (handle < 0) {
+        fprintf(stderr, "UVM: Failed to start shared channel %d connection.\n", channel->id);
+        for (int k = 0; k < channel->num_links; ++k) svm_links[channel->link_ids[k]].status = UVM_LINK_FAILED;
+        channel->connect_deadline_ms = 0;
+        channel->reconnect_at_ms = 0;
+        return false;
+    }
+    channel->connect_deadline_ms = uvm_monotonic_ms() + (uint64_t)config.uvm_connect_timeout_ms;
+    if (channel->io_handle->type == IO_TYPE_SERIAL) return uvm_mux_on_connected(channel);
+    if (!uvm_connect_watch(handle, UVM_EPOLL_MUX_TAG | (uint32_t)channel->id)) {
+        uvm_mux_abort_connect(channel);
+        return false;
+    }
+    return true;
+}
+
+// Общее соединение установлено (под uvm_links_mutex): все СВ-М канала начинают подготовку
+static bool uvm_mux_on_connected(UvmMuxChannel *channel) {
+    channel->connect_deadline_ms = 0;
+    uvm_connect_unwatch(channel->io_handle->io_handle);
+    channel->connection_handle = uvm_io_connect_finish(channel->io_handle);
+    if (channel->connection_handle < 0) {
+        fprintf(stderr, "UVM: Failed to connect shared channel %d.\n", channel->id);
+        for (int k = 0; k < channel->num_links; ++k) svm_links[channel->link_ids[k]].status = UVM_LINK_FAILED;
+        channel->reconnect_at_ms = 0;
+        return false;
+    }
+    if (pthread_create(&channel->receiver_tid, NULL, uvm_mux_receiver_thread_func, channel) != 0) {
+        perror("UVM: Failed to create shared channel receiver thread");
+        channel->receiver_tid = 0;
+        uvm_mux_abort_connect(channel);
+        channel->connection_handle = -1;
+        return false;
+    }
+    channel->up = true;
+    printf("UVM: Shared channel %d connected (Handle: %d), %d SVM on it.\n",
+           channel->id, channel->connection_handle, channel->num_links);
+    for (int k = 0; k < channel->num_links; ++k) {
+        UvmSvmLink *link = &svm_links[channel->link_ids[k]];
+        link->connection_handle = channel->connection_handle;
+        link->reconnect_attempts = channel->reconnect_attempts; // Для отчета о восстановлении
+        uvm_link_activate(link);
+        uvm_send_link_status(link);
+    }
+    channel->reconnect_attempts = 0;
+    channel->reconnect_at_ms = 0;
+    return true;
+}
+
+// Запускает подключение ко всем СВ-М (неблокирующие connect одновременно) и сразу возвращается.
+// Возвращает число начатых подключений (последовательный порт - уже подключенный).
+static int uvm_start_connects(int num_svms_in_config) {
+    int started = 0;
+    pthread_mutex_lock(&uvm_links_mutex);
+    for (int c = 0; c < uvm_num_mux_channels; ++c) { // Общие соединения (по одному на узел)
+        if (uvm_mux_begin_connect(&uvm_mux_channels[c])) started++;
+    }
+    for (int i = 0; i < num_svms_in_config; ++i) {
+        if (!config.svm_config_loaded[i] || svm_links[i].mux_channel >= 0) continue;
+        if (uvm_link_begin_connect(&svm_links[i])) started++;
+    }
+    pthread_mutex_unlock(&uvm_links_mutex);
+    return started;
+}
+
+// Завершение неблокирующих подключений (основной цикл, без uvm_links_mutex): подключившийся
+// линк сразу становится рабочим, не успевший к сроку - FAILED. В *pending - число еще идущих
+// подключений. Возвращает true, если что-то было сделано.
+static bool uvm_connect_tick(int num_svms_in_config, int *pending) {
+    bool did_something = false;
+    struct epoll_event events[MAX_SVM_INSTANCES];
+    int n = epoll_wait(uvm_connect_epfd, events, MAX_SVM_INSTANCES, 0);
+    if (n < 0 && errno != EINTR) perror("UVM: epoll_wait failed");
+    uint64_t now = uvm_monotonic_ms();
+
+    pthread_mutex_lock(&uvm_links_mutex);
+    for (int k = 0; k < n; ++k) {
+        if (events[k].data.u32 & UVM_EPOLL_MUX_TAG) {
+            UvmMuxChannel *channel = &uvm_mux_channels[events[k].data.u32 & ~UVM_EPOLL_MUX_TAG];
+            if (channel->connect_deadline_ms == 0) continue;
+            unsigned attempts = channel->reconnect_attempts;
+            if (uvm_mux_on_connected(channel) && attempts > 0) {
+                printf("UVM Reconnect (channel %d): Connected after %u attempt(s), re-running preparation for %d SVM.\n",
+                       channel->id, attempts, channel->num_links);
+            }
+        } else {
+            UvmSvmLink *link = &svm_links[events[k].data.u32];
+            if (link->connect_deadline_ms == 0) continue;
+            if (uvm_link_on_connected(link) && link->reconnect_attempts > 0) {
+                printf("UVM Reconnect (SVM %d): Connected after %u attempt(s), re-running preparation.\n",
+                       link->id, link->reconnect_attempts);
+            }
+        }
+        did_something = true;
+    }
+
+    int still_pending = 0;
+    for (int c = 0; c < uvm_num_mux_channels; ++c) {
+        UvmMuxChannel *channel = &uvm_mux_channels[c];
+        if (channel->connect_deadline_ms == 0) continue;
+        if (now < channel->connect_deadline_ms) { still_pending++; continue; }
+        fprintf(stderr, "UVM: Shared channel %d connection timed out after %d ms.\n", c, config.uvm_connect_timeout_ms);
+        uvm_mux_abort_connect(channel);
+        did_something = true;
+    }
+    for (int i = 0; i < num_svms_in_config; ++i) {
+        UvmSvmLink *link = &svm_links[i];
+        if (link->mux_channel >= 0 || link->status != UVM_LINK_CONNECTING || link->connect_deadline_ms == 0) continue;
+        if (now < link->connect_deadline_ms) { still_pending++; continue; }
+        fprintf(stderr, "UVM: Connection to SVM ID %d timed out after %d ms.\n", i, config.uvm_connect_timeout_ms);
+        uvm_link_abort_connect(link);
+        did_something = true;
+    }
+    pthread_mutex_unlock(&uvm_links_mutex);
+    if (pending) *pending = still_pending;
+    return did_something;
+}
+
+// --- Переподключение к СВ-М ---
+
+// Задержка следующей попытки: экспоненциальная с разбросом в половину (не все линки разом)
+static uint32_t uvm_reconnect_delay_ms(unsigned *attempts) {
+    static unsigned int jitter_seed = 0;
+    if (jitter_seed == 0) jitter_seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
+    uint64_t base = (uint64_t)config.uvm_reconnect_initial_ms;
+    for (unsigned a = 0; a < *attempts && base < (uint64_t)config.uvm_reconnect_max_ms; ++a) base *= 2;
+    if (base > (uint64_t)config.uvm_reconnect_max_ms) base = (uint64_t)config.uvm_reconnect_max_ms;
+    (*attempts)++;
+    uint32_t half = (uint32_t)(base / 2);
+    return half + (uint32_t)(rand_r(&jitter_seed) % (half + 1));
+}
+
+// Переподключение общих соединений (под uvm_links_mutex). Пока соединение цело, линк,
+// упавший сам по себе (таймаут ответа и т.п.), лишь заново начинает подготовку после задержки.
+static bool uvm_mux_reconnect_locked(uint64_t now) {
+    bool did_something = false;
+    for (int c = 0; c < uvm_num_mux_channels; ++c) {
+        UvmMuxChannel *channel = &uvm_mux_channels[c];
+
+        if (channel->connect_deadline_ms != 0) continue; // Идет попытка подключения (uvm_connect_tick)
+
+        if (!channel->up) {
+            // Соединение потеряно: общий приемник будится закрытием сокета и забирается без ожидания
+            if (channel->receiver_tid != 0) {
+                if (channel->connection_handle >= 0) {
+                    shutdown(channel->connection_handle, SHUT_RDWR); // Сокет закроется при следующей попытке
+                    channel->connection_handle = -1;
+                }
+                if (pthread_tryjoin_np(channel->receiver_tid, NULL) != 0) continue;
+                channel->receiver_tid = 0;
+            }
+            channel->connection_handle = -1;
+            if (channel->reconnect_at_ms == 0) {
+                for (int k = 0; k < channel->num_links; ++k) {
+                    UvmSvmLink *link = &svm_links[channel->link_ids[k]];
+                    link->connection_handle = -1;
+                    link->prep_state = PREP_STATE_FAILED;
+                    if (link->status != UVM_LINK_INACTIVE) link->status = UVM_LINK_FAILED;
+                    if (link->down_since_ms == 0) link->down_since_ms = now;
+                }
+                uint32_t delay = uvm_reconnect_delay_ms(&channel->reconnect_attempts);
+                channel->reconnect_at_ms = now + delay;
+                printf("UVM Reconnect (channel %d): Shared connection down, attempt %u in %u ms.\n",
+                       c, channel->reconnect_attempts, delay);
+                did_something = true;
+            } else if (now >= channel->reconnect_at_ms) {
+                uvm_mux_begin_connect(channel); // При неудаче reconnect_at_ms сброшен: следующая попытка позже
+                did_something = true;
+            }
+            continue;
+        }
+
+        for (int k = 0; k < channel->num_links; ++k) {
+            UvmSvmLink *link = &svm_links[channel->link_ids[k]];
+            if (link->status != UVM_LINK_FAILED && link->status != UVM_LINK_INACTIVE) continue;
+            if (link->reconnect_at_ms == 0) {
+                if (link->down_since_ms == 0) link->down_since_ms = now;
+                link->prep_state = PREP_STATE_FAILED;
+                uint32_t delay = uvm_reconnect_delay_ms(&link->reconnect_attempts);
+                link->reconnect_at_ms = now + delay;
+                printf("UVM Reconnect (SVM %d): Link down on shared channel %d, restart %u in %u ms.\n",
+                       link->id, c, link->reconnect_attempts, delay);
+                did_something = true;
+            } else if (now >= link->reconnect_at_ms) {
+                uvm_link_activate(link); // Соединение живо: только заново проходим подготовку
+                uvm_send_link_status(link);
+                printf("UVM Reconnect (SVM %d): Re-running preparation over shared channel %d.\n", link->id, c);
+                did_something = true;
+            }
+        }
+    }
+    return did_something;
+}
+
+// Обработка потерянных линков (вызывается из основного цикла, без uvm_links_mutex):
+// освобождение сеанса и планирование попыток. Начатые попытки завершает uvm_connect_tick.
+// Возвращает true, если что-то было сделано.
+static bool uvm_reconnect_tick(int num_svms_in_config) {
+    if (config.uvm_reconnect_initial_ms <= 0) return false;
+    bool did_something = false;
+    uint64_t now = uvm_monotonic_ms();
+
+    pthread_mutex_lock(&uvm_links_mutex);
+    if (uvm_mux_reconnect_locked(now)) did_something = true;
+    for (int i = 0; i < num_svms_in_config; ++i) {
+        if (!config.svm_config_loaded[i] || svm_links[i].mux_channel >= 0) continue;
+        UvmSvmLink *link = &svm_links[i];
+
+        if (link->status != UVM_LINK_FAILED && link->status != UVM_LINK_INACTIVE) continue;
+
+        // Сеанс потерян: Receiver будится закрытием сокета и забирается без ожидания
+        if (link->receiver_tid != 0) {
+            if (link->connection_handle >= 0) {
+                shutdown(link->connection_handle, SHUT_RDWR); // Сокет закроется при следующей попытке
+                link->connection_handle = -1;
+            }
+            if (pthread_tryjoin_np(link->receiver_tid, NULL) != 0) continue; // Receiver еще держит соединение
+            link->receiver_tid = 0;
+        }
+        link->connection_handle = -1;
+
+        if (link->reconnect_at_ms == 0) {
+            if (link->down_since_ms == 0) link->down_since_ms = now;
+            link->prep_state = PREP_STATE_FAILED;
+            uint32_t delay = uvm_reconnect_delay_ms(&link->reconnect_attempts);
+            link->reconnect_at_ms = now + delay;
+            printf("UVM Reconnect (SVM %d): Link down, attempt %u in %u ms.\n", i, link->reconnect_attempts, delay);
+            did_something = true;
+        } else if (now >= link->reconnect_at_ms) {
+            uvm_link_begin_connect(link); // При неудаче reconnect_at_ms сброшен: следующая попытка позже
+            did_something = true;
+        }
+    }
+    pthread_mutex_unlock(&uvm_links_mutex);
+    return did_something;
+}
+
+// Линк снова в работе после потери связи (под uvm_links_mutex): учет времени восстановления
+static void uvm_link_on_recovered(UvmSvmLink *link) {
+    if (link->down_since_ms == 0) return;
+    uint64_t recover_ms = uvm_monotonic_ms() - link->down_since_ms;
+    link->down_since_ms = 0;
+    link->recoveries++;
+    if (link->recoveries == 1 || recover_ms < link->recover_min_ms) link->recover_min_ms = recover_ms;
+    if (recover_ms > link->recover_max_ms) link->recover_max_ms = recover_ms;
+    link->recover_sum_ms += recover_ms;
+    printf("UVM Reconnect (SVM %d): Recovered in %llu ms after %u attempt(s)%s (recoveries %lu, min/avg/max %llu/%llu/%llu ms).\n",
+           link->id, (unsigned long long)recover_ms, link->reconnect_attempts,
+           link->params_resume ? ", parameters kept" : "", link->recoveries,
+           (unsigned long long)link->recover_min_ms, (unsigned long long)(link->recover_sum_ms / link->recoveries),
+           (unsigned long long)link->recover_max_ms);
+    char gui_msg[192];
+    snprintf(gui_msg, sizeof(gui_msg), "EVENT;SVM_ID:%d;Type:LinkRecovered;Details:RecoverMs=%llu,Attempts=%u,ParamsKept=%d",
+             link->id, (unsigned long long)recover_ms, link->reconnect_attempts, link->params_resume ? 1 : 0);
+    send_to_gui_socket(gui_msg);
+    link->reconnect_attempts = 0;
+}
+
+// Отправка навигационных данных (в набор параметров съемки не входят - отправляются после каждой подготовки)
+static bool uvm_send_navigation_data(UvmSvmLink *link, UvmRequest *request, uint16_t message_num) {
+    request->message = create_navigatsionnye_dannye_message(link->assigned_lak, message_num);
+    NavigatsionnyeDannyeBody nav_body = {0}; // Заполните тело, если нужно
+    memcpy(request->message.body, &nav_body, sizeof(nav_body));
+    request->message.header.body_length = htons(sizeof(nav_body));
+    return send_uvm_request(request);
+}
+
+// Отправка таблицы параметров съемки с запоминанием ее хеша (подпись загруженного в СВ-М набора).
+// Хешируется тело в порядке линии: массивы таблиц переводит в сетевой порядок только отправитель,
+// поэтому хеш считается по копии после message_to_network_byte_order (только поток main)
+static bool uvm_send_param_table(UvmSvmLink *link, UvmRequest *request) {
+    static Message wire;
+    if (!send_uvm_request(request)) return false;
+    int slot = param_signature_slot(request->message.header.message_type);
+    if (slot >= 0) {
+        uint16_t body_len = ntohs(request->message.header.body_length);
+        wire.header = request->message.header;
+        memcpy(wire.body, request->message.body, body_len);
+        message_to_network_byte_order(&wire);
+        link->uploaded_table_hash[slot] = param_table_hash(wire.body, body_len);
+    }
+    return true;
+}
+
 int main(int argc, char *argv[]) {
     pthread_t sender_tid = 0;
     int active_svm_count = 0;
@@ -448,6 +1127,7 @@ int main(int argc, char *argv[]) {
         svm_links[i].connection_handle = -1;
         svm_links[i].status = UVM_LINK_INACTIVE;
         svm_links[i].receiver_tid = 0;
+        svm_links[i].mux_channel = -1;
 		svm_links[i].prep_state = PREP_STATE_NOT_STARTED;
 		svm_links[i].last_command_sent_time = 0;
 		svm_links[i].current_preparation_msg_num = 0; // Начинаем с 0 для каждого SVM
@@ -472,101 +1152,64 @@ int main(int argc, char *argv[]) {
 
     printf("UVM: Загрузка конфигурации...\n");
     if (load_config("config.ini", &config) != 0) { exit(EXIT_FAILURE); }
-    int num_svms_in_config = config.num_svm_configs_found;
-    printf("UVM: Found %d SVM configurations in config file.\n", num_svms_in_config);
+    // Номера [settings_svmN] могут идти с пропусками: циклы по СВ-М идут до последнего настроенного
+    // номера и пропускают ненастроенные (svm_config_loaded)
+    int num_svms_in_config = 0;
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        if (config.svm_config_loaded[i]) num_svms_in_config = i + 1;
+    }
+    printf("UVM: Found %d SVM configurations in config file.\n", config.num_svm_configs_found);
     if (num_svms_in_config == 0) {
         fprintf(stderr, "UVM: No SVM configurations found in config.ini. Exiting.\n");
         exit(EXIT_FAILURE);
     }
 
     uvm_outgoing_request_queue = queue_req_create(50);
-    uvm_incoming_response_queue = uvq_create(50 * num_svms_in_config);
+    uvm_incoming_response_queue = uvq_create(50 * config.num_svm_configs_found);
     if (!uvm_outgoing_request_queue || !uvm_incoming_response_queue) {
         fprintf(stderr, "UVM: Failed to create message queues.\n");
         goto cleanup_queues;
     }
 
+    // Приемник потоковых данных: строки пишутся в файлы отдельным потоком
+    if (config.data_sink_enabled) {
+        // Арена сборщика - только до последнего настроенного СВ-М (по 4 слота кадра на каждый)
+        if (config.frame_assembler_enabled &&
+            uvm_frame_assembler_init(num_svms_in_config, (uint16_t)config.frame_max_lines, (size_t)config.frame_line_bytes,
+                                     uvm_on_frame_assembled, NULL) != 0) {
+            fprintf(stderr, "UVM: Failed to init frame assembler. K3/K4 frames will not be assembled.\n");
+        }
+        if (uvm_data_sink_start(config.data_sink_output_dir, config.data_sink_extent_mb,
+                                (size_t)config.data_sink_queue_capacity) != 0) {
+            fprintf(stderr, "UVM: Failed to start data sink. Data lines will not be recorded.\n");
+        }
+    }
+
     signal(SIGINT, uvm_handle_shutdown_signal);
     signal(SIGTERM, uvm_handle_shutdown_signal);
 
-    // --- Подключение к SVM ---
-    printf("UVM: Connecting to SVMs...\n");
-    printf("DEBUG UVM: IP before loop: %s\n", config.uvm_ethernet_target.target_ip); // Отладочный вывод
-    pthread_mutex_lock(&uvm_links_mutex);
-    for (int i = 0; i < num_svms_in_config; ++i) { // Итерируем по num_svms_in_config
-         if (!config.svm_config_loaded[i]) continue;
-
-         printf("UVM: Attempting to connect to SVM ID %d (IP: %s, Port: %d)...\n",
-                i, config.uvm_ethernet_target.target_ip, config.svm_ethernet[i].port);
-
-         svm_links[i].status = UVM_LINK_CONNECTING;
-         svm_links[i].assigned_lak = config.svm_settings[i].lak; // LAK из конфига SVM
-
-
-         EthernetConfig current_svm_config = {0};
-         strncpy(current_svm_config.target_ip,
-                 config.uvm_ethernet_target.target_ip,
-                 sizeof(current_svm_config.target_ip) - 1);
-         current_svm_config.target_ip[sizeof(current_svm_config.target_ip) - 1] = '\0'; // Гарантируем нуль-терминацию
-         current_svm_config.port = config.svm_ethernet[i].port;
-         current_svm_config.base.type = IO_TYPE_ETHERNET;
-
-         printf("DEBUG UVM: Preparing to create interface for SVM %d with IP=%s, Port=%d\n",
-                 i, current_svm_config.target_ip, current_svm_config.port); // Отладочный вывод
-
-         svm_links[i].io_handle = create_ethernet_interface(&current_svm_config);
-         if (!svm_links[i].io_handle) {
-             fprintf(stderr, "UVM: Failed to create IO interface for SVM ID %d.\n", i);
-             svm_links[i].status = UVM_LINK_FAILED;
-             continue;
-         }
-
-         svm_links[i].connection_handle = svm_links[i].io_handle->connect(svm_links[i].io_handle);
-         if (svm_links[i].connection_handle < 0) {
-             fprintf(stderr, "UVM: Failed to connect to SVM ID %d (IP: %s, Port: %d).\n",
-                     i, current_svm_config.target_ip, current_svm_config.port);
-             svm_links[i].status = UVM_LINK_FAILED;
-             svm_links[i].io_handle->destroy(svm_links[i].io_handle);
-             svm_links[i].io_handle = NULL;
-         } else {
-             printf("UVM: Successfully connected to SVM ID %d (Handle: %d).\n", i, svm_links[i].connection_handle);
-             svm_links[i].status = UVM_LINK_ACTIVE;
-			 svm_links[i].last_activity_time = time(NULL); // <-- ИНИЦИАЛИЗИРОВАТЬ ВРЕМЯ
-             active_svm_count++;
-			  // Отправка события LinkStatus в GUI
-             char initial_gui_msg[128];
-             snprintf(initial_gui_msg, sizeof(initial_gui_msg),
-                      "EVENT;SVM_ID:%d;Type:LinkStatus;Details:NewStatus=%d", i, UVM_LINK_ACTIVE);
-             send_to_gui_socket(initial_gui_msg);
-         }
+    // --- Запуск потоков и подключение к SVM ---
+    if (!uvm_mux_setup(num_svms_in_config)) goto cleanup_connections;
+    uvm_connect_epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (uvm_connect_epfd < 0) {
+        perror("UVM: epoll_create1 failed");
+        goto cleanup_connections;
     }
-    pthread_mutex_unlock(&uvm_links_mutex);
 
-    if (active_svm_count == 0) {
-        fprintf(stderr, "UVM: Failed to connect to any SVM. Exiting.\n");
-        goto cleanup_queues;
-    }
-     printf("UVM: Connected to %d out of %d configured SVMs.\n", active_svm_count, num_svms_in_config);
-
-    // --- Запуск потоков ---
+    // Sender запускается до подключения: линки готовы к работе по мере завершения их подключений
     printf("UVM: Запуск потоков Sender, Receiver(s) и GUI Server...\n");
     if (pthread_create(&sender_tid, NULL, uvm_sender_thread_func, NULL) != 0) {
         perror("UVM: Failed to create sender thread");
         goto cleanup_connections; // Или другая метка очистки
     }
 
-    // Запускаем Receiver'ы для активных соединений
-    pthread_mutex_lock(&uvm_links_mutex);
-    for (int i = 0; i < num_svms_in_config; ++i) {
-        if (svm_links[i].status == UVM_LINK_ACTIVE) {
-            if (pthread_create(&svm_links[i].receiver_tid, NULL, uvm_receiver_thread_func, &svm_links[i]) != 0) {
-                perror("UVM: Failed to create receiver thread");
-                svm_links[i].status = UVM_LINK_FAILED; // Помечаем как ошибку
-                // Можно добавить логику остановки уже запущенных потоков, если это критично
-            }
-        }
+    // Подключения завершает основной цикл; Receiver линка запускается, как только линк подключился
+    printf("UVM: Connecting to SVMs (in parallel, timeout %d ms)...\n", config.uvm_connect_timeout_ms);
+    uint64_t connect_started_ms = uvm_monotonic_ms();
+    if (uvm_start_connects(num_svms_in_config) == 0 && config.uvm_reconnect_initial_ms <= 0) {
+        fprintf(stderr, "UVM: Failed to connect to any SVM. Exiting.\n");
+        goto cleanup_connections;
     }
-    pthread_mutex_unlock(&uvm_links_mutex);
 
     // Запуск GUI сервера
     if (pthread_create(&gui_server_tid, NULL, gui_server_thread, NULL) != 0) {
@@ -622,23 +1265,42 @@ int main(int argc, char *argv[]) {
     const time_t TIMEOUT_RESULTS_KONTROL_S_MAIN = 8;  // SVM может "думать" до 6с + передача
     const time_t TIMEOUT_LINE_STATUS_S_MAIN = 5;
 
-    // Инициализируем начальное состояние подготовки для всех активных TCP-линков
+    // Начальное состояние подготовки: подключенные линки уже начали ее (uvm_link_activate),
+    // остальные начнут по завершении подключения
     pthread_mutex_lock(&uvm_links_mutex);
     for (int i = 0; i < num_svms_in_config; ++i) {
-        if (config.svm_config_loaded[i] && svm_links[i].status == UVM_LINK_ACTIVE) {
-            svm_links[i].prep_state = PREP_STATE_READY_TO_SEND_INIT_CHANNEL; // Начальное состояние для отправки InitChannel
-            svm_links[i].current_preparation_msg_num = 0;     // Сброс счетчика сообщений подготовки
-            svm_links[i].last_command_sent_time = 0;          // Сброс времени последней команды
-        } else if (config.svm_config_loaded[i]) { // Если сконфигурирован, но TCP не активен
-            svm_links[i].prep_state = PREP_STATE_FAILED;      // Сразу в ошибку подготовки
+        if (config.svm_config_loaded[i] && svm_links[i].status != UVM_LINK_ACTIVE) {
+            svm_links[i].prep_state = PREP_STATE_FAILED;
         }
     }
     pthread_mutex_unlock(&uvm_links_mutex);
 
 
+    uint64_t next_node_stats_ms = 0; // Срок очередного вывода статистики по узлам
+    uint64_t next_tcp_info_ms = 0;   // Срок очередного снимка TCP_INFO
+    bool initial_connect_reported = false;
+    int connects_pending = 0;        // Идущие неблокирующие подключения
     while (uvm_keep_running) {
         bool processed_something_this_iteration = false; // Флаг, что на этой итерации что-то сделали
 
+        // === БЛОК 1: ЗАВЕРШЕНИЕ ПОДКЛЮЧЕНИЙ (подготовка линка начинается на этой же итерации) ===
+        if (uvm_connect_tick(num_svms_in_config, &connects_pending)) processed_something_this_iteration = true;
+        if (!initial_connect_reported && connects_pending == 0) {
+            initial_connect_reported = true;
+            active_svm_count = 0;
+            pthread_mutex_lock(&uvm_links_mutex);
+            for (int i = 0; i < num_svms_in_config; ++i) {
+                if (config.svm_config_loaded[i] && svm_links[i].status == UVM_LINK_ACTIVE) active_svm_count++;
+            }
+            pthread_mutex_unlock(&uvm_links_mutex);
+            if (active_svm_count == 0 && config.uvm_reconnect_initial_ms <= 0) {
+                fprintf(stderr, "UVM: Failed to connect to any SVM. Exiting.\n");
+                break;
+            }
+            printf("UVM: Connected to %d out of %d configured SVMs in %llu ms.\n", active_svm_count, config.num_svm_configs_found,
+                   (unsigned long long)(uvm_monotonic_ms() - connect_started_ms));
+        }
+
         pthread_mutex_lock(&uvm_links_mutex);
         for (int i = 0; i < num_svms_in_config; ++i) {
             if (!config.svm_config_loaded[i]) continue;
@@ -680,6 +1342,20 @@ int main(int argc, char *argv[]) {
 
                     // --- НОВЫЙ КЕЙС: ПОДГОТОВКА ЗАВЕРШЕНА, ОТПРАВЛЯЕМ ПАРАМЕТРЫ СЪЕМКИ ---
                     case PREP_STATE_PREPARATION_COMPLETE:
+                        if (link->params_resume) {
+                            // СВ-М сохранил ранее загруженный набор параметров (подпись совпала) — повторно не отправляем;
+                            // навигационные данные отправляются как после любой подготовки
+                            printf("UVM Main (SVM %d): Параметры съемки в СВ-М не изменились, повторная загрузка пропущена.\n", i);
+                            if (uvm_send_navigation_data(link, &request_to_send, link->current_preparation_msg_num)) {
+                                link->current_preparation_msg_num++;
+                                link->prep_state = PREP_STATE_SHOOTING_PARAMS_SENT;
+                                uvm_link_on_recovered(link);
+                            } else {
+                                link->prep_state = PREP_STATE_FAILED; link->status = UVM_LINK_FAILED;
+                            }
+                            processed_something_this_iteration = true;
+                            break;
+                        }
                         printf("UVM Main (SVM %d): Подготовка завершена. Отправка параметров съемки (Режим: %d, LAK: 0x%02X)...\n",
                                i, mode, link->assigned_lak);
                         
@@ -691,47 +1367,45 @@ int main(int argc, char *argv[]) {
                         if (mode == MODE_DR) {
                              request_to_send.message = create_prinyat_parametry_sdr_message(link->assigned_lak, shoot_params_msg_num_start++);
                              PrinyatParametrySdrBodyBase sdr_b_f1 = {0}; sdr_b_f1.pp_nl=(uint8_t)mode|(i & 0x03); /* Убедитесь, что i здесь корректно для номера луча */ memcpy(request_to_send.message.body, &sdr_b_f1, sizeof(sdr_b_f1));
-                             request_to_send.message.header.body_length = htons(sizeof(sdr_b_f1)); send_uvm_request(&request_to_send);
+                             request_to_send.message.header.body_length = htons(sizeof(sdr_b_f1)); uvm_send_param_table(link, &request_to_send);
 
                              request_to_send.message = create_prinyat_parametry_tsd_message(link->assigned_lak, shoot_params_msg_num_start++);
                              PrinyatParametryTsdBodyBase tsd_b_f1 = {0}; memcpy(request_to_send.message.body, &tsd_b_f1, sizeof(tsd_b_f1));
-                             request_to_send.message.header.body_length = htons(sizeof(tsd_b_f1)); send_uvm_request(&request_to_send);
+                             request_to_send.message.header.body_length = htons(sizeof(tsd_b_f1)); uvm_send_param_table(link, &request_to_send);
                         } else if (mode == MODE_OR || mode == MODE_OR1) {
                              request_to_send.message = create_prinyat_parametry_so_message(link->assigned_lak, shoot_params_msg_num_start++);
                              PrinyatParametrySoBody so_b_f1 = {0}; so_b_f1.pp=mode; memcpy(request_to_send.message.body, &so_b_f1, sizeof(so_b_f1));
-                             request_to_send.message.header.body_length = htons(sizeof(so_b_f1)); send_uvm_request(&request_to_send);
+                             request_to_send.message.header.body_length = htons(sizeof(so_b_f1)); uvm_send_param_table(link, &request_to_send);
 
                              request_to_send.message = create_prinyat_parametry_3tso_message(link->assigned_lak, shoot_params_msg_num_start++);
                              PrinyatParametry3TsoBody tso_b_f1 = {0}; memcpy(request_to_send.message.body, &tso_b_f1, sizeof(tso_b_f1));
-                             request_to_send.message.header.body_length = htons(sizeof(tso_b_f1)); send_uvm_request(&request_to_send);
+                             request_to_send.message.header.body_length = htons(sizeof(tso_b_f1)); uvm_send_param_table(link, &request_to_send);
                             
                              request_to_send.message = create_prinyat_time_ref_range_message(link->assigned_lak, shoot_params_msg_num_start++);
                              PrinyatTimeRefRangeBody trr_b_f1 = {0}; memcpy(request_to_send.message.body, &trr_b_f1, sizeof(trr_b_f1));
-                             request_to_send.message.header.body_length = htons(sizeof(trr_b_f1)); send_uvm_request(&request_to_send);
+                             request_to_send.message.header.body_length = htons(sizeof(trr_b_f1)); uvm_send_param_table(link, &request_to_send);
 
                              request_to_send.message = create_prinyat_reper_message(link->assigned_lak, shoot_params_msg_num_start++);
                              PrinyatReperBody rep_b_f1 = {0}; memcpy(request_to_send.message.body, &rep_b_f1, sizeof(rep_b_f1));
-                             request_to_send.message.header.body_length = htons(sizeof(rep_b_f1)); send_uvm_request(&request_to_send);
+                             request_to_send.message.header.body_length = htons(sizeof(rep_b_f1)); uvm_send_param_table(link, &request_to_send);
                         } else if (mode == MODE_VR) {
                              request_to_send.message = create_prinyat_parametry_so_message(link->assigned_lak, shoot_params_msg_num_start++);
                              PrinyatParametrySoBody so_b_f_vr1 = {0}; so_b_f_vr1.pp=mode; memcpy(request_to_send.message.body, &so_b_f_vr1, sizeof(so_b_f_vr1));
-                             request_to_send.message.header.body_length = htons(sizeof(so_b_f_vr1)); send_uvm_request(&request_to_send);
+                             request_to_send.message.header.body_length = htons(sizeof(so_b_f_vr1)); uvm_send_param_table(link, &request_to_send);
 
                              request_to_send.message = create_prinyat_parametry_3tso_message(link->assigned_lak, shoot_params_msg_num_start++);
                              PrinyatParametry3TsoBody tso_b_f_vr1 = {0}; memcpy(request_to_send.message.body, &tso_b_f_vr1, sizeof(tso_b_f_vr1));
-                             request_to_send.message.header.body_length = htons(sizeof(tso_b_f_vr1)); send_uvm_request(&request_to_send);
+                             request_to_send.message.header.body_length = htons(sizeof(tso_b_f_vr1)); uvm_send_param_table(link, &request_to_send);
                         }
                         // Навигационные данные для всех режимов
-                        request_to_send.message = create_navigatsionnye_dannye_message(link->assigned_lak, shoot_params_msg_num_start++);
-                        NavigatsionnyeDannyeBody nav_b_f1 = {0}; memcpy(request_to_send.message.body, &nav_b_f1, sizeof(nav_b_f1)); // Заполните тело nav_b_f1, если нужно
-                        request_to_send.message.header.body_length = htons(sizeof(nav_b_f1)); 
-                        if(send_uvm_request(&request_to_send)) { // Проверяем результат последней отправки
+                        if (uvm_send_navigation_data(link, &request_to_send, shoot_params_msg_num_start++)) { // Проверяем результат последней отправки
                            link->current_preparation_msg_num = shoot_params_msg_num_start; // Обновляем счетчик на следующий свободный
                            // Переводим в новое состояние, например, "Ожидание начала съемки" или "Параметры съемки отправлены"
                            // Пока просто оставим PREPARATION_COMPLETE, чтобы этот блок не срабатывал повторно.
                            // TODO: Ввести новое состояние SHOOTING_PARAMS_SENT или аналогичное.
 						   link->prep_state = PREP_STATE_SHOOTING_PARAMS_SENT; // <--- ИЗМЕНЕНИЕ ЗДЕСЬ
                            printf("UVM Main (SVM %d): Параметры съемки отправлены. Состояние остается PREPARATION_COMPLETE (пока).\n", i);
+                           uvm_link_on_recovered(link);
                         } else {
                             // Ошибка отправки последнего сообщения из пачки
                              link->prep_state = PREP_STATE_FAILED; link->status = UVM_LINK_FAILED;
@@ -758,6 +1432,7 @@ int main(int argc, char *argv[]) {
                                i, link->last_sent_prep_cmd_type, link->current_preparation_msg_num);
 
                         link->last_command_sent_time = time(NULL);
+                        link->last_command_sent_us = uvm_monotonic_us();
                         // НЕ меняем link->last_sent_prep_cmd_type здесь, он уже установлен в switch
 
                         // Переводим в соответствующее состояние ОЖИДАНИЯ ОТВЕТА
@@ -799,7 +1474,8 @@ int main(int argc, char *argv[]) {
 
 
 // === БЛОК 2: ОБРАБОТКА ВХОДЯЩИХ ОТВЕТОВ ===
-        if (uvq_dequeue(uvm_incoming_response_queue, &response_msg_data_main)) {
+        // Ожидание ограничено, чтобы таймауты и переподключение отрабатывали и без входящих ответов
+        if (uvq_dequeue_timed(uvm_incoming_response_queue, &response_msg_data_main, connects_pending > 0 ? 10 : 100)) {
             processed_something_this_iteration = true; // Пометили, что что-то обработали
 			bool is_expected_reply = false; // <--- ОБЪЯВИТЕ ЗДЕСЬ
 			bool reply_is_ok_for_state_change = true;
@@ -807,6 +1483,8 @@ int main(int argc, char *argv[]) {
             Message *msg_resp = &response_msg_data_main.message;
             
             uint16_t msg_num_resp = get_full_message_number(&msg_resp->header);
+            // Нумерация у СВ-М общая для всех типов сообщений - проверяется здесь, по каждому сообщению
+            uvm_frame_assembler_track_message_number(svm_id_resp, response_msg_data_main.session, msg_num_resp);
 
             // Блокируем доступ к общему списку линков
             pthread_mutex_lock(&uvm_links_mutex);
@@ -874,9 +1552,17 @@ int main(int argc, char *argv[]) {
                         }
                         break;
                     default: // Для других типов (СУБК, КО и т.д.)
-                        strcpy(gui_details_for_recv, "Data/Unknown");
+                        if (uvm_data_sink_is_data_type(msg_resp->header.message_type) &&
+                            uvm_data_sink_submit(&response_msg_data_main)) {
+                            strcpy(gui_details_for_recv, "Data->Sink");
+                        } else {
+                            strcpy(gui_details_for_recv, "Data/Unknown");
+                        }
                         break;
                 }
+                if (bcb_found_for_recv) {
+                    uvm_data_sink_note_bcb(svm_id_resp, link_resp->last_recv_bcb);
+                }
 
                 // --- Отправка RECV сообщения в GUI ---
 				snprintf(gui_buffer_main_loop, sizeof(gui_buffer_main_loop),
@@ -908,6 +1594,14 @@ int main(int argc, char *argv[]) {
                                     send_specific_event_to_gui = true;
                                 }
                                 if (reply_ok_for_state_transition) {
+                                    // Расширенный ответ (confirm_init_signature) несет подпись набора параметров, хранящегося в СВ-М
+                                    link_resp->params_resume = false;
+                                    if (config.confirm_init_signature &&
+                                        msg_resp->header.body_length >= sizeof(ConfirmInitExtBody)) { // Длина уже в порядке хоста
+                                        uint32_t svm_signature = ((ConfirmInitExtBody*)msg_resp->body)->param_signature;
+                                        link_resp->params_resume = svm_signature != 0 &&
+                                            svm_signature == param_signature(link_resp->uploaded_table_hash);
+                                    }
                                     link_resp->prep_state = PREP_STATE_READY_TO_SEND_PROVESTI_KONTROL;
                                     link_resp->current_preparation_msg_num++;
                                 }
@@ -963,6 +1657,13 @@ int main(int argc, char *argv[]) {
                             break;
                     } // конец switch (link_resp->prep_state)
 
+                    if (is_expected_reply && link_resp->last_command_sent_us != 0) { // Задержка «команда - ответ»
+                        uint64_t rtt_us = uvm_monotonic_us() - link_resp->last_command_sent_us;
+                        link_resp->last_command_sent_us = 0;
+                        link_resp->rtt_count++;
+                        link_resp->rtt_sum_us += rtt_us;
+                        if (rtt_us > link_resp->rtt_max_us) link_resp->rtt_max_us = rtt_us;
+                    }
                     if (is_expected_reply && !reply_ok_for_state_transition) { // Если ждали ответ подготовки, но он был плохой
                         link_resp->prep_state = PREP_STATE_FAILED;
                         link_resp->status = UVM_LINK_FAILED;
@@ -1004,8 +1705,6 @@ int main(int argc, char *argv[]) {
         for (int k_to = 0; k_to < num_svms_in_config; ++k_to) {
             if (!config.svm_config_loaded[k_to]) continue;
             UvmSvmLink *link_check_to = &svm_links[k_to];
-			printf("DEBUG TIMEOUT_CHECK: SVM %d, TCP Status: %d, Prep State: %d, LastCmdTime: %ld\n", k_to, link_check_to->status, link_check_to->prep_state, link_check_to->last_command_sent_time);
-            
             if (link_check_to->status == UVM_LINK_ACTIVE && // Проверяем только для активных TCP
                 link_check_to->prep_state != PREP_STATE_PREPARATION_COMPLETE &&
                 link_check_to->prep_state != PREP_STATE_FAILED &&
@@ -1040,7 +1739,6 @@ int main(int argc, char *argv[]) {
                     default: break;
                 }
 
-				printf("DEBUG TIMEOUT_CHECK: SVM %d, TCP Status: %d, Prep State: %d, LastCmdTime: %ld, Now: %ld, TimeoutVal: %ld\n", k_to, link_check_to->status, link_check_to->prep_state, link_check_to->last_command_sent_time, now_main_timeout, current_timeout_val_s);
                 if (current_timeout_val_s > 0 && link_check_to->last_command_sent_time > 0 && (now_main_timeout - link_check_to->last_command_sent_time) > current_timeout_val_s) {
                     fprintf(stderr, "UVM Main (SVM %d): ТАЙМАУТ! Ожидался ответ типа %d на команду '%s' (тип %u).\n",
                            k_to, expected_reply_for_timeout_event, cmd_name_for_timeout_event, link_check_to->last_sent_prep_cmd_type);
@@ -1079,7 +1777,7 @@ int main(int argc, char *argv[]) {
                 link_ka->status = UVM_LINK_FAILED;
                 link_ka->prep_state = PREP_STATE_FAILED; // Также помечаем подготовку как FAILED
                 link_ka->timeout_detected = true;
-                if (link_ka->connection_handle >= 0) {
+                if (link_ka->connection_handle >= 0 && link_ka->mux_channel < 0) { // Общее соединение нужно остальным СВ-М
                     shutdown(link_ka->connection_handle, SHUT_RDWR); // Пытаемся уведомить receiver
                 }
                 snprintf(gui_buffer_main_loop, sizeof(gui_buffer_main_loop), "EVENT;SVM_ID:%d;Type:KeepAliveTimeout;Details:No activity for %d sec", ka_idx, config.uvm_keepalive_timeout_sec);
@@ -1091,8 +1789,38 @@ int main(int argc, char *argv[]) {
         }
         pthread_mutex_unlock(&uvm_links_mutex);
 
-        // Если ничего не произошло на этой итерации, небольшая пауза
-        if (!processed_something_this_iteration && uvm_keep_running) {
+        // === БЛОК 5: ПЕРЕПОДКЛЮЧЕНИЕ ПОТЕРЯННЫХ ЛИНКОВ ===
+        if (uvm_reconnect_tick(num_svms_in_config)) processed_something_this_iteration = true;
+
+        // === БЛОК 6: ПЕРИОДИЧЕСКАЯ СТАТИСТИКА ПО УЗЛАМ ===
+        if (config.uvm_node_stats_interval_sec > 0) {
+            uint64_t now_stats_ms = uvm_monotonic_ms();
+            if (next_node_stats_ms == 0) {
+                next_node_stats_ms = now_stats_ms + (uint64_t)config.uvm_node_stats_interval_sec * 1000ull;
+            } else if (now_stats_ms >= next_node_stats_ms) {
+                pthread_mutex_lock(&uvm_links_mutex);
+                uvm_print_node_stats(num_svms_in_config);
+                pthread_mutex_unlock(&uvm_links_mutex);
+                next_node_stats_ms = now_stats_ms + (uint64_t)config.uvm_node_stats_interval_sec * 1000ull;
+            }
+        }
+
+        // === БЛОК 7: СОСТОЯНИЕ TCP В ЯДРЕ ===
+        if (config.tcp_info_interval_ms > 0) {
+            uint64_t now_tcp_ms = uvm_monotonic_ms();
+            if (now_tcp_ms >= next_tcp_info_ms) {
+                pthread_mutex_lock(&uvm_links_mutex);
+                uvm_sample_tcp_info(num_svms_in_config, now_tcp_ms);
+                pthread_mutex_unlock(&uvm_links_mutex);
+                next_tcp_info_ms = now_tcp_ms + (uint64_t)config.tcp_info_interval_ms;
+            }
+        }
+
+        // === БЛОК 8: СОБЫТИЯ СБОРЩИКА КАДРОВ (от потока приемника данных) ===
+        if (uvm_flush_frame_events()) processed_something_this_iteration = true;
+
+        // Если ничего не произошло на этой итерации, небольшая пауза (пока идут подключения - без нее)
+        if (!processed_something_this_iteration && connects_pending == 0 && uvm_keep_running) {
             usleep(20000); // 20 мс
         }
     } // end while (uvm_keep_running)
@@ -1112,15 +1840,56 @@ cleanup_connections: // Метка для goto при ошибках на ран
         printf("UVM: Sender thread joined.\n");
     }
 
-    // Ожидаем завершения потоков Receiver'ов
+    // Итоговая статистика по узлам (до закрытия соединений)
+    pthread_mutex_lock(&uvm_links_mutex);
+    uvm_print_node_stats(num_svms_in_config);
+    pthread_mutex_unlock(&uvm_links_mutex);
+
+    // Общие соединения: приемники будятся закрытием сокета (без uvm_links_mutex - они его захватывают)
+    for (int c = 0; c < uvm_num_mux_channels; ++c) {
+        UvmMuxChannel *channel = &uvm_mux_channels[c];
+        if (channel->connection_handle >= 0) shutdown(channel->connection_handle, SHUT_RDWR);
+        if (channel->receiver_tid != 0) {
+            pthread_join(channel->receiver_tid, NULL);
+            channel->receiver_tid = 0;
+            printf("UVM: Shared channel %d receiver joined.\n", c);
+        }
+    }
+    pthread_mutex_lock(&uvm_links_mutex);
+    for (int i = 0; i < MAX_SVM_INSTANCES; ++i) {
+        if (svm_links[i].mux_channel < 0) continue;
+        svm_links[i].io_handle = NULL; // Интерфейс принадлежит каналу
+        svm_links[i].connection_handle = -1;
+        svm_links[i].status = UVM_LINK_INACTIVE;
+    }
+    for (int c = 0; c < uvm_num_mux_channels; ++c) {
+        IOInterface *io = uvm_mux_channels[c].io_handle;
+        if (!io) continue;
+        if (io->io_handle >= 0) io->disconnect(io, io->io_handle);
+        io->destroy(io);
+        uvm_mux_channels[c].io_handle = NULL;
+        uvm_mux_channels[c].connection_handle = -1;
+    }
+    pthread_mutex_unlock(&uvm_links_mutex);
+
+    // Ожидаем завершения потоков Receiver'ов: как и приемники общих соединений, они будятся
+    // закрытием сокета и ожидаются без uvm_links_mutex (приемник захватывает его при обрыве)
+    pthread_t receiver_tids[MAX_SVM_INSTANCES] = {0};
+    pthread_mutex_lock(&uvm_links_mutex);
+    for (int i = 0; i < num_svms_in_config; ++i) {
+        if (svm_links[i].receiver_tid == 0) continue;
+        if (svm_links[i].connection_handle >= 0) shutdown(svm_links[i].connection_handle, SHUT_RDWR);
+        receiver_tids[i] = svm_links[i].receiver_tid;
+        svm_links[i].receiver_tid = 0;
+    }
+    pthread_mutex_unlock(&uvm_links_mutex);
+    for (int i = 0; i < num_svms_in_config; ++i) {
+        if (receiver_tids[i] == 0) continue;
+        pthread_join(receiver_tids[i], NULL);
+        printf("UVM: Receiver thread for SVM ID %d joined.\n", i);
+    }
     pthread_mutex_lock(&uvm_links_mutex); // Блокируем для безопасного доступа к svm_links
     for (int i = 0; i < num_svms_in_config; ++i) {
-        if (svm_links[i].receiver_tid != 0) {
-            // Receiver должен сам завершиться, если uvm_keep_running=false или его сокет закрыт
-            pthread_join(svm_links[i].receiver_tid, NULL);
-            printf("UVM: Receiver thread for SVM ID %d joined.\n", i);
-            svm_links[i].receiver_tid = 0;
-        }
         // Закрываем соединения и уничтожаем интерфейсы (если еще не сделано)
         if (svm_links[i].io_handle) {
             if (svm_links[i].connection_handle >= 0) {
@@ -1133,6 +1902,10 @@ cleanup_connections: // Метка для goto при ошибках на ран
         }
     }
     pthread_mutex_unlock(&uvm_links_mutex);
+    if (uvm_connect_epfd >= 0) {
+        close(uvm_connect_epfd);
+        uvm_connect_epfd = -1;
+    }
 
     // Завершаем поток GUI сервера
     if (gui_server_tid != 0) {
@@ -1146,6 +1919,8 @@ cleanup_connections: // Метка для goto при ошибках на ран
     }
 
 cleanup_queues:
+    uvm_data_sink_stop(); // Дописывает оставшиеся строки и закрывает файлы сеансов
+    uvm_frame_assembler_destroy(); // Выдает незавершенные кадры и освобождает арену
     if (uvm_outgoing_request_queue && uvm_outgoing_request_queue->shutdown == false) queue_req_shutdown(uvm_outgoing_request_queue); // На всякий случай
     if (uvm_incoming_response_queue && uvm_incoming_response_queue->shutdown == false) uvq_shutdown(uvm_incoming_response_queue); // На всякий случай
     if (uvm_outgoing_request_queue) queue_req_destroy(uvm_outgoing_request_queue);
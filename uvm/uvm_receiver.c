@@ -15,6 +15,7 @@
 #include "../utils/ts_uvm_resp_queue.h" // Новая очередь ответов
 #include "uvm_types.h"
 #include "../config/config.h" // Для MAX_SVM_INSTANCES
+#include "uvm_data_sink.h"
 
 // Внешние переменные из uvm_main.c
 extern ThreadSafeUvmRespQueue *uvm_incoming_response_queue; // Общая очередь ответов
@@ -88,9 +89,12 @@ void* uvm_receiver_thread_func(void* arg) {
         } else { // Успех
 			pthread_mutex_lock(&uvm_links_mutex); // Захватываем мьютекс
 			link->last_activity_time = time(NULL); // Обновляем время активности
+			link->rx_messages++;
+			link->rx_bytes += sizeof(MessageHeader) + receivedMessage.header.body_length; // Длина уже в порядке хоста
 			pthread_mutex_unlock(&uvm_links_mutex); // Отпускаем мьютекс
             // Копируем сообщение в структуру для очереди
 			response_msg.source_svm_id = svm_id; // <-- Устанавливаем ID ПЕРЕД enqueue
+			response_msg.session = uvm_data_sink_session(svm_id);
 			memcpy(&response_msg.message, &receivedMessage, sizeof(Message)); // Копируем сообщение
 			// Помещаем в ОБЩУЮ очередь ответов
 			if (!uvq_enqueue(uvm_incoming_response_queue, &response_msg)) {
@@ -121,6 +125,82 @@ void* uvm_receiver_thread_func(void* arg) {
         }
     } // end while
 
+    // Сеанс связи завершен: следующие строки данных этого СВ-М пойдут в новые файлы
+    uvm_data_sink_end_session(svm_id);
+
     printf("UVM Receiver thread for SVM ID %d finished.\n", svm_id);
     return NULL;
-}
\ No newline at end of file
+}
+// Приемник общего соединения: ответы всех СВ-М канала раздаются по LAK отправителя,
+// который СВ-М в этом режиме ставит в поле адреса заголовка
+void* uvm_mux_receiver_thread_func(void* arg) {
+    UvmMuxChannel *channel = (UvmMuxChannel*)arg;
+    IOInterface *io = channel->io_handle;
+    int handle = channel->connection_handle;
+    printf("UVM Mux Receiver thread started for channel %d (handle: %d, %d SVM).\n",
+           channel->id, handle, channel->num_links);
+
+    Message receivedMessage;
+    UvmResponseMessage response_msg;
+    UvmLinkStatus final_status = UVM_LINK_FAILED;
+    while (uvm_keep_running) {
+        int recvStatus = receive_protocol_message(io, handle, &receivedMessage);
+        if (recvStatus == -2) continue; // Таймаут/EINTR: проверяем флаг остановки
+        if (recvStatus != 0) {
+            if (uvm_keep_running) {
+                printf("UVM Mux Receiver (channel %d): Connection %s.\n", channel->id,
+                       recvStatus == 1 ? "closed by SVM node" : "failed");
+            }
+            if (recvStatus == 1) final_status = UVM_LINK_INACTIVE;
+            break;
+        }
+
+        pthread_mutex_lock(&uvm_links_mutex);
+        int svm_id = channel->link_by_lak[receivedMessage.header.address];
+        UvmSvmLink *link = svm_id >= 0 ? &svm_links[svm_id] : NULL;
+        if (!link || (link->status != UVM_LINK_ACTIVE && link->status != UVM_LINK_WARNING)) {
+            // Чужой адрес или линк, подготовка которого будет начата заново: ответ не нужен
+            pthread_mutex_unlock(&uvm_links_mutex);
+            if (!link) {
+                fprintf(stderr, "UVM Mux Receiver (channel %d): Message type %u from unknown LAK 0x%02X dropped.\n",
+                        channel->id, receivedMessage.header.message_type, receivedMessage.header.address);
+            }
+            continue;
+        }
+        link->last_activity_time = time(NULL);
+        link->rx_messages++;
+        link->rx_bytes += sizeof(MessageHeader) + receivedMessage.header.body_length; // Длина уже в порядке хоста
+        pthread_mutex_unlock(&uvm_links_mutex);
+
+        receivedMessage.header.address = LOGICAL_ADDRESS_UVM_VAL; // Дальше - как при собственном соединении
+        response_msg.source_svm_id = svm_id;
+        response_msg.session = uvm_data_sink_session(svm_id);
+        memcpy(&response_msg.message, &receivedMessage, sizeof(Message));
+        if (!uvq_enqueue(uvm_incoming_response_queue, &response_msg)) {
+            if (uvm_keep_running) {
+                fprintf(stderr, "UVM Mux Receiver (channel %d): Failed to enqueue message to response queue (shutdown?). Exiting.\n", channel->id);
+            }
+            break;
+        }
+    }
+
+    // Соединение потеряно для всех СВ-М канала
+    pthread_mutex_lock(&uvm_links_mutex);
+    channel->up = false;
+    for (int k = 0; k < channel->num_links; ++k) {
+        UvmSvmLink *link = &svm_links[channel->link_ids[k]];
+        if (link->status == UVM_LINK_ACTIVE || link->status == UVM_LINK_WARNING) {
+            link->status = final_status;
+            char gui_event_buffer[128];
+            snprintf(gui_event_buffer, sizeof(gui_event_buffer),
+                     "EVENT;SVM_ID:%d;Type:LinkStatus;Details:NewStatus=%d,AssignedLAK=0x%02X",
+                     link->id, final_status, link->assigned_lak);
+            send_to_gui_socket(gui_event_buffer);
+        }
+    }
+    pthread_mutex_unlock(&uvm_links_mutex);
+    for (int k = 0; k < channel->num_links; ++k) uvm_data_sink_end_session(channel->link_ids[k]);
+
+    printf("UVM Mux Receiver thread for channel %d finished.\n", channel->id);
+    return NULL;
+}
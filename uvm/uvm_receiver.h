@@ -6,4 +6,7 @@
 
 void* uvm_receiver_thread_func(void* arg);
 
+// Приемник общего (мультиплексированного) соединения; arg - UvmMuxChannel*
+void* uvm_mux_receiver_thread_func(void* arg);
+
 #endif // UVM_RECEIVER_H
\ No newline at end of file
@@ -1,6 +1,9 @@
 /*
  * uvm/uvm_sender.c
  * Описание: Поток UVM для отправки сообщений разным SVM.
+ * Запросы отправляются прямо из слотов очереди, без копирования. При zerocopy_threshold > 0
+ * крупные кадры уходят и без копирования в ядро: слот тогда удерживается в пуле и
+ * возвращается очереди только после того, как ядро сообщит о его освобождении.
  */
 #include "uvm_sender.h" // (Если есть)
 #include <stdio.h>
@@ -22,34 +25,67 @@ extern volatile bool uvm_keep_running;
 extern volatile int uvm_outstanding_sends; // Счетчик для синхронизации
 extern pthread_cond_t uvm_all_sent_cond;   // Условная переменная
 extern pthread_mutex_t uvm_send_counter_mutex; // Мьютекс для счетчика
+extern AppConfig config;
+
+#define UVM_ZC_POOL_SIZE 16      // Слотов очереди, одновременно отданных ядру
+#define UVM_ZC_WAIT_MS 10        // Ожидание уведомлений ядра, когда пул занят
+
+// Элемент пула zero-copy: слот очереди запросов, отданный ядру, и билет его освобождения
+typedef struct {
+    UvmRequest *request;
+    int handle;
+    EthernetZcTicket ticket;
+    bool busy;
+} UvmZcBuffer;
+
+static UvmZcBuffer uvm_zc_pool[UVM_ZC_POOL_SIZE];
+
+// Свободный элемент пула (или NULL, если ядро не освободило ни одного слота за время ожидания)
+static UvmZcBuffer* uvm_zc_acquire(void) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        int wait_handle = -1;
+        for (int i = 0; i < UVM_ZC_POOL_SIZE; ++i) {
+            UvmZcBuffer *buffer = &uvm_zc_pool[i];
+            if (buffer->busy && ethernet_zerocopy_released(buffer->handle, &buffer->ticket)) {
+                queue_req_dequeue_end(uvm_outgoing_request_queue, buffer->request);
+                buffer->busy = false;
+            }
+            if (!buffer->busy) return buffer;
+            if (wait_handle < 0) wait_handle = buffer->handle;
+        }
+        ethernet_zerocopy_wait(wait_handle, UVM_ZC_WAIT_MS);
+    }
+    return NULL;
+}
 
 void* uvm_sender_thread_func(void* arg) {
     (void)arg;
     printf("UVM Sender thread started.\n");
-    UvmRequest request;
     bool shutdown_req_received = false;
+    bool zerocopy = config.zerocopy_threshold > 0;
 
     while (!shutdown_req_received) {
-        // Извлекаем запрос из очереди
-        if (!queue_req_dequeue(uvm_outgoing_request_queue, &request)) {
-			printf("UVM Sender: Забрал из очереди запрос для SVM %d, тип сообщения %d.\n", request.target_svm_id, request.message.header.message_type); // <-- ОТЛАДКА
-            if (!uvm_keep_running && uvm_outgoing_request_queue->count == 0) {
-                printf("Sender Thread: Request queue empty and shutdown signaled. Exiting.\n");
-                break;
-            }
-            if(uvm_keep_running) usleep(10000); // Ложное пробуждение?
-            continue; // Продолжаем, если работаем или очередь не пуста
+        // Элемент пула zero-copy для слота (NULL - пул выключен или весь у ядра: отправка с копированием)
+        UvmZcBuffer *zc_buffer = zerocopy ? uvm_zc_acquire() : NULL;
+
+        // Берем запрос из очереди на месте; NULL - очередь закрыта и пуста
+        UvmRequest *request = queue_req_dequeue_begin(uvm_outgoing_request_queue);
+        if (!request) {
+            printf("Sender Thread: Request queue empty and shutdown signaled. Exiting.\n");
+            break;
         }
+        bool slot_held = false; // Слот отдан ядру и вернется в очередь через пул
 
         // Обрабатываем запрос
-        if (request.type == UVM_REQ_SHUTDOWN) {
+        if (request->type == UVM_REQ_SHUTDOWN) {
             printf("Sender Thread: Received shutdown request.\n");
             shutdown_req_received = true;
+            queue_req_dequeue_end(uvm_outgoing_request_queue, request);
             continue; // Выйдем из цикла на следующей итерации
         }
 
-        if (request.type == UVM_REQ_SEND_MESSAGE) {
-            int svm_id = request.target_svm_id;
+        if (request->type == UVM_REQ_SEND_MESSAGE) {
+            int svm_id = request->target_svm_id;
             IOInterface *io = NULL;
             int handle = -1;
             bool is_active = false;
@@ -64,10 +100,22 @@ void* uvm_sender_thread_func(void* arg) {
             pthread_mutex_unlock(&uvm_links_mutex);
 
 			if (is_active && io && handle >= 0) {
-				if (send_protocol_message(io, handle, &request.message) != 0) {
-					fprintf(stderr, "UVM Sender: ОШИБКА ФИЗИЧЕСКОЙ отправки сообщения тип %u SVM %d.\n", request.message.header.message_type, svm_id); // <-- ОТЛАДКА
+				int send_result;
+				if (zc_buffer) {
+					send_result = send_protocol_message_zerocopy(io, handle, &request->message, &zc_buffer->ticket);
+					if (zc_buffer->ticket.pending) { // Кадр еще у ядра
+						zc_buffer->request = request;
+						zc_buffer->handle = handle;
+						zc_buffer->busy = true;
+						slot_held = true;
+					}
+				} else {
+					send_result = send_protocol_message(io, handle, &request->message);
+				}
+				if (send_result != 0) {
+					fprintf(stderr, "UVM Sender: ОШИБКА ФИЗИЧЕСКОЙ отправки сообщения тип %u SVM %d.\n", request->message.header.message_type, svm_id); // <-- ОТЛАДКА
 				} else {
-					//printf("UVM Sender: Сообщение тип %u УСПЕШНО ФИЗИЧЕСКИ отправлено SVM %d.\n", request.message.header.message_type, svm_id); // <-- ОТЛАДКА
+					//printf("UVM Sender: Сообщение тип %u УСПЕШНО ФИЗИЧЕСКИ отправлено SVM %d.\n", request->message.header.message_type, svm_id); // <-- ОТЛАДКА
 				}
 			} else if (is_active) {
 				 fprintf(stderr, "UVM Sender: SVM %d активен, но io/handle невалидны. Пропуск отправки.\n", svm_id); // <-- ОТЛАДКА
@@ -79,7 +127,7 @@ void* uvm_sender_thread_func(void* arg) {
             pthread_mutex_lock(&uvm_send_counter_mutex);
             if (uvm_outstanding_sends > 0) {
                 uvm_outstanding_sends--;
-                 //printf("UVM Sender: uvm_outstanding_sends уменьшен до %d (после обработки запроса тип %d для SVM %d).\n", uvm_outstanding_sends, request.message.header.message_type, request.target_svm_id); // <-- ОТЛАДКА
+                 //printf("UVM Sender: uvm_outstanding_sends уменьшен до %d (после обработки запроса тип %d для SVM %d).\n", uvm_outstanding_sends, request->message.header.message_type, request->target_svm_id); // <-- ОТЛАДКА
                 if (uvm_outstanding_sends == 0) {
                     //printf("Sender Thread: All pending messages sent, signaling Main.\n");
                     pthread_cond_signal(&uvm_all_sent_cond);
@@ -90,6 +138,7 @@ void* uvm_sender_thread_func(void* arg) {
         } else {
             fprintf(stderr, "UVM Sender: ВНИМАНИЕ! Попытка уменьшить uvm_outstanding_sends, когда он уже 0 или меньше.\n");
         }
+        if (!slot_held) queue_req_dequeue_end(uvm_outgoing_request_queue, request);
     } // end while
 
     printf("UVM Sender thread finished.\n");
@@ -13,6 +13,7 @@
 
 #include "../protocol/protocol_defs.h" // Для Message, LogicalAddress, MessageType
 #include "../io/io_interface.h" // Для IOInterface
+#include "../protocol/message_utils.h" // Для PARAM_SIGNATURE_TABLES
 // #include "../config/config.h" // MAX_SVM_CONFIGS теперь берем из svm_types.h
 #include "../svm/svm_types.h" // <-- ВКЛЮЧАЕМ для MAX_SVM_INSTANCES (вместо MAX_SVM_CONFIGS)
 
@@ -50,6 +51,7 @@ typedef struct {
 // Структура для сообщений в очереди ответов от Receiver'ов к Main
 typedef struct {
     int source_svm_id; // ID SVM, от которого пришло сообщение
+    unsigned session;  // Сеанс связи, в котором принято (uvm_data_sink_session; ставит приемник)
     Message message;   // Само сообщение
 } UvmResponseMessage;
 
@@ -82,17 +84,26 @@ typedef enum {
     PREP_STATE_FAILED
 } PreparationState;
 
-// Структура для хранения состояния связи с одним SVM
+// Структура для хранения состояния связи с одним SVM.
+// Группы полей, которые пишут разные потоки (приемник - на каждое сообщение, main - при обработке),
+// начинаются с новой строки кэша; соседние svm_links[] не делят строки кэша.
 typedef struct UvmSvmLink {
+    // --- Соединение: читают отправитель и приемник, пишет main при (пере)подключении ---
     int id;                 // ID этого слота (0..MAX_SVM_INSTANCES-1)
     IOInterface *io_handle; // Указатель на созданный IO интерфейс
     int connection_handle;  // Дескриптор сокета/файла
     UvmLinkStatus status;   // Текущий статус соединения
     LogicalAddress assigned_lak; // Ожидаемый/подтвержденный LAK
     pthread_t receiver_tid; // ID потока-приемника
-    time_t last_activity_time; // Время последней АКТИВНОСТИ (получения сообщения)
-	
-	PreparationState prep_state;         // Текущее состояние на этапе подготовки
+    int mux_channel;        // Индекс общего соединения в uvm_mux_channels (-1 - собственное соединение)
+
+    // --- Пишет поток-приемник на каждое сообщение ---
+    time_t last_activity_time SVM_CACHE_ALIGNED; // Время последней АКТИВНОСТИ (получения сообщения)
+    uint64_t rx_messages;   // Принято сообщений от СВ-М (статистика по узлам)
+    uint64_t rx_bytes;      // ... и байт (заголовок + тело)
+
+    // --- Состояние подготовки и сведения для GUI: пишет main ---
+    PreparationState prep_state SVM_CACHE_ALIGNED; // Текущее состояние на этапе подготовки
     time_t last_command_sent_time;     // Время отправки последней команды, на которую ожидается ответ
     uint16_t current_preparation_msg_num; // Счетчик номеров сообщений для команд подготовки ЭТОГО SVM
                                          // (заменяет msg_counters[i] из main для этого этапа)
@@ -122,7 +133,47 @@ typedef struct UvmSvmLink {
     bool        response_timeout_detected;// Был ли таймаут ожидания ответа на команду
     bool        lak_mismatch_detected;    // Был ли неверный LAK в ответе
     bool        control_failure_detected; // Был ли RSK != ожидаемого "ОК"
+
+    // --- Переподключение и восстановление сеанса: пишет main ---
+    uint64_t    connect_deadline_ms;  // Срок текущей попытки подключения (0 - попытки нет)
+    uint64_t    reconnect_at_ms;      // Время следующей попытки (0 - потеря связи еще не обработана)
+    unsigned    reconnect_attempts;   // Попыток с момента потери связи (показатель задержки)
+    uint64_t    down_since_ms;        // Момент потери связи (0 - связь не терялась)
+    unsigned long recoveries;         // Статистика времени восстановления
+    uint64_t    recover_min_ms;
+    uint64_t    recover_max_ms;
+    uint64_t    recover_sum_ms;
+    uint32_t    uploaded_table_hash[PARAM_SIGNATURE_TABLES]; // Хеши таблиц, загруженных в этот СВ-М
+    bool        params_resume;        // СВ-М сообщил подпись загруженного набора - повторная загрузка не нужна
+
+    // --- Трафик и задержка ответов (статистика по узлам): пишет main ---
+    uint64_t    tx_messages;          // Поставлено в очередь отправки сообщений этому СВ-М
+    uint64_t    tx_bytes;
+    uint64_t    last_command_sent_us; // Момент отправки команды, ожидающей ответа (монотонные мкс)
+    uint64_t    rtt_count;            // Задержка «команда - ответ» для команд подготовки
+    uint64_t    rtt_sum_us;
+    uint64_t    rtt_max_us;
+
+    // --- Состояние TCP в ядре (tcp_info_interval_ms): пишет main ---
+    EthernetTcpInfo tcp_info;         // Последний снимок (у общего соединения - один на все СВ-М канала)
+    uint64_t    tcp_info_at_ms;       // Момент снимка (0 - снимков не было)
 } UvmSvmLink;
 
+// Общее соединение с узлом эмуляции, по которому идут сообщения нескольких СВ-М
+// (мультиплексирование по логическому адресу в заголовке). Поля - под uvm_links_mutex.
+typedef struct UvmMuxChannel {
+    int id;
+    IOInterface *io_handle;   // Принадлежит каналу; линки канала ссылаются на него
+    int connection_handle;
+    pthread_t receiver_tid;   // Общий приемник: раздает ответы линкам по LAK отправителя
+    bool up;                  // Соединение установлено и приемник работает
+    uint64_t connect_deadline_ms;
+    uint64_t reconnect_at_ms;
+    unsigned reconnect_attempts;
+    int num_links;
+    int link_ids[MAX_SVM_INSTANCES];
+    int16_t link_by_lak[256]; // LAK -> ID линка (-1 - чужой адрес)
+} UvmMuxChannel;
+
 
 #endif // UVM_TYPES_H
\ No newline at end of file